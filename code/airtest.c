@@ -25,6 +25,12 @@
  * the Clang optimizer, we choose not to test in this configuration.
  * In any case, the MPS does not guarantee anything about timely
  * finalization (see <manual/html/topic/finalization.html#cautions>).
+ *
+ * .slice: The test also makes a large vector and a large array of
+ * hash buckets, and steps incremental collections one increment at a
+ * time, so that these objects are scanned in slices (see
+ * <design/trace/#scan.slice>), while the test reads and updates them
+ * between the increments.
  */
 
 #include "mps.h"
@@ -36,6 +42,9 @@
 
 #define OBJ_LEN (1u << 4)
 #define OBJ_COUNT 10
+#define SLICE_LEN (1u << 17)
+#define SLICE_STEPS 400
+#define SLICE_COLLECTIONS 4
 
 static void test_air(int interior, int stack)
 {
@@ -85,6 +94,78 @@ static void test_air(int interior, int stack)
   }
 }
 
+/* check_slice -- check the contents of the large objects */
+
+static void check_slice(obj_t v, obj_t b)
+{
+  size_t i;
+  for (i = 0; i < SLICE_LEN; ++i) {
+    obj_t o = v->vector.vector[i];
+    Insist(TYPE(o) == TYPE_INTEGER);
+    Insist(o->integer.integer == (long)i);
+  }
+  for (i = 0; i < SLICE_LEN / 2; ++i) {
+    obj_t k = b->buckets.bucket[i].key;
+    obj_t o = b->buckets.bucket[i].value;
+    Insist(TYPE(k) == TYPE_INTEGER);
+    Insist(k->integer.integer == (long)i);
+    Insist(TYPE(o) == TYPE_INTEGER);
+    Insist(o->integer.integer == -(long)i);
+  }
+}
+
+
+/* test_slice -- see .slice */
+
+static void test_slice(void)
+{
+  obj_t r[2];
+  mps_root_t root;
+  mps_addr_t *p = (void *)r;
+  size_t i, j, k;
+
+  r[0] = r[1] = NULL;
+  die(mps_root_create_table(&root, scheme_arena, mps_rank_exact(), 0, p,
+                            sizeof r / sizeof r[0]), "mps_root_create_table");
+  /* Each allocation may move the large objects, so don't read r[0] or
+     r[1] until the new object has been made. */
+  r[0] = scheme_make_vector(obj_ap, SLICE_LEN, NULL);
+  for (i = 0; i < SLICE_LEN; ++i) {
+    obj_t o = scheme_make_integer(obj_ap, (long)i);
+    r[0]->vector.vector[i] = o;
+  }
+  r[1] = scheme_make_buckets(obj_ap, SLICE_LEN / 2);
+  for (i = 0; i < SLICE_LEN / 2; ++i) {
+    obj_t o = scheme_make_integer(obj_ap, (long)i);
+    r[1]->buckets.bucket[i].key = o;
+    o = scheme_make_integer(obj_ap, -(long)i);
+    r[1]->buckets.bucket[i].value = o;
+  }
+
+  for (k = 0; k < SLICE_COLLECTIONS; ++k) {
+    die(mps_arena_start_collect(scheme_arena), "mps_arena_start_collect");
+    for (j = 0; j < SLICE_STEPS; ++j) {
+      (void)mps_arena_step(scheme_arena, 0.0, 0.0);
+      (void)scheme_make_integer(obj_ap, (long)j);
+      /* Only touch the large objects now and then, so that most
+         increments resume a partly scanned object. */
+      if (j % 50 == 49) {
+        obj_t o;
+        i = rnd() % SLICE_LEN;
+        o = scheme_make_integer(obj_ap, (long)i);
+        r[0]->vector.vector[i] = o;
+        i = rnd() % (SLICE_LEN / 2);
+        Insist(r[1]->buckets.bucket[i].key->integer.integer == (long)i);
+      }
+    }
+    mps_arena_park(scheme_arena);
+    check_slice(r[0], r[1]);
+    mps_arena_release(scheme_arena);
+  }
+
+  mps_root_destroy(root);
+}
+
 static mps_gen_param_s obj_gen_params[] = {
   { 150, 0.85 },
   { 170, 0.45 }
@@ -133,6 +214,7 @@ static void test_main(void *marker, int interior, int stack)
   }
   
   test_air(interior, stack);
+  test_slice();
 
   mps_arena_park(scheme_arena);
   if (stack)
@@ -10,6 +10,7 @@
 #include "testlib.h"
 #include "mpm.h"
 #include "mpslib.h"
+#include "table.h"
 #include "mpscamc.h"
 #include "mpsavm.h"
 #include "mpstd.h"
@@ -17,6 +18,7 @@
 #include "mpslib.h"
 
 #include <stdio.h> /* fflush, printf, putchar */
+#include <stdlib.h> /* free, malloc */
 
 
 /* These values have been tuned in the hope of getting one dynamic collection. */
@@ -30,6 +32,10 @@
 #define collectionsCOUNT  37
 #define rampSIZE          9
 #define initTestFREQ      6000
+#define frameTestFREQ     500
+#define frameTempCOUNT    8
+#define stepFREQ          1000
+#define bigRootOBJECTS    50000
 
 /* testChain -- generation parameters for the test */
 
@@ -44,11 +50,21 @@ static mps_gen_param_s testChain[genCOUNT] = {
 static mps_arena_t arena;
 static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
+static mps_bool_t exactHashed[exactRootsCOUNT]; /* has identity hash? */
+static mps_word_t exactHashes[exactRootsCOUNT]; /* identity hashes */
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
 static size_t scale;            /* Overall scale factor. */
+static mps_bool_t zeroed;       /* Pool promises zeroed allocation? */
 static unsigned long nCollsStart;
 static unsigned long nCollsDone;
 
+#define samplesCOUNT      1000
+#define sampleINTERVAL    ((size_t)1 << 16)
+
+enum { sampleFREE, sampleTRACKED, sampleDEAD };
+static int samples[samplesCOUNT]; /* state of each sample */
+static size_t samplesTaken;
+
 
 /* report -- report statistics from any messages */
 
@@ -108,6 +124,11 @@ static mps_addr_t make(size_t rootsCount)
       ArenaDescribe(arena, mps_lib_get_stderr(), 4);
       die(res, "MPS_RESERVE_BLOCK");
     }
+    if (zeroed) {
+      size_t i;
+      for (i = 0; i < size; ++i)
+        cdie(((unsigned char *)p)[i] == 0, "zeroed");
+    }
     res = dylan_init(p, size, exactRoots, rootsCount);
     if (res)
       die(res, "dylan_init");
@@ -117,6 +138,28 @@ static mps_addr_t make(size_t rootsCount)
 }
 
 
+/* frame_test -- allocate temporaries in an allocation frame
+ *
+ * If check is true, the arena must be parked, and if the temporaries
+ * fit in the buffer then popping the frame must reclaim them.
+ */
+
+static void frame_test(size_t roots_count, int check)
+{
+  mps_frame_t frame;
+  mps_addr_t limit;
+  size_t i;
+
+  die(mps_ap_frame_push(&frame, ap), "mps_ap_frame_push");
+  limit = ap->limit;
+  for (i = 0; i < frameTempCOUNT; ++i)
+    (void)make(roots_count);
+  die(mps_ap_frame_pop(ap, frame), "mps_ap_frame_pop");
+  if (check && ap->limit == limit && (char *)frame < (char *)limit)
+    cdie(ap->init == (mps_addr_t)frame, "frame pop");
+}
+
+
 /* test_stepper -- stepping function for walk */
 
 static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
@@ -128,9 +171,72 @@ static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
 }
 
 
-/* test -- the body of the test */
+/* sampler -- allocation sampler
+ *
+ * Returns a cookie pointing to the sample's state, or NULL to decline
+ * the sample when we've taken enough.
+ */
 
-static void test(mps_pool_class_t pool_class, size_t roots_count)
+static void *sampler(mps_addr_t addr, size_t size, mps_ap_t sampled_ap,
+                     void *closure)
+{
+  testlib_unused(closure);
+  cdie(addr != NULL && size > 0, "sampled allocation");
+  cdie(sampled_ap != NULL, "sampled ap");
+  if (samplesTaken == samplesCOUNT)
+    return NULL;
+  samples[samplesTaken] = sampleTRACKED;
+  return &samples[samplesTaken++];
+}
+
+
+/* sample_stepper -- check the live and dead samples
+ *
+ * Counts the live samples in the size_t pointed to by p.  Each sample
+ * must be reported dead exactly once.
+ */
+
+static void sample_stepper(mps_addr_t addr, void *cookie, mps_bool_t live,
+                           void *p, size_t s)
+{
+  int *state = cookie;
+  testlib_unused(s);
+  cdie(state >= samples && state < samples + samplesTaken, "cookie");
+  cdie(*state == sampleTRACKED, "sample already dead");
+  if (live) {
+    cdie(mps_arena_has_addr(arena, addr), "live sample in arena");
+    ++*(size_t *)p;
+  } else {
+    cdie(addr == NULL, "dead sample address");
+    *state = sampleDEAD;
+  }
+}
+
+
+/* check_samples -- walk the samples and check the books balance */
+
+static void check_samples(size_t *liveReturn)
+{
+  size_t live = 0, dead = 0, i;
+  mps_arena_samples_walk(arena, sample_stepper, &live, 0);
+  for (i = 0; i < samplesTaken; ++i)
+    if (samples[i] == sampleDEAD)
+      ++dead;
+  cdie(live + dead == samplesTaken, "samples balance");
+  *liveReturn = live;
+}
+
+
+/* test -- the body of the test
+ *
+ * promote is the survival rate above which segments are promoted in
+ * place: 0.0 promotes every segment.  If zero is true, the pool must
+ * hand out zeroed memory, and the arena is given idle time in which
+ * to zero its spare memory.
+ */
+
+static void test(mps_pool_class_t pool_class, size_t roots_count,
+                 double promote, mps_bool_t zero)
 {
   mps_fmt_t format;
   mps_chain_t chain;
@@ -143,18 +249,44 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
   mps_addr_t busy_init;
   mps_pool_t pool;
   int described = 0; 
+  size_t liveSamples;
 
   die(dylan_fmt(&format, arena), "fmt_create");
   die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
 
-  die(mps_pool_create(&pool, arena, pool_class, format, chain),
-      "pool_create(amc)");
+  if (pool_class == mps_class_amc()) {
+    /* AMC can't promise zeroed allocation, because its buffers have a
+       rank. <design/poolamc/#zeroed.leaf> */
+    MPS_ARGS_BEGIN(args) {
+      MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+      MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+      MPS_ARGS_ADD(args, MPS_KEY_ZEROED, TRUE);
+      Insist(mps_pool_create_k(&pool, arena, pool_class, args)
+             == MPS_RES_PARAM);
+    } MPS_ARGS_END(args);
+  }
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_PROMOTE_SURVIVAL, promote);
+    MPS_ARGS_ADD(args, MPS_KEY_ZEROED, zero);
+    die(mps_pool_create_k(&pool, arena, pool_class, args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+
+  zeroed = zero;
 
   die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
   die(mps_ap_create(&busy_ap, pool, mps_rank_exact()), "BufferCreate 2");
 
-  for(i = 0; i < exactRootsCOUNT; ++i)
+  samplesTaken = 0;
+  mps_arena_sampler_set(arena, sampleINTERVAL, sampler, NULL);
+
+  for(i = 0; i < exactRootsCOUNT; ++i) {
     exactRoots[i] = objNULL;
+    exactHashed[i] = FALSE;
+  }
   for(i = 0; i < ambigRootsCOUNT; ++i)
     ambigRoots[i] = rnd_addr();
 
@@ -224,10 +356,23 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
       cdie(!mps_arena_has_addr(arena, NULL),
            "NULL in arena");
 
+      check_samples(&liveSamples);
+      printf("%lu of %lu samples live\n", (unsigned long)liveSamples,
+             (unsigned long)samplesTaken);
+
+      /* Identity hashes survive the objects moving. */
+      for (i = 0; i < exactRootsCOUNT; ++i)
+        if (exactHashed[i]) {
+          mps_word_t hash;
+          die(mps_addr_hash(&hash, arena, exactRoots[i]), "mps_addr_hash");
+          cdie(hash == exactHashes[i], "identity hash changed");
+        }
+
       if (collections == collectionsCOUNT / 2) {
         unsigned long object_count = 0;
         mps_arena_park(arena);
         mps_arena_formatted_objects_walk(arena, test_stepper, &object_count, 0);
+        frame_test(roots_count, TRUE);
         mps_arena_release(arena);
         printf("stepped on %lu objects.\n", object_count);
       }
@@ -245,6 +390,7 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
             if (exactRoots[i] != objNULL) {
               cdie(dylan_check(exactRoots[i]), "ramp kill check");
               exactRoots[i] = objNULL;
+              exactHashed[i] = FALSE;
             }
           }
         }
@@ -264,6 +410,10 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
       if (exactRoots[i] != objNULL)
         cdie(dylan_check(exactRoots[i]), "dying root check");
       exactRoots[i] = make(roots_count);
+      exactHashed[i] = (r & 6) == 0;
+      if (exactHashed[i])
+        die(mps_addr_hash(&exactHashes[i], arena, exactRoots[i]),
+            "mps_addr_hash");
       if (exactRoots[(exactRootsCOUNT-1) - i] != objNULL)
         dylan_write(exactRoots[(exactRootsCOUNT-1) - i],
                     exactRoots, exactRootsCOUNT);
@@ -277,6 +427,12 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
     if (r % initTestFREQ == 0)
       *(int*)busy_init = -1; /* check that the buffer is still there */
 
+    if (r % frameTestFREQ == 0)
+      frame_test(roots_count, FALSE);
+
+    if (zeroed && r % stepFREQ == 0)
+      (void)mps_arena_step(arena, 0.001, 0.0);
+
     if (objs % 1024 == 0) {
       report();
       putchar('.');
@@ -293,11 +449,415 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
   mps_root_destroy(exactRoot);
   mps_root_destroy(ambigRoot);
   mps_pool_destroy(pool);
+
+  /* Destroying the pool kills all the samples. */
+  check_samples(&liveSamples);
+  cdie(liveSamples == 0, "samples outlived pool");
+  cdie(samplesTaken > 0, "no samples taken");
+  mps_arena_sampler_set(arena, 0, NULL, NULL);
+
   mps_chain_destroy(chain);
   mps_fmt_destroy(format);
   mps_arena_release(arena);
 }
 
+/* chain_scale_test -- heap growth scales the adapted capacity
+ *
+ * ChainScale measures the heap growth target against the capacity
+ * given by the client program, so a change to the capacity of
+ * generation zero (as made by adaptive chains) is not cancelled out.
+ * See <design/strategy/#policy.growth.capacity>.
+ */
+
+static void chain_scale_test(void)
+{
+  mps_gen_param_s params[1] = {{1, 0.85}};
+  mps_chain_t chain;
+  Chain c;
+  Size capacity, base;
+
+  Insist(mps_arena_heap_growth(arena) > 0.0);
+  Insist(mps_arena_live_size(arena) > 0);
+  die(mps_chain_create(&chain, arena, NELEMS(params), params),
+      "chain_create");
+  c = (Chain)chain;
+  base = c->gens[0].baseCapacity;
+  capacity = ChainCapacity(c, 0);
+  Insist(capacity > base);
+
+  GenDescSetCapacity(&c->gens[0], base * 2);
+  Insist(ChainCapacity(c, 0) >= 2 * capacity - 2);
+  Insist(ChainCapacity(c, 0) <= 2 * capacity + 2);
+  GenDescSetCapacity(&c->gens[0], base);
+  Insist(ChainCapacity(c, 0) == capacity);
+
+  mps_chain_destroy(chain);
+}
+
+/* big_root_test -- incremental scanning of a large area root
+ *
+ * The root is several regions long, so that its scan is deferred at
+ * flip and continued by mps_arena_step and by barrier hits as the
+ * mutator reads and writes it. See <design/root/#region>.
+ */
+
+static void big_root_test(size_t grainSize)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_root_t root;
+  size_t align = grainSize > ((size_t)1 << 18) ? grainSize : (size_t)1 << 18;
+  size_t size = 4 * align, count = size / sizeof(mps_addr_t), i;
+  unsigned long objs;
+  void *block;
+  mps_addr_t *base;
+
+  block = malloc(size + align);
+  cdie(block != NULL, "malloc");
+  base = (mps_addr_t *)(((mps_word_t)block + align - 1)
+                        & ~(mps_word_t)(align - 1));
+  for (i = 0; i < count; ++i)
+    base[i] = objNULL;
+  for (i = 0; i < exactRootsCOUNT; ++i)
+    exactRoots[i] = objNULL;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
+  zeroed = FALSE;
+
+  die(mps_root_create_area_tagged(&root, arena, mps_rank_exact(),
+                                  MPS_RM_PROT | MPS_RM_INCREMENTAL,
+                                  base, base + count,
+                                  mps_scan_area_tagged,
+                                  (mps_word_t)1, (mps_word_t)0),
+      "root_create_area_tagged(incremental)");
+
+  for (objs = 0; objs < bigRootOBJECTS; ++objs) {
+    size_t j = rnd() % count;
+    if (base[j] != objNULL)
+      cdie(dylan_check(base[j]), "big root check");
+    base[j] = make(0);
+    /* Copy a reference between regions, reading one and writing
+       another. */
+    base[rnd() % count] = base[rnd() % count];
+    if (objs % stepFREQ == 0) {
+      (void)mps_arena_step(arena, 0.001, 0.0);
+      report();
+    }
+  }
+
+  mps_arena_collect(arena);
+  for (i = 0; i < count; ++i)
+    cdie(base[i] == objNULL || dylan_check(base[i]), "big root final check");
+
+  mps_arena_park(arena);
+  mps_root_destroy(root);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+  free(block);
+}
+
+
+/* promote_test -- check that promotion in place reclaims dead cycles
+ *
+ * If promote is true, every segment is promoted in place. A live
+ * chain of objects points backwards through its segment, and a dead
+ * cycle shares the segment and must be finalized. If promote is
+ * false, the pool is created with the default threshold, so the
+ * segment must be evacuated.
+ */
+
+static void promote_test(mps_bool_t promote)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_root_t root;
+  mps_addr_t live[1], ref;
+  mps_word_t a, b, c, d, v;
+  mps_message_t message;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    if (promote)
+      MPS_ARGS_ADD(args, MPS_KEY_AMC_PROMOTE_SURVIVAL, 0.0);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
+
+  die(make_dylan_vector(&d, ap, 1), "make_dylan_vector");
+  die(make_dylan_vector(&c, ap, 1), "make_dylan_vector");
+  die(make_dylan_vector(&v, ap, 1), "make_dylan_vector");
+  die(make_dylan_vector(&a, ap, 1), "make_dylan_vector");
+  die(make_dylan_vector(&b, ap, 1), "make_dylan_vector");
+  DYLAN_VECTOR_SLOT(v, 0) = c;
+  DYLAN_VECTOR_SLOT(c, 0) = d;
+  DYLAN_VECTOR_SLOT(a, 0) = b;
+  DYLAN_VECTOR_SLOT(b, 0) = a;
+  live[0] = (mps_addr_t)v;
+  ref = (mps_addr_t)a;
+
+  mps_arena_park(arena);
+  die(mps_root_create_table(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                            live, 1),
+      "root_create_table(exact)");
+  mps_message_type_enable(arena, mps_message_type_finalization());
+  die(mps_finalize(arena, &ref), "finalize");
+  mps_ap_destroy(ap); /* so that the segment can be promoted */
+
+  mps_arena_collect(arena);
+  if (promote) {
+    Insist(live[0] == (mps_addr_t)v);  /* promoted, not moved */
+    Insist(DYLAN_VECTOR_SLOT(v, 0) == c);
+    Insist(DYLAN_VECTOR_SLOT(c, 0) == d);
+  } else {
+    Insist(live[0] != (mps_addr_t)v);  /* evacuated */
+  }
+  cdie(dylan_check(live[0]), "promoted live check");
+
+  /* The dead cycle wasn't scanned, so it wasn't reached. */
+  Insist(mps_message_get(&message, arena, mps_message_type_finalization()));
+  mps_message_finalization_ref(&ref, arena, message);
+  if (promote) {
+    Insist(ref == (mps_addr_t)a);
+  }
+  mps_message_discard(arena, message);
+  mps_message_type_disable(arena, mps_message_type_finalization());
+
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* sample_test -- check which allocations are sampled
+ *
+ * The arena is parked, so the objects stay alive and don't move.
+ * First every sample is declined, and the declined objects mustn't
+ * keep identity hashes.  Then the samples are taken: there must be
+ * about one in every sampleTestINTERVAL bytes allocated, and they
+ * must fall anywhere in the buffers, not only where they were filled.
+ * See <design/arena/#sample>.
+ */
+
+#define sampleTestOBJECTS  20000
+#define sampleTestINTERVAL ((size_t)256)
+
+typedef struct sample_test_s {
+  mps_bool_t take;              /* take the samples? */
+  size_t count;                 /* samples offered */
+  size_t inside;                /* samples not at the base of a grain */
+  size_t grainSize;             /* arena grain size */
+} sample_test_s;
+
+static int sampleTestCookie;
+
+static void *sample_test_sampler(mps_addr_t addr, size_t size,
+                                 mps_ap_t sampled_ap, void *closure)
+{
+  sample_test_s *st = closure;
+  testlib_unused(size);
+  testlib_unused(sampled_ap);
+  ++st->count;
+  if ((mps_word_t)addr % st->grainSize != 0)
+    ++st->inside;
+  return st->take ? &sampleTestCookie : NULL;
+}
+
+static void sample_test_stepper(mps_addr_t addr, void *cookie,
+                                mps_bool_t live, void *p, size_t s)
+{
+  testlib_unused(addr);
+  testlib_unused(s);
+  Insist(cookie == &sampleTestCookie);
+  Insist(!live);
+  ++*(size_t *)p;
+}
+
+static Count hash_count(void)
+{
+  Table table = ((Arena)arena)->hashTable;
+  return table == NULL ? 0 : TableCount(table);
+}
+
+static void sample_test(void)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_word_t v;
+  sample_test_s st;
+  size_t i, slots, bytes, dead;
+  Count hashes;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
+  mps_arena_park(arena);
+
+  st.take = FALSE;
+  st.count = 0;
+  st.inside = 0;
+  st.grainSize = ArenaGrainSize((Arena)arena);
+  hashes = hash_count();
+  mps_arena_sampler_set(arena, sampleTestINTERVAL, sample_test_sampler, &st);
+  for (i = 0; i < sampleTestOBJECTS; ++i)
+    die(make_dylan_vector(&v, ap, 1 + i % 8), "make_dylan_vector");
+  printf("%lu samples declined\n", (unsigned long)st.count);
+  Insist(st.count > 0);
+  Insist(hash_count() == hashes);
+
+  st.take = TRUE;
+  st.count = 0;
+  st.inside = 0;
+  bytes = 0;
+  for (i = 0; i < sampleTestOBJECTS; ++i) {
+    slots = 1 + i % 8;
+    die(make_dylan_vector(&v, ap, slots), "make_dylan_vector");
+    bytes += (slots + 2) * sizeof(mps_word_t);
+  }
+  printf("%lu samples taken in %lu bytes, %lu inside grains\n",
+         (unsigned long)st.count, (unsigned long)bytes,
+         (unsigned long)st.inside);
+  Insist(st.count > bytes / sampleTestINTERVAL / 2);
+  Insist(st.count < bytes / sampleTestINTERVAL * 2);
+  Insist(st.inside > st.count / 2);
+  mps_arena_sampler_set(arena, 0, NULL, NULL);
+
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  dead = 0;
+  mps_arena_samples_walk(arena, sample_test_stepper, &dead, 0);
+  Insist(dead == st.count);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
+/* adapt_test -- adaptive chains grow and shrink the nursery
+ *
+ * Nothing is reachable, so the survival rate of the nursery is low and
+ * its capacity grows.  Then the pause time is set so low that every
+ * collection exceeds it, and the capacity shrinks.  See
+ * <design/strategy/#policy.adapt>.
+ */
+
+#define adaptOBJECTS 1000000
+
+static void adapt_test(void)
+{
+  mps_gen_param_s params[2] = {{64, 0.85}, {256, 0.45}};
+  mps_arena_t adapt_arena;
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t adapt_ap;
+  mps_word_t v;
+  GenDesc gen;
+  Size base, grown;
+  size_t i;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ADAPT_CHAINS, TRUE);
+    die(mps_arena_create_k(&adapt_arena, mps_arena_class_vm(), args),
+        "arena_create(adapt)");
+  } MPS_ARGS_END(args);
+  die(dylan_fmt(&format, adapt_arena), "fmt_create");
+  die(mps_chain_create(&chain, adapt_arena, NELEMS(params), params),
+      "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, adapt_arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&adapt_ap, pool, mps_rank_exact()), "BufferCreate");
+
+  gen = &((Chain)chain)->gens[0];
+  base = gen->baseCapacity;
+  for (i = 0; i < adaptOBJECTS && gen->capacity <= base; ++i)
+    die(make_dylan_vector(&v, adapt_ap, 8), "make_dylan_vector");
+  printf("Nursery grew from %lu to %lu after %lu objects.\n",
+         (unsigned long)base, (unsigned long)gen->capacity,
+         (unsigned long)i);
+  Insist(gen->capacity > base);
+
+  grown = gen->capacity;
+  mps_arena_pause_time_set(adapt_arena, 0.0);
+  for (i = 0; i < adaptOBJECTS && gen->capacity >= grown; ++i)
+    die(make_dylan_vector(&v, adapt_ap, 8), "make_dylan_vector");
+  printf("Nursery shrank from %lu to %lu after %lu objects.\n",
+         (unsigned long)grown, (unsigned long)gen->capacity,
+         (unsigned long)i);
+  Insist(gen->capacity < grown);
+
+  mps_arena_park(adapt_arena);
+  mps_ap_destroy(adapt_ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(adapt_arena);
+}
+
+
+/* pause_stats_test -- check the pause statistics are consistent */
+
+static void pause_stats_test(void)
+{
+  mps_pause_kind_t kind;
+  double window;
+
+  for (kind = MPS_PAUSE_POLL; kind <= MPS_PAUSE_STEP; ++kind) {
+    mps_pause_stats_s stats;
+    mps_arena_pause_stats(arena, kind, &stats);
+    printf("pause kind %u: count %lu total %g max %g"
+           " p50 %g p90 %g p99 %g p99.9 %g\n", kind,
+           (unsigned long)stats.count, stats.total, stats.max,
+           stats.p50, stats.p90, stats.p99, stats.p999);
+    Insist(stats.p50 <= stats.p90);
+    Insist(stats.p90 <= stats.p99);
+    Insist(stats.p99 <= stats.p999);
+    Insist(stats.p999 <= stats.max);
+    Insist(stats.max <= stats.total);
+    Insist(stats.count > 0 || stats.total == 0.0);
+    if (kind == MPS_PAUSE_POLL || kind == MPS_PAUSE_FLIP) {
+      Insist(stats.count > 0);
+    }
+  }
+
+  for (window = 0.0001; window <= 1.0; window *= 10) {
+    double mmu = mps_arena_mmu(arena, window);
+    printf("MMU over %g s: %g\n", window, mmu);
+    Insist(0.0 <= mmu);
+    Insist(mmu <= 1.0);
+  }
+}
+
 int main(int argc, char *argv[])
 {
   size_t i, grainSize;
@@ -318,10 +878,31 @@ int main(int argc, char *argv[])
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_gc_start());
   die(mps_thread_reg(&thread, arena), "thread_reg");
-  test(mps_class_amc(), exactRootsCOUNT);
-  test(mps_class_amcz(), 0);
+
+  /* Schedule the first test by heap growth over the live size. */
+  mps_arena_heap_growth_set(arena, 100.0);
+  Insist(mps_arena_heap_growth(arena) == 100.0);
+  test(mps_class_amc(), exactRootsCOUNT, 0.9, FALSE);
+  Insist(mps_arena_live_size(arena) > 0);
+  chain_scale_test();
+  mps_arena_heap_growth_set(arena, 0.0);
+
+  test(mps_class_amc(), exactRootsCOUNT, 0.0, FALSE);
+
+  /* Pace the remaining tests to a minimum mutator utilization. */
+  mps_arena_mmu_target_set(arena, 0.5, 0.01);
+  Insist(mps_arena_mmu_target(arena) == 0.5);
+  Insist(mps_arena_mmu_window(arena) == 0.01);
+  test(mps_class_amcz(), 0, 0.0, FALSE);
+  test(mps_class_amcz(), 0, 0.9, TRUE);
+  big_root_test(grainSize);
+  promote_test(TRUE);
+  promote_test(FALSE);
+  sample_test();
+  adapt_test();
   mps_thread_dereg(thread);
   report();
+  pause_stats_test();
   mps_arena_destroy(arena);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
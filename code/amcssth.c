@@ -7,7 +7,10 @@
  * The main thread parks the arena half way through the test case and
  * runs mps_arena_formatted_objects_walk(). This checks that walking
  * works while the other threads continue to allocate in the
- * background.
+ * background. It then walks the objects again with
+ * mps_arena_formatted_objects_walk_parallel() on several threads, and
+ * checks that the workers visit at least as many objects.  (The other
+ * threads keep allocating, so the exact comparison is in walkt0.c.)
  */
 
 #include "fmtdy.h"
@@ -86,6 +89,43 @@ static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
 }
 
 
+/* walk_runner -- run the workers of a parallel walk on threads */
+
+#define walkWORKERS 4
+
+typedef struct walk_worker_s {
+  mps_walk_work_t work;
+  void *work_p;
+  size_t worker;
+} walk_worker_s;
+
+static void *walk_worker_thread(void *arg)
+{
+  walk_worker_s *w = arg;
+  (*w->work)(w->work_p, w->worker);
+  return NULL;
+}
+
+static void walk_runner(mps_walk_work_t work, void *work_p, size_t workers,
+                        void *p)
+{
+  testthr_t threads[walkWORKERS];
+  walk_worker_s ws[walkWORKERS];
+  size_t i;
+
+  Insist(workers == walkWORKERS);
+  testlib_unused(p);
+  for (i = 0; i < workers; ++i) {
+    ws[i].work = work;
+    ws[i].work_p = work_p;
+    ws[i].worker = i;
+    testthr_create(&threads[i], walk_worker_thread, &ws[i]);
+  }
+  for (i = 0; i < workers; ++i)
+    testthr_join(&threads[i], NULL);
+}
+
+
 /* churn -- create an object and install into roots */
 
 static void churn(mps_ap_t ap, size_t roots_count)
@@ -209,11 +249,27 @@ static void test_pool(const char *name, mps_pool_t pool, size_t roots_count)
 
         if (collections >= collectionsCOUNT / 2 && !walked)
         {
-          unsigned long count = 0;
+          unsigned long count = 0, total = 0;
+          unsigned long counts[walkWORKERS];
+          void *ps[walkWORKERS];
           mps_arena_park(arena);
           mps_arena_formatted_objects_walk(arena, test_stepper, &count, 0);
+          for (i = 0; i < walkWORKERS; ++i) {
+            counts[i] = 0;
+            ps[i] = &counts[i];
+          }
+          die(mps_arena_formatted_objects_walk_parallel(arena, test_stepper,
+                                                        ps, 0, walkWORKERS,
+                                                        walk_runner, NULL),
+              "mps_arena_formatted_objects_walk_parallel");
           mps_arena_release(arena);
-          printf("stepped on %lu objects.\n", count);
+          for (i = 0; i < walkWORKERS; ++i)
+            total += counts[i];
+          printf("stepped on %lu objects, then %lu in parallel.\n",
+                 count, total);
+          /* The other threads may allocate while the arena is parked, */
+          /* but nothing dies. */
+          cdie(total >= count, "parallel walk count");
           walked = TRUE;
         }
         if (collections >= rampSwitch && !ramped) {
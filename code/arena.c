@@ -40,6 +40,9 @@ Bool ArenaGrainSizeCheck(Size size)
 /* Forward declarations */
 
 static void ArenaTrivCompact(Arena arena, Trace trace);
+static void ArenaTrivZero(Arena arena, Addr base, Addr limit);
+static Size ArenaNoZeroSpare(Arena arena, Size size);
+static void ArenaTrivDecaySpare(Arena arena);
 static void arenaFreePage(Arena arena, Addr base, Pool pool);
 static void arenaFreeLandFinish(Arena arena);
 static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args);
@@ -124,6 +127,9 @@ DEFINE_CLASS(Arena, AbstractArena, klass)
   klass->create = ArenaNoCreate;
   klass->destroy = ArenaNoDestroy;
   klass->purgeSpare = ArenaNoPurgeSpare;
+  klass->zero = ArenaTrivZero;
+  klass->zeroSpare = ArenaNoZeroSpare;
+  klass->decaySpare = ArenaTrivDecaySpare;
   klass->extend = ArenaNoExtend;
   klass->grow = ArenaNoGrow;
   klass->free = ArenaNoFree;
@@ -148,6 +154,9 @@ Bool ArenaClassCheck(ArenaClass klass)
   CHECKL(FUNCHECK(klass->create));
   CHECKL(FUNCHECK(klass->destroy));
   CHECKL(FUNCHECK(klass->purgeSpare));
+  CHECKL(FUNCHECK(klass->zero));
+  CHECKL(FUNCHECK(klass->zeroSpare));
+  CHECKL(FUNCHECK(klass->decaySpare));
   CHECKL(FUNCHECK(klass->extend));
   CHECKL(FUNCHECK(klass->grow));
   CHECKL(FUNCHECK(klass->free));
@@ -193,6 +202,24 @@ Bool ArenaCheck(Arena arena)
   CHECKL(0.0 <= arena->spare);
   CHECKL(arena->spare <= 1.0);
   CHECKL(0.0 <= arena->pauseTime);
+  CHECKL(0.0 <= arena->spareDecay);
+  CHECKL(0.0 <= arena->mmuTarget);
+  CHECKL(arena->mmuTarget < 1.0);
+  CHECKL(0.0 < arena->mmuWindow);
+  CHECKL(0.0 <= arena->heapGrowth);
+  CHECKL(BoolCheck(arena->adaptChains));
+  /* nothing to check for memoryTarget or probedTarget */
+  CHECKL(arena->pressureProbe == NULL || FUNCHECK(arena->pressureProbe));
+  /* can't check pressureClosure */
+  CHECKL(0.0 <= arena->pressure);
+  CHECKL(0.0 <= arena->pressureSpare);
+  CHECKL(arena->pressureSpare <= 1.0);
+  CHECKL(0.0 <= arena->idleTime);
+  if (arena->idleTimer != NULL)
+    CHECKL(ThreadTimerCheck(arena->idleTimer));
+  CHECKL(0.0 <= arena->idleFillSize);
+  /* nothing to check for idleTicks */
+  /* nothing to check for liveSize */
 
   CHECKL(arena->zoneShift == ZoneShiftUNSET
          || ShiftCheck(arena->zoneShift));
@@ -238,6 +265,15 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   Size commitLimit = ARENA_DEFAULT_COMMIT_LIMIT;
   double spare = ARENA_SPARE_DEFAULT;
   double pauseTime = ARENA_DEFAULT_PAUSE_TIME;
+  double spareDecay = ARENA_DEFAULT_SPARE_DECAY;
+  double mmuTarget = ARENA_DEFAULT_MMU_TARGET;
+  double mmuWindow = ARENA_DEFAULT_MMU_WINDOW;
+  double heapGrowth = ARENA_DEFAULT_HEAP_GROWTH;
+  Bool adaptChains = ARENA_DEFAULT_ADAPT_CHAINS;
+  Size memoryTarget = ARENA_DEFAULT_MEMORY_TARGET;
+  mps_pressure_probe_t pressureProbe = NULL;
+  void *pressureClosure = NULL;
+  double idleTime = ARENA_DEFAULT_IDLE_TIME;
   mps_arg_s arg;
 
   AVER(arena != NULL);
@@ -258,6 +294,25 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
     spare = arg.val.d;
   if (ArgPick(&arg, args, MPS_KEY_PAUSE_TIME))
     pauseTime = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_SPARE_DECAY))
+    spareDecay = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_MMU_TARGET))
+    mmuTarget = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_MMU_WINDOW))
+    mmuWindow = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_HEAP_GROWTH))
+    heapGrowth = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_ADAPT_CHAINS))
+    adaptChains = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_MEMORY_TARGET))
+    memoryTarget = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_PRESSURE_PROBE))
+    pressureProbe = arg.val.pressure_probe;
+  if (ArgPick(&arg, args, MPS_KEY_PRESSURE_CLOSURE))
+    pressureClosure = arg.val.p;
+  if (ArgPick(&arg, args, MPS_KEY_IDLE_TIME))
+    idleTime = arg.val.d;
+  AVER(0.0 <= idleTime);
 
   /* Superclass init */
   InstInit(CouldBeA(Inst, arena));
@@ -268,6 +323,28 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->spareCommitted = (Size)0;
   arena->spare = spare;
   arena->pauseTime = pauseTime;
+  arena->spareDecay = spareDecay;
+  arena->lastSpareDecay = ClockNow();
+  arena->mmuTarget = mmuTarget;
+  arena->mmuWindow = mmuWindow;
+  arena->heapGrowth = heapGrowth;
+  arena->liveSize = (Size)0;
+  arena->adaptChains = adaptChains;
+  arena->memoryTarget = memoryTarget;
+  arena->pressureProbe = pressureProbe;
+  arena->pressureClosure = pressureClosure;
+  /* Probe at once, so that the first poll has a target to work to. */
+  arena->probedTarget = pressureProbe == NULL ? (Size)0
+                        : (*pressureProbe)(pressureClosure);
+  arena->lastPressureProbe = ClockNow();
+  arena->pressure = 0.0;
+  arena->pressureSpare = 1.0;
+  /* The idle timer is started by ArenaCreate <design/arena/#idle>. */
+  arena->idleTime = idleTime;
+  arena->idleTimer = NULL;
+  arena->idleFillSize = 0.0;
+  arena->idleTicks = 0;
+  arena->zeroedPools = 0;
   arena->grainSize = grainSize;
   /* zoneShift must be overridden by arena class init */
   arena->zoneShift = ZoneShiftUNSET;
@@ -329,6 +406,7 @@ failGlobalsInit:
  * exist on all platforms. */
 
 ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
+ARG_DEFINE_KEY(ARENA_HUGE_PAGES, Bool);
 
 
 /* ArenaCreate -- create the arena and call initializers */
@@ -339,6 +417,15 @@ ARG_DEFINE_KEY(ARENA_ZONED, Bool);
 ARG_DEFINE_KEY(COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(SPARE_COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(PAUSE_TIME, double);
+ARG_DEFINE_KEY(SPARE_DECAY, double);
+ARG_DEFINE_KEY(MMU_TARGET, double);
+ARG_DEFINE_KEY(MMU_WINDOW, double);
+ARG_DEFINE_KEY(HEAP_GROWTH, double);
+ARG_DEFINE_KEY(ADAPT_CHAINS, Bool);
+ARG_DEFINE_KEY(MEMORY_TARGET, Size);
+ARG_DEFINE_KEY(PRESSURE_PROBE, Fun);
+ARG_DEFINE_KEY(PRESSURE_CLOSURE, Pointer);
+ARG_DEFINE_KEY(IDLE_TIME, double);
 
 static Res arenaFreeLandInit(Arena arena)
 {
@@ -419,10 +506,18 @@ Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args)
   if (res != ResOK)
     goto failGlobalsCompleteCreate;
 
+  /* Start the idle timer now that the arena is locked and complete.
+     See <design/arena/#idle>. */
+  res = ArenaSetIdleTime(arena, arena->idleTime);
+  if (res != ResOK)
+    goto failIdleTime;
+
   AVERT(Arena, arena);
   *arenaReturn = arena;
   return ResOK;
 
+failIdleTime:
+  GlobalsPrepareToDestroy(ArenaGlobals(arena));
 failGlobalsCompleteCreate:
   ControlFinish(arena);
 failControlInit:
@@ -441,6 +536,7 @@ static void ArenaAbsFinish(Inst inst)
 {
   Arena arena = MustBeA(AbstractArena, inst);
   AVERC(Arena, arena);
+  AVER(arena->zeroedPools == 0);
   PoolFinish(ArenaCBSBlockPool(arena));
   arena->sig = SigInvalid;
   NextMethod(Inst, AbstractArena, finish)(inst);
@@ -564,6 +660,19 @@ static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "commitLimit      $W\n", (WriteFW)arena->commitLimit,
                "spareCommitted   $W\n", (WriteFW)arena->spareCommitted,
                "spare            $D\n", (WriteFD)arena->spare,
+               "spareDecay       $D\n", (WriteFD)arena->spareDecay,
+               "mmuTarget        $D\n", (WriteFD)arena->mmuTarget,
+               "mmuWindow        $D\n", (WriteFD)arena->mmuWindow,
+               "heapGrowth       $D\n", (WriteFD)arena->heapGrowth,
+               "liveSize         $W\n", (WriteFW)arena->liveSize,
+               "adaptChains      $S\n", WriteFYesNo(arena->adaptChains),
+               "memoryTarget     $W\n", (WriteFW)arena->memoryTarget,
+               "probedTarget     $W\n", (WriteFW)arena->probedTarget,
+               "pressure         $D\n", (WriteFD)arena->pressure,
+               "pressureSpare    $D\n", (WriteFD)arena->pressureSpare,
+               "idleTime         $D\n", (WriteFD)arena->idleTime,
+               "idleTimer        $P\n", (WriteFP)arena->idleTimer,
+               "idleTicks        $U\n", (WriteFU)arena->idleTicks,
                "zoneShift        $U\n", (WriteFU)arena->zoneShift,
                "grainSize        $W\n", (WriteFW)arena->grainSize,
                "lastTract        $P\n", (WriteFP)arena->lastTract,
@@ -715,6 +824,30 @@ void ControlFree(Arena arena, void* base, size_t size)
 }
 
 
+/* ControlTableAlloc, ControlTableFree -- table memory from the control pool
+ *
+ * These have the signatures of the allocator and deallocator passed
+ * to TableCreate, with the arena as the closure, so that a table
+ * used by the MPS itself can keep its entries in the control pool.
+ */
+
+void *ControlTableAlloc(void *closure, size_t size)
+{
+  void *p;
+  Res res;
+
+  res = ControlAlloc(&p, (Arena)closure, size);
+  if (res != ResOK)
+    return NULL;
+  return p;
+}
+
+void ControlTableFree(void *closure, void *p, size_t size)
+{
+  ControlFree((Arena)closure, p, size);
+}
+
+
 /* ControlDescribe -- describe the arena's control pool */
 
 Res ControlDescribe(Arena arena, mps_lib_FILE *stream, Count depth)
@@ -1220,6 +1353,72 @@ void ArenaSetPauseTime(Arena arena, double pauseTime)
   EVENT2(PauseTimeSet, arena, pauseTime);
 }
 
+double ArenaSpareDecay(Arena arena)
+{
+  AVERT(Arena, arena);
+  return arena->spareDecay;
+}
+
+void ArenaSetSpareDecay(Arena arena, double spareDecay)
+{
+  AVERT(Arena, arena);
+  AVER(0.0 <= spareDecay);
+  arena->spareDecay = spareDecay;
+  EVENT2(SpareDecaySet, arena, spareDecay);
+}
+
+double ArenaMMUTarget(Arena arena)
+{
+  AVERT(Arena, arena);
+  return arena->mmuTarget;
+}
+
+double ArenaMMUWindow(Arena arena)
+{
+  AVERT(Arena, arena);
+  return arena->mmuWindow;
+}
+
+void ArenaSetMMUTarget(Arena arena, double mmuTarget, double mmuWindow)
+{
+  AVERT(Arena, arena);
+  AVER(0.0 <= mmuTarget);
+  AVER(mmuTarget < 1.0);
+  AVER(0.0 < mmuWindow);
+  arena->mmuTarget = mmuTarget;
+  arena->mmuWindow = mmuWindow;
+  EVENT3(MMUTargetSet, arena, mmuTarget, mmuWindow);
+}
+
+double ArenaHeapGrowth(Arena arena)
+{
+  AVERT(Arena, arena);
+  return arena->heapGrowth;
+}
+
+void ArenaSetHeapGrowth(Arena arena, double heapGrowth)
+{
+  AVERT(Arena, arena);
+  AVER(0.0 <= heapGrowth);
+  arena->heapGrowth = heapGrowth;
+  EVENT2(HeapGrowthSet, arena, heapGrowth);
+}
+
+Size ArenaMemoryTarget(Arena arena)
+{
+  AVERT(Arena, arena);
+  return arena->memoryTarget;
+}
+
+void ArenaSetMemoryTarget(Arena arena, Size memoryTarget)
+{
+  AVERT(Arena, arena);
+  arena->memoryTarget = memoryTarget;
+  EVENT2(MemoryTargetSet, arena, memoryTarget);
+  /* Respond to a lowered target at once, not at the next poll. */
+  ArenaUpdatePressure(arena, ClockNow());
+}
+
 /* Used by arenas which don't use spare committed memory */
 Size ArenaNoPurgeSpare(Arena arena, Size size)
 {
@@ -1317,6 +1516,335 @@ void ArenaAccumulateTime(Arena arena, Clock start, Clock end)
 }
 
 
+/* Pause statistics -- see <design/arena/#pause>
+ *
+ * .pause.bucket: Pauses shorter than 2^PauseHistSUB_SHIFT clocks each
+ * get their own bucket.  Longer pauses are bucketed by their highest
+ * set bit and the PauseHistSUB_SHIFT bits below it.
+ */
+
+static Index pauseBucket(Clock clocks)
+{
+  Shift e;
+
+  if (clocks < ((Clock)1 << PauseHistSUB_SHIFT))
+    return (Index)clocks;
+  e = SizeFloorLog2((Size)clocks);
+  if (e >= PauseHistEXP_LIMIT)
+    return PauseHistBUCKETS - 1;
+  return ((Index)(e - PauseHistSUB_SHIFT + 1) << PauseHistSUB_SHIFT)
+    + (Index)((clocks >> (e - PauseHistSUB_SHIFT))
+              & (((Clock)1 << PauseHistSUB_SHIFT) - 1));
+}
+
+/* pauseBucketLimit -- smallest pause that belongs in a later bucket */
+
+static Clock pauseBucketLimit(Index i)
+{
+  Shift e;
+  Clock sub;
+
+  AVER(i < PauseHistBUCKETS);
+  if (i < ((Index)1 << PauseHistSUB_SHIFT))
+    return (Clock)i + 1;
+  e = (Shift)(i >> PauseHistSUB_SHIFT) + PauseHistSUB_SHIFT - 1;
+  sub = (Clock)i & (((Clock)1 << PauseHistSUB_SHIFT) - 1);
+  return (((Clock)1 << PauseHistSUB_SHIFT) + sub + 1)
+    << (e - PauseHistSUB_SHIFT);
+}
+
+void PauseStatsInit(PauseStats stats)
+{
+  PauseKind kind;
+  Index i;
+
+  AVER(stats != NULL);
+
+  for (kind = 0; kind < PauseKindLIMIT; ++kind) {
+    PauseHist hist = &stats->hist[kind];
+    hist->count = 0;
+    hist->total = 0;
+    hist->max = 0;
+    for (i = 0; i < PauseHistBUCKETS; ++i)
+      hist->bucket[i] = 0;
+  }
+  stats->logNext = 0;
+  stats->logCount = 0;
+
+  stats->sig = PauseStatsSig;
+  AVERT(PauseStats, stats);
+}
+
+Bool PauseStatsCheck(PauseStats stats)
+{
+  PauseKind kind;
+
+  CHECKS(PauseStats, stats);
+  for (kind = 0; kind < PauseKindLIMIT; ++kind) {
+    PauseHist hist = &stats->hist[kind];
+    CHECKL(hist->max <= hist->total);
+    CHECKL(hist->count > 0 || hist->total == 0);
+  }
+  CHECKL(stats->logNext < PauseLogLENGTH);
+  CHECKL(stats->logCount <= PauseLogLENGTH);
+  return TRUE;
+}
+
+void PauseStatsFinish(PauseStats stats)
+{
+  AVERT(PauseStats, stats);
+  stats->sig = SigInvalid;
+}
+
+Res PauseStatsDescribe(PauseStats stats, mps_lib_FILE *stream, Count depth)
+{
+  Res res;
+  PauseKind kind;
+
+  if (!TESTT(PauseStats, stats))
+    return ResPARAM;
+  if (stream == NULL)
+    return ResPARAM;
+
+  res = WriteF(stream, depth,
+               "PauseStats $P {\n", (WriteFP)stats,
+               "  logCount $U\n", (WriteFU)stats->logCount,
+               NULL);
+  if (res != ResOK)
+    return res;
+
+  for (kind = 0; kind < PauseKindLIMIT; ++kind) {
+    PauseHist hist = &stats->hist[kind];
+    res = WriteF(stream, depth + 2,
+                 "[$U] count $U total $W max $W\n",
+                 (WriteFU)kind, (WriteFU)hist->count,
+                 (WriteFW)hist->total, (WriteFW)hist->max,
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+
+  res = WriteF(stream, depth, "} PauseStats $P\n", (WriteFP)stats, NULL);
+  if (res != ResOK)
+    return res;
+
+  return ResOK;
+}
+
+
+/* PauseStatsRecord -- record a pause of the given kind
+ *
+ * Flips happen inside polls, steps, and collections, so they are not
+ * logged for MMU.  Steps and collections are requested by the client,
+ * so only polls and barrier hits are logged.  See
+ * <design/arena/#pause.log>.
+ */
+
+void PauseStatsRecord(PauseStats stats, PauseKind kind,
+                      Clock start, Clock end)
+{
+  PauseHist hist;
+  Clock clocks;
+
+  AVERT(PauseStats, stats);
+  AVER(kind < PauseKindLIMIT);
+  AVER(start <= end);
+
+  clocks = end - start;
+  hist = &stats->hist[kind];
+  ++hist->count;
+  hist->total += clocks;
+  if (clocks > hist->max)
+    hist->max = clocks;
+  ++hist->bucket[pauseBucket(clocks)];
+
+  if (kind == PauseKindPOLL || kind == PauseKindACCESS) {
+    PauseLogEntryStruct *entry = &stats->log[stats->logNext];
+    entry->start = start;
+    entry->end = end;
+    stats->logNext = (stats->logNext + 1) % PauseLogLENGTH;
+    if (stats->logCount < PauseLogLENGTH)
+      ++stats->logCount;
+  }
+}
+
+Count PauseStatsCount(PauseStats stats, PauseKind kind)
+{
+  AVERT(PauseStats, stats);
+  AVER(kind < PauseKindLIMIT);
+  return stats->hist[kind].count;
+}
+
+Clock PauseStatsTotal(PauseStats stats, PauseKind kind)
+{
+  AVERT(PauseStats, stats);
+  AVER(kind < PauseKindLIMIT);
+  return stats->hist[kind].total;
+}
+
+Clock PauseStatsMax(PauseStats stats, PauseKind kind)
+{
+  AVERT(PauseStats, stats);
+  AVER(kind < PauseKindLIMIT);
+  return stats->hist[kind].max;
+}
+
+
+/* PauseStatsPercentile -- estimate a percentile of the pause times
+ *
+ * Returns an upper bound on the shortest pause that is at least as
+ * long as the given fraction of pauses of the kind, accurate to the
+ * width of a bucket, or zero if there have been no pauses.
+ */
+
+Clock PauseStatsPercentile(PauseStats stats, PauseKind kind,
+                           double fraction)
+{
+  PauseHist hist;
+  Count rank, seen;
+  Index i;
+
+  AVERT(PauseStats, stats);
+  AVER(kind < PauseKindLIMIT);
+  AVER(0.0 <= fraction);
+  AVER(fraction <= 1.0);
+
+  hist = &stats->hist[kind];
+  if (hist->count == 0)
+    return 0;
+
+  /* rank is the 1-based rank of the pause we're looking for */
+  rank = (Count)(fraction * (double)hist->count);
+  if ((double)rank < fraction * (double)hist->count)
+    ++rank;
+  if (rank == 0)
+    rank = 1;
+
+  seen = 0;
+  for (i = 0; i < PauseHistBUCKETS; ++i) {
+    seen += hist->bucket[i];
+    if (seen >= rank) {
+      Clock limit = pauseBucketLimit(i) - 1;
+      return limit < hist->max ? limit : hist->max;
+    }
+  }
+  NOTREACHED;
+  return hist->max;
+}
+
+
+/* pauseLogEntry -- return the i'th oldest logged pause */
+
+static PauseLogEntryStruct *pauseLogEntry(PauseStats stats, Index i)
+{
+  AVER(i < stats->logCount);
+  return &stats->log[(stats->logNext + PauseLogLENGTH - stats->logCount + i)
+                     % PauseLogLENGTH];
+}
+
+
+/* PauseStatsMMU -- minimum mutator utilization
+ *
+ * Returns the smallest fraction of any window of the given length,
+ * within the span of the pause log, that was not spent in polls or
+ * barrier hits.  The least utilized window always either starts at the
+ * start of a pause or ends at the end of one, so only those windows
+ * need to be considered.  Pauses don't overlap, because they are all
+ * made with the arena lock held, so the log is in time order.
+ */
+
+double PauseStatsMMU(PauseStats stats, Clock window)
+{
+  double mmu = 1.0;
+  Index i, j;
+
+  AVERT(PauseStats, stats);
+  AVER(window > 0);
+
+  for (i = 0; i < stats->logCount; ++i) {
+    PauseLogEntryStruct *pause = pauseLogEntry(stats, i);
+    Clock busy;
+    double utilization;
+
+    /* Window starting at the start of pause i. */
+    busy = 0;
+    for (j = i; j < stats->logCount; ++j) {
+      PauseLogEntryStruct *other = pauseLogEntry(stats, j);
+      if (other->start - pause->start >= window)
+        break;
+      if (other->end - pause->start >= window)
+        busy += window - (other->start - pause->start);
+      else
+        busy += other->end - other->start;
+    }
+    utilization = 1.0 - (double)busy / (double)window;
+    if (utilization < mmu)
+      mmu = utilization;
+
+    /* Window ending at the end of pause i. */
+    busy = 0;
+    for (j = i + 1; j > 0; --j) {
+      PauseLogEntryStruct *other = pauseLogEntry(stats, j - 1);
+      if (pause->end - other->end >= window)
+        break;
+      if (pause->end - other->start >= window)
+        busy += window - (pause->end - other->end);
+      else
+        busy += other->end - other->start;
+    }
+    utilization = 1.0 - (double)busy / (double)window;
+    if (utilization < mmu)
+      mmu = utilization;
+  }
+
+  return mmu < 0.0 ? 0.0 : mmu;
+}
+
+
+/* PauseStatsSince -- time spent in logged pauses since a given time */
+
+Clock PauseStatsSince(PauseStats stats, Clock since)
+{
+  Clock busy = 0;
+  Index i;
+
+  AVERT(PauseStats, stats);
+
+  for (i = stats->logCount; i > 0; --i) {
+    PauseLogEntryStruct *pause = pauseLogEntry(stats, i - 1);
+    if (pause->end <= since)
+      break;
+    if (pause->start < since)
+      busy += pause->end - since;
+    else
+      busy += pause->end - pause->start;
+  }
+
+  return busy;
+}
+
+
+/* PauseStatsMaxSince -- longest logged pause that ended after a time */
+
+Clock PauseStatsMaxSince(PauseStats stats, Clock since)
+{
+  Clock max = 0;
+  Index i;
+
+  AVERT(PauseStats, stats);
+
+  for (i = stats->logCount; i > 0; --i) {
+    PauseLogEntryStruct *pause = pauseLogEntry(stats, i - 1);
+    if (pause->end <= since)
+      break;
+    if (pause->end - pause->start > max)
+      max = pause->end - pause->start;
+  }
+
+  return max;
+}
+
+
 /* ArenaExtend -- Add a new chunk in the arena */
 
 Res ArenaExtend(Arena arena, Addr base, Size size)
@@ -1365,6 +1893,143 @@ static void ArenaTrivCompact(Arena arena, Trace trace)
 }
 
 
+/* ArenaZero -- fill freshly allocated memory with zeros
+ *
+ * The range must be whole grains allocated to a pool, and the pool
+ * must not have written to it since it was allocated.  The arena
+ * class may skip memory that it knows is already zero.  See
+ * <design/arena/#zero>.
+ */
+
+void ArenaZero(Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  AVER(base < limit);
+  AVER(AddrIsArenaGrain(base, arena));
+  AVER(AddrIsArenaGrain(limit, arena));
+  Method(Arena, arena, zero)(arena, base, limit);
+}
+
+/* Used by arenas which know nothing about the contents of their memory */
+static void ArenaTrivZero(Arena arena, Addr base, Addr limit)
+{
+  UNUSED(arena);
+  (void)AddrSet(base, 0, AddrOffset(base, limit));
+}
+
+
+/* ArenaZeroSpare -- zero some spare committed memory
+ *
+ * Zero up to size bytes of spare committed memory, so that it need
+ * not be zeroed when it is next allocated.  Returns the amount of
+ * memory zeroed, which is zero if there is nothing left to zero, or
+ * if no pool needs zeroed memory.  See <design/arena/#zero.spare>.
+ */
+
+Size ArenaZeroSpare(Arena arena, Size size)
+{
+  AVERT(Arena, arena);
+  if (arena->zeroedPools == 0)
+    return 0;
+  return Method(Arena, arena, zeroSpare)(arena, size);
+}
+
+/* Used by arenas which don't use spare committed memory */
+static Size ArenaNoZeroSpare(Arena arena, Size size)
+{
+  AVERT(Arena, arena);
+  UNUSED(size);
+  return 0;
+}
+
+
+/* ArenaDecaySpare -- age spare committed memory
+ *
+ * If the spare decay time has passed since spare committed memory was
+ * last aged, age it again.  Spare memory is returned to the operating
+ * system in two stages: first the operating system is told that it
+ * may discard the contents, and then, one decay time later, it is
+ * unmapped.  A decay time of zero means that spare memory does not
+ * decay.  See <design/arena/#spare.decay>.
+ */
+
+void ArenaDecaySpare(Arena arena, Clock now)
+{
+  AVERT(Arena, arena);
+  if (arena->spareDecay == 0.0)
+    return;
+  if (now - arena->lastSpareDecay
+      < (Clock)(arena->spareDecay * (double)ClocksPerSec()))
+    return;
+  arena->lastSpareDecay = now;
+  Method(Arena, arena, decaySpare)(arena);
+}
+
+/* ArenaUpdatePressure -- respond to memory pressure
+ *
+ * Measure the memory pressure: the ratio of committed memory to the
+ * soft target, which is the target most recently returned by the
+ * client's probe if it returned one, or else the memory target.  As
+ * the pressure rises from ArenaPressureLOW to 1.0, reduce the
+ * fraction of the spare allowance that the arena may keep, and purge
+ * any spare memory over the reduced allowance.  The policy starts
+ * collections when the pressure reaches 1.0.  See
+ * <design/arena/#pressure>.
+ */
+
+void ArenaUpdatePressure(Arena arena, Clock now)
+{
+  Size target, spareMax;
+  double pressure, pressureSpare;
+
+  AVERT(Arena, arena);
+
+  if (arena->pressureProbe != NULL
+      && now - arena->lastPressureProbe
+         >= (Clock)(ArenaPressurePROBE_INTERVAL * (double)ClocksPerSec()))
+  {
+    arena->lastPressureProbe = now;
+    arena->probedTarget = (*arena->pressureProbe)(arena->pressureClosure);
+  }
+
+  target = arena->probedTarget;
+  if (target == 0)
+    target = arena->memoryTarget;
+  if (target == 0) {
+    arena->pressure = 0.0;
+    arena->pressureSpare = 1.0;
+    return;
+  }
+
+  pressure = (double)ArenaCommitted(arena) / (double)target;
+  if (pressure <= ArenaPressureLOW)
+    pressureSpare = 1.0;
+  else if (pressure >= 1.0)
+    pressureSpare = 0.0;
+  else
+    pressureSpare = (1.0 - pressure) / (1.0 - ArenaPressureLOW);
+  arena->pressureSpare = pressureSpare;
+
+  spareMax = ArenaSpareCommitLimit(arena);
+  if (arena->spareCommitted > spareMax) {
+    Size excess = arena->spareCommitted - spareMax;
+    (void)Method(Arena, arena, purgeSpare)(arena, excess);
+  }
+
+  /* Purging may have reduced the committed memory. */
+  arena->pressure = (double)ArenaCommitted(arena) / (double)target;
+  if (pressure > ArenaPressureLOW)
+    EVENT4(MemoryPressure, arena, target, ArenaCommitted(arena),
+           arena->pressure);
+}
+
+/* Used by arenas which don't use spare committed memory */
+static void ArenaTrivDecaySpare(Arena arena)
+{
+  AVERT(Arena, arena);
+}
+
+
 /* Has Addr */
 
 Bool ArenaHasAddr(Arena arena, Addr addr)
@@ -402,7 +402,8 @@ static void testAllocAndIterate(Arena arena, Pool pool,
 }
 
 
-static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
+static void testPageTable(ArenaClass klass, Size size, Addr addr,
+                          Bool zoned, Bool hugePages)
 {
   Arena arena; Pool pool;
   Size pageSize;
@@ -412,6 +413,7 @@ static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_CL_BASE, addr);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, hugePages);
     die(ArenaCreate(&arena, klass, args), "ArenaCreate");
   } MPS_ARGS_END(args);
 
@@ -473,12 +475,17 @@ int main(int argc, char *argv[])
 
   testlib_init(argc, argv);
 
-  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, TRUE);
-  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                TRUE, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                FALSE, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0,
+                TRUE, TRUE);
 
   block = malloc(TEST_ARENA_SIZE);
   cdie(block != NULL, "malloc");
-  testPageTable((ArenaClass)mps_arena_class_cl(), TEST_ARENA_SIZE, block, FALSE);
+  testPageTable((ArenaClass)mps_arena_class_cl(), TEST_ARENA_SIZE, block,
+                FALSE, FALSE);
 
   testSize(TEST_ARENA_SIZE);
 
@@ -12,6 +12,16 @@
  * pointers, and Count with size_t (Index), because all refer to the
  * virtual address space.
  *
+ * .huge: If the chunk's VM uses huge pages (VMHugePageSize is larger
+ * than the page size) then the chunk is aligned to huge pages. When
+ * an allocation maps fresh pages, the rest of each huge page around
+ * it is mapped too and made spare (pagesMapSpare), so that the
+ * operating system can back it with a single huge page. When spare
+ * pages are purged, a huge page that is completely spare is unmapped
+ * whole, rather than split (chunkUnmapAroundPage), and spare pages
+ * only decay in whole huge pages (VMDecaySpare). See
+ * <design/arenavm/#huge>.
+ *
  *
  * IMPROVEMENTS
  *
@@ -45,6 +55,7 @@ typedef struct VMChunkStruct {
   VMStruct vmStruct;            /* virtual memory descriptor */
   Addr overheadMappedLimit;     /* limit of pages mapped for overhead */
   SparseArrayStruct pages;      /* to manage backing store of page table */
+  BT zeroed;                    /* pages known to contain only zeros */
   Sig sig;                      /* <design/sig/> */
 } VMChunkStruct;
 
@@ -73,6 +84,8 @@ typedef struct VMArenaStruct {  /* VM arena structure */
   VMStruct vmStruct;            /* VM descriptor for VM containing arena */
   char vmParams[VMParamSize];   /* VM parameter block */
   Size spareSize;               /* total size of spare pages */
+  Size spareDirty;              /* size of spare pages not known zero */
+  Size spareLazy;               /* size of lazily freed spare pages */
   Size extendBy;                /* desired arena increment */
   Size extendMin;               /* minimum arena increment */
   ArenaVMExtendedCallback extended;
@@ -114,6 +127,9 @@ static Bool VMChunkCheck(VMChunk vmchunk)
   CHECKL(chunk->base < (Addr)vmchunk->pages.pages);
   CHECKL(AddrAdd(vmchunk->pages.pages, BTSize(chunk->pageTablePages)) <=
          vmchunk->overheadMappedLimit);
+  CHECKL(chunk->base < (Addr)vmchunk->zeroed);
+  CHECKL(AddrAdd(vmchunk->zeroed, BTSize(chunk->pages)) <=
+         vmchunk->overheadMappedLimit);
   /* .improve.check-table: Could check the consistency of the tables. */
   
   return TRUE;
@@ -165,6 +181,8 @@ static Bool VMArenaCheck(VMArena vmArena)
   CHECKD(Arena, arena);
   /* spare pages are committed, so must be less spare than committed. */
   CHECKL(vmArena->spareSize <= arena->committed);
+  CHECKL(vmArena->spareDirty <= arena->spareCommitted);
+  CHECKL(vmArena->spareLazy <= arena->spareCommitted);
 
   CHECKL(vmArena->extendBy > 0);
   CHECKL(vmArena->extendMin <= vmArena->extendBy);
@@ -204,6 +222,8 @@ static Res VMArenaDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
 
   res = WriteF(stream, depth,
                "  spareSize:     $U\n", (WriteFU)vmArena->spareSize,
+               "  spareDirty:    $U\n", (WriteFU)vmArena->spareDirty,
+               "  spareLazy:     $U\n", (WriteFU)vmArena->spareLazy,
                NULL);
   if(res != ResOK)
     return res;
@@ -336,7 +356,7 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
   Addr overheadLimit;
   void *p;
   Res res;
-  BT saMapped, saPages;
+  BT saMapped, saPages, zeroed;
 
   /* chunk is supposed to be uninitialized, so don't check it. */
   vmChunk = Chunk2VMChunk(chunk);
@@ -353,6 +373,12 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
   if (res != ResOK)
     goto failSaPages;
   saPages = p;
+
+  /* .overhead.zeroed: Chunk overhead for table of zeroed pages. */
+  res = BootAlloc(&p, boot, BTSize(chunk->pages), MPS_PF_ALIGN);
+  if (res != ResOK)
+    goto failZeroed;
+  zeroed = p;
   
   overheadLimit = AddrAdd(chunk->base, (Size)BootAllocated(boot));
 
@@ -379,10 +405,15 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
                   chunk->pages,
                   saMapped, saPages, VMChunkVM(vmChunk));
 
+  /* No page is allocated or spare yet, so none is known to be zero. */
+  BTResRange(zeroed, 0, chunk->pages);
+  vmChunk->zeroed = zeroed;
+
   return ResOK;
 
   /* .no-clean: No clean-ups needed for boot, as we will discard the chunk. */
 failTableMap:
+failZeroed:
 failSaPages:
 failAllocPageTable:
 failSaMapped:
@@ -520,6 +551,9 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
     pageTablePages = pageTableSize >> grainShift;
     overhead += SizeAlignUp(BTSize(pageTablePages), MPS_PF_ALIGN);
 
+    /* See .overhead.zeroed. */
+    overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
+
     /* See .overhead.page-table. */
     overhead = SizeAlignUp(overhead, grainSize);
     overhead += SizeAlignUp(pageTableSize, grainSize);
@@ -609,6 +643,8 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   /* Copy VM descriptor into its place in the arena. */
   VMCopy(VMArenaVM(vmArena), vm);
   vmArena->spareSize = 0;
+  vmArena->spareDirty = 0;
+  vmArena->spareLazy = 0;
   RingInit(&vmArena->spareRing);
 
   /* Copy the stack-allocated VM parameters into their home in the VMArena. */
@@ -637,15 +673,18 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   /* Check the computation of the chunk size in vmArenaChunkSize, now
    * that we have the actual chunk for comparison. Note that
    * vmArenaChunkSize computes the smallest size with a given number
-   * of usable bytes -- the actual chunk may be one grain larger. */
+   * of usable bytes -- the actual chunk may be one grain larger, or
+   * rounded up to a whole number of huge pages (see .huge). */
   {
-    Size usableSize, computedChunkSize;
+    Size usableSize, computedChunkSize, hugePageSize;
     usableSize = AddrOffset(PageIndexBase(chunk, chunk->allocBase),
                             chunk->limit);
     res = vmArenaChunkSize(&computedChunkSize, vmArena, usableSize);
     AVER(res == ResOK);
-    AVER(computedChunkSize == ChunkSize(chunk)
-         || computedChunkSize + grainSize == ChunkSize(chunk));
+    hugePageSize = VMHugePageSize(VMChunkVM(Chunk2VMChunk(chunk)));
+    AVER(computedChunkSize <= ChunkSize(chunk));
+    AVER(ChunkSize(chunk) <= SizeAlignUp(computedChunkSize + grainSize,
+                                         hugePageSize));
   }
 #endif
 
@@ -793,6 +832,15 @@ static unsigned pageState(VMChunk vmChunk, Index pi)
 }
 
 
+/* pageIsSpare -- is page spare (perhaps lazily freed)? */
+
+static Bool pageIsSpare(VMChunk vmChunk, Index pi)
+{
+  unsigned state = pageState(vmChunk, pi);
+  return state == PageStateSPARE || state == PageStateLAZY;
+}
+
+
 /* sparePageRelease -- releases a spare page
  *
  * Either to allocate it or to purge it.
@@ -802,13 +850,22 @@ static void sparePageRelease(VMChunk vmChunk, Index pi)
 {
   Chunk chunk = VMChunk2Chunk(vmChunk);
   Arena arena = ChunkArena(chunk);
+  VMArena vmArena = VMChunkVMArena(vmChunk);
   Page page = ChunkPage(chunk, pi);
 
-  AVER(PageState(page) == PageStateSPARE);
+  AVER(pageIsSpare(vmChunk, pi));
   AVER(arena->spareCommitted >= ChunkPageSize(chunk));
 
   arena->spareCommitted -= ChunkPageSize(chunk);
   RingRemove(PageSpareRing(page));
+  if (!BTGet(vmChunk->zeroed, pi)) {
+    AVER(vmArena->spareDirty >= ChunkPageSize(chunk));
+    vmArena->spareDirty -= ChunkPageSize(chunk);
+  }
+  if (PageState(page) == PageStateLAZY) {
+    AVER(vmArena->spareLazy >= ChunkPageSize(chunk));
+    vmArena->spareLazy -= ChunkPageSize(chunk);
+  }
 }
 
 
@@ -837,6 +894,61 @@ static void pageDescUnmap(VMChunk vmChunk, Index basePI, Index limitPI)
 }
 
 
+/* pagesMapSpare -- map free pages as spare
+ *
+ * Map any free pages in the range from basePI to limitPI and add them
+ * to the spare ring, so that the huge pages containing an allocation
+ * are completely mapped (see .huge). This is only an optimization, so
+ * it gives up quietly if mapping fails.
+ */
+
+static void pagesMapSpare(VMArena vmArena, VMChunk vmChunk,
+                          Index basePI, Index limitPI)
+{
+  Arena arena = MustBeA(AbstractArena, vmArena);
+  Chunk chunk = VMChunk2Chunk(vmChunk);
+  Index cursor, i, j, k;
+
+  AVER(chunk->allocBase <= basePI);
+  AVER(basePI <= limitPI);
+  AVER(limitPI <= chunk->pages);
+
+  cursor = basePI;
+  while (cursor < limitPI
+         && BTFindLongResRange(&j, &k, vmChunk->pages.mapped,
+                               cursor, limitPI, 1))
+  {
+    /* Don't exceed the spare commit limit (so with spare set to zero,
+       this never maps anything). */
+    if (arena->spareCommitted + ChunkPagesToSize(chunk, k - j)
+        > ArenaSpareCommitLimit(arena))
+      return;
+    if (pageDescMap(vmChunk, j, k) != ResOK)
+      return;
+    if (vmArenaMap(vmArena, VMChunkVM(vmChunk),
+                   PageIndexBase(chunk, j), PageIndexBase(chunk, k))
+        != ResOK)
+    {
+      pageDescUnmap(vmChunk, j, k);
+      return;
+    }
+    for (i = j; i < k; ++i) {
+      Page page = ChunkPage(chunk, i);
+      PageInit(chunk, i);
+      /* Clear the free state so that it can be changed. */
+      page->pool.pool = NULL;
+      PageSetType(page, PageStateSPARE);
+      RingInit(PageSpareRing(page));
+      RingAppend(&vmArena->spareRing, PageSpareRing(page));
+    }
+    arena->spareCommitted += ChunkPagesToSize(chunk, k - j);
+    /* Freshly mapped memory is zero: see <design/arena/#zero.map>. */
+    BTSetRange(vmChunk->zeroed, j, k);
+    cursor = k;
+  }
+}
+
+
 /* pagesMarkAllocated -- Mark the pages allocated */
 
 static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
@@ -845,6 +957,7 @@ static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
   Index cursor, i, j, k;
   Index limitPI;
   Chunk chunk = VMChunk2Chunk(vmChunk);
+  Size hugePageSize;
   Res res;
   
   limitPI = basePI + pages;
@@ -871,14 +984,32 @@ static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
       PageInit(chunk, i);
       PageAlloc(chunk, i, pool);
     }
+    /* Freshly mapped memory is zero: see <design/arena/#zero.map>. */
+    BTSetRange(vmChunk->zeroed, j, k);
     cursor = k;
     if (cursor == limitPI)
-      return ResOK;
+      goto mapped;
   }
   for (i = cursor; i < limitPI; ++i) {
     sparePageRelease(vmChunk, i);
     PageAlloc(chunk, i, pool);
   }
+
+mapped:
+  /* Map the rest of the huge pages containing the allocation: see .huge. */
+  hugePageSize = VMHugePageSize(VMChunkVM(vmChunk));
+  if (hugePageSize > ChunkPageSize(chunk)) {
+    Count framePages = ChunkSizeToPages(chunk, hugePageSize);
+    Index frameBase = basePI - basePI % framePages;
+    Index frameLimit = limitPI + framePages - 1;
+    frameLimit -= frameLimit % framePages;
+    if (frameBase < chunk->allocBase)
+      frameBase = chunk->allocBase;
+    if (frameLimit > chunk->pages)
+      frameLimit = chunk->pages;
+    pagesMapSpare(vmArena, vmChunk, frameBase, basePI);
+    pagesMapSpare(vmArena, vmChunk, limitPI, frameLimit);
+  }
   return ResOK;
 
 failVMMap:
@@ -948,7 +1079,8 @@ static Bool VMChunkPageMapped(Chunk chunk, Index index)
  *
  * Unmap the spare page passed, and possibly other pages in the chunk,
  * unmapping at least the size passed if available.  The amount unmapped
- * may exceed the size by up to one page.  Returns the amount of memory
+ * may exceed the size by up to one page, or up to one huge page if the
+ * chunk uses them (see .huge).  Returns the amount of memory
  * unmapped.
  *
  * To minimse unmapping calls, the page passed is coalesced with spare
@@ -960,13 +1092,14 @@ static Size chunkUnmapAroundPage(Chunk chunk, Size size, Page page)
 {
   VMChunk vmChunk;
   Size purged = 0;
-  Size pageSize;
+  Size pageSize, hugePageSize;
   Index basePI, limitPI;
 
   AVERT(Chunk, chunk);
   vmChunk = Chunk2VMChunk(chunk);
   AVERT(VMChunk, vmChunk);
-  AVER(PageState(page) == PageStateSPARE);
+  AVER(PageState(page) == PageStateSPARE
+       || PageState(page) == PageStateLAZY);
   /* size is arbitrary */
 
   pageSize = ChunkPageSize(chunk);
@@ -981,15 +1114,34 @@ static Size chunkUnmapAroundPage(Chunk chunk, Size size, Page page)
     purged += pageSize;
   } while (purged < size &&
            limitPI < chunk->pages &&
-           pageState(vmChunk, limitPI) == PageStateSPARE);
+           pageIsSpare(vmChunk, limitPI));
   while (purged < size &&
          basePI > 0 &&
-         pageState(vmChunk, basePI - 1) == PageStateSPARE) {
+         pageIsSpare(vmChunk, basePI - 1)) {
     --basePI;
     sparePageRelease(vmChunk, basePI);
     purged += pageSize;
   }
 
+  /* Avoid splitting a huge page that is completely spare: see .huge. */
+  hugePageSize = VMHugePageSize(VMChunkVM(vmChunk));
+  if (hugePageSize > pageSize) {
+    Count framePages = ChunkSizeToPages(chunk, hugePageSize);
+    while (limitPI % framePages != 0 &&
+           limitPI < chunk->pages &&
+           pageIsSpare(vmChunk, limitPI)) {
+      sparePageRelease(vmChunk, limitPI);
+      ++limitPI;
+      purged += pageSize;
+    }
+    while (basePI % framePages != 0 &&
+           pageIsSpare(vmChunk, basePI - 1)) {
+      --basePI;
+      sparePageRelease(vmChunk, basePI);
+      purged += pageSize;
+    }
+  }
+
   vmArenaUnmap(VMChunkVMArena(vmChunk),
                VMChunkVM(vmChunk),
                PageIndexBase(chunk, basePI),
@@ -1060,6 +1212,269 @@ static void chunkUnmapSpare(Chunk chunk)
 }
 
 
+/* VMZero -- fill freshly allocated pages with zeros
+ *
+ * Pages that were mapped when they were allocated, or that were
+ * zeroed by VMZeroSpare while they were spare, are already zero and
+ * are skipped.  See <design/arena/#zero>.
+ */
+
+static void VMZero(Arena arena, Addr base, Addr limit)
+{
+  VMChunk vmChunk;
+  Chunk chunk = NULL;           /* suppress "may be used uninitialized" */
+  Index piBase, piLimit, i, j;
+  Bool foundChunk;
+
+  AVERT(Arena, arena);
+  foundChunk = ChunkOfAddr(&chunk, arena, base);
+  AVER(foundChunk);
+  AVER(limit <= chunk->limit);
+  vmChunk = Chunk2VMChunk(chunk);
+
+  piBase = INDEX_OF_ADDR(chunk, base);
+  piLimit = INDEX_OF_ADDR(chunk, limit);
+  AVER(BTIsSetRange(chunk->allocTable, piBase, piLimit));
+
+  i = piBase;
+  while (i < piLimit
+         && BTFindLongResRange(&i, &j, vmChunk->zeroed, i, piLimit, 1)) {
+    (void)AddrSet(PageIndexBase(chunk, i), 0, ChunkPagesToSize(chunk, j - i));
+    i = j;
+  }
+
+  /* The pool is about to write to the pages. */
+  BTResRange(vmChunk->zeroed, piBase, piLimit);
+}
+
+
+/* VMZeroSpare -- zero some spare pages
+ *
+ * Zero up to size bytes of spare pages that are not known to be
+ * zero, so that VMZero can skip them if they are allocated again.
+ * Start with the most recently freed pages, since those are the last
+ * to be purged by arenaUnmapSpare.  See <design/arena/#zero.spare>.
+ */
+
+static Size VMZeroSpare(Arena arena, Size size)
+{
+  VMArena vmArena = MustBeA(VMArena, arena);
+  Ring node;
+  Size zeroed = 0;
+
+  for (node = RingPrev(&vmArena->spareRing);
+       node != &vmArena->spareRing
+         && zeroed < size && vmArena->spareDirty > 0;
+       node = RingPrev(node))
+  {
+    Page page = PageOfSpareRing(node);
+    Chunk chunk = NULL; /* suppress uninit warning */
+    VMChunk vmChunk;
+    Index pi;
+    Bool b;
+
+    /* See arenaUnmapSpare for why this finds the chunk. */
+    b = ChunkOfAddr(&chunk, arena, (Addr)page);
+    AVER(b);
+    vmChunk = Chunk2VMChunk(chunk);
+    pi = (Index)(page - chunk->pageTable);
+    /* Writing to a lazily freed page would take it back from the OS,
+       and the remaining pages are older still: see .lazy.prefix. */
+    if (PageState(page) == PageStateLAZY)
+      break;
+    if (!BTGet(vmChunk->zeroed, pi)) {
+      (void)AddrSet(PageIndexBase(chunk, pi), 0, ChunkPageSize(chunk));
+      BTSet(vmChunk->zeroed, pi);
+      AVER(vmArena->spareDirty >= ChunkPageSize(chunk));
+      vmArena->spareDirty -= ChunkPageSize(chunk);
+      zeroed += ChunkPageSize(chunk);
+    }
+  }
+
+  return zeroed;
+}
+
+
+/* chunkFramePages -- number of pages in a huge page of the chunk
+ *
+ * Returns 1 if the chunk does not use huge pages (see .huge).
+ */
+
+static Count chunkFramePages(Chunk chunk)
+{
+  Size hugePageSize = VMHugePageSize(VMChunkVM(Chunk2VMChunk(chunk)));
+  if (hugePageSize <= ChunkPageSize(chunk))
+    return 1;
+  return ChunkSizeToPages(chunk, hugePageSize);
+}
+
+
+/* spareLazyRevert -- make a lazily freed page plain spare again
+ *
+ * The page is moved to the end of the spare ring, to keep .lazy.prefix.
+ * Its contents may still be discarded by the operating system, but
+ * since the zeroed bit is only set on pages that are zero, this
+ * doesn't invalidate it.
+ */
+
+static void spareLazyRevert(Chunk chunk, Index pi)
+{
+  VMArena vmArena = VMChunkVMArena(Chunk2VMChunk(chunk));
+  Page page = ChunkPage(chunk, pi);
+
+  AVER(PageState(page) == PageStateLAZY);
+  AVER(vmArena->spareLazy >= ChunkPageSize(chunk));
+  vmArena->spareLazy -= ChunkPageSize(chunk);
+  page->pool.pool = NULL;
+  PageSetType(page, PageStateSPARE);
+  RingRemove(PageSpareRing(page));
+  RingAppend(&vmArena->spareRing, PageSpareRing(page));
+}
+
+
+/* chunkUnmapLazy -- unmap the lazily freed pages around a page
+ *
+ * Unlike chunkUnmapAroundPage, this only coalesces the page with
+ * neighbours that were lazily freed too, so that pages that became
+ * spare since the previous step are not unmapped before they have
+ * aged.  If the chunk uses huge pages, only whole huge pages are
+ * unmapped, and lazily freed pages in a huge page that is partly in
+ * use are made plain spare again: see <design/arenavm/#huge.decay>.
+ */
+
+static void chunkUnmapLazy(Chunk chunk, Index pi)
+{
+  VMChunk vmChunk = Chunk2VMChunk(chunk);
+  Count framePages = chunkFramePages(chunk);
+  Index basePI, limitPI, unmapBasePI, unmapLimitPI, i;
+
+  AVER(pageState(vmChunk, pi) == PageStateLAZY);
+
+  basePI = pi;
+  limitPI = pi + 1;
+  while (basePI > 0 && pageState(vmChunk, basePI - 1) == PageStateLAZY)
+    --basePI;
+  while (limitPI < chunk->pages
+         && pageState(vmChunk, limitPI) == PageStateLAZY)
+    ++limitPI;
+
+  unmapBasePI = basePI + (framePages - basePI % framePages) % framePages;
+  unmapLimitPI = limitPI - limitPI % framePages;
+  if (unmapBasePI >= unmapLimitPI)
+    unmapBasePI = unmapLimitPI = limitPI;
+  for (i = basePI; i < unmapBasePI; ++i)
+    spareLazyRevert(chunk, i);
+  for (i = unmapLimitPI; i < limitPI; ++i)
+    spareLazyRevert(chunk, i);
+  if (unmapBasePI == unmapLimitPI)
+    return;
+
+  for (i = unmapBasePI; i < unmapLimitPI; ++i)
+    sparePageRelease(vmChunk, i);
+  vmArenaUnmap(VMChunkVMArena(vmChunk), VMChunkVM(vmChunk),
+               PageIndexBase(chunk, unmapBasePI),
+               PageIndexBase(chunk, unmapLimitPI));
+  pageDescUnmap(vmChunk, unmapBasePI, unmapLimitPI);
+}
+
+
+/* VMDecaySpare -- age the spare pages
+ *
+ * Unmap the spare pages that were lazily freed at the previous step,
+ * then lazily free all the others, so that a page that stays spare is
+ * unmapped after between one and two decay times.  See
+ * <design/arena/#spare.decay>.
+ *
+ * .lazy.prefix: The lazily freed pages are always at the start of the
+ * spare ring.  They are moved there when they are lazily freed, and
+ * new spare pages are appended to the end.
+ */
+
+static void VMDecaySpare(Arena arena)
+{
+  VMArena vmArena = MustBeA(VMArena, arena);
+  RingStruct lazyRing, keepRing;
+  Ring node;
+
+  while (vmArena->spareLazy > 0) {
+    Page page = PageOfSpareRing(RingNext(&vmArena->spareRing));
+    Chunk chunk = NULL; /* suppress uninit warning */
+    Bool b;
+    AVER(PageState(page) == PageStateLAZY); /* .lazy.prefix */
+    /* See arenaUnmapSpare for why this finds the chunk. */
+    b = ChunkOfAddr(&chunk, arena, (Addr)page);
+    AVER(b);
+    chunkUnmapLazy(chunk, (Index)(page - chunk->pageTable));
+  }
+
+  /* Lazily free the remaining spare pages, coalescing runs of adjacent
+     pages to reduce the number of calls to the OS.  Every page is
+     moved from the spare ring either to lazyRing or to keepRing, and
+     these are then put back in that order. */
+  RingInit(&lazyRing);
+  RingInit(&keepRing);
+  while (!RingIsSingle(&vmArena->spareRing)) {
+    Page page = PageOfSpareRing(RingNext(&vmArena->spareRing));
+    Chunk chunk = NULL; /* suppress uninit warning */
+    VMChunk vmChunk;
+    Count framePages;
+    Index basePI, limitPI, lazyBasePI, lazyLimitPI, pi;
+    Bool b;
+
+    AVER(PageState(page) == PageStateSPARE);
+    b = ChunkOfAddr(&chunk, arena, (Addr)page);
+    AVER(b);
+    vmChunk = Chunk2VMChunk(chunk);
+    basePI = (Index)(page - chunk->pageTable);
+    limitPI = basePI + 1;
+    while (basePI > 0 && pageState(vmChunk, basePI - 1) == PageStateSPARE)
+      --basePI;
+    while (limitPI < chunk->pages
+           && pageState(vmChunk, limitPI) == PageStateSPARE)
+      ++limitPI;
+
+    /* Only advise whole huge pages: see <design/arenavm/#huge.decay>. */
+    framePages = chunkFramePages(chunk);
+    lazyBasePI = basePI + (framePages - basePI % framePages) % framePages;
+    lazyLimitPI = limitPI - limitPI % framePages;
+    if (lazyBasePI >= lazyLimitPI)
+      lazyBasePI = lazyLimitPI = limitPI;
+
+    for (pi = basePI; pi < limitPI; ++pi) {
+      Page p = ChunkPage(chunk, pi);
+      RingRemove(PageSpareRing(p));
+      if (lazyBasePI <= pi && pi < lazyLimitPI) {
+        /* Clear the spare state so that it can be changed. */
+        p->pool.pool = NULL;
+        PageSetType(p, PageStateLAZY);
+        RingAppend(&lazyRing, PageSpareRing(p));
+      } else {
+        RingAppend(&keepRing, PageSpareRing(p));
+      }
+    }
+    if (lazyBasePI < lazyLimitPI) {
+      VMLazyFree(VMChunkVM(vmChunk), PageIndexBase(chunk, lazyBasePI),
+                 PageIndexBase(chunk, lazyLimitPI));
+      vmArena->spareLazy += ChunkPagesToSize(chunk, lazyLimitPI - lazyBasePI);
+    }
+  }
+
+  while (!RingIsSingle(&lazyRing)) {
+    node = RingNext(&lazyRing);
+    RingRemove(node);
+    RingAppend(&vmArena->spareRing, node);
+  }
+  while (!RingIsSingle(&keepRing)) {
+    node = RingNext(&keepRing);
+    RingRemove(node);
+    RingAppend(&vmArena->spareRing, node);
+  }
+  RingFinish(&keepRing);
+  RingFinish(&lazyRing);
+  AVER(vmArena->spareLazy <= arena->spareCommitted);
+}
+
+
 /* VMFree -- free a region in the arena */
 
 static void VMFree(Addr base, Size size, Pool pool)
@@ -1109,6 +1524,9 @@ static void VMFree(Addr base, Size size, Pool pool)
   }
   arena->spareCommitted += ChunkPagesToSize(chunk, piLimit - piBase);
   BTResRange(chunk->allocTable, piBase, piLimit);
+  /* The pool may have written to the pages. */
+  BTResRange(Chunk2VMChunk(chunk)->zeroed, piBase, piLimit);
+  vmArena->spareDirty += ChunkPagesToSize(chunk, piLimit - piBase);
 
   /* Consider returning memory to the OS. */
   /* Purging spare memory can cause page descriptors to be unmapped,
@@ -1135,7 +1553,7 @@ static void VMFree(Addr base, Size size, Pool pool)
     AVER(newSpareCommitted < spareCommitted);
     spareCommitted = newSpareCommitted;
   }
-  AVER(ArenaCurrentSpare(arena) <= ArenaSpare(arena));
+  AVER(ArenaSpareCommitted(arena) <= ArenaSpareCommitLimit(arena));
 
   /* TODO: Chunks are only destroyed when ArenaCompact is called, and
      that is only called from traceReclaim. Should consider destroying
@@ -1232,6 +1650,9 @@ DEFINE_CLASS(Arena, VMArena, klass)
   klass->create = VMArenaCreate;
   klass->destroy = VMArenaDestroy;
   klass->purgeSpare = VMPurgeSpare;
+  klass->zero = VMZero;
+  klass->zeroSpare = VMZeroSpare;
+  klass->decaySpare = VMDecaySpare;
   klass->grow = VMArenaGrow;
   klass->free = VMFree;
   klass->chunkInit = VMChunkInit;
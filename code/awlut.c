@@ -8,10 +8,12 @@
  * .design: see <design/poolawl/#test>.*
  */
 
+#include "mpscamc.h"
 #include "mpscawl.h"
 #include "mpsclo.h"
 #include "mpsavm.h"
 #include "fmtdy.h"
+#include "ephtab.h"
 #include "testlib.h"
 #include "testthr.h"
 #include "mpslib.h"
@@ -24,6 +26,8 @@
 
 #define testArenaSIZE     ((size_t)64<<20)
 #define TABLE_SLOTS 49
+#define EPH_LENGTH 97  /* entries in the ephemeron table */
+#define EPH_KEYS 40    /* keys added to the ephemeron table */
 #define ITERATIONS 5000
 #define CHATTER 100
 
@@ -173,13 +177,41 @@ static void table_link(mps_word_t *t1, mps_word_t *t2)
 }
 
 
+/* ephkeys -- preserves keys in the ephemeron table
+ *
+ * This is an exact root, not on the stack, so that the keys can move.
+ * Keys with even indexes are allocated in the LO pool, and can't
+ * move; the others in the AMC pool.
+ */
+
+static mps_word_t *ephkeys[EPH_KEYS];
+
+
+/* ephcheck -- check a live entry in the ephemeron table */
+
+static void ephcheck(mps_addr_t key, mps_addr_t value, void *closure)
+{
+  size_t *live = closure;
+  size_t j;
+
+  for(j = 0; j < EPH_KEYS; ++j)
+    if (ephkeys[j] == key)
+      break;
+  if (j == EPH_KEYS)
+    error("Unreachable ephemeron key found.\n");
+  cdie(table_slot(value, 0) == key, "ephemeron value");
+  ++*live;
+}
+
+
 typedef struct tables_s {
   mps_arena_t arena;
   mps_word_t *weaktable;
   mps_word_t *exacttable;
   mps_word_t *preserve[TABLE_SLOTS];    /* preserves objects in the weak */
                                         /* table by referring to them */
-  mps_ap_t weakap, exactap, bogusap, leafap;
+  ephtab_t ephtable;
+  mps_ap_t weakap, exactap, bogusap, leafap, amcap, ephap;
 } tables_s, *tables_t;
 
 
@@ -218,6 +250,20 @@ static void *populate(void *state)
     set_table_slot(tables->exacttable, i, string);
   }
 
+  /* Each value refers to its key, so a weak key with a strong value */
+  /* would keep every entry alive. */
+  die(ephtab_create(&tables->ephtable, tables->ephap, tables->arena,
+                    EPH_LENGTH),
+      "ephtab_create");
+  for(i = 0; i < EPH_KEYS; ++i) {
+    mps_ap_t keyap = i % 2 == 0 ? tables->leafap : tables->amcap;
+    mps_word_t *key = alloc_string("iamakey", keyap);
+    mps_word_t *value = alloc_table(1, tables->amcap);
+    set_table_slot(value, 0, key);
+    die(ephtab_put(tables->ephtable, key, value), "ephtab_put");
+    ephkeys[i] = rnd() % 2 == 0 ? key : NULL;
+  }
+
   mps_root_destroy(root);
   mps_thread_dereg(me);
 
@@ -226,11 +272,13 @@ static void *populate(void *state)
 
 static void test(mps_arena_t arena,
                  mps_ap_t leafap, mps_ap_t exactap, mps_ap_t weakap,
-                 mps_ap_t bogusap)
+                 mps_ap_t bogusap, mps_ap_t amcap, mps_ap_t ephap)
 {
   tables_s tables;
-  size_t i, j;
+  size_t i, j, live, preserved, pass, rehashing;
   testthr_t thr;
+  mps_root_t ephroot;
+  mps_word_t *key, *value;
   void *p;
 
   /* Leave bogusap between reserve and commit for the duration */
@@ -241,6 +289,16 @@ static void test(mps_arena_t arena,
   tables.weakap = weakap;
   tables.leafap = leafap;
   tables.bogusap = bogusap;
+  tables.amcap = amcap;
+  tables.ephap = ephap;
+  for(i = 0; i < EPH_KEYS; ++i)
+    ephkeys[i] = NULL;
+
+  /* The keys must be able to move, so that the table must rehash. */
+  die(mps_root_create_area(&ephroot, arena, mps_rank_exact(), (mps_rm_t)0,
+                           &ephkeys[0], &ephkeys[EPH_KEYS],
+                           mps_scan_area, NULL),
+      "Ephemeron Key Root Create\n");
 
   /* We using a thread for its pararallel execution, so just create
      and wait for it to finish. */
@@ -271,6 +329,48 @@ static void test(mps_arena_t arena,
     }
   }
 
+  /* Preserved keys must be found with their values, perhaps after a */
+  /* rehash; other keys must have been splatted.  The keys that can't */
+  /* move are looked up first, so that some lookups are answered part */
+  /* way through the rehash <code/ephtab.c#rehash>. */
+  preserved = 0;
+  rehashing = 0;
+  for(pass = 0; pass < 2; ++pass) {
+    for(i = pass; i < EPH_KEYS; i += 2) {
+      key = ephkeys[i];
+      if (key != NULL) {
+        ++preserved;
+        value = ephtab_get(tables.ephtable, key);
+        if (ephtab_rehashing(tables.ephtable))
+          ++rehashing;
+        if (value == NULL || table_slot(value, 0) != key)
+          error("Reachable ephemeron key not found, key %"PRIuLONGEST".\n",
+                (ulongest_t)i);
+      }
+    }
+  }
+  live = 0;
+  ephtab_map(tables.ephtable, ephcheck, &live);
+  cdie(live == preserved, "ephemeron keys");
+  printf("%"PRIuLONGEST" of %d ephemeron keys survived; "
+         "%"PRIuLONGEST" lookups during a rehash.\n",
+         (ulongest_t)live, EPH_KEYS, (ulongest_t)rehashing);
+
+  /* Putting a key that is already present replaces its value. */
+  for(i = 0; i < EPH_KEYS; ++i) {
+    key = ephkeys[i];
+    if (key != NULL) {
+      value = alloc_table(1, amcap);
+      set_table_slot(value, 0, key);
+      die(ephtab_put(tables.ephtable, key, value), "ephtab_put");
+      cdie(ephtab_get(tables.ephtable, key) == value, "ephtab_put value");
+    }
+  }
+  live = 0;
+  ephtab_map(tables.ephtable, ephcheck, &live);
+  cdie(live == preserved, "ephtab_put duplicate");
+
+  mps_root_destroy(ephroot);
   (void)mps_commit(bogusap, p, 64);
 }
 
@@ -296,7 +396,10 @@ static void *setup(void *v, size_t s)
   mps_pool_t tablepool;
   mps_fmt_t dylanfmt;
   mps_fmt_t dylanweakfmt;
-  mps_ap_t leafap, exactap, weakap, bogusap;
+  mps_fmt_t ephfmt;
+  mps_pool_t amcpool;
+  mps_pool_t ephpool;
+  mps_ap_t leafap, exactap, weakap, bogusap, amcap, ephap;
   mps_root_t stack;
   mps_thr_t thr;
 
@@ -327,9 +430,31 @@ static void *setup(void *v, size_t s)
       "Weak AP Create\n");
   die(mps_ap_create(&bogusap, tablepool, mps_rank_exact()),
       "Bogus AP Create\n");
+  die(ephtab_fmt(&ephfmt, arena), "Format Create (eph)\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, dylanfmt);
+    die(mps_pool_create_k(&amcpool, arena, mps_class_amc(), args),
+        "Key Pool Create\n");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, ephfmt);
+    die(mps_pool_create_k(&ephpool, arena, mps_class_awl(), args),
+        "Ephemeron Pool Create\n");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&amcap, amcpool, mps_rank_exact()),
+      "Key AP Create\n");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_RANK, mps_rank_ephemeron());
+    die(mps_ap_create_k(&ephap, ephpool, args), "Ephemeron AP Create\n");
+  } MPS_ARGS_END(args);
 
-  test(arena, leafap, exactap, weakap, bogusap);
+  test(arena, leafap, exactap, weakap, bogusap, amcap, ephap);
 
+  mps_ap_destroy(ephap);
+  mps_ap_destroy(amcap);
+  mps_pool_destroy(ephpool);
+  mps_pool_destroy(amcpool);
+  mps_fmt_destroy(ephfmt);
   mps_ap_destroy(bogusap);
   mps_ap_destroy(weakap);
   mps_ap_destroy(exactap);
@@ -66,6 +66,7 @@ Bool BufferCheck(Buffer buffer)
     CHECKL(buffer->ap_s.limit == (Addr)0);
     /* Nothing reliable to check for lightweight frame state */
     CHECKL(buffer->poolLimit == (Addr)0);
+    CHECKL(buffer->sampleLimit == (Addr)0);
   } else {
     /* The buffer is attached to a region of memory.   */
     /* Check consistency. */
@@ -85,6 +86,15 @@ Bool BufferCheck(Buffer buffer)
     CHECKL(AddrIsAligned(buffer->ap_s.limit, buffer->alignment));
     CHECKL(AddrIsAligned(buffer->poolLimit, buffer->alignment));
 
+    /* A sample point is strictly inside the buffer, so that the */
+    /* allocation that reaches it goes out of line to BufferFill. */
+    /* See <code/sample.c#sample.point>. */
+    if (buffer->sampleLimit != (Addr)0) {
+      CHECKL(buffer->base <= buffer->sampleLimit);
+      CHECKL(buffer->sampleLimit < buffer->poolLimit);
+      CHECKL(AddrIsAligned(buffer->sampleLimit, buffer->alignment));
+    }
+
     /* If the buffer isn't trapped then "limit" should be the limit */
     /* set by the owning pool.  Otherwise, "init" is either at the */
     /* same place it was at flip (.commit.before) or has been set */
@@ -152,6 +162,7 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 "alloc $A\n",       (WriteFA)buffer->ap_s.alloc,
                 "limit $A\n",       (WriteFA)buffer->ap_s.limit,
                 "poolLimit $A\n",   (WriteFA)buffer->poolLimit,
+                "sampleLimit $A\n", (WriteFA)buffer->sampleLimit,
                 "alignment $W\n",   (WriteFW)buffer->alignment,
                 "rampCount $U\n",   (WriteFU)buffer->rampCount,
                 NULL);
@@ -172,6 +183,7 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   AVER(buffer != NULL);
   AVERT(Pool, pool);
   AVER(BoolCheck(isMutator));
+  AVER(!isMutator || !PoolFrozen(pool)); /* see BufferCreate */
   AVERT(ArgList, args);
 
   /* Superclass init */
@@ -202,6 +214,7 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   buffer->ap_s.alloc = (mps_addr_t)0;
   buffer->ap_s.limit = (mps_addr_t)0;
   buffer->poolLimit = (Addr)0;
+  buffer->sampleLimit = (Addr)0;
   buffer->rampCount = 0;
 
   /* .init.sig-serial: Now the vanilla stuff is initialized, sign the
@@ -246,6 +259,10 @@ Res BufferCreate(Buffer *bufferReturn, BufferClass klass,
   AVERT(BufferClass, klass);
   AVERT(Pool, pool);
 
+  /* Objects can't be allocated in a frozen pool. See PoolFreeze. */
+  if (isMutator && PoolFrozen(pool))
+    return ResPARAM;
+
   arena = PoolArena(pool);
 
   /* Allocate memory for the buffer descriptor structure. */
@@ -308,6 +325,7 @@ void BufferDetach(Buffer buffer, Pool pool)
     buffer->ap_s.alloc = (mps_addr_t)0;
     buffer->ap_s.limit = (mps_addr_t)0;
     buffer->poolLimit = (Addr)0;
+    buffer->sampleLimit = (Addr)0;
     buffer->mode &=
       ~(BufferModeATTACHED|BufferModeFLIPPED|BufferModeTRANSITION);
 
@@ -414,7 +432,8 @@ static void BufferSetUnflipped(Buffer buffer)
   buffer->mode &= ~BufferModeFLIPPED;
   /* restore ap_s.limit if appropriate */
   if (!BufferIsTrapped(buffer)) {
-    buffer->ap_s.limit = buffer->poolLimit;
+    buffer->ap_s.limit = buffer->sampleLimit != (Addr)0
+                         ? buffer->sampleLimit : buffer->poolLimit;
   }
   buffer->initAtFlip = (Addr)0;
 }
@@ -437,6 +456,27 @@ void BufferSetAllocAddr(Buffer buffer, Addr addr)
 }
 
 
+/* BufferSetSampleLimit -- set or clear the buffer's sample point
+ *
+ * While a sample point is set, the AP's limit is held at the point, so
+ * that the allocation that reaches it goes out of line to BufferFill,
+ * which calls SampleCross.  See <code/sample.c#sample.point>.  */
+
+void BufferSetSampleLimit(Buffer buffer, Addr point)
+{
+  AVERT(Buffer, buffer);
+  AVER(!BufferIsReset(buffer));
+  AVER(point == (Addr)0
+       || ((Addr)buffer->ap_s.alloc <= point && point < buffer->poolLimit));
+  AVER(AddrIsAligned(point, buffer->alignment));
+
+  buffer->sampleLimit = point;
+  if (!BufferIsTrapped(buffer)) {
+    buffer->ap_s.limit = point != (Addr)0 ? point : buffer->poolLimit;
+  }
+}
+
+
 /* BufferFramePush
  *
  * See <design/alloc-frame/>.  */
@@ -561,13 +601,15 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
  * BufferFill is entered by the "reserve" operation on a buffer if there
  * isn't enough room between "alloc" and "limit" to satisfy an
  * allocation request.  This might be because the buffer has been
- * trapped and "limit" has been set to zero.  */
+ * trapped and "limit" has been set to zero, or because "limit" has
+ * been held at a sample point.  */
 
 Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
 {
   Res res;
   Pool pool;
   Addr base, limit, next;
+  Bool crossed;
 
   AVER(pReturn != NULL);
   AVERT(Buffer, buffer);
@@ -577,9 +619,11 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
 
   pool = BufferPool(buffer);
 
-  /* If we're here because the buffer was trapped, then we attempt */
-  /* the allocation here. */
-  if (!BufferIsReset(buffer) && buffer->ap_s.limit == (Addr)0) {
+  /* If we're here because the buffer was trapped, or reached its */
+  /* sample point, then we attempt the allocation here. */
+  if (!BufferIsReset(buffer)
+      && (buffer->ap_s.limit == (Addr)0
+          || buffer->sampleLimit != (Addr)0)) {
     /* .fill.unflip: If the buffer is flipped then we unflip the buffer. */
     if (buffer->mode & BufferModeFLIPPED) {
       BufferSetUnflipped(buffer);
@@ -593,6 +637,10 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
       if (buffer->mode & BufferModeLOGGED) {
         EVENT3(BufferReserve, buffer, buffer->ap_s.init, size);
       }
+      if (buffer->sampleLimit != (Addr)0 && next > buffer->sampleLimit) {
+        /* See <design/arena/#sample>. */
+        SampleCross(buffer, buffer->ap_s.init, size);
+      }
       *pReturn = buffer->ap_s.init;
       return ResOK;
     }
@@ -602,6 +650,9 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
   AVER(AddrAdd(buffer->ap_s.alloc, size) > buffer->poolLimit ||
        AddrAdd(buffer->ap_s.alloc, size) < (Addr)buffer->ap_s.alloc);
 
+  /* An allocation that doesn't fit reaches any sample point. */
+  crossed = buffer->sampleLimit != (Addr)0;
+
   BufferDetach(buffer, pool);
 
   /* Ask the pool for some memory. */
@@ -617,6 +668,9 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
     EVENT3(BufferReserve, buffer, buffer->ap_s.init, size);
   }
 
+  /* Consider sampling the allocation. See <design/arena/#sample>. */
+  SampleFill(buffer, base, size, crossed);
+
   *pReturn = base;
   return res;
 }
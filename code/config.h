@@ -346,6 +346,7 @@
 #define FMT_ISFWD_DEFAULT (&FormatNoIsMoved)
 #define FMT_PAD_DEFAULT (&FormatNoPad)
 #define FMT_CLASS_DEFAULT (&FormatDefaultClass)
+#define FMT_SCAN_SLICE_DEFAULT NULL
 
 
 /* Pool AMC Configuration -- see <code/poolamc.c> */
@@ -354,6 +355,12 @@
 /* AMC treats objects larger than or equal to this as "Large" */
 #define AMC_LARGE_SIZE_DEFAULT ((Size)32768)
 #define AMC_EXTEND_BY_DEFAULT  ((Size)8192)
+/* AMC promotes segments in place rather than evacuating them if the
+ * survival rate of their generation is at least this.  The default is
+ * above 1.0, so promotion in place is off unless the client asks for
+ * it.  See <design/poolamc/#promote.survival> */
+#define AMC_PROMOTE_SURVIVAL_DEFAULT 2.0
+#define AMC_ZEROED_DEFAULT FALSE
 
 
 /* Pool AMS Configuration -- see <code/poolams.c> */
@@ -374,6 +381,7 @@
 /* Pool LO Configuration -- see <code/poollo.c> */
 
 #define LO_GEN_DEFAULT       0
+#define LO_ZEROED_DEFAULT    FALSE
 
 
 /* Pool MFS Configuration -- see <code/poolmfs.c> */
@@ -381,6 +389,11 @@
 #define MFS_EXTEND_BY_DEFAULT ((Size)65536)
 
 
+/* Pool MRG Configuration -- see <code/poolmrg.c> */
+
+#define MRG_INDEX_INITIAL ((Count)64) /* initial capacity of index */
+
+
 /* Pool MVFF Configuration -- see <code/poolmvff.c> */
 
 #define MVFF_EXTEND_BY_DEFAULT   ((Size)65536)
@@ -407,6 +420,12 @@
 
 #define ArenaPollALLOCTIME (65536.0)
 
+/* ArenaPollDEBTMAX is the most allocation, in bytes, that polling may
+ * fall behind by in order to meet the MMU target before it does
+ * collection work regardless.  See <design/arena/#mmu.debt>. */
+
+#define ArenaPollDEBTMAX (64 * ArenaPollALLOCTIME)
+
 /* .client.seg-size: ARENA_CLIENT_GRAIN_SIZE is the minimum size, in
  * bytes, of a grain in the client arena. It's set at 8192 with no
  * particular justification. */
@@ -424,6 +443,74 @@
 
 #define ARENA_DEFAULT_PAUSE_TIME (0.1)
 
+/* ARENA_DEFAULT_SPARE_DECAY is the time (in seconds) between steps in
+ * returning spare committed memory to the operating system.  Zero means
+ * that spare memory does not decay, and is only returned when it
+ * exceeds the spare commit limit.  See <design/arena/#spare.decay> and
+ * mps_arena_spare_decay_set in the manual. */
+
+#define ARENA_DEFAULT_SPARE_DECAY (0.0)
+
+/* ARENA_DEFAULT_MMU_TARGET is the minimum mutator utilization that
+ * polling aims to leave the mutator in any window of
+ * ARENA_DEFAULT_MMU_WINDOW seconds.  Zero means that polls are limited
+ * only by the pause time.  See <design/arena/#mmu> and
+ * mps_arena_mmu_target_set in the manual. */
+
+#define ARENA_DEFAULT_MMU_TARGET (0.0)
+#define ARENA_DEFAULT_MMU_WINDOW (0.01)
+
+/* ARENA_DEFAULT_HEAP_GROWTH is the percentage by which the heap may
+ * grow over the live size measured by the last full collection
+ * before another is started.  Zero means that collections are
+ * scheduled by the generation capacities alone.  See
+ * <design/strategy/#policy.growth> and mps_arena_heap_growth_set in
+ * the manual. */
+
+#define ARENA_DEFAULT_HEAP_GROWTH (0.0)
+
+/* ARENA_DEFAULT_ADAPT_CHAINS says whether the capacities of the
+ * generations in the arena's chains adapt to the cost of collecting
+ * them.  See <design/strategy/#policy.adapt>. */
+
+#define ARENA_DEFAULT_ADAPT_CHAINS FALSE
+
+/* ARENA_DEFAULT_MEMORY_TARGET is the soft target (in bytes) for the
+ * committed memory of the arena.  Zero means that there is no target,
+ * and the arena only responds to the commit limit.  See
+ * <design/arena/#pressure> and mps_arena_memory_target_set in the
+ * manual.
+ *
+ * ArenaPressurePROBE_INTERVAL is the minimum time (in seconds)
+ * between calls to the client's pressure probe.
+ *
+ * ArenaPressureLOW is the memory pressure (the ratio of committed
+ * memory to the target) above which the arena starts to give up its
+ * spare committed memory.  At pressure 1.0 it keeps none.
+ *
+ * ArenaPressureREGROW is how far the heap must grow over the live
+ * size measured by the last full collection before high pressure
+ * starts another one.  It stops the arena collecting the world
+ * continuously when the live objects alone exceed the target. */
+
+#define ARENA_DEFAULT_MEMORY_TARGET ((Size)0)
+#define ArenaPressurePROBE_INTERVAL (0.1)
+#define ArenaPressureLOW        (0.8)
+#define ArenaPressureREGROW     (1.1)
+
+/* ARENA_DEFAULT_IDLE_TIME is how long (in seconds) the arena must go
+ * without an allocation point fill before a background thread starts
+ * doing collection work.  Zero means that there is no background
+ * thread.  See <design/arena/#idle>. */
+
+#define ARENA_DEFAULT_IDLE_TIME (0.0)
+
+/* ARENA_ZERO_SPARE_STEP is the amount of spare memory that ArenaStep
+ * zeroes between looks at the clock when it has time left over.  See
+ * <design/arena/#zero.spare>. */
+
+#define ARENA_ZERO_SPARE_STEP ((Size)64 * 1024)
+
 #define ARENA_DEFAULT_ZONED     TRUE
 
 /* ARENA_MINIMUM_COLLECTABLE_SIZE is the minimum size (in bytes) of
@@ -470,6 +557,19 @@
 
 #define LDHistoryLENGTH ((Size)4)
 
+/* Pause statistics -- see <design/arena/#pause>
+ *
+ * Each pause histogram has 2^PauseHistSUB_SHIFT buckets for each power
+ * of two, so that a bucket is at most 1/8 of the size of its smallest
+ * pause.  Pauses of 2^PauseHistEXP_LIMIT clocks or more all go in the
+ * top bucket.  PauseLogLENGTH is the number of recent pauses kept for
+ * computing minimum mutator utilization.
+ */
+
+#define PauseHistSUB_SHIFT      ((Shift)3)
+#define PauseHistEXP_LIMIT      ((Shift)48)
+#define PauseLogLENGTH          ((Count)256)
+
 /* Value of MPS_KEY_EXTEND_BY for the arena control pool. */
 #define CONTROL_EXTEND_BY ((Size)32768)
 
@@ -482,6 +582,26 @@
  * average computation of the mortality of a generation. */
 #define LocusMortalityALPHA (0.4)
 
+/* Adaptive chains: the factors by which a generation's capacity grows
+ * or shrinks after a collection, the factor either side of the
+ * capacity given by the client program within which it stays, and the
+ * survival rate below which it grows.  See
+ * <design/strategy/#policy.adapt>. */
+#define LocusAdaptGROW (1.25)
+#define LocusAdaptSHRINK (0.8)
+#define LocusAdaptRANGE (16.0)
+#define LocusAdaptSURVIVAL (0.1)
+
+/* Cost model: when the bytes measured for a pool generation exceed
+ * LocusCostMEMORY, the measurements are halved, so that the model
+ * follows recent collections.  The clock used to time tracing is
+ * calibrated against the plinth clock once ArenaCalibrateMIN seconds
+ * have been measured, and the calibration is halved after
+ * ArenaCalibrateMEMORY seconds.  See <design/strategy/#policy.model>. */
+#define LocusCostMEMORY ((double)64 * 1024 * 1024)
+#define ArenaCalibrateMIN (0.1)
+#define ArenaCalibrateMEMORY (10.0)
+
 
 /* Stack probe configuration -- see <code/sp*.c> */
 
@@ -503,6 +623,8 @@
 /* VM Configuration -- see <code/vm*.c> */
 
 #define VMAN_PAGE_SIZE ((Align)4096)
+/* Size of a transparent huge page on Linux: see <design/vm/#sol.huge> */
+#define VMIX_HUGE_PAGE_SIZE ((Size)2 << 20)
 #define VMJunkBYTE ((unsigned char)0xA9)
 #define VMParamSize (sizeof(Word))
 
@@ -520,7 +642,8 @@
  * prmclii3.c  REG_EAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmclii6.c  REG_RAX etc.              <ucontext.h>  _GNU_SOURCE
  * pthrdext.c  sigaction etc.            <signal.h>    _XOPEN_SOURCE
- * vmix.c      MAP_ANON                  <sys/mman.h>  _GNU_SOURCE
+ * vmix.c      MAP_ANON, MADV_HUGEPAGE   <sys/mman.h>  _GNU_SOURCE
+ *             MADV_FREE
  *
  * It is not possible to localize these feature specifications around
  * the individual headers: all headers share a common set of features
@@ -626,6 +749,10 @@
 #define TraceLIMIT ((size_t)1)
 /* I count 4 function calls to scan, 10 to copy. */
 #define TraceCopyScanRATIO (1.5)
+/* Segments larger than this are scanned in slices of this size by an
+ * incremental trace step, if the pool and format support it.  See
+ * <design/trace/#scan.slice>. */
+#define TraceSliceSIZE ((Size)262144)
 
 /* Chosen so that the RememberedSummaryBlockStruct packs nicely into
    pages */
@@ -634,10 +761,18 @@
 
 /* Events
  *
- * EventBufferSIZE is the number of words in the global event buffer.
+ * EventBufferSIZE is the size, in bytes, of each half of the event
+ * buffer for each kind.  There are two halves so that a full buffer can
+ * wait to be written while recording continues in the other (see
+ * <design/telemetry/#buffer.handoff>).  Larger buffers make it less
+ * likely that events are dropped (see <design/telemetry/#buffer.full>).
+ * It may be overridden on the compiler command line, for example with
+ * -DEventBufferSIZE=1048576.
  */
 
-#define EventBufferSIZE ((size_t)4096)
+#ifndef EventBufferSIZE
+#define EventBufferSIZE ((size_t)16384)
+#endif
 #define EventStringLengthMAX ((size_t)255) /* Not including NUL */
 
 
@@ -0,0 +1,453 @@
+/* ephtab.c: EPHEMERON HASH TABLE
+ *
+ * $Id$
+ * Copyright (c) 2001-2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: A weak-key hash table for clients, allocated in an AWL
+ * pool with rank ephemeron, so that an entry is deleted when its key
+ * dies, even if its value refers to the key.  See
+ * <design/poolawl/#ephemeron>.  Like the object formats in this
+ * directory, it is client code: it uses only the public interface.
+ *
+ * .hash: Keys are hashed by address, with open addressing and linear
+ * probing.  The table keeps a location dependency on its keys, and
+ * must rehash them when a moving collection changes their addresses.
+ * The table doesn't grow, so the client chooses its length.
+ *
+ * .halves: A table has two arrays of entries, each with its own
+ * location dependency.  The current array holds the entries placed
+ * since its dependency was reset.  The other array is empty, except
+ * while the table is rehashing.
+ *
+ * .rehash: When the dependency of the current array goes stale, the
+ * arrays swap roles, and the entries are moved from the old array to
+ * the new one a few at a time (ephtabSTEP) on each call to ephtab_get
+ * or ephtab_put, so that no call does more than a bounded amount of
+ * rehashing, and none allocates.  A moved entry leaves a tombstone in
+ * the old array, so that the probe sequences of the entries still
+ * there are unbroken.  When all the entries have been moved, the old
+ * array is swept clean, again a few entries at a time.
+ *
+ * .rehash.miss: A lookup probes the current array and then, while the
+ * table is rehashing, the old array.  A probe in an array can be
+ * trusted unless the array's dependency is stale for the key.  If the
+ * lookup misses and either dependency is stale for the key, the key
+ * may still be in the table at the position for its old address, so
+ * the lookup finishes the rehash (and does another if need be) before
+ * it answers.  This is the only case in which a call does work in
+ * proportion to the length of the table.
+ *
+ * .splat: An entry whose key has died is splatted by the MPS: its key
+ * and value become NULL.  It keeps its place in the probe sequences
+ * until a rehash drops it.  When the table is full, ephtab_put rehashes
+ * to drop splatted entries.
+ */
+
+#include "ephtab.h"
+#include "mps.h"
+#include "mpstd.h"
+#include <assert.h>
+#include <stddef.h>
+
+#define ephtabTYPE      ((mps_word_t)0x7AB1E)
+#define ephtabPAD       ((mps_word_t)0xBAD)
+#define ephtabSTEP      ((size_t)4)     /* entries of rehash per call */
+
+static mps_word_t ephtabUnusedStruct;   /* address marks an unused entry */
+static mps_word_t ephtabTombStruct;     /* address marks a moved entry */
+#define ephtabUNUSED    ((mps_addr_t)&ephtabUnusedStruct)
+#define ephtabTOMB      ((mps_addr_t)&ephtabTombStruct)
+
+typedef struct ephtab_entry_s {
+  mps_addr_t key;               /* NULL if splatted */
+  mps_addr_t value;
+} ephtab_entry_s, *ephtab_entry_t;
+
+typedef struct ephtab_s {
+  mps_word_t type;              /* ephtabTYPE or ephtabPAD */
+  size_t size;                  /* size of object in bytes */
+  mps_arena_t arena;            /* arena for location dependencies */
+  size_t length;                /* entries in each array */
+  size_t count;                 /* entries in use, including splatted */
+  size_t current;               /* index of current array, 0 or 1 */
+  size_t move;                  /* next old entry to move, or length */
+  size_t sweep;                 /* next old entry to sweep, or length */
+  mps_ld_s ld[2];               /* dependency on keys in each array */
+  ephtab_entry_s entries[1];    /* really 2 * length */
+} ephtab_s;
+
+#define ephtabALIGN     sizeof(ephtab_entry_s)
+#define ephtabHEADER    offsetof(ephtab_s, entries)
+
+#define ephtabAlignUp(s) \
+  (((s) + ephtabALIGN - 1) / ephtabALIGN * ephtabALIGN)
+
+
+/* Format methods for the pool holding the tables */
+
+static mps_res_t ephtab_scan(mps_ss_t ss, mps_addr_t base,
+                             mps_addr_t limit)
+{
+  MPS_SCAN_BEGIN(ss) {
+    while (base < limit) {
+      ephtab_t table = base;
+      if (table->type == ephtabTYPE) {
+        size_t i;
+        for (i = 0; i < 2 * table->length; ++i) {
+          ephtab_entry_t entry = &table->entries[i];
+          mps_res_t res = MPS_FIX_EPHEMERON(ss, &entry->key, &entry->value);
+          if (res != MPS_RES_OK)
+            return res;
+        }
+      }
+      base = (char *)base + table->size;
+    }
+  } MPS_SCAN_END(ss);
+  return MPS_RES_OK;
+}
+
+static mps_addr_t ephtab_skip(mps_addr_t base)
+{
+  return (char *)base + ((ephtab_t)base)->size;
+}
+
+static void ephtab_pad(mps_addr_t addr, size_t size)
+{
+  ephtab_t table = addr;
+  assert(size >= ephtabALIGN);
+  table->type = ephtabPAD;
+  table->size = size;
+}
+
+mps_res_t ephtab_fmt(mps_fmt_t *fmt_o, mps_arena_t arena)
+{
+  mps_res_t res;
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_ALIGN, ephtabALIGN);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN, ephtab_scan);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SKIP, ephtab_skip);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_PAD, ephtab_pad);
+    res = mps_fmt_create_k(fmt_o, arena, args);
+  } MPS_ARGS_END(args);
+  return res;
+}
+
+
+/* ephtab_create -- allocate a table on an ephemeron allocation point */
+
+mps_res_t ephtab_create(ephtab_t *table_o, mps_ap_t ap,
+                        mps_arena_t arena, size_t length)
+{
+  size_t size = ephtabAlignUp(ephtabHEADER
+                              + 2 * length * sizeof(ephtab_entry_s));
+  ephtab_t table;
+  mps_addr_t p;
+  mps_res_t res;
+
+  assert(table_o != NULL);
+  assert(length >= 2);
+
+  do {
+    size_t i;
+    res = mps_reserve(&p, ap, size);
+    if (res != MPS_RES_OK)
+      return res;
+    table = p;
+    table->type = ephtabTYPE;
+    table->size = size;
+    table->arena = arena;
+    table->length = length;
+    table->count = 0;
+    table->current = 0;
+    table->move = length;
+    table->sweep = length;
+    mps_ld_reset(&table->ld[0], arena);
+    mps_ld_reset(&table->ld[1], arena);
+    for (i = 0; i < 2 * length; ++i) {
+      table->entries[i].key = ephtabUNUSED;
+      table->entries[i].value = NULL;
+    }
+  } while (!mps_commit(ap, p, size));
+
+  *table_o = table;
+  return MPS_RES_OK;
+}
+
+
+static ephtab_entry_t ephtabArray(ephtab_t table, size_t which)
+{
+  return &table->entries[which * table->length];
+}
+
+static size_t ephtabHash(ephtab_t table, mps_addr_t key)
+{
+  return (size_t)((mps_word_t)key / MPS_PF_ALIGN % table->length);
+}
+
+
+/* ephtabProbe -- index of key in an array, or of the unused entry
+ * ending its probe sequence
+ *
+ * Every array has an unused entry, because count < length, and
+ * because tombstones are only left in the old array, which gets no
+ * new entries.
+ */
+
+static size_t ephtabProbe(ephtab_t table, ephtab_entry_t array,
+                          mps_addr_t key)
+{
+  size_t i = ephtabHash(table, key);
+  while (array[i].key != key && array[i].key != ephtabUNUSED)
+    i = (i + 1) % table->length;
+  return i;
+}
+
+
+/* ephtabPlace -- place an entry in the current array
+ *
+ * The key is added to the dependency before it is hashed, so that if
+ * it moves after that, the dependency is stale.
+ */
+
+static void ephtabPlace(ephtab_t table, mps_addr_t key, mps_addr_t value)
+{
+  ephtab_entry_t array = ephtabArray(table, table->current);
+  size_t i;
+
+  mps_ld_add(&table->ld[table->current], table->arena, key);
+  i = ephtabProbe(table, array, key);
+  assert(array[i].key == ephtabUNUSED);
+  array[i].key = key;
+  array[i].value = value;
+}
+
+
+/* ephtabStep -- do up to work entries of rehashing */
+
+static void ephtabStep(ephtab_t table, size_t work)
+{
+  ephtab_entry_t old = ephtabArray(table, 1 - table->current);
+
+  for (; work > 0; --work) {
+    if (table->move < table->length) {
+      ephtab_entry_t entry = &old[table->move];
+      mps_addr_t key = entry->key;
+      if (key != ephtabUNUSED) {
+        if (key == NULL)
+          --table->count; /* .splat */
+        else
+          ephtabPlace(table, key, entry->value);
+        entry->key = ephtabTOMB;
+        entry->value = NULL;
+      }
+      ++table->move;
+      if (table->move == table->length)
+        table->sweep = 0;
+    } else if (table->sweep < table->length) {
+      old[table->sweep].key = ephtabUNUSED;
+      ++table->sweep;
+    } else {
+      break;
+    }
+  }
+}
+
+
+/* ephtabFinish -- finish rehashing */
+
+static void ephtabFinish(ephtab_t table)
+{
+  ephtabStep(table, 2 * table->length);
+  assert(table->move == table->length);
+  assert(table->sweep == table->length);
+}
+
+
+/* ephtabStart -- swap the arrays and start rehashing into the other */
+
+static void ephtabStart(ephtab_t table)
+{
+  assert(table->move == table->length);
+  ephtabFinish(table); /* finish any sweep */
+  table->current = 1 - table->current;
+  mps_ld_reset(&table->ld[table->current], table->arena);
+  table->move = 0;
+}
+
+
+/* ephtabPoll -- start rehashing if needed, and do a little of it */
+
+static void ephtabPoll(ephtab_t table)
+{
+  if (table->move == table->length
+      && mps_ld_isstale_any(&table->ld[table->current], table->arena))
+    ephtabStart(table);
+  ephtabStep(table, ephtabSTEP);
+}
+
+
+/* ephtabFind -- find the entry for a key, or NULL
+ *
+ * See .rehash.miss.
+ */
+
+static ephtab_entry_t ephtabFind(ephtab_t table, mps_addr_t key)
+{
+  ephtab_entry_t array = ephtabArray(table, table->current);
+  size_t i = ephtabProbe(table, array, key);
+  mps_bool_t stale;
+
+  if (array[i].key == key)
+    return &array[i];
+  stale = mps_ld_isstale_precise(&table->ld[table->current],
+                                 table->arena, key);
+
+  if (table->move < table->length) {
+    size_t old = 1 - table->current;
+    if (mps_ld_isstale_precise(&table->ld[old], table->arena, key)) {
+      stale = 1;
+    } else {
+      array = ephtabArray(table, old);
+      i = ephtabProbe(table, array, key);
+      if (array[i].key == key)
+        return &array[i];
+    }
+  }
+
+  if (stale) {
+    ephtabFinish(table);
+    for (;;) {
+      array = ephtabArray(table, table->current);
+      i = ephtabProbe(table, array, key);
+      if (array[i].key == key)
+        return &array[i];
+      if (!mps_ld_isstale_precise(&table->ld[table->current],
+                                  table->arena, key))
+        break;
+      ephtabStart(table);
+      ephtabFinish(table);
+    }
+  }
+
+  return NULL;
+}
+
+
+/* ephtab_get -- look up a key, returning its value, or NULL */
+
+mps_addr_t ephtab_get(ephtab_t table, mps_addr_t key)
+{
+  ephtab_entry_t entry;
+
+  assert(table != NULL);
+  assert(key != NULL && key != ephtabUNUSED && key != ephtabTOMB);
+
+  ephtabPoll(table);
+  entry = ephtabFind(table, key);
+  return entry == NULL ? NULL : entry->value;
+}
+
+
+/* ephtab_put -- set the value of a key
+ *
+ * Returns MPS_RES_LIMIT if the key is new and the table is full, even
+ * after dropping splatted entries.
+ */
+
+mps_res_t ephtab_put(ephtab_t table, mps_addr_t key, mps_addr_t value)
+{
+  ephtab_entry_t entry;
+
+  assert(table != NULL);
+  assert(key != NULL && key != ephtabUNUSED && key != ephtabTOMB);
+
+  ephtabPoll(table);
+  entry = ephtabFind(table, key);
+  if (entry != NULL) {
+    entry->value = value;
+    return MPS_RES_OK;
+  }
+
+  if (table->count + 1 >= table->length) {
+    ephtabFinish(table);
+    ephtabStart(table);
+    ephtabFinish(table);
+    if (table->count + 1 >= table->length)
+      return MPS_RES_LIMIT;
+  }
+
+  ephtabPlace(table, key, value);
+  ++table->count;
+  return MPS_RES_OK;
+}
+
+
+/* ephtab_map -- visit the entries whose keys are alive
+ *
+ * The visitor must not change the table.
+ */
+
+void ephtab_map(ephtab_t table, ephtab_visitor_t visit, void *closure)
+{
+  size_t i;
+
+  assert(table != NULL);
+  assert(visit != NULL);
+
+  for (i = 0; i < 2 * table->length; ++i) {
+    mps_addr_t key = table->entries[i].key;
+    if (key != NULL && key != ephtabUNUSED && key != ephtabTOMB)
+      visit(key, table->entries[i].value, closure);
+  }
+}
+
+
+/* ephtab_rehashing -- is the table part way through a rehash? */
+
+mps_bool_t ephtab_rehashing(ephtab_t table)
+{
+  assert(table != NULL);
+  return table->move < table->length;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,74 @@
+/* ephtab.h: EPHEMERON HASH TABLE INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2001-2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: A weak-key hash table for clients, allocated in an AWL
+ * pool with rank ephemeron.  See <code/ephtab.c>.
+ */
+
+#ifndef ephtab_h
+#define ephtab_h
+
+#include "mps.h"
+
+typedef struct ephtab_s *ephtab_t;
+
+typedef void (*ephtab_visitor_t)(mps_addr_t key, mps_addr_t value,
+                                 void *closure);
+
+/* Format for the pool holding the tables */
+extern mps_res_t ephtab_fmt(mps_fmt_t *fmt_o, mps_arena_t arena);
+
+extern mps_res_t ephtab_create(ephtab_t *table_o, mps_ap_t ap,
+                               mps_arena_t arena, size_t length);
+extern mps_addr_t ephtab_get(ephtab_t table, mps_addr_t key);
+extern mps_res_t ephtab_put(ephtab_t table, mps_addr_t key,
+                            mps_addr_t value);
+extern void ephtab_map(ephtab_t table, ephtab_visitor_t visit,
+                       void *closure);
+extern mps_bool_t ephtab_rehashing(ephtab_t table);
+
+#endif /* ephtab_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -30,8 +30,18 @@ static Bool eventIOInited = FALSE;
 static mps_io_t eventIO;
 static Serial EventInternSerial;
 
-/* Buffers in which events are recorded, from the top down. */
-char EventBuffer[EventKindLIMIT][EventBufferSIZE];
+/* Buffers in which events are recorded, from the top down.  Each kind
+   has two halves: EventBuffer[kind] points to the half that events are
+   being recorded in, and the other half is either idle or has been
+   handed off to the writer.  See <design/telemetry/#buffer.handoff>.
+
+   .lock: The buffers, the pointers into them, the handoff slots, and
+   the event stream are protected by the event lock (LockClaimEvent),
+   which is claimed by EVENT_BEGIN and released by EVENT_END, so that
+   threads working in different arenas, or outside any arena, don't
+   race.  See <design/telemetry/#buffer.lock>. */
+static char eventBuffers[EventKindLIMIT][2][EventBufferSIZE];
+char *EventBuffer[EventKindLIMIT];
 
 /* Pointers to last event logged into each buffer. */
 char *EventLast[EventKindLIMIT];
@@ -39,6 +49,18 @@ char *EventLast[EventKindLIMIT];
 /* Pointers to the last event written out of each buffer. */
 static char *EventWritten[EventKindLIMIT];
 
+/* Events handed off by EventFlush and not yet written, or NULL if the
+   handoff slot for the kind is empty.  See .handoff. */
+static char *eventPending[EventKindLIMIT];
+static size_t eventPendingSize[EventKindLIMIT];
+
+/* .handoff.hint: TRUE if a slot may have been filled since the writer
+   last looked.  EventWritePending reads this without the lock, so that
+   ArenaLeave need not claim it when there is nothing to do.  If it
+   reads a stale FALSE, the events are written at the next ArenaLeave,
+   or by EventFlush when the buffer fills again. */
+static volatile Bool eventPendingAny = FALSE;
+
 EventControlSet EventKindControl;       /* Bit set used to control output. */
 
 
@@ -68,10 +90,97 @@ failWrite:
 }
 
 
-/* EventFlush -- flush event buffer (perhaps to the event stream) */
+/* eventIOCreate -- open the event stream if it is not already open
+ *
+ * The stream is opened late so that no stream is created if no events
+ * are enabled by telemetry control.  Must be called with the event
+ * lock held.
+ */
+
+static Res eventIOCreate(void)
+{
+  Res res;
+
+  if (!eventIOInited) {
+    res = (Res)mps_io_create(&eventIO);
+    if (res != ResOK)
+      return res; /* TODO: Consider taking some other action if open fails. */
+    eventIOInited = TRUE;
+  }
+  return ResOK;
+}
+
+
+/* eventWrite -- send events to the event stream
+ *
+ * Must be called with the event lock held.
+ */
+
+static Res eventWrite(char *base, size_t size)
+{
+  Res res;
+
+  res = eventIOCreate();
+  if (res != ResOK)
+    return res;
+
+  /* Writing might be faster if the size is aligned to a multiple of the
+     C library or kernel's buffer size.  We could pad out the buffer with
+     a marker for this purpose. */
+
+  return (Res)mps_io_write(eventIO, (void *)base, size);
+}
+
+
+/* eventWritePending -- write out events handed off by EventFlush
+ *
+ * Must be called with the event lock held.  Returns TRUE if any events
+ * were written.
+ */
+
+static Bool eventWritePending(void)
+{
+  EventKind kind;
+  Bool wrote = FALSE;
+
+  eventPendingAny = FALSE;
+  for (kind = 0; kind < EventKindLIMIT; ++kind) {
+    char *base = eventPending[kind];
+    if (base != NULL) {
+      Res res = eventWrite(base, eventPendingSize[kind]);
+      /* TODO: Consider taking some other action if a write fails. */
+      if (res == ResOK)
+        wrote = TRUE;
+      eventPending[kind] = NULL; /* .handoff: release the other half */
+    }
+  }
+
+  return wrote;
+}
+
+
+/* EventFlush -- flush event buffer (perhaps to the event stream)
+ *
+ * .handoff: This is called from EVENT_BEGIN, with the event lock held,
+ * when a buffer is full, and so may be called in the middle of a
+ * collection with an arena lock held.  Rather than write the events,
+ * it hands them over to the writer (EventWritePending or EventSync) by
+ * publishing them in the kind's handoff slot, and carries on recording
+ * in the other half of the buffer.  Only EventFlush fills the slot and
+ * only the writer empties it, once the events have been written, so
+ * the other half is free whenever the slot is empty.
+ *
+ * .handoff.full: If the writer has not yet emptied the slot (for
+ * example, because the collector has not returned to the client
+ * program since the last handoff), EventFlush writes out the pending
+ * events itself before handing off, so that no events are lost.  Only
+ * in this case does the collector wait for telemetry I/O.
+ */
 
 void EventFlush(EventKind kind)
 {
+  size_t size;
+
   AVER(eventInited);
   AVER(NONNEGATIVE(kind));
   AVER(kind < EventKindLIMIT);
@@ -80,8 +189,19 @@ void EventFlush(EventKind kind)
   AVER(EventLast[kind] <= EventWritten[kind]);
   AVER(EventWritten[kind] <= EventBuffer[kind] + EventBufferSIZE);
 
-  /* Send all pending events to the event stream. */
-  EventSync();
+  size = (size_t)(EventWritten[kind] - EventLast[kind]);
+  if (BS_IS_MEMBER(EventKindControl, kind) && size > 0) {
+    if (eventPending[kind] != NULL) /* .handoff.full */
+      (void)eventWritePending();
+    AVER(eventPending[kind] == NULL);
+    eventPending[kind] = EventLast[kind];
+    eventPendingSize[kind] = size;
+    eventPendingAny = TRUE;
+    if (EventBuffer[kind] == eventBuffers[kind][0])
+      EventBuffer[kind] = eventBuffers[kind][1];
+    else
+      EventBuffer[kind] = eventBuffers[kind][0];
+  }
 
   /* Flush the in-memory buffer whether or not we send this buffer, so
      that we can continue to record recent events. */
@@ -89,12 +209,38 @@ void EventFlush(EventKind kind)
 }
 
 
+/* EventWritePending -- write out events handed off by EventFlush
+ *
+ * This is called by ArenaLeave after releasing the arena lock, so that
+ * the I/O does not hold up other threads using the arena.
+ */
+
+void EventWritePending(void)
+{
+  if (!eventPendingAny) /* .handoff.hint */
+    return;
+
+  LockClaimEvent();
+  if (eventWritePending()) {
+    (void)eventClockSync();
+    (void)mps_io_flush(eventIO);
+  }
+  LockReleaseEvent();
+}
+
+
 /* EventSync -- synchronize the event stream with the buffers */
 
 void EventSync(void)
 {
   EventKind kind;
-  Bool wrote = FALSE;
+  Bool wrote;
+
+  LockClaimEvent();
+
+  /* Events that were handed off come before those still in the
+     buffers, so write them first. */
+  wrote = eventWritePending();
 
   for (kind = 0; kind < EventKindLIMIT; ++kind) {
 
@@ -110,23 +256,7 @@ void EventSync(void)
 
       size = (size_t)(EventWritten[kind] - EventLast[kind]);
       if (size > 0) {
-
-        /* Ensure the IO stream is open.  We do this late so that no stream is
-           created if no events are enabled by telemetry control. */
-        if (!eventIOInited) {
-          res = (Res)mps_io_create(&eventIO);
-          if(res != ResOK) {
-            /* TODO: Consider taking some other action if open fails. */
-            return;
-          }
-          eventIOInited = TRUE;
-        }
-
-        /* Writing might be faster if the size is aligned to a multiple of the
-           C library or kernel's buffer size.  We could pad out the buffer with
-           a marker for this purpose. */
-
-        res = (Res)mps_io_write(eventIO, (void *)EventLast[kind], size);
+        res = eventWrite(EventLast[kind], size);
         if (res == ResOK) {
           /* TODO: Consider taking some other action if a write fails. */
           EventWritten[kind] = EventLast[kind];
@@ -142,6 +272,8 @@ void EventSync(void)
     (void)eventClockSync();
     (void)mps_io_flush(eventIO);
   }
+
+  LockReleaseEvent();
 }
 
 
@@ -184,6 +316,8 @@ void EventInit(void)
 #define EVENT_CHECK(X, name, code, used, kind) \
   AVER(size_tAlignUp(sizeof(Event##name##Struct), EVENT_ALIGN) \
        <= EventSizeMAX); \
+  AVER(size_tAlignUp(sizeof(Event##name##Struct), EVENT_ALIGN) \
+       <= EventBufferSIZE); \
   AVER(Event##name##Code == code); \
   AVER(0 <= code); \
   AVER(code <= EventCodeMAX); \
@@ -196,9 +330,6 @@ void EventInit(void)
 
   EVENT_LIST(EVENT_CHECK, X);
 
-  /* Ensure that no event can be larger than the maximum event size. */
-  AVER(EventBufferSIZE <= EventSizeMAX);
-
   /* Only if this is the first call. */
   if (!eventInited) { /* See .trans.log */
     LockClaimGlobalRecursive();
@@ -207,6 +338,7 @@ void EventInit(void)
       for (kind = 0; kind < EventKindLIMIT; ++kind) {
         AVER(EventLast[kind] == NULL);
         AVER(EventWritten[kind] == NULL);
+        EventBuffer[kind] = eventBuffers[kind][0];
         EventLast[kind] = EventWritten[kind] = EventBuffer[kind] + EventBufferSIZE;
       }
       eventInited = TRUE;
@@ -278,10 +410,11 @@ EventStringId EventInternGenString(size_t len, const char *label)
 
   AVER(label != NULL);
 
+  LockClaimEvent(); /* .lock: serialize the ids */
   id = EventInternSerial;
   ++EventInternSerial;
-
   EVENT2S(Intern, id, len, label);
+  LockReleaseEvent();
 
   return id;
 }
@@ -455,6 +588,12 @@ void EventSync(void)
 }
 
 
+void EventWritePending(void)
+{
+  NOOP;
+}
+
+
 void EventInit(void)
 {
   NOOP;
@@ -25,6 +25,7 @@ typedef Word EventStringId;
 typedef Word EventControlSet;
 
 extern void EventSync(void);
+extern void EventWritePending(void);
 extern void EventInit(void);
 extern void EventFinish(void);
 extern EventControlSet EventControl(EventControlSet resetMask,
@@ -43,12 +44,17 @@ extern void EventDump(mps_lib_FILE *stream);
 
 /* Event writing support */
 
-extern char EventBuffer[EventKindLIMIT][EventBufferSIZE];
+extern char *EventBuffer[EventKindLIMIT];
 extern char *EventLast[EventKindLIMIT];
 extern Word EventKindControl;
 
 
-/* EVENT_BEGIN -- flush buffer if necessary and write event header */
+/* EVENT_BEGIN -- flush buffer if necessary and write event header
+ *
+ * The event lock is held from EVENT_BEGIN to EVENT_END, so that
+ * threads recording events into the same buffer don't race.  See
+ * <design/telemetry/#buffer.lock>.
+ */
 
 #define EVENT_BEGIN(name, structSize)                           \
   BEGIN                                                         \
@@ -56,6 +62,7 @@ extern Word EventKindControl;
     EventKind _kind = Event##name##Kind;                        \
     size_t _size = size_tAlignUp(structSize, EVENT_ALIGN);      \
     AVER(Event##name##Used);                                    \
+    LockClaimEvent();                                           \
     if (_size > (size_t)(EventLast[Event##name##Kind]           \
                          - EventBuffer[Event##name##Kind]))     \
       EventFlush(Event##name##Kind);                            \
@@ -68,6 +75,7 @@ extern Word EventKindControl;
 
 #define EVENT_END                   \
     EventLast[_kind] -= _size;      \
+    LockReleaseEvent();             \
   END
 
 
@@ -75,8 +83,8 @@ extern Word EventKindControl;
  *
  * The macros EVENT0, EVENT1, etc. are used throughout the MPS to emit an
  * event with parameters.  They work by appending the event parameters to
- * an event buffer, which is flushed to the telemetry output stream when
- * full.  EVENT2S is a special case that takes a variable length string.
+ * an event buffer, which is handed off to be written to the telemetry
+ * output stream when full.  EVENT2S is a special case that takes a variable length string.
  */
 
 #define EVENT2S(name, p0, length, string) \
@@ -61,7 +61,7 @@
  */
 
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x005c)
+#define EventCodeMAX ((EventCode)0x0066)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -77,6 +77,7 @@
   EVENT(X, ArenaDestroy       , 0x000a,  TRUE, Arena) \
   EVENT(X, ArenaExtend        , 0x000b,  TRUE, Arena) \
   EVENT(X, ArenaFree          , 0x000c,  TRUE, Arena) \
+  EVENT(X, ArenaIdleStep      , 0x0065,  TRUE, Arena) \
   EVENT(X, ArenaPollBegin     , 0x000d,  TRUE, Arena) \
   EVENT(X, ArenaPollEnd       , 0x000e,  TRUE, Arena) \
   EVENT(X, ArenaSetEmergency  , 0x000f,  TRUE, Arena) \
@@ -94,17 +95,24 @@
   EVENT(X, CommitLimitSet     , 0x001b,  TRUE, Arena) \
   EVENT(X, EventClockSync     , 0x001c,  TRUE, Arena) \
   EVENT(X, EventInit          , 0x001d,  TRUE, Arena) \
+  EVENT(X, GenAdapt           , 0x0062,  TRUE, Arena) \
   EVENT(X, GenFinish          , 0x001e,  TRUE, Arena) \
   EVENT(X, GenInit            , 0x001f,  TRUE, Arena) \
   EVENT(X, GenZoneSet         , 0x0020,  TRUE, Arena) \
+  EVENT(X, HeapGrowthSet      , 0x0060,  TRUE, Arena) \
+  EVENT(X, IdleTimeSet        , 0x0066,  TRUE, Arena) \
   EVENT(X, Intern             , 0x0021,  TRUE, User) \
   EVENT(X, Label              , 0x0022,  TRUE, User) \
   EVENT(X, LabelPointer       , 0x0023,  TRUE, User) \
   EVENT(X, LandInit           , 0x0024,  TRUE, Pool) \
+  EVENT(X, LiveSize           , 0x0061,  TRUE, Arena) \
+  EVENT(X, MemoryPressure     , 0x0063,  TRUE, Arena) \
+  EVENT(X, MemoryTargetSet    , 0x0064,  TRUE, Arena) \
   EVENT(X, MessagesDropped    , 0x0025,  TRUE, Arena) \
   EVENT(X, MessagesExist      , 0x0026,  TRUE, Arena) \
   EVENT(X, MeterInit          , 0x0027,  TRUE, Pool) \
   EVENT(X, MeterValues        , 0x0028,  TRUE, Pool) \
+  EVENT(X, MMUTargetSet       , 0x005f,  TRUE, Arena) \
   EVENT(X, PauseTimeSet       , 0x0029,  TRUE, Arena) \
   EVENT(X, PoolAlloc          , 0x002a,  TRUE, Object) \
   EVENT(X, PoolFinish         , 0x002b,  TRUE, Pool) \
@@ -129,6 +137,7 @@
   EVENT(X, SegSetGrey         , 0x003e,  TRUE, Seg) \
   EVENT(X, SegSetSummary      , 0x003f,  TRUE, Seg) \
   EVENT(X, SegSplit           , 0x0040,  TRUE, Seg) \
+  EVENT(X, SpareDecaySet      , 0x005d,  TRUE, Arena) \
   EVENT(X, TraceAccess        , 0x0041,  TRUE, Seg) \
   EVENT(X, TraceBandAdvance   , 0x0042,  TRUE, Trace) \
   EVENT(X, TraceCondemnAll    , 0x0043,  TRUE, Trace) \
@@ -243,6 +252,11 @@
   PARAM(X,  2, W, size, "size of the freed block in bytes") \
   PARAM(X,  3, P, pool, "pool that freed the block")
 
+#define EVENT_ArenaIdleStep_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, D, idle, "seconds since the last buffer fill") \
+  PARAM(X,  2, B, workWasDone, "any collection work done in step?")
+
 #define EVENT_ArenaPollBegin_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "arena about to be polled")
 
@@ -326,6 +340,16 @@
   PARAM(X,  5, U, wordWidth, "MPS_WORD_WIDTH") \
   PARAM(X,  6, W, clocksPerSec, "mps_clocks_per_sec()")
 
+#define EVENT_GenAdapt_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, P, trace, "the trace that collected the generation") \
+  PARAM(X,  2, P, gen, "the generation") \
+  PARAM(X,  3, W, survived, "bytes that survived the trace") \
+  PARAM(X,  4, W, condemned, "bytes of the generation condemned") \
+  PARAM(X,  5, D, pause, "longest pause during the trace, in seconds") \
+  PARAM(X,  6, W, oldCapacity, "capacity before adapting, in bytes") \
+  PARAM(X,  7, W, newCapacity, "capacity after adapting, in bytes")
+
 #define EVENT_GenFinish_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "generation's arena") \
   PARAM(X,  1, P, gen, "the generation") \
@@ -343,6 +367,14 @@
   PARAM(X,  1, P, gen, "the generation") \
   PARAM(X,  2, W, zoneSet, "generation's new summary")
 
+#define EVENT_HeapGrowthSet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, D, heapGrowth, "the new heap growth target, in percent")
+
+#define EVENT_IdleTimeSet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, D, idleTime, "the new idle time, in seconds")
+
 #define EVENT_Intern_PARAMS(PARAM, X) \
   PARAM(X,  0, W, stringId, "identifier of interned string") \
   PARAM(X,  1, S, string, "the interned string")
@@ -359,6 +391,21 @@
   PARAM(X,  0, P, land, "the land") \
   PARAM(X,  1, P, owner, "owner pointer")
 
+#define EVENT_LiveSize_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, P, trace, "the trace that measured it") \
+  PARAM(X,  2, W, liveSize, "the new live size, in bytes")
+
+#define EVENT_MemoryPressure_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, W, target, "the soft target for committed memory") \
+  PARAM(X,  2, W, committed, "committed memory after purging spare") \
+  PARAM(X,  3, D, pressure, "committed memory / target")
+
+#define EVENT_MemoryTargetSet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, W, memoryTarget, "the new memory target, in bytes")
+
 #define EVENT_MessagesDropped_PARAMS(PARAM, X) \
   PARAM(X,  0, W, count, "count of messages dropped")
 
@@ -376,6 +423,11 @@
   PARAM(X,  4, W, max, "maximum metered amount") \
   PARAM(X,  5, W, min, "minimum metered amount")
 
+#define EVENT_MMUTargetSet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, D, mmuTarget, "the new target minimum mutator utilization") \
+  PARAM(X,  2, D, mmuWindow, "the new MMU window, in seconds")
+
 #define EVENT_PauseTimeSet_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "the arena") \
   PARAM(X,  1, D, pauseTime, "the new maximum pause time, in seconds")
@@ -504,6 +556,10 @@
   PARAM(X,  2, P, segHi, "new high segment") \
   PARAM(X,  3, A, at, "split address")
 
+#define EVENT_SpareDecaySet_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena, "the arena") \
+  PARAM(X,  1, D, spareDecay, "the new spare decay time, in seconds")
+
 #define EVENT_TraceAccess_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena, "the arena") \
   PARAM(X,  1, P, seg, "segment accessed") \
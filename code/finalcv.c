@@ -147,10 +147,30 @@ static void test(mps_arena_t arena, mps_pool_class_t pool_class)
        yet, or for an address that was not registered for finalization. */
     Insist(mps_definalize(arena, &p) == MPS_RES_FAIL);
 
-    die(mps_finalize(arena, &p), "finalize\n");
+    /* The first half are registered together below. */
+    if (i >= rootCOUNT / 2)
+      die(mps_finalize(arena, &p), "finalize\n");
     root[i] = p; state[i] = rootSTATE;
   }
   p = NULL;
+  die(mps_finalize_many(arena, root, rootCOUNT / 2), "finalize_many\n");
+
+  /* An object registered twice can be deregistered twice, even after
+     it has moved. */
+  die(mps_finalize(arena, &root[0]), "finalize twice\n");
+  mps_arena_collect(arena);
+  mps_arena_release(arena);
+  die(mps_definalize(arena, &root[0]), "definalize\n");
+  die(mps_definalize(arena, &root[0]), "definalize twice\n");
+  Insist(mps_definalize(arena, &root[0]) == MPS_RES_FAIL);
+  die(mps_finalize(arena, &root[0]), "finalize again\n");
+
+  /* Deregister an object during a collection, after it has moved but
+     before its guardian has been scanned. */
+  die(mps_arena_start_collect(arena), "start_collect\n");
+  die(mps_definalize(arena, &root[1]), "definalize in collection\n");
+  Insist(mps_definalize(arena, &root[1]) == MPS_RES_FAIL);
+  die(mps_finalize(arena, &root[1]), "finalize in collection\n");
 
   mps_message_type_enable(arena, mps_message_type_finalization());
   mps_message_type_enable(arena, mps_message_type_gc());
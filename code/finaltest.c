@@ -140,6 +140,7 @@ static void register_indirect_tree(mps_word_t tree, mps_arena_t arena)
 }
 
 static void *root[rootCOUNT];
+static mps_addr_t finalREFS[64];
 
 static void test_trees(int mode, const char *name, mps_arena_t arena,
                        mps_pool_t pool, mps_ap_t ap,
@@ -173,6 +174,7 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
 
   while (finals < object_count && collections < collectionCOUNT) {
     mps_message_type_t type;
+    mps_message_t message;
     mps_word_t final_this_time = 0;
     switch (mode) {
     default:
@@ -199,8 +201,19 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
       Insist(free_size <= total_size);
       Insist(free_size + live_size <= total_size);
     }
+    if (mode == ModePOLL) {
+      /* Drain finalization messages in bulk. */
+      size_t got;
+      do {
+        got = mps_message_finalization_refs(finalREFS, arena,
+                                            NELEMS(finalREFS));
+        Insist(got <= NELEMS(finalREFS));
+        final_this_time += got;
+      } while (got == NELEMS(finalREFS));
+      Insist(!mps_message_get(&message, arena,
+                              mps_message_type_finalization()));
+    }
     while (mps_message_queue_type(&type, arena)) {
-      mps_message_t message;
       cdie(mps_message_get(&message, arena, type), "message_get");
       if (type == mps_message_type_finalization()) {
         mps_addr_t objaddr;
@@ -401,6 +401,62 @@ static mps_addr_t obj_skip(mps_addr_t base)
   return base;
 }
 
+/* obj_scan_slice -- scan the references of an object in [base, limit)
+ *
+ * Vectors and buckets may be large, so only their elements in the
+ * slice are scanned. Other objects are small, and are scanned whole by
+ * the slice that contains their start.
+ */
+
+static mps_res_t obj_scan_slice(mps_ss_t ss, mps_addr_t object,
+                                mps_addr_t base, mps_addr_t limit)
+{
+  obj_t obj = object;
+  char *lo = base, *hi = limit;
+
+  switch (TYPE(obj)) {
+  case TYPE_VECTOR:
+    {
+      obj_t *p = obj->vector.vector;
+      obj_t *q = p + obj->vector.length;
+      if ((char *)p < lo)
+        p = (obj_t *)lo;
+      if (hi < (char *)q)
+        q = (obj_t *)hi;
+      MPS_SCAN_BEGIN(ss) {
+        for (; p < q; ++p)
+          FIX(*p);
+      } MPS_SCAN_END(ss);
+    }
+    break;
+  case TYPE_BUCKETS:
+    {
+      char *start = (char *)&obj->buckets.bucket[0];
+      size_t size = sizeof(obj->buckets.bucket[0]);
+      size_t i = 0, n = obj->buckets.length;
+      if (start < lo)
+        i = (size_t)(lo - start) / size;
+      if (hi < start + n * size)
+        n = (size_t)(hi - start + (ptrdiff_t)size - 1) / size;
+      MPS_SCAN_BEGIN(ss) {
+        for (; i < n; ++i) {
+          struct bucket_s *b = &obj->buckets.bucket[i];
+          if (lo <= (char *)&b->key && (char *)&b->key < hi)
+            FIX(b->key);
+          if (lo <= (char *)&b->value && (char *)&b->value < hi)
+            FIX(b->value);
+        }
+      } MPS_SCAN_END(ss);
+    }
+    break;
+  default:
+    if (lo <= (char *)object && (char *)object < hi)
+      return obj_scan(ss, object, obj_skip(object));
+    break;
+  }
+  return MPS_RES_OK;
+}
+
 static mps_addr_t obj_isfwd(mps_addr_t addr)
 {
   obj_t obj = addr;
@@ -452,6 +508,7 @@ void scheme_fmt(mps_fmt_t *fmt)
     MPS_ARGS_ADD(args, MPS_KEY_FMT_FWD, obj_fwd);
     MPS_ARGS_ADD(args, MPS_KEY_FMT_ISFWD, obj_isfwd);
     MPS_ARGS_ADD(args, MPS_KEY_FMT_PAD, obj_pad);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN_SLICE, obj_scan_slice);
     res = mps_fmt_create_k(fmt, scheme_arena, args);
   } MPS_ARGS_END(args);
   if (res != MPS_RES_OK) error("Couldn't create obj format");
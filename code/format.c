@@ -33,6 +33,7 @@ Bool FormatCheck(Format format)
   CHECKL(FUNCHECK(format->isMoved));
   CHECKL(FUNCHECK(format->pad));
   CHECKL(FUNCHECK(format->klass));
+  CHECKL(format->scanSlice == NULL || FUNCHECK(format->scanSlice));
 
   return TRUE;
 }
@@ -96,6 +97,7 @@ ARG_DEFINE_KEY(FMT_ISFWD, Fun);
 ARG_DEFINE_KEY(FMT_PAD, Fun);
 ARG_DEFINE_KEY(FMT_HEADER_SIZE, Size);
 ARG_DEFINE_KEY(FMT_CLASS, Fun);
+ARG_DEFINE_KEY(FMT_SCAN_SLICE, Fun);
 
 Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
 {
@@ -111,6 +113,7 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
   mps_fmt_isfwd_t fmtIsfwd = FMT_ISFWD_DEFAULT;
   mps_fmt_pad_t fmtPad = FMT_PAD_DEFAULT;
   mps_fmt_class_t fmtClass = FMT_CLASS_DEFAULT;
+  mps_fmt_scan_slice_t fmtScanSlice = FMT_SCAN_SLICE_DEFAULT;
 
   AVER(formatReturn != NULL);
   AVERT(Arena, arena);
@@ -132,6 +135,8 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
     fmtPad = arg.val.fmt_pad;
   if (ArgPick(&arg, args, MPS_KEY_FMT_CLASS))
     fmtClass = arg.val.fmt_class;
+  if (ArgPick(&arg, args, MPS_KEY_FMT_SCAN_SLICE))
+    fmtScanSlice = arg.val.fmt_scan_slice;
 
   res = ControlAlloc(&p, arena, sizeof(FormatStruct));
   if(res != ResOK)
@@ -149,6 +154,7 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
   format->isMoved = fmtIsfwd;
   format->pad = fmtPad;
   format->klass = fmtClass;
+  format->scanSlice = fmtScanSlice;
 
   format->sig = FormatSig;
   format->serial = arena->formatSerial;
@@ -221,6 +227,30 @@ Res FormatScan(Format format, ScanState ss, Addr base, Addr limit)
 }
 
 
+/* FormatScanSlice -- scan part of a formatted object for references
+ *
+ * Scans the references in the object whose addresses lie in [base,
+ * limit), so that a pool can scan a large object in several
+ * increments.  Only valid if the format has a scan slice method.  See
+ * <design/trace/#scan.slice>.
+ */
+
+Res FormatScanSlice(Format format, ScanState ss, Addr object,
+                    Addr base, Addr limit)
+{
+  AVERT(Format, format);
+  AVERT(ScanState, ss);
+  AVER(format->scanSlice != NULL);
+  AVER(object != NULL);
+  AVER(base != NULL);
+  AVER(base < limit);
+
+  ss->scannedSize += AddrOffset(base, limit);
+
+  return format->scanSlice(&ss->ss_s, object, base, limit);
+}
+
+
 /* FormatDescribe -- describe a format */
 
 Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth)
@@ -238,6 +268,7 @@ Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth)
                "  move $F\n", (WriteFF)format->move,
                "  isMoved $F\n", (WriteFF)format->isMoved,
                "  pad $F\n", (WriteFF)format->pad,
+               "  scanSlice $F\n", (WriteFF)format->scanSlice,
                "  headerSize $W\n", (WriteFW)format->headerSize,
                "} Format $P ($U)\n", (WriteFP)format, (WriteFU)format->serial,
                NULL);
@@ -57,6 +57,12 @@ static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
 static double spare = ARENA_SPARE_DEFAULT; /* spare commit fraction */
+static mps_bool_t huge_pages = FALSE; /* arena uses huge pages */
+static double mmu_target = ARENA_DEFAULT_MMU_TARGET; /* MMU target */
+static double mmu_window = ARENA_DEFAULT_MMU_WINDOW; /* MMU window */
+static double heap_growth = ARENA_DEFAULT_HEAP_GROWTH; /* % over live */
+static mps_bool_t adapt_chains = FALSE; /* adapt generation capacities? */
+static size_t memory_target = 0; /* soft target for committed memory */
 
 typedef struct gcthread_s *gcthread_t;
 
@@ -248,6 +254,12 @@ static void arena_setup(gcthread_fn_t fn,
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, spare);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, huge_pages);
+    MPS_ARGS_ADD(args, MPS_KEY_MMU_TARGET, mmu_target);
+    MPS_ARGS_ADD(args, MPS_KEY_MMU_WINDOW, mmu_window);
+    MPS_ARGS_ADD(args, MPS_KEY_HEAP_GROWTH, heap_growth);
+    MPS_ARGS_ADD(args, MPS_KEY_ADAPT_CHAINS, adapt_chains);
+    MPS_ARGS_ADD(args, MPS_KEY_MEMORY_TARGET, memory_target);
     RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
   RESMUST(dylan_fmt(&format, arena));
@@ -263,6 +275,13 @@ static void arena_setup(gcthread_fn_t fn,
     RESMUST(mps_pool_create_k(&pool, arena, pool_class, args));
   } MPS_ARGS_END(args);
   watch(fn, name);
+  {
+    mps_pause_stats_s stats;
+    mps_arena_pause_stats(arena, MPS_PAUSE_POLL, &stats);
+    printf("%s: polls %lu p99 %g max %g mmu(%g) %g\n", name,
+           (unsigned long)stats.count, stats.p99, stats.max,
+           mmu_window, mps_arena_mmu(arena, mmu_window));
+  }
   mps_arena_park(arena);
   mps_pool_destroy(pool);
   mps_fmt_destroy(format);
@@ -291,6 +310,12 @@ static struct option longopts[] = {
   {"arena-unzoned",    no_argument,       NULL, 'z'},
   {"pause-time",       required_argument, NULL, 'P'},
   {"spare",            required_argument, NULL, 'S'},
+  {"arena-huge-pages", no_argument,       NULL, 'H'},
+  {"mmu-target",       required_argument, NULL, 'U'},
+  {"mmu-window",       required_argument, NULL, 'W'},
+  {"heap-growth",      required_argument, NULL, 'G'},
+  {"adapt-chains",     no_argument,       NULL, 'A'},
+  {"memory-target",    required_argument, NULL, 'T'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -316,7 +341,7 @@ int main(int argc, char *argv[])
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:S:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:S:HU:W:G:AT:",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -413,6 +438,35 @@ int main(int argc, char *argv[])
     case 'S':
       spare = strtod(optarg, NULL);
       break;
+    case 'H':
+      huge_pages = TRUE;
+      break;
+    case 'U':
+      mmu_target = strtod(optarg, NULL);
+      break;
+    case 'W':
+      mmu_window = strtod(optarg, NULL);
+      break;
+    case 'G':
+      heap_growth = strtod(optarg, NULL);
+      break;
+    case 'A':
+      adapt_chains = TRUE;
+      break;
+    case 'T': {
+        char *p;
+        memory_target = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': memory_target <<= 30; break;
+        case 'M': memory_target <<= 20; break;
+        case 'K': memory_target <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad memory target %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -462,12 +516,29 @@ int main(int argc, char *argv[])
               "    Maximum pause time in seconds (default %f)\n"
               "  -S f, --spare\n"
               "    Maximum spare committed fraction (default %f)\n"
+              "  -H, --arena-huge-pages\n"
+              "    Back the arena with huge pages if possible\n"
+              "  -U u, --mmu-target=u\n"
+              "    Minimum mutator utilization to aim for (default %f)\n"
+              "  -W t, --mmu-window=t\n"
+              "    Window for MMU, in seconds (default %f)\n",
+              pause_time,
+              spare,
+              mmu_target,
+              mmu_window);
+      fprintf(stderr,
+              "  -G p, --heap-growth=p\n"
+              "    Percentage heap growth over live size (default %f)\n"
+              "  -A, --adapt-chains\n"
+              "    Adapt generation capacities to collection cost\n"
+              "  -T n, --memory-target=n[KMG]?\n"
+              "    Soft target for committed memory (default none)\n",
+              heap_growth);
+      fprintf(stderr,
               "Tests:\n"
               "  amc   pool class AMC\n"
               "  ams   pool class AMS\n"
-              "  awl   pool class AWL\n",
-              pause_time,
-              spare);
+              "  awl   pool class AWL\n");
       return EXIT_FAILURE;
     }
   argc -= optind;
@@ -22,6 +22,7 @@
  * confusion over naming.  */
 
 #include "bt.h"
+#include "table.h"
 #include "poolmrg.h"
 #include "mps.h" /* finalization */
 #include "mpm.h"
@@ -61,6 +62,7 @@ void GlobalsClaimAll(void)
   LockClaimGlobalRecursive();
   arenaClaimRingLock();
   GlobalsArenaMap(ArenaEnter);
+  LockClaimEvent();
 }
 
 /* GlobalsReleaseAll -- release all MPS locks. GlobalsClaimAll must
@@ -68,6 +70,7 @@ void GlobalsClaimAll(void)
 
 void GlobalsReleaseAll(void)
 {
+  LockReleaseEvent();
   GlobalsArenaMap(ArenaLeave);
   arenaReleaseRingLock();
   LockReleaseGlobalRecursive();
@@ -175,6 +178,7 @@ Bool GlobalsCheck(Globals arenaGlobals)
     CHECKD_NOSIG(Lock, arenaGlobals->lock);
 
   /* no check possible on pollThreshold */
+  CHECKL(arenaGlobals->pollDebt >= 0.0);
   CHECKL(BoolCheck(arenaGlobals->insidePoll));
   CHECKL(BoolCheck(arenaGlobals->clamped));
   CHECKL(arenaGlobals->fillMutatorSize >= 0.0);
@@ -197,6 +201,12 @@ Bool GlobalsCheck(Globals arenaGlobals)
   CHECKD_NOSIG(Ring, &arena->messageRing);
   if (arena->enabledMessageTypes != NULL)
     CHECKD_NOSIG(BT, arena->enabledMessageTypes);
+  if (arena->hashTable != NULL)
+    CHECKD(Table, arena->hashTable);
+  CHECKL(arena->sampleInterval == 0 || FUNCHECK(arena->sampler));
+  CHECKL(arena->sampleInterval != 0 || arena->sampleCountdown == 0);
+  if (arena->sampleTable != NULL)
+    CHECKD(Table, arena->sampleTable);
   CHECKL(BoolCheck(arena->isFinalPool));
   if (arena->isFinalPool) {
     CHECKD(Pool, arena->finalPool);
@@ -231,10 +241,13 @@ Bool GlobalsCheck(Globals arenaGlobals)
 
   CHECKL(arena->tracedWork >= 0.0);
   CHECKL(arena->tracedTime >= 0.0);
+  CHECKL(arena->calibClocks >= 0.0);
+  CHECKL(arena->calibTicks >= 0.0);
   /* no check for arena->lastWorldCollect (Clock) */
 
   /* can't write a check for arena->epoch */
   CHECKD(History, ArenaHistory(arena));
+  CHECKD(PauseStats, ArenaPauseStats(arena));
 
   /* we also check the statics now. <design/arena/#static.check> */
   CHECKL(BoolCheck(arenaRingInit));
@@ -296,6 +309,7 @@ Res GlobalsInit(Globals arenaGlobals)
   arenaGlobals->lock = NULL;
 
   arenaGlobals->pollThreshold = 0.0;
+  arenaGlobals->pollDebt = 0.0;
   arenaGlobals->insidePoll = FALSE;
   arenaGlobals->clamped = FALSE;
   arenaGlobals->fillMutatorSize = 0.0;
@@ -328,11 +342,20 @@ Res GlobalsInit(Globals arenaGlobals)
   arena->droppedMessages = 0;
   arena->isFinalPool = FALSE;
   arena->finalPool = NULL;
+  arena->hashTable = NULL;
+  arena->hashSerial = 0;
+  arena->sampleInterval = 0;
+  arena->sampleCountdown = 0;
+  arena->sampler = NULL;
+  arena->samplerClosure = NULL;
+  arena->sampleTable = NULL;
   arena->busyTraces = TraceSetEMPTY;    /* <code/trace.c> */
   arena->flippedTraces = TraceSetEMPTY; /* <code/trace.c> */
   arena->tracedWork = 0.0;
   arena->tracedTime = 0.0;
   arena->lastWorldCollect = ClockNow();
+  arena->calibClocks = 0.0;
+  arena->calibTicks = 0.0;
   ShieldInit(ArenaShield(arena));
 
   for (ti = 0; ti < TraceLIMIT; ++ti) {
@@ -350,6 +373,7 @@ Res GlobalsInit(Globals arenaGlobals)
   RingInit(&arena->chainRing);
 
   HistoryInit(ArenaHistory(arena));
+  PauseStatsInit(ArenaPauseStats(arena));
   
   arena->emergency = FALSE;
 
@@ -447,6 +471,7 @@ void GlobalsFinish(Globals arenaGlobals)
 
   ShieldFinish(ArenaShield(arena));
   HistoryFinish(ArenaHistory(arena));
+  PauseStatsFinish(ArenaPauseStats(arena));
   RingFinish(&arena->formatRing);
   RingFinish(&arena->chainRing);
   RingFinish(&arena->messageRing);
@@ -474,12 +499,20 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
 
   AVERT(Globals, arenaGlobals);
 
+  arena = GlobalsArena(arenaGlobals);
+
+  /* Stop the idle timer before parking, so that it can't start
+   * another collection <design/arena/#idle>. */
+  if (arena->idleTimer != NULL) {
+    ThreadTimer timer = arena->idleTimer;
+    arena->idleTimer = NULL;
+    ThreadTimerDestroy(timer);
+  }
+
   /* Park the arena before destroying the default chain, to ensure
    * that there are no traces using that chain. */
   ArenaPark(arenaGlobals);
 
-  arena = GlobalsArena(arenaGlobals);
-
   arenaDenounce(arena);
 
   defaultChain = arenaGlobals->defaultChain;
@@ -518,6 +551,11 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
     arena->enabledMessageTypes = NULL;
   }
 
+  /* throw away the samples and identity hashes */
+  /* <design/arena/#sample>, <design/arena/#hash> */
+  SampleFinish(arena);
+  IdHashFinish(arena);
+
   /* destroy the final pool (see <design/finalize/>) */
   if (arena->isFinalPool) {
     /* All this subtlety is because PoolDestroy will call */
@@ -633,6 +671,10 @@ void ArenaLeaveLock(Arena arena, Bool recursive)
     LockReleaseRecursive(lock);
   } else {
     LockRelease(lock);
+    /* Write out any telemetry that filled up while we were in the
+       arena, now that other threads aren't waiting for the lock.
+       <design/telemetry/#buffer.write> */
+    EventWritePending();
   }
 }
 
@@ -666,9 +708,11 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
     Globals arenaGlobals = RING_ELT(Globals, globalRing, node);
     Arena arena = GlobalsArena(arenaGlobals);
     Root root;
+    Clock start;
 
     ArenaEnter(arena);     /* <design/arena/#lock.arena> */
     EVENT3(ArenaAccessBegin, arena, addr, mode);
+    start = ClockNow();
 
     /* @@@@ The code below assumes that Roots and Segs are disjoint. */
     /* It will fall over (in TraceSegAccess probably) if there is a */
@@ -689,14 +733,18 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
         /* Protection was already cleared, for example by another thread
            or a fault in a nested exception handler: nothing to do now. */
       }
+      PauseStatsRecord(ArenaPauseStats(arena), PauseKindACCESS,
+                       start, ClockNow());
       EVENT1(ArenaAccessEnd, arena);
       ArenaLeave(arena);
       return TRUE;
     } else if (RootOfAddr(&root, arena, addr)) {
       arenaReleaseRingLock();
-      mode &= RootPM(root);
+      mode &= RootPM(root, addr);
       if (mode != AccessSetEMPTY)
-        RootAccess(root, mode);
+        TraceRootAccess(arena, root, addr, mode);
+      PauseStatsRecord(ArenaPauseStats(arena), PauseKindACCESS,
+                       start, ClockNow());
       EVENT1(ArenaAccessEnd, arena);
       ArenaLeave(arena);
       return TRUE;
@@ -738,6 +786,7 @@ void (ArenaPoll)(Globals globals)
   Bool worldCollected = FALSE;
   Bool moreWork, workWasDone = FALSE;
   Work tracedWork;
+  EventClock startTicks;
 
   AVERT(Globals, globals);
 
@@ -753,9 +802,13 @@ void (ArenaPoll)(Globals globals)
 
   /* fillMutatorSize has advanced; call TracePoll enough to catch up. */
   start = ClockNow();
+  EVENT_CLOCK(startTicks);
 
   EVENT1(ArenaPollBegin, arena);
 
+  /* See <design/arena/#pressure>. */
+  ArenaUpdatePressure(arena, start);
+
   do {
     moreWork = TracePoll(&tracedWork, &worldCollected, globals,
                          !worldCollected);
@@ -766,9 +819,19 @@ void (ArenaPoll)(Globals globals)
 
   /* Don't count time spent checking for work, if there was no work to do. */
   if (workWasDone) {
-    ArenaAccumulateTime(arena, start, ClockNow());
+    Clock end = ClockNow();
+    EventClock endTicks;
+    EVENT_CLOCK(endTicks);
+    ArenaAccumulateTime(arena, start, end);
+    /* <design/strategy/#policy.model.clock> */
+    if (endTicks > startTicks)
+      PolicyCalibrate(arena, end - start, (double)(endTicks - startTicks));
+    PauseStatsRecord(ArenaPauseStats(arena), PauseKindPOLL, start, end);
   }
 
+  /* See <design/arena/#spare.decay>. */
+  ArenaDecaySpare(arena, start);
+
   EVENT2(ArenaPollEnd, arena, BOOLOF(workWasDone));
 
   globals->insidePoll = FALSE;
@@ -797,6 +860,9 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   availableEnd = start + (Clock)(interval * multiplier * clocks_per_sec);
   AVER(availableEnd >= start);
 
+  /* See <design/arena/#pressure>. */
+  ArenaUpdatePressure(arena, start);
+
   /* loop while there is work to do and time on the clock. */
   do {
     Trace trace;
@@ -830,24 +896,117 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
     ArenaAccumulateTime(arena, start, now);
   }
 
+  /* Spend any time that is left zeroing spare memory, so that pools
+     needing zeroed memory don't have to zero it when they allocate.
+     See <design/arena/#zero.spare>. */
+  while (now < intervalEnd
+         && ArenaZeroSpare(arena, ARENA_ZERO_SPARE_STEP) > 0)
+    now = ClockNow();
+
+  /* See <design/arena/#spare.decay>. */
+  ArenaDecaySpare(arena, now);
+
+  PauseStatsRecord(ArenaPauseStats(arena), PauseKindSTEP, start, now);
+
   return workWasDone;
 }
 
-/* ArenaFinalize -- registers an object for finalization
+
+/* arenaIdleTick -- called periodically by the idle timer
  *
- * See <design/finalize/>.  */
+ * See <design/arena/#idle>.  This runs on a background thread, which
+ * only tries to claim the arena lock: if another thread holds it then
+ * the arena isn't idle, and ArenaSetIdleTime may be waiting for this
+ * function to return while holding it.
+ */
 
-Res ArenaFinalize(Arena arena, Ref obj)
+static void arenaIdleTick(void *closure)
 {
-  Res res;
-  Pool refpool;
+  Arena arena = closure;
+  Globals globals;
+
+  AVER(TESTT(Arena, arena));
+  globals = ArenaGlobals(arena);
+  if (!LockTryClaim(globals->lock))
+    return;
+  AVERT(Arena, arena); /* can't AVERT it until we've got the lock */
+  ShieldEnter(arena);
 
+  if (globals->clamped || globals->fillMutatorSize != arena->idleFillSize) {
+    /* The mutator has filled a buffer since the last tick, or the
+       client has asked for no background activity. */
+    arena->idleFillSize = globals->fillMutatorSize;
+    arena->idleTicks = 0;
+  } else {
+    double idle, pauseTime, multiplier;
+    Bool workWasDone;
+
+    ++arena->idleTicks;
+    idle = arena->idleTime * (double)arena->idleTicks;
+    pauseTime = ArenaPauseTime(arena);
+    /* Work for at most one pause, since the mutator may need the
+       lock at any moment, but expect it to stay idle for as long
+       again when deciding whether to collect the world
+       <design/arena/#idle.world>. */
+    multiplier = pauseTime > 0.0 ? idle / pauseTime : 0.0;
+    workWasDone = ArenaStep(globals, pauseTime, multiplier);
+    EVENT3(ArenaIdleStep, arena, idle, BOOLOF(workWasDone));
+  }
+
+  ArenaLeave(arena);
+}
+
+
+/* ArenaIdleTime, ArenaSetIdleTime -- get and set the idle time
+ *
+ * Setting the idle time replaces the idle timer, if any, with a new
+ * one, unless the idle time is zero.  The old timer never waits for
+ * the arena lock (see arenaIdleTick) so it is safe to destroy it
+ * while holding the lock.
+ */
+
+double ArenaIdleTime(Arena arena)
+{
   AVERT(Arena, arena);
-  AVER(PoolOfAddr(&refpool, arena, (Addr)obj));
-  AVER(PoolHasAttr(refpool, AttrGC));
+  return arena->idleTime;
+}
+
+Res ArenaSetIdleTime(Arena arena, double idleTime)
+{
+  AVERT(Arena, arena);
+  AVER(0.0 <= idleTime);
+
+  if (arena->idleTimer != NULL) {
+    ThreadTimer timer = arena->idleTimer;
+    arena->idleTimer = NULL; /* before ControlFree checks the arena */
+    ThreadTimerDestroy(timer);
+  }
+  arena->idleTime = 0.0;
+  arena->idleFillSize = ArenaGlobals(arena)->fillMutatorSize;
+  arena->idleTicks = 0;
+
+  if (idleTime > 0.0) {
+    Res res = ThreadTimerCreate(&arena->idleTimer, arena, idleTime,
+                                arenaIdleTick, arena);
+    if (res != ResOK)
+      return res;
+  }
 
+  arena->idleTime = idleTime;
+  EVENT2(IdleTimeSet, arena, idleTime);
+  return ResOK;
+}
+
+
+/* arenaFinalPool -- return the arena's finalization pool
+ *
+ * The pool is created when an object is first registered. */
+
+static Res arenaFinalPool(Pool *poolReturn, Arena arena)
+{
   if (!arena->isFinalPool) {
     Pool finalpool;
+    Res res;
 
     res = PoolCreate(&finalpool, arena, PoolClassMRG(), argsNone);
     if (res != ResOK)
@@ -856,7 +1015,61 @@ Res ArenaFinalize(Arena arena, Ref obj)
     arena->isFinalPool = TRUE;
   }
 
-  res = MRGRegister(arena->finalPool, obj);
+  *poolReturn = arena->finalPool;
+  return ResOK;
+}
+
+/* ArenaFinalize -- registers an object for finalization
+ *
+ * See <design/finalize/>.  */
+
+Res ArenaFinalize(Arena arena, Ref obj)
+{
+  Res res;
+  Pool refpool, finalpool;
+
+  AVERT(Arena, arena);
+  AVER(PoolOfAddr(&refpool, arena, (Addr)obj));
+  AVER(PoolHasAttr(refpool, AttrGC));
+
+  res = arenaFinalPool(&finalpool, arena);
+  if (res != ResOK)
+    return res;
+
+  res = MRGRegister(finalpool, obj);
+  return res;
+}
+
+
+/* ArenaFinalizeMany -- registers several objects for finalization
+ *
+ * The references are read from refs through the barrier. Either all
+ * the objects are registered, or none are. See <design/finalize>.  */
+
+Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count)
+{
+  Res res;
+  Pool finalpool;
+
+  AVERT(Arena, arena);
+  AVER(refs != NULL);
+
+#if defined(AVER_AND_CHECK_ALL)
+  {
+    Index i;
+    for (i = 0; i < count; ++i) {
+      Pool refpool;
+      AVER(PoolOfAddr(&refpool, arena, (Addr)ArenaPeek(arena, &refs[i])));
+      AVER(PoolHasAttr(refpool, AttrGC));
+    }
+  }
+#endif
+
+  res = arenaFinalPool(&finalpool, arena);
+  if (res != ResOK)
+    return res;
+
+  res = MRGRegisterMany(finalpool, refs, count);
   return res;
 }
 
@@ -1031,6 +1244,7 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
                "mpsVersion $S\n", (WriteFS)arenaGlobals->mpsVersionString,
                "lock $P\n", (WriteFP)arenaGlobals->lock,
                "pollThreshold $U\n", (WriteFU)arenaGlobals->pollThreshold,
+               "pollDebt $U\n", (WriteFU)arenaGlobals->pollDebt,
                arenaGlobals->insidePoll ? "inside" : "outside", " poll\n",
                arenaGlobals->clamped ? "clamped\n" : "released\n",
                "fillMutatorSize $U\n", (WriteFU)arenaGlobals->fillMutatorSize,
@@ -1052,6 +1266,10 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
   if (res != ResOK)
     return res;
 
+  res = PauseStatsDescribe(ArenaPauseStats(arena), stream, depth + 2);
+  if (res != ResOK)
+    return res;
+
   res = ShieldDescribe(ArenaShield(arena), stream, depth + 2);
   if (res != ResOK)
     return res;
@@ -0,0 +1,916 @@
+/* image.c: HEAP IMAGES
+ *
+ * $Id$
+ * Copyright (c) 2001-2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: A heap image is a copy of the formatted objects in a
+ * pool, which can be read back into a pool of the same class and
+ * format, possibly in another process, so that a client program can
+ * start up by loading a prebuilt heap instead of allocating it object
+ * by object.
+ *
+ * .layout: An image consists of a header (ImageHeaderStruct), a table
+ * of runs (ImageRunStruct), a table of padding objects
+ * (ImagePadStruct), the contents of the runs, and a bit table with one
+ * bit for each word of the contents, set for the words that hold
+ * references.  A run is a maximal sequence of contiguous objects in one
+ * segment, including padding objects.  In the image, a reference is
+ * replaced by the offset of its target from the start of the contents,
+ * plus any tag bits the format keeps in the reference.
+ *
+ * .pad: A padding object may record its own address (for example, a
+ * padding object in the Dylan format records its limit), so it can't
+ * be copied.  An object is taken to be padding if skipping its copy
+ * doesn't give the copy's limit.  Padding objects are recreated with
+ * the format's pad method, both in the copy made when the image is
+ * written and in the pool when it is read.
+ *
+ * .reloc: The references are found when the image is written, by
+ * scanning a copy of the contents with the format's scan method and a
+ * fix method that points each reference at the corresponding copy.
+ * The words of the copy that differ from the original are the
+ * references.  The copy is made before any of it is scanned, so the
+ * scan method may follow the references it fixes, and the references
+ * aren't converted to offsets until all of it has been scanned.  So
+ * reading an image doesn't call the format: it copies the contents
+ * into freshly reserved memory and adds the new address of each run to
+ * the references into it.
+ *
+ * .closed: An image must be closed: a reference from an object in the
+ * pool to another pool in the arena can't be relocated, so writing
+ * the image fails.  References to memory outside the arena are
+ * written unchanged.
+ *
+ * .parked: Both writing and reading require a parked arena.  Writing
+ * needs to create a trace; reading commits objects whose references
+ * aren't relocated until all the objects have been read, so nothing
+ * may scan them in between.
+ *
+ * .fail: If reading fails after some runs have been read, they are
+ * replaced with padding before returning, so the pool can still be
+ * collected and used.
+ */
+
+#include "mpm.h"
+#include "mps.h"
+
+SRCID(image, "$Id$");
+
+
+#define imageMAGIC      ((Word)0x519A6E5A) /* SIGnAture IMAGE SAve */
+#define imageVERSION    ((Word)1)
+#define imageRUNS       ((Count)64)
+
+
+/* ImageHeaderStruct -- the header of an image, as written */
+
+typedef struct ImageHeaderStruct {
+  Word magic;                   /* imageMAGIC */
+  Word version;                 /* imageVERSION */
+  Word wordSize;                /* sizeof(Word) in the writer */
+  Word alignment;               /* alignment of the pool */
+  Word headerSize;              /* header size of the format */
+  Word runs;                    /* number of runs */
+  Word pads;                    /* number of padding objects */
+  Word size;                    /* total size of the runs */
+} ImageHeaderStruct;
+
+
+/* ImageRunStruct -- a run of objects, as written */
+
+typedef struct ImageRunStruct {
+  Word base;                    /* address of run when written */
+  Word size;                    /* size of run */
+} ImageRunStruct;
+
+
+/* ImagePadStruct -- a padding object, as written and in memory */
+
+typedef struct ImagePadStruct *ImagePad;
+
+typedef struct ImagePadStruct {
+  Word offset;                  /* offset of padding in contents */
+  Word size;                    /* size of padding */
+} ImagePadStruct;
+
+
+/* ImageRunDescStruct -- a run of objects, in memory */
+
+typedef struct ImageRunDescStruct *ImageRunDesc;
+
+typedef struct ImageRunDescStruct {
+  Addr base;                    /* address of run when written */
+  Size size;                    /* size of run */
+  Size offset;                  /* offset of run in contents */
+  Addr newBase;                 /* address of copy or restored run */
+  Seg seg;                      /* segment containing run, or NULL */
+} ImageRunDescStruct;
+
+
+/* imageGrow -- make room for another element in an array */
+
+static Res imageGrow(Arena arena, void **arrayIO, Count *maxIO,
+                     Count count, Size size)
+{
+  Count newMax;
+  void *newArray;
+  Res res;
+
+  if (count < *maxIO)
+    return ResOK;
+  newMax = *maxIO == 0 ? imageRUNS : *maxIO * 2;
+  res = ControlAlloc(&newArray, arena, newMax * size);
+  if (res != ResOK)
+    return res;
+  if (*arrayIO != NULL) {
+    (void)AddrCopy(newArray, *arrayIO, count * size);
+    ControlFree(arena, *arrayIO, *maxIO * size);
+  }
+  *arrayIO = newArray;
+  *maxIO = newMax;
+  return ResOK;
+}
+
+
+/* imageRunOfAddr -- find the run containing an address
+ *
+ * The runs are in address order, because they are found by visiting
+ * the segments in address order.
+ */
+
+static Bool imageRunOfAddr(Index *indexReturn, ImageRunDesc runs,
+                           Count count, Addr addr)
+{
+  Index lo = 0, hi = count;
+  while (lo < hi) {
+    Index mid = lo + (hi - lo) / 2;
+    if (addr < runs[mid].base)
+      hi = mid;
+    else if (addr >= AddrAdd(runs[mid].base, runs[mid].size))
+      lo = mid + 1;
+    else {
+      *indexReturn = mid;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+
+/* imageRunOfOffset -- find the run containing an offset in contents */
+
+static Bool imageRunOfOffset(Index *indexReturn, ImageRunDesc runs,
+                             Count count, Size offset)
+{
+  Index lo = 0, hi = count;
+  while (lo < hi) {
+    Index mid = lo + (hi - lo) / 2;
+    if (offset < runs[mid].offset)
+      hi = mid;
+    else if (offset >= runs[mid].offset + runs[mid].size)
+      lo = mid + 1;
+    else {
+      *indexReturn = mid;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+
+/* Writing images */
+
+#define ImageWriteSig ((Sig)0x519A6E56) /* SIGnAture IMAGE WRite */
+
+typedef struct ImageWriteStruct *ImageWrite;
+
+typedef struct ImageWriteStruct {
+  Sig sig;
+  Arena arena;
+  Pool pool;                    /* pool being written */
+  Format format;                /* format of pool */
+  ImageRunDesc runs;            /* array of runs found so far */
+  Count runCount;               /* number of runs found so far */
+  Count runMax;                 /* length of runs array */
+  ImagePad pads;                /* array of padding objects found */
+  Count padCount;               /* number of padding objects found */
+  Count padMax;                 /* length of pads array */
+  Seg seg;                      /* segment being walked */
+  Size size;                    /* total size of runs */
+  Res res;                      /* first failure, or ResOK */
+} ImageWriteStruct;
+
+
+ATTRIBUTE_UNUSED
+static Bool ImageWriteCheck(ImageWrite iw)
+{
+  CHECKS(ImageWrite, iw);
+  CHECKU(Arena, iw->arena);
+  CHECKU(Pool, iw->pool);
+  CHECKU(Format, iw->format);
+  CHECKL(iw->runCount <= iw->runMax);
+  CHECKL((iw->runs == NULL) == (iw->runMax == 0));
+  CHECKL(iw->padCount <= iw->padMax);
+  CHECKL((iw->pads == NULL) == (iw->padMax == 0));
+  CHECKL(iw->seg == NULL || SegPool(iw->seg) == iw->pool);
+  return TRUE;
+}
+
+
+/* imageRunStep -- add an object to the runs */
+
+static void imageRunStep(Addr object, Format format, Pool pool,
+                         void *p, size_t s)
+{
+  ImageWrite iw = p;
+  ImageRunDesc run;
+  Addr base, limit;
+  void *runs;
+  Res res;
+
+  AVERT(Format, format);
+  AVERT(Pool, pool);
+  AVERT(ImageWrite, iw);
+  AVER(s == UNUSED_SIZE);
+
+  if (iw->res != ResOK)
+    return;
+
+  base = AddrSub(object, format->headerSize);
+  limit = AddrSub((Addr)(*format->skip)(object), format->headerSize);
+
+  if (iw->runCount > 0) {
+    run = &iw->runs[iw->runCount - 1];
+    if (run->seg == iw->seg && AddrAdd(run->base, run->size) == base) {
+      run->size += AddrOffset(base, limit);
+      iw->size += AddrOffset(base, limit);
+      return;
+    }
+  }
+
+  runs = iw->runs;
+  res = imageGrow(iw->arena, &runs, &iw->runMax, iw->runCount,
+                  sizeof(ImageRunDescStruct));
+  iw->runs = runs;
+  if (res != ResOK) {
+    iw->res = res;
+    return;
+  }
+
+  run = &iw->runs[iw->runCount];
+  ++iw->runCount;
+  run->base = base;
+  run->size = AddrOffset(base, limit);
+  run->offset = iw->size;
+  run->newBase = NULL;
+  run->seg = iw->seg;
+  iw->size += run->size;
+}
+
+
+/* imageCopy -- copy a run and recreate its padding objects
+ *
+ * See .pad.  The caller must expose the run's segment.
+ */
+
+static Res imageCopy(ImageWrite iw, ImageRunDesc run)
+{
+  Format format = iw->format;
+  Size headerSize = format->headerSize;
+  Addr orig = AddrAdd(run->base, headerSize);
+  Addr copy = AddrAdd(run->newBase, headerSize);
+  Addr limit = AddrAdd(orig, run->size);
+
+  (void)AddrCopy(run->newBase, run->base, run->size);
+  while (orig < limit) {
+    Addr next = (Addr)(*format->skip)(orig);
+    Size size = AddrOffset(orig, next);
+    if ((Addr)(*format->skip)(copy) != AddrAdd(copy, size)) {
+      void *pads = iw->pads;
+      ImagePad pad;
+      Res res = imageGrow(iw->arena, &pads, &iw->padMax, iw->padCount,
+                          sizeof(ImagePadStruct));
+      iw->pads = pads;
+      if (res != ResOK)
+        return res;
+      pad = &iw->pads[iw->padCount];
+      ++iw->padCount;
+      pad->offset = run->offset + AddrOffset(run->newBase,
+                                             AddrSub(copy, headerSize));
+      pad->size = size;
+      (*format->pad)(AddrSub(copy, headerSize), size);
+    }
+    orig = next;
+    copy = AddrAdd(copy, size);
+  }
+  return ResOK;
+}
+
+
+/* ImageScanState -- scan state for finding references
+ *
+ * Defined as a subclass of ScanState, like rootsStepClosure in
+ * walk.c.
+ */
+
+typedef struct ImageScanStateStruct {
+  ScanStateStruct ssStruct;     /* generic scan state object */
+  ImageWrite iw;                /* image being written */
+} ImageScanStateStruct;
+
+#define ScanState2ImageScanState(ss) \
+  PARENT(ImageScanStateStruct, ssStruct, ss)
+
+
+/* imageFix -- point a reference at the copy of its target
+ *
+ * See .reloc and .closed.
+ */
+
+static Res imageFix(Seg seg, ScanState ss, Ref *refIO)
+{
+  ImageWrite iw;
+  ImageRunDesc run;
+  Index i;
+
+  AVERT(Seg, seg);
+  AVERT(ScanState, ss);
+  AVER(refIO != NULL);
+  iw = ScanState2ImageScanState(ss)->iw;
+  AVERT(ImageWrite, iw);
+
+  if (SegPool(seg) != iw->pool)
+    return ResFAIL; /* .closed */
+  if (!imageRunOfAddr(&i, iw->runs, iw->runCount, *refIO))
+    return ResFAIL;
+  run = &iw->runs[i];
+  *refIO = AddrAdd(run->newBase, AddrOffset(run->base, *refIO));
+  return ResOK;
+}
+
+
+/* imageScan -- point the references in the copy at the copy
+ *
+ * Scans the copy of each run in a scanned segment with a trace for
+ * which every segment is white, so that imageFix sees every reference
+ * into the arena.
+ */
+
+static Res imageScan(ImageWrite iw)
+{
+  Arena arena = iw->arena;
+  ImageScanStateStruct issStruct;
+  ScanState ss = &issStruct.ssStruct;
+  Trace trace;
+  Index i;
+  Res res;
+
+  res = WalkTraceCreate(&trace, arena);
+  if (res != ResOK)
+    return res;
+
+  ScanStateInit(ss, TraceSetSingle(trace), arena, RankEXACT,
+                trace->white);
+  ss->fix = imageFix;
+  issStruct.iw = iw;
+
+  for (i = 0; i < iw->runCount; ++i) {
+    ImageRunDesc run = &iw->runs[i];
+    if (SegRankSet(run->seg) != RankSetEMPTY) {
+      Addr base = AddrAdd(run->newBase, iw->format->headerSize);
+      res = FormatScan(iw->format, ss, base, AddrAdd(base, run->size));
+      if (res != ResOK)
+        break;
+    }
+  }
+
+  ScanStateFinish(ss);
+  WalkTraceDestroy(trace);
+  return res;
+}
+
+
+/* imageMark -- convert the references in the copy to offsets
+ *
+ * Compares the copy of each run with the original to find the
+ * references, marks them in the bit table, and converts them from
+ * addresses in the copy to offsets.  See .reloc.  Padding objects were
+ * recreated in the copy, so they differ from the original, but they
+ * aren't references (.pad).
+ */
+
+static void imageMark(ImageWrite iw, Addr contents, BT bt)
+{
+  Index i, pad = 0;
+
+  for (i = 0; i < iw->runCount; ++i) {
+    ImageRunDesc run = &iw->runs[i];
+    Word *copy = (Word *)run->newBase;
+    Word *orig = (Word *)run->base;
+    Index w, words = run->size / sizeof(Word);
+    Index bit = run->offset / sizeof(Word);
+
+    if (SegRankSet(run->seg) == RankSetEMPTY)
+      continue;
+    ShieldExpose(iw->arena, run->seg);
+    for (w = 0; w < words; ++w) {
+      Size offset = run->offset + w * sizeof(Word);
+      while (pad < iw->padCount
+             && iw->pads[pad].offset + iw->pads[pad].size <= offset)
+        ++pad;
+      if (pad < iw->padCount && iw->pads[pad].offset <= offset)
+        continue;
+      if (copy[w] != orig[w]) {
+        BTSet(bt, bit + w);
+        copy[w] -= (Word)contents;
+      }
+    }
+    ShieldCover(iw->arena, run->seg);
+  }
+}
+
+
+/* imageWriteOut -- pass the image to the client's writer */
+
+static Res imageWriteOut(ImageWrite iw, Addr contents, BT bt,
+                         mps_image_write_t write, void *p)
+{
+  ImageHeaderStruct header;
+  Index i;
+  Res res;
+
+  header.magic = imageMAGIC;
+  header.version = imageVERSION;
+  header.wordSize = sizeof(Word);
+  header.alignment = PoolAlignment(iw->pool);
+  header.headerSize = iw->format->headerSize;
+  header.runs = iw->runCount;
+  header.pads = iw->padCount;
+  header.size = iw->size;
+  res = (Res)(*write)(&header, sizeof header, p);
+  if (res != ResOK)
+    return res;
+
+  for (i = 0; i < iw->runCount; ++i) {
+    ImageRunStruct run;
+    run.base = (Word)iw->runs[i].base;
+    run.size = iw->runs[i].size;
+    res = (Res)(*write)(&run, sizeof run, p);
+    if (res != ResOK)
+      return res;
+  }
+  if (iw->padCount > 0) {
+    res = (Res)(*write)(iw->pads, iw->padCount * sizeof(ImagePadStruct), p);
+    if (res != ResOK)
+      return res;
+  }
+
+  if (iw->size > 0) {
+    res = (Res)(*write)(contents, iw->size, p);
+    if (res != ResOK)
+      return res;
+    res = (Res)(*write)(bt, BTSize(iw->size / sizeof(Word)), p);
+    if (res != ResOK)
+      return res;
+  }
+  return ResOK;
+}
+
+
+/* PoolImageWrite -- write an image of the objects in a pool */
+
+static Res PoolImageWrite(Pool pool, mps_image_write_t write, void *p)
+{
+  ImageWriteStruct iwStruct;
+  ImageWrite iw = &iwStruct;
+  Arena arena = PoolArena(pool);
+  Addr contents = NULL;
+  BT bt = NULL;
+  Count words = 0;
+  Format format;
+  Seg seg;
+  Index i;
+  Res res;
+
+  if (!PoolFormat(&format, pool))
+    return ResPARAM;
+  if (PoolAlignment(pool) < sizeof(Word))
+    return ResUNIMPL;
+
+  iw->arena = arena;
+  iw->pool = pool;
+  iw->format = format;
+  iw->runs = NULL;
+  iw->runCount = 0;
+  iw->runMax = 0;
+  iw->pads = NULL;
+  iw->padCount = 0;
+  iw->padMax = 0;
+  iw->seg = NULL;
+  iw->size = 0;
+  iw->res = ResOK;
+  iw->sig = ImageWriteSig;
+  AVERT(ImageWrite, iw);
+
+  if (SegFirst(&seg, arena)) {
+    do {
+      if (SegPool(seg) == pool) {
+        iw->seg = seg;
+        ShieldExpose(arena, seg);
+        SegWalk(seg, format, imageRunStep, iw, UNUSED_SIZE);
+        ShieldCover(arena, seg);
+      }
+    } while (iw->res == ResOK && SegNext(&seg, arena, seg));
+  }
+  res = iw->res;
+  if (res != ResOK)
+    goto failWalk;
+
+  if (iw->size > 0) {
+    void *base;
+    res = ControlAlloc(&base, arena, iw->size);
+    if (res != ResOK)
+      goto failContents;
+    contents = base;
+    words = iw->size / sizeof(Word);
+    res = BTCreate(&bt, arena, words);
+    if (res != ResOK)
+      goto failBT;
+    BTResRange(bt, 0, words);
+
+    for (i = 0; i < iw->runCount; ++i) {
+      ImageRunDesc run = &iw->runs[i];
+      run->newBase = AddrAdd(contents, run->offset);
+      ShieldExpose(arena, run->seg);
+      res = imageCopy(iw, run);
+      ShieldCover(arena, run->seg);
+      if (res != ResOK)
+        goto failScan;
+    }
+
+    res = imageScan(iw);
+    if (res != ResOK)
+      goto failScan;
+    imageMark(iw, contents, bt);
+  }
+
+  res = imageWriteOut(iw, contents, bt, write, p);
+
+failScan:
+  if (bt != NULL)
+    BTDestroy(bt, arena, words);
+failBT:
+  if (contents != NULL)
+    ControlFree(arena, contents, iw->size);
+failContents:
+failWalk:
+  if (iw->pads != NULL)
+    ControlFree(arena, iw->pads, iw->padMax * sizeof(ImagePadStruct));
+  if (iw->runs != NULL)
+    ControlFree(arena, iw->runs, iw->runMax * sizeof(ImageRunDescStruct));
+  iw->sig = SigInvalid;
+  return res;
+}
+
+
+/* mps_pool_image_write -- write an image of the objects in a pool
+ *
+ * Client interface to PoolImageWrite.  */
+
+mps_res_t mps_pool_image_write(mps_pool_t pool, mps_image_write_t write,
+                               void *p)
+{
+  Arena arena;
+  Res res;
+
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+  AVERT(Pool, pool);
+  AVER(FUNCHECK(write));
+  /* p is an arbitrary closure, hence can't be checked */
+  AVER(ArenaGlobals(arena)->clamped);          /* .parked */
+  AVER(arena->busyTraces == TraceSetEMPTY);    /* .parked */
+  res = PoolImageWrite(pool, write, p);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* Reading images */
+
+/* imageReadRun -- reserve memory for a run and read it
+ *
+ * Recreates the padding objects in the run (.pad), starting at
+ * pads[*padIO], and updates *padIO.  If this fails, the whole run is
+ * padded and committed, so that the buffer is left ready for the
+ * client.
+ */
+
+static Res imageReadRun(Buffer buffer, Format format, ImageRunDesc run,
+                        ImagePad pads, Count padCount, Index *padIO,
+                        mps_image_read_t read, void *p)
+{
+  Size limit = run->offset + run->size;
+  Addr base;
+  Bool committed;
+  Res res;
+
+  res = BufferReserve(&base, buffer, run->size);
+  if (res != ResOK)
+    return res;
+  res = (Res)(*read)(base, run->size, p);
+  for (; res == ResOK && *padIO < padCount
+         && pads[*padIO].offset < limit; ++*padIO) {
+    ImagePad pad = &pads[*padIO];
+    if (pad->offset < run->offset || pad->size > limit - pad->offset
+        || pad->size == 0
+        || !SizeIsAligned(pad->size, PoolAlignment(BufferPool(buffer)))
+        || !SizeIsAligned(pad->offset, PoolAlignment(BufferPool(buffer))))
+      res = ResFAIL;
+    else
+      (*format->pad)(AddrAdd(base, pad->offset - run->offset), pad->size);
+  }
+  if (res != ResOK)
+    (*format->pad)(base, run->size);
+  committed = BufferCommit(buffer, base, run->size);
+  AVER(committed); /* no flip, because the arena is .parked */
+  run->newBase = base;
+  return res;
+}
+
+
+/* imageRelocate -- relocate the references in the restored runs */
+
+static Res imageRelocate(Arena arena, ImageRunDesc runs, Count count,
+                         Size size, BT bt)
+{
+  Index i;
+
+  for (i = 0; i < count; ++i) {
+    ImageRunDesc run = &runs[i];
+    Word *words = (Word *)run->newBase;
+    Index w, limit = run->size / sizeof(Word);
+    Index bit = run->offset / sizeof(Word);
+    Bool relocated = FALSE;
+    Seg seg;
+    Bool b;
+
+    b = SegOfAddr(&seg, arena, run->newBase);
+    AVER(b);
+    ShieldExpose(arena, seg);
+    for (w = 0; w < limit; ++w)
+      if (BTGet(bt, bit + w)) {
+        Index j;
+        if (words[w] >= size
+            || !imageRunOfOffset(&j, runs, count, words[w])) {
+          ShieldCover(arena, seg);
+          return ResFAIL;
+        }
+        words[w] = (Word)AddrAdd(runs[j].newBase, words[w] - runs[j].offset);
+        relocated = TRUE;
+      }
+    ShieldCover(arena, seg);
+    /* The references were written behind the write barrier. */
+    if (relocated && SegRankSet(seg) != RankSetEMPTY)
+      SegSetSummary(seg, RefSetUNIV);
+  }
+  return ResOK;
+}
+
+
+/* imagePadRuns -- pad the runs restored by a failed read
+ *
+ * The runs have been committed, and their references may not have
+ * been relocated, so they are replaced with padding objects that the
+ * pool can scan and reclaim.  See .fail.
+ */
+
+static void imagePadRuns(Arena arena, Format format, ImageRunDesc runs,
+                         Count count)
+{
+  Index i;
+
+  for (i = 0; i < count; ++i) {
+    ImageRunDesc run = &runs[i];
+    if (run->newBase != NULL) {
+      Seg seg = NULL;   /* suppress "may be used uninitialized" */
+      Bool b = SegOfAddr(&seg, arena, run->newBase);
+      AVER(b);
+      ShieldExpose(arena, seg);
+      (*format->pad)(run->newBase, run->size);
+      ShieldCover(arena, seg);
+    }
+  }
+}
+
+
+/* BufferImageRead -- read an image into a pool through a buffer */
+
+static Res BufferImageRead(Buffer buffer, mps_image_read_t read, void *p,
+                           mps_addr_t *refs, size_t count)
+{
+  Pool pool = BufferPool(buffer);
+  Arena arena = PoolArena(pool);
+  ImageHeaderStruct header;
+  ImageRunDesc runs = NULL;
+  Count runCount = 0;
+  ImagePad pads = NULL;
+  Count padCount = 0;
+  Index pad;
+  BT bt = NULL;
+  Count words = 0;
+  Format format;
+  Size offset;
+  Index i;
+  Res res;
+
+  if (!PoolFormat(&format, pool))
+    return ResPARAM;
+
+  res = (Res)(*read)(&header, sizeof header, p);
+  if (res != ResOK)
+    return res;
+  if (header.magic != imageMAGIC || header.version != imageVERSION
+      || header.wordSize != sizeof(Word)
+      || header.alignment != PoolAlignment(pool)
+      || header.headerSize != format->headerSize
+      || !SizeIsAligned(header.size, PoolAlignment(pool)))
+    return ResFAIL;
+  /* Each run and each padding object is at least one aligned unit, */
+  /* so a header that claims more is corrupt, and the tables mustn't */
+  /* be sized from it. */
+  if (header.runs > header.size / PoolAlignment(pool)
+      || header.pads > header.size / PoolAlignment(pool)
+      || header.runs > SizeMAX / sizeof(ImageRunDescStruct)
+      || header.pads > SizeMAX / sizeof(ImagePadStruct))
+    return ResFAIL;
+
+  if (header.runs > 0) {
+    void *base;
+    res = ControlAlloc(&base, arena,
+                       header.runs * sizeof(ImageRunDescStruct));
+    if (res != ResOK)
+      return res;
+    runs = base;
+    runCount = header.runs;
+  }
+
+  offset = 0;
+  for (i = 0; i < runCount; ++i) {
+    ImageRunStruct run;
+    res = (Res)(*read)(&run, sizeof run, p);
+    if (res != ResOK)
+      goto failRuns;
+    if (run.size == 0 || !SizeIsAligned(run.size, PoolAlignment(pool))
+        || run.size > header.size - offset
+        || (i > 0 && (Addr)run.base < AddrAdd(runs[i - 1].base,
+                                              runs[i - 1].size))) {
+      res = ResFAIL;
+      goto failRuns;
+    }
+    runs[i].base = (Addr)run.base;
+    runs[i].size = run.size;
+    runs[i].offset = offset;
+    runs[i].newBase = NULL;
+    runs[i].seg = NULL;
+    offset += run.size;
+  }
+  if (offset != header.size) {
+    res = ResFAIL;
+    goto failRuns;
+  }
+
+  if (header.pads > 0) {
+    void *base;
+    res = ControlAlloc(&base, arena, header.pads * sizeof(ImagePadStruct));
+    if (res != ResOK)
+      goto failPads;
+    pads = base;
+    padCount = header.pads;
+    res = (Res)(*read)(pads, padCount * sizeof(ImagePadStruct), p);
+    if (res != ResOK)
+      goto failRead;
+  }
+
+  pad = 0;
+  for (i = 0; i < runCount; ++i) {
+    res = imageReadRun(buffer, format, &runs[i], pads, padCount, &pad,
+                       read, p);
+    if (res != ResOK)
+      goto failRead;
+  }
+  if (pad != padCount) {
+    res = ResFAIL;
+    goto failRead;
+  }
+
+  if (header.size > 0) {
+    words = header.size / sizeof(Word);
+    res = BTCreate(&bt, arena, words);
+    if (res != ResOK)
+      goto failBT;
+    res = (Res)(*read)(bt, BTSize(words), p);
+    if (res != ResOK)
+      goto failRelocate;
+    res = imageRelocate(arena, runs, runCount, header.size, bt);
+    if (res != ResOK)
+      goto failRelocate;
+  }
+
+  for (i = 0; i < count; ++i) {
+    Index j;
+    if (imageRunOfAddr(&j, runs, runCount, (Addr)refs[i]))
+      refs[i] = (mps_addr_t)AddrAdd(runs[j].newBase,
+                                    AddrOffset(runs[j].base,
+                                               (Addr)refs[i]));
+  }
+
+failRelocate:
+  if (bt != NULL)
+    BTDestroy(bt, arena, words);
+failBT:
+failRead:
+  if (res != ResOK)
+    imagePadRuns(arena, format, runs, runCount);
+  if (pads != NULL)
+    ControlFree(arena, pads, padCount * sizeof(ImagePadStruct));
+failPads:
+failRuns:
+  if (runs != NULL)
+    ControlFree(arena, runs, runCount * sizeof(ImageRunDescStruct));
+  return res;
+}
+
+
+/* mps_ap_image_read -- read an image into a pool
+ *
+ * Client interface to BufferImageRead.  */
+
+mps_res_t mps_ap_image_read(mps_ap_t mps_ap, mps_image_read_t read,
+                            void *p, mps_addr_t *refs, size_t count)
+{
+  Buffer buf;
+  Arena arena;
+  Res res;
+
+  AVER(mps_ap != NULL);
+  buf = BufferOfAP(mps_ap);
+  AVER(TESTT(Buffer, buf));
+  arena = BufferArena(buf);
+
+  ArenaEnter(arena);
+  AVERT(Buffer, buf);
+  AVER(FUNCHECK(read));
+  /* p is an arbitrary closure, hence can't be checked */
+  AVER(count == 0 || refs != NULL);
+  AVER(BufferIsReady(buf));
+  AVER(ArenaGlobals(arena)->clamped);          /* .parked */
+  AVER(arena->busyTraces == TraceSetEMPTY);    /* .parked */
+  res = BufferImageRead(buf, read, p, refs, count);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -43,10 +43,20 @@
  * .ld.access: Accesses (reads and writes) to the ld structure must be
  * "wrapped" with an ShieldExpose/Cover pair if and only if the access
  * is taking place inside the arena.  Currently this is only the case for
- * LDReset.
+ * LDReset and LDIsStalePrecise.
+ *
+ * .hash: Identity hashes are an alternative to location dependency
+ * for clients that hash objects in moving pools.  An object is given
+ * a hash when first asked, and the hash is kept in a table in the
+ * arena, keyed by the object's address, which the moving pool updates
+ * when it moves the object.  See <design/arena/#hash>.
+ *
+ * .sampling: Allocation sampling uses identity hashes to track
+ * sampled objects.  See <code/sample.c>.
  */
 
 #include "mpm.h"
+#include "table.h"
 
 SRCID(ld, "$Id$");
 
@@ -258,6 +268,42 @@ Bool LDIsStale(mps_ld_t ld, Arena arena, Addr addr)
 }
 
 
+/* LDIsStalePrecise -- check whether a dependency on a block is stale
+ *
+ * .stale.precise: If the dependency is stale by zone, look at the
+ * segment containing addr.  A block that has moved since the epoch of
+ * the dependency is now in a segment into which something has moved
+ * since then (<design/seg/#field.moved>), so if nothing has, the
+ * block at addr has not moved and there are no false negatives.  A
+ * block that isn't in a segment has never been moved by the arena.
+ *
+ * .stale.precise.lock: Unlike LDIsStale, this must be called with the
+ * arena lock held, because it looks up the segment.
+ */
+Bool LDIsStalePrecise(mps_ld_t ld, Arena arena, Addr addr)
+{
+  mps_ld_s ldStruct;
+  Bool b;
+  Seg seg;
+
+  AVER(ld != NULL);
+  AVERT(Arena, arena);
+
+  b = SegOfAddr(&seg, arena, (Addr)ld);
+  if (b)
+    ShieldExpose(arena, seg);   /* .ld.access */
+  ldStruct = *ld;
+  if (b)
+    ShieldCover(arena, seg);
+
+  if (!LDIsStaleAny(&ldStruct, arena))
+    return FALSE;
+  if (!SegOfAddr(&seg, arena, addr))
+    return FALSE;
+  return SegMoved(seg) > ldStruct._epoch;
+}
+
+
 /* LDAge -- age the arena by adding a moved set
  *
  * This stores the fact that a set of references has changed in
@@ -322,6 +368,188 @@ void LDMerge(mps_ld_t ld, Arena arena, mps_ld_t from)
 }
 
 
+
+/* Identity hashes
+ *
+ * Objects are aligned and segments are never at address zero, so
+ * neither zero nor one can be the address of an object in a segment.
+ */
+
+#define idHashUNUSED    ((TableKey)0)
+#define idHashDELETED   ((TableKey)1)
+#define idHashINITIAL   ((Count)64)
+
+
+/* idHashScramble -- spread the bits of a serial number or address */
+
+static Word idHashScramble(Word w)
+{
+  return w * (Word)2654435761u; /* Knuth's multiplicative hash */
+}
+
+
+/* IdHash -- get the identity hash of an object
+ *
+ * .hash.static: An object that isn't in a pool that moves objects
+ * keeps its address for life, so it is hashed by address and needs no
+ * entry in the table.
+ *
+ * .hash.new: Otherwise the object gets the next hash in sequence.
+ * Its segment is marked as having hashed objects, so that the pool
+ * knows to update the table when it moves or reclaims them, even if
+ * the hash was already in the table.
+ */
+Res IdHash(Word *hashReturn, Arena arena, Addr addr)
+{
+  TableValue value;
+  Seg seg;
+  Res res;
+
+  AVER(hashReturn != NULL);
+  AVERT(Arena, arena);
+
+  if (!SegOfAddr(&seg, arena, addr)
+      || !PoolHasAttr(SegPool(seg), AttrMOVINGGC)) {
+    *hashReturn = idHashScramble((Word)addr); /* .hash.static */
+    return ResOK;
+  }
+
+  if (arena->hashTable == NULL) {
+    res = TableCreate(&arena->hashTable, idHashINITIAL,
+                      ControlTableAlloc, ControlTableFree, arena,
+                      idHashUNUSED, idHashDELETED);
+    if (res != ResOK)
+      return res;
+  }
+
+  if (!TableLookup(&value, arena->hashTable, (TableKey)addr)) {
+    /* .hash.new */
+    /* .hash.tidy: Moving and forgetting hashes leaves deleted entries */
+    /* that lookups must probe past, and fix can't rehash the table, */
+    /* so rehash it here if they make it cramped. */
+    res = TableGrow(arena->hashTable, 1);
+    if (res != ResOK)
+      return res;
+    value = (TableValue)idHashScramble(arena->hashSerial + 1);
+    res = TableDefine(arena->hashTable, (TableKey)addr, value);
+    if (res != ResOK)
+      return res;
+    ++arena->hashSerial;
+  }
+  SegSetHashed(seg, TRUE);
+
+  *hashReturn = (Word)value;
+  return ResOK;
+}
+
+
+/* IdHashMove -- move an object's identity hash to its new address
+ *
+ * Called by a moving pool when it copies an object out of a segment
+ * with hashed objects.  It is called from fix, so it must not
+ * allocate: removing the old key means the table has room for the new
+ * one without growing.  Returns TRUE if the object had a hash, in
+ * which case the pool must mark the object's new segment as hashed.
+ */
+Bool IdHashMove(Arena arena, Addr old, Addr new)
+{
+  TableValue value;
+  Res res;
+
+  AVERT(Arena, arena);
+
+  if (arena->hashTable == NULL
+      || !TableLookup(&value, arena->hashTable, (TableKey)old))
+    return FALSE;
+
+  res = TableRemove(arena->hashTable, (TableKey)old);
+  AVER(res == ResOK);
+  res = TableDefine(arena->hashTable, (TableKey)new, value);
+  if (res != ResOK) {
+    /* Only possible if a dead object at the new address was never */
+    /* forgotten; overwrite its hash. */
+    AVER(res == ResFAIL);
+    res = TableRedefine(arena->hashTable, (TableKey)new, value);
+    AVER(res == ResOK);
+  }
+  return TRUE;
+}
+
+
+/* IdHashForget -- forget the identity hash of a dead object */
+
+void IdHashForget(Arena arena, Addr addr)
+{
+  TableValue value;
+  Res res;
+
+  AVERT(Arena, arena);
+
+  if (arena->hashTable != NULL
+      && TableLookup(&value, arena->hashTable, (TableKey)addr)) {
+    res = TableRemove(arena->hashTable, (TableKey)addr);
+    AVER(res == ResOK);
+  }
+}
+
+
+/* IdHashForgetPool -- forget the identity hashes of a pool's objects
+ *
+ * Called by a moving pool when it is destroyed, before it frees its
+ * segments, because its objects can no longer be walked.  This visits
+ * every entry in the table once, rather than once per segment.
+ */
+
+typedef struct IdHashPoolStruct {
+  Arena arena;
+  Pool pool;
+} IdHashPoolStruct, *IdHashPool;
+
+static void idHashForgetInPool(void *closure, TableKey key,
+                               TableValue value)
+{
+  IdHashPool closureStruct = closure;
+  Arena arena = closureStruct->arena;
+  Seg seg;
+
+  UNUSED(value);
+  if (SegOfAddr(&seg, arena, (Addr)key)
+      && SegPool(seg) == closureStruct->pool) {
+    /* Removing the entry only marks it deleted, so TableMap can */
+    /* carry on. */
+    Res res = TableRemove(arena->hashTable, key);
+    AVER(res == ResOK);
+  }
+}
+
+void IdHashForgetPool(Arena arena, Pool pool)
+{
+  IdHashPoolStruct closureStruct;
+
+  AVERT(Arena, arena);
+  AVERT(Pool, pool);
+
+  if (arena->hashTable != NULL) {
+    closureStruct.arena = arena;
+    closureStruct.pool = pool;
+    TableMap(arena->hashTable, idHashForgetInPool, &closureStruct);
+  }
+}
+
+
+/* IdHashFinish -- throw away all identity hashes */
+
+void IdHashFinish(Arena arena)
+{
+  AVERT(Arena, arena);
+
+  if (arena->hashTable != NULL) {
+    TableDestroy(arena->hashTable);
+    arena->hashTable = NULL;
+  }
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2015 Ravenbrook Limited <http://www.ravenbrook.com/>.
@@ -68,6 +68,16 @@ extern void LockReleaseRecursive(Lock lock);
 extern void LockClaim(Lock lock);
 
 
+/*  LockTryClaim
+ *
+ *  Like LockClaim, but if the lock is owned by another thread,
+ *  return FALSE at once instead of waiting for it.  A successful
+ *  claim returns TRUE and must be matched by a call to LockRelease.
+ */
+
+extern Bool LockTryClaim(Lock lock);
+
+
 /*  LockRelease
  *
  *  This must only be used to release a Lock symmetrically
@@ -113,6 +123,26 @@ extern void LockClaimGlobalRecursive(void);
 extern void LockReleaseGlobalRecursive(void);
 
 
+/*  LockClaimEvent
+ *
+ *  This is called to increase the number of claims on the recursive
+ *  event lock, which protects the telemetry event buffers.  It is
+ *  claimed after all other MPS locks, and no other MPS lock may be
+ *  claimed while it is held.  This can be called recursively.
+ */
+
+extern void LockClaimEvent(void);
+
+
+/*  LockReleaseEvent
+ *
+ *  This is called to reduce the number of claims on the recursive
+ *  event lock.  It must not be called without possession of the lock.
+ */
+
+extern void LockReleaseEvent(void);
+
+
 /*  LockClaimGlobal
  *
  *  This is called to claim the binary global lock, and may only be
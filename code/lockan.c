@@ -58,6 +58,15 @@ void (LockClaim)(Lock lock)
   lock->claims = 1;
 }
 
+Bool (LockTryClaim)(Lock lock)
+{
+  AVERT(Lock, lock);
+  if (lock->claims > 0)
+    return FALSE;
+  lock->claims = 1;
+  return TRUE;
+}
+
 void (LockRelease)(Lock lock)
 {
   AVERT(Lock, lock);
@@ -106,12 +115,21 @@ static Lock globalLock = &globalLockStruct;
 
 static Lock globalRecLock = &globalRecursiveLockStruct;
 
+static LockStruct eventLockStruct = {
+  LockSig,
+  0
+};
+
+static Lock eventLock = &eventLockStruct;
+
 void LockInitGlobal(void)
 {
   globalLock->claims = 0;
   LockInit(globalLock);
   globalRecLock->claims = 0;
   LockInit(globalRecLock);
+  eventLock->claims = 0;
+  LockInit(eventLock);
 }
 
 void (LockClaimGlobalRecursive)(void)
@@ -124,6 +142,16 @@ void (LockReleaseGlobalRecursive)(void)
   LockReleaseRecursive(globalRecLock);
 }
 
+void (LockClaimEvent)(void)
+{
+  LockClaimRecursive(eventLock);
+}
+
+void (LockReleaseEvent)(void)
+{
+  LockReleaseRecursive(eventLock);
+}
+
 void (LockClaimGlobal)(void)
 {
   LockClaim(globalLock);
@@ -69,6 +69,10 @@ int main(int argc, char *argv[])
   LockReleaseRecursive(a);
   LockRelease(a);
   LockFinish(a);
+  LockClaimEvent();
+  LockClaimEvent();
+  LockReleaseEvent();
+  LockReleaseEvent();
   LockReleaseGlobalRecursive();
 
   mps_free(pool, a, LockSize());
@@ -132,6 +132,25 @@ void (LockClaim)(Lock lock)
 }
 
 
+/* LockTryClaim -- claim a lock if it is free (non-recursive) */
+
+Bool (LockTryClaim)(Lock lock)
+{
+  int res;
+
+  AVERT(Lock, lock);
+
+  res = pthread_mutex_trylock(&lock->mut);
+  if (res == EBUSY)
+    return FALSE;
+  AVER(res == 0);
+
+  AVER(lock->claims == 0);
+  lock->claims = 1;
+  return TRUE;
+}
+
+
 /* LockRelease -- release a lock (non-recursive) */
 
 void (LockRelease)(Lock lock)
@@ -201,19 +220,23 @@ Bool (LockIsHeld)(Lock lock)
 
 /* Global locks
  *
- * .global: The two "global" locks are statically allocated normal locks.
+ * .global: The three "global" locks are statically allocated normal
+ * locks.
  */
 
 static LockStruct globalLockStruct;
 static LockStruct globalRecLockStruct;
+static LockStruct eventLockStruct;
 static Lock globalLock = &globalLockStruct;
 static Lock globalRecLock = &globalRecLockStruct;
+static Lock eventLock = &eventLockStruct;
 static pthread_once_t isGlobalLockInit = PTHREAD_ONCE_INIT;
 
 void LockInitGlobal(void)
 {
   LockInit(globalLock);
   LockInit(globalRecLock);
+  LockInit(eventLock);
 }
 
 
@@ -238,6 +261,27 @@ void (LockReleaseGlobalRecursive)(void)
 }
 
 
+/* LockClaimEvent -- claim the event lock */
+
+void (LockClaimEvent)(void)
+{
+  int res;
+
+  /* Ensure the global lock has been initialized */
+  res = pthread_once(&isGlobalLockInit, LockInitGlobal);
+  AVER(res == 0);
+  LockClaimRecursive(eventLock);
+}
+
+
+/* LockReleaseEvent -- release the event lock */
+
+void (LockReleaseEvent)(void)
+{
+  LockReleaseRecursive(eventLock);
+}
+
+
 /* LockClaimGlobal -- claim the global non-recursive lock */
 
 void (LockClaimGlobal)(void)
@@ -80,6 +80,18 @@ void (LockClaim)(Lock lock)
   lock->claims = 1;
 }
 
+Bool (LockTryClaim)(Lock lock)
+{
+  AVERT(Lock, lock);
+  if (!TryEnterCriticalSection(&lock->cs))
+    return FALSE;
+  /* A critical section can be entered recursively, so this might be
+   * a second claim by the owning thread, which is not allowed. */
+  AVER(lock->claims == 0);
+  lock->claims = 1;
+  return TRUE;
+}
+
 void (LockRelease)(Lock lock)
 {
   AVERT(Lock, lock);
@@ -125,6 +137,8 @@ static LockStruct globalLockStruct;
 static LockStruct globalRecLockStruct;
 static Lock globalLock = &globalLockStruct;
 static Lock globalRecLock = &globalRecLockStruct;
+static LockStruct eventLockStruct;
+static Lock eventLock = &eventLockStruct;
 static Bool globalLockInit = FALSE; /* TRUE iff initialized */
 
 void LockInitGlobal(void)
@@ -133,6 +147,8 @@ void LockInitGlobal(void)
   LockInit(globalLock);
   globalRecLock->claims = 0;
   LockInit(globalRecLock);
+  eventLock->claims = 0;
+  LockInit(eventLock);
   globalLockInit = TRUE;
 }
 
@@ -177,6 +193,19 @@ void (LockReleaseGlobalRecursive)(void)
   LockReleaseRecursive(globalRecLock);
 }
 
+void (LockClaimEvent)(void)
+{
+  lockEnsureGlobalLock();
+  AVER(globalLockInit);
+  LockClaimRecursive(eventLock);
+}
+
+void (LockReleaseEvent)(void)
+{
+  AVER(globalLockInit);
+  LockReleaseRecursive(eventLock);
+}
+
 void (LockClaimGlobal)(void)
 {
   lockEnsureGlobalLock();
@@ -108,6 +108,7 @@ Bool GenDescCheck(GenDesc gen)
   CHECKS(GenDesc, gen);
   /* nothing to check for zones */
   CHECKL(gen->capacity > 0);
+  CHECKL(gen->baseCapacity > 0);
   CHECKL(gen->mortality >= 0.0);
   CHECKL(gen->mortality <= 1.0);
   CHECKD_NOSIG(Ring, &gen->locusRing);
@@ -144,6 +145,7 @@ static void GenDescInit(Arena arena, GenDesc gen, GenParamStruct *params)
   ++ arena->genSerial;
   gen->zones = ZoneSetEMPTY;
   gen->capacity = params->capacity * 1024;
+  gen->baseCapacity = gen->capacity;
   gen->mortality = params->mortality;
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
@@ -292,6 +294,101 @@ Size GenDescTotalSize(GenDesc gen)
 }
 
 
+/* GenDescUsedSize -- return size of memory in use in generation
+ *
+ * This is the memory in the generation's segments that is not free:
+ * that is, memory that is allocated to the client program, or held
+ * in buffers, and not yet reclaimed.
+ */
+
+Size GenDescUsedSize(GenDesc gen)
+{
+  Size size = 0;
+  Ring node, nextNode;
+
+  AVERT(GenDesc, gen);
+
+  RING_FOR(node, &gen->locusRing, nextNode) {
+    PoolGen pgen = RING_ELT(PoolGen, genRing, node);
+    AVERT(PoolGen, pgen);
+    size += pgen->totalSize - pgen->freeSize;
+  }
+  return size;
+}
+
+
+/* GenDescSetCapacity -- set the capacity of a generation
+ *
+ * Used by adaptive chains. See <design/strategy/#policy.adapt>.
+ */
+
+void GenDescSetCapacity(GenDesc gen, Size capacity)
+{
+  AVERT(GenDesc, gen);
+  AVER(capacity > 0);
+  gen->capacity = capacity;
+}
+
+
+/* GenDescCollectTicks -- predict the cost of collecting a generation
+ *
+ * Return the predicted time, in event clock ticks, to scan the
+ * survivors and reclaim the segments of each pool in the generation,
+ * using the generation's mortality and each pool generation's
+ * measured costs.  defaultScanRate is the cost per byte scanned to
+ * use for a pool generation that has not been scanned yet.  See
+ * <design/strategy/#policy.model>.
+ */
+
+double GenDescCollectTicks(GenDesc gen, double defaultScanRate)
+{
+  double ticks = 0.0;
+  Ring node, nextNode;
+
+  AVERT(GenDesc, gen);
+  AVER(defaultScanRate >= 0.0);
+
+  RING_FOR(node, &gen->locusRing, nextNode) {
+    PoolGen pgen = RING_ELT(PoolGen, genRing, node);
+    double used, scanRate;
+    AVERT(PoolGen, pgen);
+    used = (double)(pgen->totalSize - pgen->freeSize);
+    if (pgen->scanSize > 0.0)
+      scanRate = pgen->scanTicks / pgen->scanSize;
+    else
+      scanRate = defaultScanRate;
+    ticks += used * (1.0 - gen->mortality) * scanRate;
+    if (pgen->reclaimSize > 0.0)
+      ticks += used * pgen->reclaimTicks / pgen->reclaimSize;
+  }
+  return ticks;
+}
+
+
+/* GenDescReclaimRate -- measured cost of reclaiming a generation
+ *
+ * Return the cost, in event clock ticks per byte, of reclaiming the
+ * segments of the generation, averaged over its pools, or zero if
+ * none has been measured.
+ */
+
+double GenDescReclaimRate(GenDesc gen)
+{
+  double size = 0.0, ticks = 0.0;
+  Ring node, nextNode;
+
+  AVERT(GenDesc, gen);
+
+  RING_FOR(node, &gen->locusRing, nextNode) {
+    PoolGen pgen = RING_ELT(PoolGen, genRing, node);
+    AVERT(PoolGen, pgen);
+    size += pgen->reclaimSize;
+    ticks += pgen->reclaimTicks;
+  }
+  return size > 0.0 ? ticks / size : 0.0;
+}
+
+
 /* GenDescDescribe -- describe a generation in a chain */
 
 Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
@@ -309,6 +406,7 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
                "GenDesc $P {\n", (WriteFP)gen,
                "  zones $B\n", (WriteFB)gen->zones,
                "  capacity $U\n", (WriteFW)gen->capacity,
+               "  baseCapacity $U\n", (WriteFW)gen->baseCapacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
                "  activeTraces $B\n", (WriteFB)gen->activeTraces,
                NULL);
@@ -459,21 +557,97 @@ GenDesc ChainGen(Chain chain, Index gen)
 }
 
 
+/* GenDescIndex -- find the index of a generation in its chain
+ *
+ * Returns FALSE for the arena's top generation, which isn't in any
+ * chain.
+ */
+
+Bool GenDescIndex(Index *indexReturn, Arena arena, GenDesc gen)
+{
+  Ring node, next;
+
+  AVER(indexReturn != NULL);
+  AVERT(Arena, arena);
+  AVERT(GenDesc, gen);
+
+  RING_FOR(node, &arena->chainRing, next) {
+    Chain chain = RING_ELT(Chain, chainRing, node);
+    Index i;
+    for (i = 0; i < chain->genCount; ++i) {
+      if (&chain->gens[i] == gen) {
+        *indexReturn = i;
+        return TRUE;
+      }
+    }
+  }
+  AVER(gen == &arena->topGen);
+  return FALSE;
+}
+
+
+/* ChainScale -- return factor by which the chain's capacities scale
+ *
+ * If the arena has a heap growth target, the capacity of generation
+ * zero grows so that it can hold the target growth over the live
+ * size, and the other generations keep their proportion to it. The
+ * capacities given by the client program are the minimum. The scale is
+ * measured against the capacity given by the client program, not the
+ * adapted capacity, so that it does not undo the adaptation (see
+ * <design/strategy/#policy.adapt.range>). See
+ * <design/strategy/#policy.growth.capacity>.
+ */
+
+double ChainScale(Chain chain)
+{
+  Arena arena;
+  double scale;
+
+  AVERT(Chain, chain);
+
+  arena = chain->arena;
+  if (arena->heapGrowth == 0.0 || arena->liveSize == 0)
+    return 1.0;
+  scale = (double)arena->liveSize * arena->heapGrowth / 100.0
+    / (double)chain->gens[0].baseCapacity;
+  return scale < 1.0 ? 1.0 : scale;
+}
+
+
+/* ChainCapacity -- return effective capacity of a generation in a chain */
+
+Size ChainCapacity(Chain chain, Index gen)
+{
+  double capacity;
+
+  AVERT(Chain, chain);
+  AVER(gen < chain->genCount);
+
+  capacity = (double)chain->gens[gen].capacity * ChainScale(chain);
+  if (capacity >= (double)SizeMAX)
+    return SizeMAX;
+  return (Size)capacity;
+}
+
+
 /* ChainDeferral -- time until next ephemeral GC for this chain */
 
 double ChainDeferral(Chain chain)
 {
   double time = DBL_MAX;
+  double scale;
   size_t i;
 
   AVERT(Chain, chain);
 
+  scale = ChainScale(chain);
   for (i = 0; i < chain->genCount; ++i) {
     double genTime;
     GenDesc gen = &chain->gens[i];
     if (gen->activeTraces != TraceSetEMPTY)
       return DBL_MAX;
-    genTime = (double)gen->capacity - (double)GenDescNewSize(&chain->gens[i]);
+    genTime = (double)gen->capacity * scale
+      - (double)GenDescNewSize(&chain->gens[i]);
     if (genTime < time)
       time = genTime;
   }
@@ -497,6 +671,7 @@ Res ChainDescribe(Chain chain, mps_lib_FILE *stream, Count depth)
   res = WriteF(stream, depth,
                "Chain $P {\n", (WriteFP)chain,
                "  arena $P\n", (WriteFP)chain->arena,
+               "  scale $D\n", (WriteFD)ChainScale(chain),
                NULL);
   if (res != ResOK)
     return res;
@@ -535,6 +710,10 @@ Res PoolGenInit(PoolGen pgen, GenDesc gen, Pool pool)
   pgen->oldSize = 0;
   pgen->newDeferredSize = 0;
   pgen->oldDeferredSize = 0;
+  pgen->scanSize = 0.0;
+  pgen->scanTicks = 0.0;
+  pgen->reclaimSize = 0.0;
+  pgen->reclaimTicks = 0.0;
   pgen->sig = PoolGenSig;
   AVERT(PoolGen, pgen);
 
@@ -576,6 +755,10 @@ Bool PoolGenCheck(PoolGen pgen)
   CHECKL(pgen->totalSize == pgen->freeSize + pgen->bufferedSize
          + pgen->newSize + pgen->oldSize
          + pgen->newDeferredSize + pgen->oldDeferredSize);
+  CHECKL(pgen->scanSize >= 0.0);
+  CHECKL(pgen->scanTicks >= 0.0);
+  CHECKL(pgen->reclaimSize >= 0.0);
+  CHECKL(pgen->reclaimTicks >= 0.0);
   return TRUE;
 }
 
@@ -590,6 +773,31 @@ static void PoolGenAccountForAlloc(PoolGen pgen, Size size)
 }  
 
 
+/* genDescAddSeg -- attach a segment to a generation
+ *
+ * Add the segment to the generation's ring of segments, and add its
+ * zones to the generation's zone set.
+ */
+
+static void genDescAddSeg(GenDesc gen, Arena arena, Seg seg)
+{
+  ZoneSet zones, moreZones;
+
+  RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
+
+  zones = gen->zones;
+  moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
+  gen->zones = moreZones;
+
+  if (!ZoneSetSuper(zones, moreZones)) {
+    /* Tracking the whole zoneset for each generation gives more
+     * understandable telemetry than just reporting the added
+     * zones. */
+    EVENT3(GenZoneSet, arena, gen, moreZones);
+  }
+}
+
+
 /* PoolGenAlloc -- allocate a segment in a pool generation
  *
  * Allocate a segment belong to klass (which must be GCSegClass or a
@@ -602,7 +810,6 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass, Size size,
   LocusPrefStruct pref;
   Res res;
   Seg seg;
-  ZoneSet zones, moreZones;
   Arena arena;
   GenDesc gen;
 
@@ -615,28 +822,16 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass, Size size,
 
   arena = PoolArena(pgen->pool);
   gen = pgen->gen;
-  zones = gen->zones;
 
   LocusPrefInit(&pref);
   pref.high = FALSE;
-  pref.zones = zones;
+  pref.zones = gen->zones;
   pref.avoid = ZoneSetBlacklist(arena);
   res = SegAlloc(&seg, klass, &pref, size, pgen->pool, args);
   if (res != ResOK)
     return res;
 
-  RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
-
-  moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
-  gen->zones = moreZones;
-  
-  if (!ZoneSetSuper(zones, moreZones)) {
-    /* Tracking the whole zoneset for each generation gives more
-     * understandable telemetry than just reporting the added
-     * zones. */
-    EVENT3(GenZoneSet, arena, gen, moreZones);
-  }
-
+  genDescAddSeg(gen, arena, seg);
   PoolGenAccountForAlloc(pgen, SegSize(seg));
 
   *segReturn = seg;
@@ -742,6 +937,47 @@ void PoolGenAccountForReclaim(PoolGen pgen, Size reclaimed, Bool deferred)
 }
 
 
+/* PoolGenAccountForScanCost -- record the cost of scanning
+ *
+ * Call this after scanning a segment, passing the number of bytes
+ * scanned and the event clock ticks it took, including the cost of
+ * fixing the references found.  See <design/strategy/#policy.model>.
+ */
+
+void PoolGenAccountForScanCost(PoolGen pgen, Size size, double ticks)
+{
+  AVERT(PoolGen, pgen);
+  AVER(ticks >= 0.0);
+
+  pgen->scanSize += (double)size;
+  pgen->scanTicks += ticks;
+  if (pgen->scanSize > LocusCostMEMORY) {
+    pgen->scanSize /= 2.0;
+    pgen->scanTicks /= 2.0;
+  }
+}
+
+
+/* PoolGenAccountForReclaimCost -- record the cost of reclaiming
+ *
+ * Call this after reclaiming a segment, passing its size and the
+ * event clock ticks it took.
+ */
+
+void PoolGenAccountForReclaimCost(PoolGen pgen, Size size, double ticks)
+{
+  AVERT(PoolGen, pgen);
+  AVER(ticks >= 0.0);
+
+  pgen->reclaimSize += (double)size;
+  pgen->reclaimTicks += ticks;
+  if (pgen->reclaimSize > LocusCostMEMORY) {
+    pgen->reclaimSize /= 2.0;
+    pgen->reclaimTicks /= 2.0;
+  }
+}
+
+
 /* PoolGenUndefer -- finish deferring accounting
  *
  * Call this when exiting ramp mode, passing the amount of old
@@ -831,6 +1067,44 @@ void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
 }
 
 
+/* PoolGenPromote -- move a segment to another pool generation
+ *
+ * Call this when a segment that survived a collection is promoted in
+ * place to toPgen (a generation of the same pool) instead of having
+ * its contents copied there. The whole segment must be accounted as
+ * old (not deferred) in pgen, and is accounted as old in toPgen.
+ *
+ * See <design/strategy/#accounting.op.promote>
+ */
+
+void PoolGenPromote(PoolGen pgen, PoolGen toPgen, Seg seg)
+{
+  Size size;
+
+  AVERT(PoolGen, pgen);
+  AVERT(PoolGen, toPgen);
+  AVERT(Seg, seg);
+  AVER(pgen != toPgen);
+  AVER(pgen->pool == toPgen->pool);
+  AVER(SegPool(seg) == pgen->pool);
+
+  size = SegSize(seg);
+  AVER(pgen->oldSize >= size);
+  pgen->oldSize -= size;
+  AVER(pgen->totalSize >= size);
+  pgen->totalSize -= size;
+  AVER(pgen->segs > 0);
+  -- pgen->segs;
+
+  RingRemove(&SegGCSeg(seg)->genRing);
+  genDescAddSeg(toPgen->gen, PoolArena(toPgen->pool), seg);
+
+  toPgen->totalSize += size;
+  ++ toPgen->segs;
+  toPgen->oldSize += size;
+}
+
+
 /* PoolGenDescribe -- describe a PoolGen */
 
 Res PoolGenDescribe(PoolGen pgen, mps_lib_FILE *stream, Count depth)
@@ -858,6 +1132,10 @@ Res PoolGenDescribe(PoolGen pgen, mps_lib_FILE *stream, Count depth)
                "  oldDeferredSize $U\n", (WriteFU)pgen->oldDeferredSize,
                "  newSize $U\n", (WriteFU)pgen->newSize,
                "  newDeferredSize $U\n", (WriteFU)pgen->newDeferredSize,
+               "  scanSize $D\n", (WriteFD)pgen->scanSize,
+               "  scanTicks $D\n", (WriteFD)pgen->scanTicks,
+               "  reclaimSize $D\n", (WriteFD)pgen->reclaimSize,
+               "  reclaimTicks $D\n", (WriteFD)pgen->reclaimTicks,
                "} PoolGen $P\n", (WriteFP)pgen,
                NULL);
   return res;
@@ -45,6 +45,7 @@ typedef struct GenDescStruct {
   Serial serial;        /* serial number within arena */
   ZoneSet zones;        /* zoneset for this generation */
   Size capacity;        /* capacity in bytes */
+  Size baseCapacity;    /* capacity given by client program, in bytes */
   double mortality;     /* moving average mortality */
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
   RingStruct segRing;   /* Ring of GCSegs in this generation */
@@ -73,6 +74,13 @@ typedef struct PoolGenStruct {
   Size oldSize;           /* allocated prior to last collection */
   Size newDeferredSize;   /* new (but deferred) */
   Size oldDeferredSize;   /* old (but deferred) */
+
+  /* Cost of tracing in this generation for this pool, in event clock
+     ticks.  See <design/strategy/#policy.model>. */
+  double scanSize;        /* bytes scanned */
+  double scanTicks;       /* ticks spent scanning them */
+  double reclaimSize;     /* bytes of segments reclaimed */
+  double reclaimTicks;    /* ticks spent reclaiming them */
 } PoolGenStruct;
 
 
@@ -92,6 +100,10 @@ typedef struct mps_chain_s {
 extern Bool GenDescCheck(GenDesc gen);
 extern Size GenDescNewSize(GenDesc gen);
 extern Size GenDescTotalSize(GenDesc gen);
+extern Size GenDescUsedSize(GenDesc gen);
+extern void GenDescSetCapacity(GenDesc gen, Size capacity);
+extern double GenDescCollectTicks(GenDesc gen, double defaultScanRate);
+extern double GenDescReclaimRate(GenDesc gen);
 extern void GenDescStartTrace(GenDesc gen, Trace trace);
 extern void GenDescEndTrace(GenDesc gen, Trace trace);
 extern void GenDescCondemned(GenDesc gen, Trace trace, Size size);
@@ -105,8 +117,11 @@ extern void ChainDestroy(Chain chain);
 extern Bool ChainCheck(Chain chain);
 
 extern double ChainDeferral(Chain chain);
+extern double ChainScale(Chain chain);
+extern Size ChainCapacity(Chain chain, Index gen);
 extern size_t ChainGens(Chain chain);
 extern GenDesc ChainGen(Chain chain, Index gen);
+extern Bool GenDescIndex(Index *indexReturn, Arena arena, GenDesc gen);
 extern Res ChainDescribe(Chain chain, mps_lib_FILE *stream, Count depth);
 
 extern Bool PoolGenCheck(PoolGen pgen);
@@ -120,9 +135,12 @@ extern void PoolGenAccountForFill(PoolGen pgen, Size size);
 extern void PoolGenAccountForEmpty(PoolGen pgen, Size used, Size unused, Bool deferred);
 extern void PoolGenAccountForAge(PoolGen pgen, Size wasBuffered, Size wasNew, Bool deferred);
 extern void PoolGenAccountForReclaim(PoolGen pgen, Size reclaimed, Bool deferred);
+extern void PoolGenAccountForScanCost(PoolGen pgen, Size size, double ticks);
+extern void PoolGenAccountForReclaimCost(PoolGen pgen, Size size, double ticks);
 extern void PoolGenUndefer(PoolGen pgen, Size oldSize, Size newSize);
 extern void PoolGenAccountForSegSplit(PoolGen pgen);
 extern void PoolGenAccountForSegMerge(PoolGen pgen);
+extern void PoolGenPromote(PoolGen pgen, PoolGen toPgen, Seg seg);
 extern Res PoolGenDescribe(PoolGen gen, mps_lib_FILE *stream, Count depth);
 
 #endif /* locus_h */
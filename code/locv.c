@@ -5,6 +5,10 @@
  *
  * This is (not much of) a coverage test for the Leaf Object
  * pool (PoolClassLO).
+ *
+ * test_zeroed checks that a pool created with MPS_KEY_ZEROED hands
+ * out zeroed memory, both from new segments and from reclaimed
+ * objects.
  */
 
 #include "testlib.h"
@@ -14,9 +18,12 @@
 #include "mpsavm.h"
 
 #include <stdio.h> /* printf */
+#include <string.h> /* memset */
 
 
 #define testArenaSIZE   ((size_t)16<<20)
+#define zeroedOBJECTS   1000
+#define zeroedROUNDS    4
 
 static mps_res_t scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit);
 static mps_addr_t skip(mps_addr_t object);
@@ -42,6 +49,48 @@ static mps_fmt_A_s locv_fmt =
 static mps_addr_t roots[4];
 
 
+/* test_zeroed -- check that a zeroed pool hands out zeroed memory */
+
+static void test_zeroed(mps_arena_t arena, mps_fmt_t format)
+{
+  mps_pool_t pool;
+  mps_ap_t ap;
+  size_t round, i, j;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_ZEROED, TRUE);
+    die(mps_pool_create_k(&pool, arena, mps_class_lo(), args),
+        "LOCreate zeroed");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "APCreate zeroed");
+
+  for (round = 0; round < zeroedROUNDS; ++round) {
+    for (i = 0; i < zeroedOBJECTS; ++i) {
+      size_t size = (1 + rnd() % 64) * sizeof(void *);
+      mps_addr_t p;
+      do {
+        die(mps_reserve(&p, ap, size), "mps_reserve zeroed");
+        for (j = 0; j < size; ++j)
+          cdie(((unsigned char *)p)[j] == 0, "zeroed");
+        /* Scribble over the object so that reuse is detected. */
+        memset(p, 0xA5, size);
+        *(mps_word_t *)p = size;
+      } while (!mps_commit(ap, p, size));
+    }
+    /* Nothing refers to the objects, so they are all reclaimed, and
+       the arena has time to zero the pages it freed. */
+    mps_arena_collect(arena);
+    mps_arena_release(arena);
+    (void)mps_arena_step(arena, 0.01, 0.0);
+  }
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+}
+
+
 int main(int argc, char *argv[])
 {
   mps_arena_t arena;
@@ -93,6 +142,9 @@ int main(int argc, char *argv[])
   
   mps_ap_destroy(ap);
   mps_pool_destroy(pool);
+
+  test_zeroed(arena, format);
+
   mps_fmt_destroy(format);
   mps_root_destroy(root);
   mps_arena_destroy(arena);
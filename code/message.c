@@ -267,6 +267,37 @@ Bool MessageGet(Message *messageReturn, Arena arena, MessageType type)
   return FALSE;
 }
 
+/* Get finalization references in bulk
+ *
+ * Removes up to count finalization messages from the queue, oldest
+ * first, stores their references in refs, and deletes the messages
+ * (so that their guardians are recycled). Returns the number of
+ * references stored. See <design/message/#if.fun.finalization-refs>.
+ */
+Count MessageFinalizationRefs(Ref *refs, Arena arena, Count count)
+{
+  Ring node, next;
+  Count i = 0;
+
+  AVER(refs != NULL);
+  AVERT(Arena, arena);
+
+  RING_FOR(node, &arena->messageRing, next) {
+    Message message = RING_ELT(Message, queueRing, node);
+    Ref ref;
+    if(i == count)
+      break;
+    if(MessageGetType(message) == MessageTypeFINALIZATION) {
+      RingRemove(&message->queueRing);
+      MessageFinalizationRef(&ref, arena, message);
+      ArenaPoke(arena, &refs[i], ref);
+      MessageDelete(message);
+      ++i;
+    }
+  }
+  return i;
+}
+
 /* Discard a message (recipient has finished using it). */
 void MessageDiscard(Arena arena, Message message)
 {
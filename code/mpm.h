@@ -210,6 +210,7 @@ extern Res PoolDescribe(Pool pool, mps_lib_FILE *stream, Count depth);
 #define PoolArenaRing(pool) (&(pool)->arenaRing)
 #define PoolOfArenaRing(node) RING_ELT(Pool, arenaRing, node)
 #define PoolHasAttr(pool, Attr) ((ClassOfPoly(Pool, pool)->attr & (Attr)) != 0)
+#define PoolFrozen(pool)        ((pool)->frozen)
 #define PoolSizeGrains(pool, size) ((size) >> (pool)->alignShift)
 #define PoolGrainsSize(pool, grains) ((grains) << (pool)->alignShift)
 #define PoolIndexOfAddr(base, pool, p) \
@@ -306,6 +307,8 @@ extern Bool MessageQueueType(MessageType *typeReturn, Arena arena);
 extern Bool MessageGet(Message *messageReturn, Arena arena,
                        MessageType type);
 extern void MessageDiscard(Arena arena, Message message);
+extern Count MessageFinalizationRefs(Ref *refs, Arena arena,
+                                    Count count);
 /* -- Message Methods, Generic */
 extern MessageType MessageGetType(Message message);
 extern MessageClass MessageGetClass(Message message);
@@ -369,6 +372,8 @@ extern Bool TraceCheck(Trace trace);
 extern Res TraceCreate(Trace *traceReturn, Arena arena, TraceStartWhy why);
 extern void TraceDestroyInit(Trace trace);
 extern void TraceDestroyFinished(Trace trace);
+extern Res WalkTraceCreate(Trace *traceReturn, Arena arena);
+extern void WalkTraceDestroy(Trace trace);
 
 extern Bool TraceIsEmpty(Trace trace);
 extern Res TraceAddWhite(Trace trace, Seg seg);
@@ -380,8 +385,12 @@ extern Bool TracePoll(Work *workReturn, Bool *collectWorldReturn,
 
 extern Rank TraceRankForAccess(Arena arena, Seg seg);
 extern void TraceSegAccess(Arena arena, Seg seg, AccessSet mode);
+extern void TraceSegScanFlipped(Arena arena, Seg seg);
+extern void TraceRootAccess(Arena arena, Root root, Addr addr,
+                            AccessSet mode);
 
 extern void TraceAdvance(Trace trace);
+extern Res TraceCondemnAll(double *mortalityReturn, Trace trace);
 extern Res TraceStartCollectAll(Trace *traceReturn, Arena arena, TraceStartWhy why);
 extern Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth);
 
@@ -495,6 +504,7 @@ extern void GlobalsReinitializeAll(void);
 #define ArenaChunkRing(arena)   (&(arena)->chunkRing)
 #define ArenaShield(arena)      (&(arena)->shieldStruct)
 #define ArenaHistory(arena)     (&(arena)->historyStruct)
+#define ArenaPauseStats(arena)  (&(arena)->pauseStatsStruct)
 
 extern Bool ArenaGrainSizeCheck(Size size);
 #define AddrArenaGrainUp(addr, arena) AddrAlignUp(addr, ArenaGrainSize(arena))
@@ -535,6 +545,22 @@ extern void ArenaChunkInsert(Arena arena, Chunk chunk);
 extern void ArenaChunkRemoved(Arena arena, Chunk chunk);
 extern void ArenaAccumulateTime(Arena arena, Clock start, Clock now);
 
+extern void PauseStatsInit(PauseStats stats);
+extern void PauseStatsFinish(PauseStats stats);
+extern Bool PauseStatsCheck(PauseStats stats);
+extern Res PauseStatsDescribe(PauseStats stats, mps_lib_FILE *stream,
+                              Count depth);
+extern void PauseStatsRecord(PauseStats stats, PauseKind kind,
+                             Clock start, Clock end);
+extern Count PauseStatsCount(PauseStats stats, PauseKind kind);
+extern Clock PauseStatsTotal(PauseStats stats, PauseKind kind);
+extern Clock PauseStatsMax(PauseStats stats, PauseKind kind);
+extern Clock PauseStatsPercentile(PauseStats stats, PauseKind kind,
+                                  double fraction);
+extern double PauseStatsMMU(PauseStats stats, Clock window);
+extern Clock PauseStatsSince(PauseStats stats, Clock since);
+extern Clock PauseStatsMaxSince(PauseStats stats, Clock since);
+
 extern void ArenaSetEmergency(Arena arena, Bool emergency);
 extern Bool ArenaEmergency(Arena arean);
 
@@ -542,6 +568,8 @@ extern Res ControlInit(Arena arena);
 extern void ControlFinish(Arena arena);
 extern Res ControlAlloc(void **baseReturn, Arena arena, size_t size);
 extern void ControlFree(Arena arena, void *base, size_t size);
+extern void *ControlTableAlloc(void *closure, size_t size);
+extern void ControlTableFree(void *closure, void *p, size_t size);
 extern Res ControlDescribe(Arena arena, mps_lib_FILE *stream, Count depth);
 
 
@@ -576,13 +604,28 @@ extern Size ArenaCommitted(Arena arena);
 extern Size ArenaSpareCommitted(Arena arena);
 extern double ArenaSpare(Arena arena);
 extern void ArenaSetSpare(Arena arena, double spare);
-#define ArenaSpareCommitLimit(arena) ((Size)(ArenaCommitted(arena) * ArenaSpare(arena)))
+#define ArenaPressureSpare(arena) RVALUE((arena)->pressureSpare)
+#define ArenaSpareCommitLimit(arena) ((Size)(ArenaCommitted(arena) * ArenaSpare(arena) * ArenaPressureSpare(arena)))
 #define ArenaCurrentSpare(arena) ((double)ArenaSpareCommitted(arena) / ArenaCommitted(arena))
 
 extern Size ArenaCommitLimit(Arena arena);
 extern Res ArenaSetCommitLimit(Arena arena, Size limit);
 extern double ArenaPauseTime(Arena arena);
 extern void ArenaSetPauseTime(Arena arena, double pauseTime);
+extern double ArenaSpareDecay(Arena arena);
+extern void ArenaSetSpareDecay(Arena arena, double spareDecay);
+extern double ArenaMMUTarget(Arena arena);
+extern double ArenaMMUWindow(Arena arena);
+extern void ArenaSetMMUTarget(Arena arena, double mmuTarget,
+                              double mmuWindow);
+extern double ArenaHeapGrowth(Arena arena);
+extern void ArenaSetHeapGrowth(Arena arena, double heapGrowth);
+#define ArenaLiveSize(arena) RVALUE((arena)->liveSize)
+extern Size ArenaMemoryTarget(Arena arena);
+extern void ArenaSetMemoryTarget(Arena arena, Size memoryTarget);
+#define ArenaMemoryPressure(arena) RVALUE((arena)->pressure)
+extern double ArenaIdleTime(Arena arena);
+extern Res ArenaSetIdleTime(Arena arena, double idleTime);
 extern Size ArenaNoPurgeSpare(Arena arena, Size size);
 extern Res ArenaNoGrow(Arena arena, LocusPref pref, Size size);
 
@@ -592,8 +635,13 @@ extern Size ArenaCollectable(Arena arena);
 extern Res ArenaExtend(Arena, Addr base, Size size);
 
 extern void ArenaCompact(Arena arena, Trace trace);
+extern void ArenaZero(Arena arena, Addr base, Addr limit);
+extern Size ArenaZeroSpare(Arena arena, Size size);
+extern void ArenaDecaySpare(Arena arena, Clock now);
+extern void ArenaUpdatePressure(Arena arena, Clock now);
 
 extern Res ArenaFinalize(Arena arena, Ref obj);
+extern Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count);
 extern Res ArenaDefinalize(Arena arena, Ref obj);
 
 extern Res ArenaAlloc(Addr *baseReturn, LocusPref pref,
@@ -615,6 +663,8 @@ extern Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                              Arena arena, Bool collectWorldAllowed);
 extern Bool PolicyPoll(Arena arena);
 extern Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork);
+extern void PolicyTraceEnd(Trace trace);
+extern void PolicyCalibrate(Arena arena, Clock clocks, double ticks);
 
 
 /* Locus interface */
@@ -698,6 +748,10 @@ extern Addr (SegLimit)(Seg seg);
 #define SegGrey(seg)            RVALUE((TraceSet)(seg)->grey)
 #define SegWhite(seg)           RVALUE((TraceSet)(seg)->white)
 #define SegNailed(seg)          RVALUE((TraceSet)(seg)->nailed)
+#define SegMoved(seg)           RVALUE((Epoch)(seg)->moved)
+#define SegSetMoved(seg, epoch) ((void)((seg)->moved = (epoch)))
+#define SegHashed(seg)          RVALUE((Bool)(seg)->hashed)
+#define SegSetHashed(seg, b)    ((void)((seg)->hashed = BOOLOF(b)))
 #define SegPoolRing(seg)        (&(seg)->poolRing)
 #define SegOfPoolRing(node)     RING_ELT(Seg, poolRing, (node))
 #define SegOfGreyRing(node)     (&(RING_ELT(GCSeg, greyRing, (node)) \
@@ -747,6 +801,7 @@ extern Bool BufferIsReset(Buffer buffer);
 extern Bool BufferIsReady(Buffer buffer);
 extern Bool BufferIsMutator(Buffer buffer);
 extern void BufferSetAllocAddr(Buffer buffer, Addr addr);
+extern void BufferSetSampleLimit(Buffer buffer, Addr point);
 extern void BufferAttach(Buffer buffer,
                          Addr base, Addr limit, Addr init, Size size);
 extern void BufferDetach(Buffer buffer, Pool pool);
@@ -808,6 +863,8 @@ extern void FormatDestroy(Format format);
 extern Arena FormatArena(Format format);
 extern Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth);
 extern Res FormatScan(Format format, ScanState ss, Addr base, Addr limit);
+extern Res FormatScanSlice(Format format, ScanState ss, Addr object,
+                           Addr base, Addr limit);
 
 
 /* Reference Interface -- see <code/ref.c> */
@@ -913,10 +970,27 @@ extern void LDReset(mps_ld_t ld, Arena arena);
 extern void LDAdd(mps_ld_t ld, Arena arena, Addr addr);
 extern Bool LDIsStaleAny(mps_ld_t ld, Arena arena);
 extern Bool LDIsStale(mps_ld_t ld, Arena arena, Addr addr);
+extern Bool LDIsStalePrecise(mps_ld_t ld, Arena arena, Addr addr);
+extern Res IdHash(Word *hashReturn, Arena arena, Addr addr);
+extern Bool IdHashMove(Arena arena, Addr old, Addr new);
+extern void IdHashForget(Arena arena, Addr addr);
+extern void IdHashForgetPool(Arena arena, Pool pool);
+extern void IdHashFinish(Arena arena);
 extern void LDAge(Arena arena, RefSet moved);
 extern void LDMerge(mps_ld_t ld, Arena arena, mps_ld_t from);
 
 
+/* Allocation Sampling -- see <code/sample.c> */
+
+extern void SamplerSet(Arena arena, Size interval,
+                       mps_alloc_sampler_t sampler, void *closure);
+extern void SampleFill(Buffer buffer, Addr base, Size size, Bool crossed);
+extern void SampleCross(Buffer buffer, Addr p, Size size);
+extern void SamplesWalk(Arena arena, mps_sample_stepper_t f,
+                        void *p, size_t s);
+extern void SampleFinish(Arena arena);
+
+
 /* Root Interface -- see <code/root.c> */
 
 extern Res RootCreateArea(Root *rootReturn, Arena arena,
@@ -952,13 +1026,16 @@ extern Bool RootCheck(Root root);
 extern Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth);
 extern Res RootsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth);
 extern Rank RootRank(Root root);
-extern AccessSet RootPM(Root root);
+extern AccessSet RootPM(Root root, Addr addr);
 extern RefSet RootSummary(Root root);
 extern void RootGrey(Root root, Trace trace);
 extern Res RootScan(ScanState ss, Root root);
+extern Res RootScanRegion(ScanState ss, Root root, Addr addr);
+extern Bool RootRegionIsGrey(Root root, Addr addr);
 extern Arena RootArena(Root root);
 extern Bool RootOfAddr(Root *root, Arena arena, Addr addr);
-extern void RootAccess(Root root, AccessSet mode);
+extern Bool RootOfGreyRegions(Root *root, Arena arena);
+extern void RootAccess(Root root, Addr addr, AccessSet mode);
 typedef Res (*RootIterateFn)(Root root, void *p);
 extern Res RootsIterate(Globals arena, RootIterateFn f, void *p);
 
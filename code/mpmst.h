@@ -97,6 +97,7 @@ typedef struct mps_pool_s {     /* generic structure */
   Align alignment;              /* alignment for grains */
   Shift alignShift;             /* log2(alignment) */
   Format format;                /* format or NULL */
+  Bool frozen;                  /* objects immutable, see PoolFreeze */
 } PoolStruct;
 
 
@@ -225,13 +226,16 @@ typedef struct SegStruct {      /* segment structure */
   Tract firstTract;             /* first tract of segment */
   RingStruct poolRing;          /* link in list of segs in pool */
   Addr limit;                   /* limit of segment */
+  Epoch moved;                  /* epoch of last move into seg, <design/seg/#field.moved> */
   unsigned depth : ShieldDepthWIDTH; /* see design.mps.shield.def.depth */
   BOOLFIELD(queued);            /* in shield queue? */
+  BOOLFIELD(hashed);            /* any identity hashes? <design/seg/#field.hashed> */
   AccessSet pm : AccessLIMIT;   /* protection mode, <code/shield.c> */
   AccessSet sm : AccessLIMIT;   /* shield mode, <code/shield.c> */
   TraceSet grey : TraceLIMIT;   /* traces for which seg is grey */
   TraceSet white : TraceLIMIT;  /* traces for which seg is white */
   TraceSet nailed : TraceLIMIT; /* traces for which seg has nailed objects */
+  TraceSet pending : TraceLIMIT; /* traces for which seg awaits ephemeron keys */
   RankSet rankSet : RankLIMIT;  /* ranks of references in this seg */
   unsigned defer : WB_DEFER_BITS; /* defer write barrier for this many scans */
 } SegStruct;
@@ -323,6 +327,7 @@ typedef struct BufferStruct {
   Addr initAtFlip;              /* limit of initialized data at flip */
   mps_ap_s ap_s;                /* the allocation point */
   Addr poolLimit;               /* the pool's idea of the limit */
+  Addr sampleLimit;             /* sample point, or 0 <code/sample.c#sample> */
   Align alignment;              /* allocation alignment */
   unsigned rampCount;           /* see <code/buffer.c#ramp.hack> */
 } BufferStruct;
@@ -365,6 +370,7 @@ typedef struct mps_fmt_s {
   mps_fmt_isfwd_t isMoved;
   mps_fmt_pad_t pad;
   mps_fmt_class_t klass;        /* pointer indicating class */
+  mps_fmt_scan_slice_t scanSlice; /* scan part of an object, or NULL */
   Size headerSize;              /* size of header */
 } FormatStruct;
 
@@ -417,6 +423,11 @@ typedef struct ScanStateStruct {
   STATISTIC_DECL(Count preservedInPlaceCount) /* objects preserved in place */
   STATISTIC_DECL(Size copiedSize) /* bytes copied */
   Size scannedSize;             /* bytes scanned */
+  Size sliceSize;               /* bound on resumable scan, or 0 */
+  Bool unfinished;              /* resumable scan stopped early */
+  Count pending;                /* ephemerons with keys not yet reached */
+  Bool progress;                /* ephemeron scan may have preserved objects */
+  Bool splat;                   /* splat ephemerons with unreached keys */
 } ScanStateStruct;
 
 
@@ -429,11 +440,16 @@ typedef struct TraceStruct {
   TraceId ti;                   /* index into TraceSets */
   Arena arena;                  /* owning arena */
   TraceStartWhy why;            /* why the trace began */
+  Clock startTime;              /* when the trace was created */
+  Clock flipPause;              /* length of the flip, in clocks */
   ZoneSet white;                /* zones in the white set */
   ZoneSet mayMove;              /* zones containing possibly moving objs */
+  Bool frozenWhite;             /* condemned objects in a frozen pool */
   TraceState state;             /* current state of trace */
   Rank band;                    /* current band */
   Bool firstStretch;            /* in first stretch of band (see accessor) */
+  Bool ephemeronProgress;       /* preserved objects since ephemeron round */
+  Bool ephemeronSplat;          /* splat ephemerons with unreached keys */
   SegFixMethod fix;             /* fix method to apply to references */
   void *fixClosure;             /* see .ss.fix-closure */
   RingStruct genRing;           /* ring of generations condemned for trace */
@@ -449,6 +465,7 @@ typedef struct TraceStruct {
   STATISTIC_DECL(Size rootCopiedSize) /* bytes copied by scanning roots */
   STATISTIC_DECL(Count segScanCount) /* number of segments scanned */
   Count segScanSize;            /* total size of scanned segments */
+  double segScanTicks;          /* event clock ticks spent scanning them */
   STATISTIC_DECL(Size segCopiedSize) /* bytes copied by scanning segments */
   STATISTIC_DECL(Count singleScanCount) /* number of single refs scanned */
   STATISTIC_DECL(Count singleScanSize) /* total size of single refs scanned */
@@ -481,6 +498,9 @@ typedef struct mps_arena_class_s {
   ArenaCreateMethod create;
   ArenaDestroyMethod destroy;
   ArenaPurgeSpareMethod purgeSpare;
+  ArenaZeroMethod zero;
+  ArenaZeroSpareMethod zeroSpare;
+  ArenaDecaySpareMethod decaySpare;
   ArenaExtendMethod extend;
   ArenaGrowMethod grow;
   ArenaFreeMethod free;
@@ -511,6 +531,7 @@ typedef struct GlobalsStruct {
 
   /* polling fields (<code/global.c>) */
   double pollThreshold;         /* <design/arena/#poll> */
+  double pollDebt;              /* <design/arena/#mmu.defer> */
   Bool insidePoll;
   Bool clamped;                 /* prevent background activity */
   double fillMutatorSize;       /* total bytes filled, mutator buffers */
@@ -702,6 +723,36 @@ typedef struct HistoryStruct {
 } HistoryStruct;  
 
 
+/* PauseStats -- pause time statistics
+ *
+ * See <design/arena/#pause>.
+ */
+
+#define PauseStatsSig   ((Sig)0x519BA05E) /* SIGnature PAUSE */
+
+#define PauseHistBUCKETS \
+  ((Count)(PauseHistEXP_LIMIT - PauseHistSUB_SHIFT + 1) << PauseHistSUB_SHIFT)
+
+typedef struct PauseHistStruct {
+  Count count;                  /* number of pauses */
+  Clock total;                  /* total time in pauses */
+  Clock max;                    /* longest pause */
+  Count bucket[PauseHistBUCKETS]; /* <design/arena/#pause.hist> */
+} PauseHistStruct;
+
+typedef struct PauseLogEntryStruct {
+  Clock start, end;             /* extent of the pause */
+} PauseLogEntryStruct;
+
+typedef struct PauseStatsStruct {
+  Sig sig;                         /* design.mps.sig */
+  PauseHistStruct hist[PauseKindLIMIT]; /* histogram for each kind */
+  Index logNext;                   /* index of next log entry to write */
+  Count logCount;                  /* number of valid log entries */
+  PauseLogEntryStruct log[PauseLogLENGTH]; /* <design/arena/#pause.log> */
+} PauseStatsStruct;
+
+
 /* MVFFStruct -- MVFF (Manual Variable First Fit) pool outer structure
  *
  * The signature is placed at the end, see
@@ -754,6 +805,25 @@ typedef struct mps_arena_s {
   Size spareCommitted;          /* amount of memory in hysteresis fund */
   double spare;                 /* maximum spareCommitted/committed */
   double pauseTime;             /* maximum pause time, in seconds */
+  double spareDecay;            /* age of spare memory before purge, secs */
+  double mmuTarget;             /* <design/arena/#mmu> */
+  double mmuWindow;             /* MMU window, in seconds */
+  double heapGrowth;            /* <design/strategy/#policy.growth> */
+  Size liveSize;                /* <design/strategy/#policy.growth.live> */
+  Bool adaptChains;             /* <design/strategy/#policy.adapt> */
+  Size memoryTarget;            /* <design/arena/#pressure> */
+  mps_pressure_probe_t pressureProbe; /* client's target probe, or NULL */
+  void *pressureClosure;        /* closure argument for pressureProbe */
+  Size probedTarget;            /* target last returned by pressureProbe */
+  Clock lastPressureProbe;      /* when pressureProbe was last called */
+  double pressure;              /* committed memory / target */
+  double pressureSpare;         /* <design/arena/#pressure.spare> */
+  double idleTime;              /* <design/arena/#idle> */
+  ThreadTimer idleTimer;        /* background thread, or NULL */
+  double idleFillSize;          /* fillMutatorSize at last idle tick */
+  Count idleTicks;              /* consecutive idle ticks */
+  Clock lastSpareDecay;         /* when spare memory was last aged */
+  Count zeroedPools;            /* pools promising zeroed allocation */
 
   Shift zoneShift;              /* see also <code/ref.c> */
   Size grainSize;               /* <design/arena/#grain> */
@@ -789,6 +859,17 @@ typedef struct mps_arena_s {
   Bool isFinalPool;             /* indicator for finalPool */
   Pool finalPool;               /* either NULL or an MRG pool */
 
+  /* identity hash fields (<design/arena/#hash>, <code/ld.c>) */
+  struct TableStruct *hashTable; /* map from object to hash, or NULL */
+  Word hashSerial;              /* serial of last identity hash */
+
+  /* allocation sampling fields (<design/arena/#sample>, <code/sample.c>) */
+  Size sampleInterval;          /* mean bytes between samples, or 0 */
+  Size sampleCountdown;         /* bytes to fill before next sample */
+  mps_alloc_sampler_t sampler;  /* client's sampler, or NULL */
+  void *samplerClosure;         /* closure for sampler */
+  struct TableStruct *sampleTable; /* map from hash to sample, or NULL */
+
   /* thread fields (<code/thread.c>) */
   RingStruct threadRing;        /* ring of attached threads */
   RingStruct deadRing;          /* ring of dead threads */
@@ -810,11 +891,14 @@ typedef struct mps_arena_s {
   double tracedWork;
   double tracedTime;
   Clock lastWorldCollect;
+  double calibClocks;           /* <design/strategy/#policy.model.clock> */
+  double calibTicks;            /* event clock ticks in calibClocks */
 
   RingStruct greyRing[RankLIMIT]; /* ring of grey segments at each rank */
   RingStruct chainRing;         /* ring of chains */
 
   struct HistoryStruct historyStruct;
+  PauseStatsStruct pauseStatsStruct; /* <design/arena/#pause> */
   
   Bool emergency;               /* garbage collect in emergency mode? */
 
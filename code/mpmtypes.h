@@ -95,6 +95,8 @@ typedef struct GlobalsStruct *Globals;  /* <design/arena/> */
 typedef struct VMStruct *VM;            /* <code/vm.c>* */
 typedef struct RootStruct *Root;        /* <code/root.c> */
 typedef struct mps_thr_s *Thread;       /* <code/th.c>* */
+typedef struct ThreadTimerStruct *ThreadTimer; /* <design/thread-manager/#if.timer> */
+typedef void (*ThreadTimerFunction)(void *closure);
 typedef struct MutatorContextStruct *MutatorContext; /* <design/prmc/> */
 typedef struct PoolDebugMixinStruct *PoolDebugMixin;
 typedef struct AllocPatternStruct *AllocPattern;
@@ -107,6 +109,9 @@ typedef struct LandClassStruct *LandClass; /* <design/land/> */
 typedef unsigned FindDelete;            /* <design/land/> */
 typedef struct ShieldStruct *Shield; /* design.mps.shield */
 typedef struct HistoryStruct *History;  /* design.mps.arena.ld */
+typedef struct PauseStatsStruct *PauseStats; /* <design/arena/#pause> */
+typedef struct PauseHistStruct *PauseHist; /* <design/arena/#pause.hist> */
+typedef unsigned PauseKind;             /* <design/arena/#pause> */
 typedef struct PoolGenStruct *PoolGen;  /* <design/strategy/> */
 
 
@@ -117,6 +122,9 @@ typedef Res (*ArenaCreateMethod)(Arena *arenaReturn, ArgList args);
 typedef void (*ArenaDestroyMethod)(Arena arena);
 typedef Res (*ArenaInitMethod)(Arena arena, Size grainSize, ArgList args);
 typedef Size (*ArenaPurgeSpareMethod)(Arena arena, Size size);
+typedef void (*ArenaZeroMethod)(Arena arena, Addr base, Addr limit);
+typedef Size (*ArenaZeroSpareMethod)(Arena arena, Size size);
+typedef void (*ArenaDecaySpareMethod)(Arena arena);
 typedef Res (*ArenaExtendMethod)(Arena arena, Addr base, Size size);
 typedef Res (*ArenaGrowMethod)(Arena arena, LocusPref pref, Size size);
 typedef void (*ArenaFreeMethod)(Addr base, Size size, Pool pool);
@@ -304,7 +312,7 @@ enum {
 /* These definitions must match <code/mps.h#rank>. */
 /* This is checked by <code/mpsi.c#check>. */
 
-#define RANK_LIST(X) X(AMBIG) X(EXACT) X(FINAL) X(WEAK)
+#define RANK_LIST(X) X(AMBIG) X(EXACT) X(EPHEMERON) X(FINAL) X(WEAK)
 
 enum {
 #define X(RANK) Rank ## RANK,
@@ -323,6 +331,7 @@ enum {
 #define RootModeCONSTANT          ((RootMode)1<<0)
 #define RootModePROTECTABLE       ((RootMode)1<<1)
 #define RootModePROTECTABLE_INNER ((RootMode)1<<2)
+#define RootModeINCREMENTAL       ((RootMode)1<<3)
 
 
 /* Root Variants -- see <design/type/#rootvar>
@@ -379,7 +388,13 @@ enum {
     "Client requests: immediate full collection.")                      \
   X(WALK, "walk", "Walking all live objects.")                          \
   X(EXTENSION, "extension", \
-    "Extension: an MPS extension started the trace.")
+    "Extension: an MPS extension started the trace.")                   \
+  X(HEAPGROWTH, "heap growth",                                          \
+    "The heap has grown past its target over the live size measured "   \
+    "by the last full collection: start full collection.")              \
+  X(MEMORYPRESSURE, "memory pressure",                                  \
+    "Committed memory has reached the soft target set by the client "   \
+    "or its pressure probe: start full collection.")
 
 enum {
 #define X(WHY, SHORT, LONG) TraceStartWhy ## WHY,
@@ -400,6 +415,18 @@ enum {
 };
 
 
+/* PauseKinds -- see <design/arena/#pause> */
+/* .pause.kinds: Keep in sync with <code/mps.h#pause.kinds> */
+
+enum {
+  PauseKindPOLL,        /* MPS_PAUSE_POLL: ArenaPoll */
+  PauseKindFLIP,        /* MPS_PAUSE_FLIP: traceFlip */
+  PauseKindACCESS,      /* MPS_PAUSE_ACCESS: ArenaAccess */
+  PauseKindSTEP,        /* MPS_PAUSE_STEP: ArenaStep */
+  PauseKindLIMIT        /* not a pause kind, the limit of the enum. */
+};
+
+
 /* FindDelete operations -- see <design/land/> */
 
 enum {
@@ -39,6 +39,7 @@
 #include "locus.c"
 #include "tract.c"
 #include "walk.c"
+#include "image.c"
 #include "protocol.c"
 #include "pool.c"
 #include "poolabs.c"
@@ -54,6 +55,7 @@
 #include "ring.c"
 #include "shield.c"
 #include "ld.c"
+#include "sample.c"
 #include "event.c"
 #include "sac.c"
 #include "message.c"
@@ -116,6 +118,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thxc.c"       /* macOS Mach threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protxc.c"     /* macOS Mach exception handling */
@@ -130,6 +133,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thxc.c"       /* macOS Mach threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protxc.c"     /* macOS Mach exception handling */
@@ -144,6 +148,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -159,6 +164,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -174,6 +180,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -189,6 +196,7 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "timerix.c"    /* Posix timer threads */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
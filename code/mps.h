@@ -74,6 +74,7 @@ typedef size_t mps_align_t;     /* alignment (size_t) */
 typedef unsigned mps_rm_t;      /* root mode (unsigned) */
 typedef unsigned mps_rank_t;    /* ranks (unsigned) */
 typedef unsigned mps_message_type_t;    /* message type (unsigned) */
+typedef unsigned mps_pause_kind_t;      /* pause kind (unsigned) */
 typedef mps_word_t mps_clock_t;  /* processor time */
 typedef mps_word_t mps_label_t;  /* telemetry label */
 
@@ -119,6 +120,9 @@ typedef void (*mps_fmt_fwd_t)(mps_addr_t, mps_addr_t);
 typedef mps_addr_t (*mps_fmt_isfwd_t)(mps_addr_t);
 typedef void (*mps_fmt_pad_t)(mps_addr_t, size_t);
 typedef mps_addr_t (*mps_fmt_class_t)(mps_addr_t);
+typedef mps_res_t (*mps_fmt_scan_slice_t)(mps_ss_t, mps_addr_t,
+                                          mps_addr_t, mps_addr_t);
+typedef size_t (*mps_pressure_probe_t)(void *);
 
 
 /* Keyword argument lists */
@@ -154,7 +158,9 @@ typedef struct mps_arg_s {
     mps_fmt_isfwd_t fmt_isfwd;
     mps_fmt_pad_t fmt_pad;
     mps_fmt_class_t fmt_class;
+    mps_fmt_scan_slice_t fmt_scan_slice;
     mps_pool_t pool;
+    mps_pressure_probe_t pressure_probe;
   } val;
 } mps_arg_s;
 
@@ -192,6 +198,33 @@ extern const struct mps_key_s _mps_key_SPARE_COMMIT_LIMIT;
 extern const struct mps_key_s _mps_key_PAUSE_TIME;
 #define MPS_KEY_PAUSE_TIME      (&_mps_key_PAUSE_TIME)
 #define MPS_KEY_PAUSE_TIME_FIELD d
+extern const struct mps_key_s _mps_key_SPARE_DECAY;
+#define MPS_KEY_SPARE_DECAY     (&_mps_key_SPARE_DECAY)
+#define MPS_KEY_SPARE_DECAY_FIELD d
+extern const struct mps_key_s _mps_key_MMU_TARGET;
+#define MPS_KEY_MMU_TARGET      (&_mps_key_MMU_TARGET)
+#define MPS_KEY_MMU_TARGET_FIELD d
+extern const struct mps_key_s _mps_key_MMU_WINDOW;
+#define MPS_KEY_MMU_WINDOW      (&_mps_key_MMU_WINDOW)
+#define MPS_KEY_MMU_WINDOW_FIELD d
+extern const struct mps_key_s _mps_key_HEAP_GROWTH;
+#define MPS_KEY_HEAP_GROWTH     (&_mps_key_HEAP_GROWTH)
+#define MPS_KEY_HEAP_GROWTH_FIELD d
+extern const struct mps_key_s _mps_key_ADAPT_CHAINS;
+#define MPS_KEY_ADAPT_CHAINS    (&_mps_key_ADAPT_CHAINS)
+#define MPS_KEY_ADAPT_CHAINS_FIELD b
+extern const struct mps_key_s _mps_key_MEMORY_TARGET;
+#define MPS_KEY_MEMORY_TARGET   (&_mps_key_MEMORY_TARGET)
+#define MPS_KEY_MEMORY_TARGET_FIELD size
+extern const struct mps_key_s _mps_key_PRESSURE_PROBE;
+#define MPS_KEY_PRESSURE_PROBE  (&_mps_key_PRESSURE_PROBE)
+#define MPS_KEY_PRESSURE_PROBE_FIELD pressure_probe
+extern const struct mps_key_s _mps_key_PRESSURE_CLOSURE;
+#define MPS_KEY_PRESSURE_CLOSURE (&_mps_key_PRESSURE_CLOSURE)
+#define MPS_KEY_PRESSURE_CLOSURE_FIELD p
+extern const struct mps_key_s _mps_key_IDLE_TIME;
+#define MPS_KEY_IDLE_TIME       (&_mps_key_IDLE_TIME)
+#define MPS_KEY_IDLE_TIME_FIELD d
 
 extern const struct mps_key_s _mps_key_EXTEND_BY;
 #define MPS_KEY_EXTEND_BY       (&_mps_key_EXTEND_BY)
@@ -217,10 +250,16 @@ extern const struct mps_key_s _mps_key_SPARE;
 extern const struct mps_key_s _mps_key_INTERIOR;
 #define MPS_KEY_INTERIOR        (&_mps_key_INTERIOR)
 #define MPS_KEY_INTERIOR_FIELD  b
+extern const struct mps_key_s _mps_key_ZEROED;
+#define MPS_KEY_ZEROED          (&_mps_key_ZEROED)
+#define MPS_KEY_ZEROED_FIELD    b
 
 extern const struct mps_key_s _mps_key_VMW3_TOP_DOWN;
 #define MPS_KEY_VMW3_TOP_DOWN   (&_mps_key_VMW3_TOP_DOWN)
 #define MPS_KEY_VMW3_TOP_DOWN_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_HUGE_PAGES;
+#define MPS_KEY_ARENA_HUGE_PAGES (&_mps_key_ARENA_HUGE_PAGES)
+#define MPS_KEY_ARENA_HUGE_PAGES_FIELD b
 
 extern const struct mps_key_s _mps_key_FMT_ALIGN;
 #define MPS_KEY_FMT_ALIGN   (&_mps_key_FMT_ALIGN)
@@ -246,6 +285,9 @@ extern const struct mps_key_s _mps_key_FMT_PAD;
 extern const struct mps_key_s _mps_key_FMT_CLASS;
 #define MPS_KEY_FMT_CLASS   (&_mps_key_FMT_CLASS)
 #define MPS_KEY_FMT_CLASS_FIELD fmt_class
+extern const struct mps_key_s _mps_key_FMT_SCAN_SLICE;
+#define MPS_KEY_FMT_SCAN_SLICE   (&_mps_key_FMT_SCAN_SLICE)
+#define MPS_KEY_FMT_SCAN_SLICE_FIELD fmt_scan_slice
 
 /* Maximum length of a keyword argument list. */
 #define MPS_ARGS_MAX          32
@@ -298,12 +340,34 @@ enum {
 #define mps_message_type_gc_start() _mps_MESSAGE_TYPE_GC_START
 
 
+/* <a id="pause.kinds"> Keep in sync with
+ * <code/mpmtypes.h#pause.kinds> */
+
+enum {
+  MPS_PAUSE_POLL,               /* collection work during allocation */
+  MPS_PAUSE_FLIP,               /* flipping the mutator */
+  MPS_PAUSE_ACCESS,             /* handling a barrier hit */
+  MPS_PAUSE_STEP                /* mps_arena_step */
+};
+
+typedef struct mps_pause_stats_s {
+  size_t count;                 /* number of pauses */
+  double total;                 /* total pause time, in seconds */
+  double max;                   /* longest pause, in seconds */
+  double p50;                   /* median pause, in seconds */
+  double p90;                   /* 90th percentile pause, in seconds */
+  double p99;                   /* 99th percentile pause, in seconds */
+  double p999;                  /* 99.9th percentile pause, in seconds */
+} mps_pause_stats_s;
+
+
 /* Reference Ranks
  *
  * See protocol.mps.reference. */
 
 extern mps_rank_t mps_rank_ambig(void);
 extern mps_rank_t mps_rank_exact(void);
+extern mps_rank_t mps_rank_ephemeron(void);
 extern mps_rank_t mps_rank_weak(void);
 
 
@@ -313,6 +377,7 @@ extern mps_rank_t mps_rank_weak(void);
 #define MPS_RM_CONST      (((mps_rm_t)1<<0))
 #define MPS_RM_PROT       (((mps_rm_t)1<<1))
 #define MPS_RM_PROT_INNER (((mps_rm_t)1<<1))
+#define MPS_RM_INCREMENTAL (((mps_rm_t)1<<3))
 
 
 /* Allocation Point */
@@ -462,11 +527,39 @@ extern size_t mps_arena_spare_commit_limit(mps_arena_t);
 
 extern double mps_arena_pause_time(mps_arena_t);
 extern void mps_arena_pause_time_set(mps_arena_t, double);
+extern double mps_arena_spare_decay(mps_arena_t);
+extern void mps_arena_spare_decay_set(mps_arena_t, double);
+extern void mps_arena_pause_stats(mps_arena_t, mps_pause_kind_t,
+                                  mps_pause_stats_s *);
+extern double mps_arena_mmu(mps_arena_t, double);
+extern double mps_arena_mmu_target(mps_arena_t);
+extern double mps_arena_mmu_window(mps_arena_t);
+extern void mps_arena_mmu_target_set(mps_arena_t, double, double);
+extern double mps_arena_heap_growth(mps_arena_t);
+extern void mps_arena_heap_growth_set(mps_arena_t, double);
+extern size_t mps_arena_live_size(mps_arena_t);
+extern size_t mps_arena_memory_target(mps_arena_t);
+extern void mps_arena_memory_target_set(mps_arena_t, size_t);
+extern double mps_arena_memory_pressure(mps_arena_t);
+extern double mps_arena_idle_time(mps_arena_t);
+extern mps_res_t mps_arena_idle_time_set(mps_arena_t, double);
 
 extern mps_bool_t mps_arena_busy(mps_arena_t);
 extern mps_bool_t mps_arena_has_addr(mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_pool(mps_pool_t *, mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_fmt(mps_fmt_t *, mps_arena_t, mps_addr_t);
+extern mps_res_t mps_addr_hash(mps_word_t *, mps_arena_t, mps_addr_t);
+
+
+/* Allocation sampling */
+
+typedef void *(*mps_alloc_sampler_t)(mps_addr_t, size_t, mps_ap_t, void *);
+typedef void (*mps_sample_stepper_t)(mps_addr_t, void *, mps_bool_t,
+                                     void *, size_t);
+extern void mps_arena_sampler_set(mps_arena_t, size_t,
+                                  mps_alloc_sampler_t, void *);
+extern void mps_arena_samples_walk(mps_arena_t, mps_sample_stepper_t,
+                                   void *, size_t);
 
 /* Client memory arenas */
 extern mps_res_t mps_arena_extend(mps_arena_t, mps_addr_t, size_t);
@@ -727,6 +820,7 @@ extern void mps_ld_add(mps_ld_t, mps_arena_t, mps_addr_t);
 extern void mps_ld_merge(mps_ld_t, mps_arena_t, mps_ld_t);
 extern mps_bool_t mps_ld_isstale(mps_ld_t, mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_ld_isstale_any(mps_ld_t, mps_arena_t);
+extern mps_bool_t mps_ld_isstale_precise(mps_ld_t, mps_arena_t, mps_addr_t);
 
 extern mps_word_t mps_collections(mps_arena_t);
 
@@ -750,6 +844,8 @@ extern mps_clock_t mps_message_clock(mps_arena_t, mps_message_t);
 /* -- mps_message_type_finalization */
 extern void mps_message_finalization_ref(mps_addr_t *,
                                          mps_arena_t, mps_message_t);
+extern size_t mps_message_finalization_refs(mps_addr_t *,
+                                           mps_arena_t, size_t);
 
 /* -- mps_message_type_gc */
 extern size_t mps_message_gc_live_size(mps_arena_t, mps_message_t);
@@ -764,6 +860,7 @@ extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
 /* Finalization */
 
 extern mps_res_t mps_finalize(mps_arena_t, mps_addr_t *);
+extern mps_res_t mps_finalize_many(mps_arena_t, mps_addr_t *, size_t);
 extern mps_res_t mps_definalize(mps_arena_t, mps_addr_t *);
 
 
@@ -787,6 +884,41 @@ extern void mps_arena_formatted_objects_walk(mps_arena_t,
                                              mps_formatted_objects_stepper_t,
                                              void *, size_t);
 
+typedef void (*mps_walk_work_t)(void *, size_t);
+typedef void (*mps_walk_runner_t)(mps_walk_work_t, void *, size_t,
+                                  void *);
+extern mps_res_t mps_arena_formatted_objects_walk_parallel(mps_arena_t,
+                                                           mps_formatted_objects_stepper_t,
+                                                           void **, size_t,
+                                                           size_t,
+                                                           mps_walk_runner_t,
+                                                           void *);
+
+
+/* Heap Census */
+
+#define MPS_CENSUS_GEN_TOP ((size_t)-1)
+
+typedef void (*mps_census_stepper_t)(mps_pool_t, size_t, mps_addr_t,
+                                     size_t, size_t, void *, size_t);
+extern mps_res_t mps_arena_census(mps_arena_t, mps_census_stepper_t,
+                                  void *, size_t);
+
+
+/* Heap Images */
+
+typedef mps_res_t (*mps_image_write_t)(const void *, size_t, void *);
+typedef mps_res_t (*mps_image_read_t)(void *, size_t, void *);
+extern mps_res_t mps_pool_image_write(mps_pool_t, mps_image_write_t,
+                                      void *);
+extern mps_res_t mps_ap_image_read(mps_ap_t, mps_image_read_t, void *,
+                                   mps_addr_t *, size_t);
+
+
+/* Frozen Pools */
+
+extern mps_res_t mps_pool_freeze(mps_pool_t);
+
 
 /* Root Walking */
 
@@ -847,6 +979,14 @@ extern mps_res_t _mps_fix2(mps_ss_t, mps_addr_t *);
   (MPS_FIX1(ss, *(ref_io)) ? \
    MPS_FIX2(ss, ref_io) : MPS_RES_OK)
 
+extern mps_res_t _mps_fix_ephemeron(mps_ss_t, mps_addr_t *, mps_addr_t *);
+#define MPS_FIX_EPHEMERON(ss, key_io, value_io) \
+  (MPS_FIX1(ss, *(key_io)) ? \
+   ((void)MPS_FIX1(ss, *(value_io)), \
+    _mps_fix_ephemeron(ss, key_io, value_io)) : \
+   MPS_FIX1(ss, *(value_io)) ? \
+   _mps_fix_ephemeron(ss, key_io, value_io) : MPS_RES_OK)
+
 /* MPS_FIX is deprecated */
 #define MPS_FIX(ss, ref_io) MPS_FIX12(ss, ref_io)
 
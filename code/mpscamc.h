@@ -12,6 +12,10 @@
 extern mps_pool_class_t mps_class_amc(void);
 extern mps_pool_class_t mps_class_amcz(void);
 
+extern const struct mps_key_s _mps_key_AMC_PROMOTE_SURVIVAL;
+#define MPS_KEY_AMC_PROMOTE_SURVIVAL (&_mps_key_AMC_PROMOTE_SURVIVAL)
+#define MPS_KEY_AMC_PROMOTE_SURVIVAL_FIELD d
+
 typedef void (*mps_amc_apply_stepper_t)(mps_addr_t, void *, size_t);
 extern void mps_amc_apply(mps_pool_t, mps_amc_apply_stepper_t,
                           void *, size_t);
@@ -83,6 +83,15 @@ static Bool mpsi_check(void)
   CHECKL((int)MessageTypeGCSTART
          == (int)_mps_MESSAGE_TYPE_GC_START);
 
+  /* Check that external and internal pause kinds match. */
+  /* See <code/mps.h#pause.kinds> and */
+  /* <code/mpmtypes.h#pause.kinds>. */
+  CHECKL(COMPATTYPE(mps_pause_kind_t, PauseKind));
+  CHECKL((int)PauseKindPOLL == (int)MPS_PAUSE_POLL);
+  CHECKL((int)PauseKindFLIP == (int)MPS_PAUSE_FLIP);
+  CHECKL((int)PauseKindACCESS == (int)MPS_PAUSE_ACCESS);
+  CHECKL((int)PauseKindSTEP == (int)MPS_PAUSE_STEP);
+
   /* The external idea of a word width and the internal one */
   /* had better match.  See <design/interface-c/#cons>. */
   CHECKL(sizeof(mps_word_t) == sizeof(void *));
@@ -123,6 +132,11 @@ mps_rank_t mps_rank_exact(void)
   return RankEXACT;
 }
 
+mps_rank_t mps_rank_ephemeron(void)
+{
+  return RankEPHEMERON;
+}
+
 mps_rank_t mps_rank_weak(void)
 {
   return RankWEAK;
@@ -256,6 +270,212 @@ void mps_arena_pause_time_set(mps_arena_t arena, double pause_time)
   ArenaLeave(arena);
 }
 
+double mps_arena_spare_decay(mps_arena_t arena)
+{
+  double spare_decay;
+
+  ArenaEnter(arena);
+  spare_decay = ArenaSpareDecay(arena);
+  ArenaLeave(arena);
+
+  return spare_decay;
+}
+
+void mps_arena_spare_decay_set(mps_arena_t arena, double spare_decay)
+{
+  ArenaEnter(arena);
+  ArenaSetSpareDecay(arena, spare_decay);
+  ArenaLeave(arena);
+}
+
+
+/* mps_arena_pause_stats -- summarize the pauses of one kind
+ *
+ * See <design/arena/#pause>.
+ */
+
+void mps_arena_pause_stats(mps_arena_t arena, mps_pause_kind_t kind,
+                           mps_pause_stats_s *stats)
+{
+  PauseStats pauseStats;
+  double clocks_per_sec;
+
+  ArenaEnter(arena);
+
+  AVER(kind < PauseKindLIMIT);
+  AVER(stats != NULL);
+  pauseStats = ArenaPauseStats(arena);
+  clocks_per_sec = (double)ClocksPerSec();
+  stats->count = PauseStatsCount(pauseStats, kind);
+  stats->total = (double)PauseStatsTotal(pauseStats, kind) / clocks_per_sec;
+  stats->max = (double)PauseStatsMax(pauseStats, kind) / clocks_per_sec;
+  stats->p50 = (double)PauseStatsPercentile(pauseStats, kind, 0.5)
+    / clocks_per_sec;
+  stats->p90 = (double)PauseStatsPercentile(pauseStats, kind, 0.9)
+    / clocks_per_sec;
+  stats->p99 = (double)PauseStatsPercentile(pauseStats, kind, 0.99)
+    / clocks_per_sec;
+  stats->p999 = (double)PauseStatsPercentile(pauseStats, kind, 0.999)
+    / clocks_per_sec;
+
+  ArenaLeave(arena);
+}
+
+
+/* mps_arena_mmu_target -- get the MMU target for polling
+ *
+ * See <design/arena/#mmu>.
+ */
+
+double mps_arena_mmu_target(mps_arena_t arena)
+{
+  double mmu_target;
+
+  ArenaEnter(arena);
+  mmu_target = ArenaMMUTarget(arena);
+  ArenaLeave(arena);
+
+  return mmu_target;
+}
+
+double mps_arena_mmu_window(mps_arena_t arena)
+{
+  double mmu_window;
+
+  ArenaEnter(arena);
+  mmu_window = ArenaMMUWindow(arena);
+  ArenaLeave(arena);
+
+  return mmu_window;
+}
+
+void mps_arena_mmu_target_set(mps_arena_t arena, double mmu_target,
+                              double mmu_window)
+{
+  ArenaEnter(arena);
+  ArenaSetMMUTarget(arena, mmu_target, mmu_window);
+  ArenaLeave(arena);
+}
+
+
+/* mps_arena_heap_growth -- get the heap growth target
+ *
+ * See <design/strategy/#policy.growth>.
+ */
+
+double mps_arena_heap_growth(mps_arena_t arena)
+{
+  double heap_growth;
+
+  ArenaEnter(arena);
+  heap_growth = ArenaHeapGrowth(arena);
+  ArenaLeave(arena);
+
+  return heap_growth;
+}
+
+void mps_arena_heap_growth_set(mps_arena_t arena, double heap_growth)
+{
+  ArenaEnter(arena);
+  ArenaSetHeapGrowth(arena, heap_growth);
+  ArenaLeave(arena);
+}
+
+size_t mps_arena_live_size(mps_arena_t arena)
+{
+  Size size;
+
+  ArenaEnter(arena);
+  size = ArenaLiveSize(arena);
+  ArenaLeave(arena);
+
+  return (size_t)size;
+}
+
+
+/* mps_arena_memory_target -- get the soft memory target
+ *
+ * See <design/arena/#pressure>.
+ */
+
+size_t mps_arena_memory_target(mps_arena_t arena)
+{
+  Size target;
+
+  ArenaEnter(arena);
+  target = ArenaMemoryTarget(arena);
+  ArenaLeave(arena);
+
+  return (size_t)target;
+}
+
+void mps_arena_memory_target_set(mps_arena_t arena, size_t target)
+{
+  ArenaEnter(arena);
+  ArenaSetMemoryTarget(arena, target);
+  ArenaLeave(arena);
+}
+
+double mps_arena_memory_pressure(mps_arena_t arena)
+{
+  double pressure;
+
+  ArenaEnter(arena);
+  pressure = ArenaMemoryPressure(arena);
+  ArenaLeave(arena);
+
+  return pressure;
+}
+
+
+/* mps_arena_idle_time -- get the idle time
+ *
+ * See <design/arena/#idle>.
+ */
+
+double mps_arena_idle_time(mps_arena_t arena)
+{
+  double idleTime;
+
+  ArenaEnter(arena);
+  idleTime = ArenaIdleTime(arena);
+  ArenaLeave(arena);
+
+  return idleTime;
+}
+
+mps_res_t mps_arena_idle_time_set(mps_arena_t arena, double idle_time)
+{
+  Res res;
+
+  ArenaEnter(arena);
+  res = ArenaSetIdleTime(arena, idle_time);
+  ArenaLeave(arena);
+
+  return (mps_res_t)res;
+}
+
+
+/* mps_arena_mmu -- minimum mutator utilization over recent pauses */
+
+double mps_arena_mmu(mps_arena_t arena, double window)
+{
+  double mmu;
+  Clock clocks;
+
+  ArenaEnter(arena);
+
+  AVER(window > 0.0);
+  clocks = (Clock)(window * (double)ClocksPerSec());
+  if (clocks == 0)
+    clocks = 1;
+  mmu = PauseStatsMMU(ArenaPauseStats(arena), clocks);
+
+  ArenaLeave(arena);
+
+  return mmu;
+}
+
 
 void mps_arena_clamp(mps_arena_t arena)
 {
@@ -512,6 +732,55 @@ mps_bool_t mps_addr_fmt(mps_fmt_t *mps_fmt_o,
 }
 
 
+/* mps_addr_hash -- identity hash of a block
+ *
+ * See <design/arena/#hash>.
+ */
+
+mps_res_t mps_addr_hash(mps_word_t *hash_o, mps_arena_t arena,
+                        mps_addr_t addr)
+{
+  Word hash;
+  Res res;
+
+  AVER(hash_o != NULL);
+
+  ArenaEnter(arena);
+  res = IdHash(&hash, arena, (Addr)addr);
+  ArenaLeave(arena);
+
+  if (res != ResOK)
+    return (mps_res_t)res;
+  *hash_o = (mps_word_t)hash;
+  return MPS_RES_OK;
+}
+
+
+/* mps_arena_sampler_set -- set or clear the allocation sampler
+ *
+ * See <design/arena/#sample>.
+ */
+
+void mps_arena_sampler_set(mps_arena_t arena, size_t interval,
+                           mps_alloc_sampler_t sampler, void *p)
+{
+  ArenaEnter(arena);
+  SamplerSet(arena, (Size)interval, sampler, p);
+  ArenaLeave(arena);
+}
+
+
+/* mps_arena_samples_walk -- visit the allocation samples */
+
+void mps_arena_samples_walk(mps_arena_t arena, mps_sample_stepper_t f,
+                            void *p, size_t s)
+{
+  ArenaEnter(arena);
+  SamplesWalk(arena, f, p, s);
+  ArenaLeave(arena);
+}
+
+
 /* mps_fmt_create_k -- create an object format using keyword arguments */
 
 mps_res_t mps_fmt_create_k(mps_fmt_t *mps_fmt_o,
@@ -1728,6 +1997,27 @@ mps_bool_t mps_ld_isstale_any(mps_ld_t ld, mps_arena_t arena)
   return (mps_bool_t)b;
 }
 
+
+/* mps_ld_isstale_precise -- check whether a dependency on a block is stale
+ *
+ * Unlike mps_ld_isstale, this claims the arena lock, but only if the
+ * dependency is stale by zone.  */
+
+mps_bool_t mps_ld_isstale_precise(mps_ld_t ld, mps_arena_t arena,
+                                  mps_addr_t addr)
+{
+  Bool b;
+
+  if (!LDIsStaleAny(ld, arena))
+    return FALSE;
+
+  ArenaEnter(arena);
+  b = LDIsStalePrecise(ld, arena, (Addr)addr);
+  ArenaLeave(arena);
+
+  return (mps_bool_t)b;
+}
+
 mps_res_t mps_fix(mps_ss_t mps_ss, mps_addr_t *ref_io)
 {
   mps_res_t res;
@@ -1762,6 +2052,23 @@ mps_res_t mps_finalize(mps_arena_t arena, mps_addr_t *refref)
 }
 
 
+/* mps_finalize_many -- register several objects for finalization */
+
+mps_res_t mps_finalize_many(mps_arena_t arena, mps_addr_t *refs,
+                            size_t count)
+{
+  Res res;
+
+  ArenaEnter(arena);
+
+  AVER(refs != NULL);
+  res = ArenaFinalizeMany(arena, (Ref *)refs, count);
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
 /* mps_definalize -- deregister for finalization */
 
 mps_res_t mps_definalize(mps_arena_t arena, mps_addr_t *refref)
@@ -1917,6 +2224,23 @@ void mps_message_finalization_ref(mps_addr_t *mps_addr_return,
   ArenaLeave(arena);
 }
 
+size_t mps_message_finalization_refs(mps_addr_t *refs_o,
+                                     mps_arena_t arena, size_t count)
+{
+  Count got;
+
+  AVER(refs_o != NULL);
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  got = MessageFinalizationRefs((Ref *)refs_o, arena, count);
+
+  ArenaLeave(arena);
+
+  return got;
+}
+
 /* -- mps_message_type_gc */
 
 size_t mps_message_gc_live_size(mps_arena_t arena,
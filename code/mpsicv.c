@@ -8,6 +8,7 @@
 #include "testlib.h"
 #include "mpslib.h"
 #include "mpscamc.h"
+#include "mpscams.h"
 #include "mpsavm.h"
 #include "mpscmvff.h"
 #include "fmthe.h"
@@ -16,7 +17,7 @@
 #include "mps.h"
 #include "mpstd.h"
 
-#include <stdio.h> /* printf */
+#include <stdio.h> /* fclose, fopen, fprintf, printf, remove */
 
 
 #define exactRootsCOUNT  49
@@ -358,6 +359,267 @@ static void arena_commit_test(mps_arena_t arena)
 }
 
 
+/* arena_spare_decay_test
+ *
+ * intended to test:
+ *   MPS_KEY_SPARE_DECAY
+ *   mps_arena_spare_decay
+ *   mps_arena_spare_decay_set
+ *   mps_arena_step
+ * incidentally tests:
+ *   mps_alloc
+ *   mps_arena_spare_committed
+ *   mps_class_mvff
+ */
+
+#define spareDecayOBJECTS 256
+#define spareDecayTICK 1e-9     /* shorter than a clock tick */
+
+static void spare_decay_alloc(mps_arena_t arena, size_t objects)
+{
+  mps_pool_t pool;
+  void *p;
+  size_t i;
+
+  die(mps_pool_create_k(&pool, arena, mps_class_mvff(), mps_args_none),
+      "spare decay pool create");
+  for (i = 0; i < objects; ++i)
+    die(mps_alloc(&p, pool, FILLER_OBJECT_SIZE), "spare decay alloc");
+  mps_pool_destroy(pool);
+}
+
+static void arena_spare_decay_test(void)
+{
+  mps_arena_t arena;
+  mps_pool_t pool;
+  size_t spare_committed, lazy;
+  void *p;
+
+  /* By default, spare memory doesn't decay. */
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE, 1.0);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "spare decay arena create");
+  } MPS_ARGS_END(args);
+  Insist(mps_arena_spare_decay(arena) == 0.0);
+  spare_decay_alloc(arena, spareDecayOBJECTS);
+  spare_committed = mps_arena_spare_committed(arena);
+  Insist(spare_committed > 0);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == spare_committed);
+
+  /* The first step lazily frees the spare memory, which is still
+     committed; the second step unmaps it. */
+  mps_arena_spare_decay_set(arena, spareDecayTICK);
+  Insist(mps_arena_spare_decay(arena) == spareDecayTICK);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == spare_committed);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == 0);
+
+  /* Memory that becomes spare between the steps is not unmapped
+     along with its lazily freed neighbours. */
+  spare_decay_alloc(arena, spareDecayOBJECTS);
+  Insist(mps_arena_spare_committed(arena) > 0);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  die(mps_pool_create_k(&pool, arena, mps_class_mvff(), mps_args_none),
+      "spare decay pool create");
+  die(mps_alloc(&p, pool, FILLER_OBJECT_SIZE), "spare decay alloc");
+  lazy = mps_arena_spare_committed(arena);
+  Insist(lazy > 0);
+  mps_pool_destroy(pool);
+  spare_committed = mps_arena_spare_committed(arena);
+  Insist(spare_committed > lazy);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == spare_committed - lazy);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == 0);
+
+  mps_arena_spare_decay_set(arena, 1.5);
+  Insist(mps_arena_spare_decay(arena) == 1.5);
+  mps_arena_destroy(arena);
+}
+
+
+/* arena_pressure_test
+ *
+ * intended to test:
+ *   MPS_KEY_PRESSURE_PROBE
+ *   MPS_KEY_PRESSURE_CLOSURE
+ *   mps_arena_memory_pressure
+ *   mps_arena_memory_target
+ *   mps_arena_memory_target_set
+ * incidentally tests:
+ *   file_pressure_probe
+ *   mps_arena_step
+ *   mps_arena_spare_committed
+ */
+
+static char pressure_filename[] = "mpsicv.pressure";
+
+static void pressure_file_write(const char *contents)
+{
+  FILE *stream = fopen(pressure_filename, "w");
+  cdie(stream != NULL, "pressure file open");
+  cdie(fprintf(stream, "%s\n", contents) > 0, "pressure file write");
+  cdie(fclose(stream) == 0, "pressure file close");
+}
+
+static mps_arena_t pressure_arena_create(size_t *spareReturn)
+{
+  mps_arena_t arena;
+  mps_pool_t pool;
+  void *p;
+  size_t i;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE, 1.0);
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE_DECAY, 1000.0);
+    MPS_ARGS_ADD(args, MPS_KEY_PRESSURE_PROBE, file_pressure_probe);
+    MPS_ARGS_ADD(args, MPS_KEY_PRESSURE_CLOSURE, pressure_filename);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "pressure arena create");
+  } MPS_ARGS_END(args);
+
+  die(mps_pool_create_k(&pool, arena, mps_class_mvff(), mps_args_none),
+      "pressure pool create");
+  for (i = 0; i < spareDecayOBJECTS; ++i)
+    die(mps_alloc(&p, pool, FILLER_OBJECT_SIZE), "pressure alloc");
+  mps_pool_destroy(pool);
+  *spareReturn = mps_arena_spare_committed(arena);
+  return arena;
+}
+
+static void arena_pressure_test(void)
+{
+  mps_arena_t arena;
+  size_t spare_committed, committed;
+
+  /* A probe that finds no target leaves the client's target in
+     charge. */
+  pressure_file_write("max");
+  arena = pressure_arena_create(&spare_committed);
+  Insist(spare_committed > 0);
+  Insist(mps_arena_memory_target(arena) == 0);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_memory_pressure(arena) == 0.0);
+  Insist(mps_arena_spare_committed(arena) == spare_committed);
+
+  /* Low pressure keeps the spare memory. */
+  committed = mps_arena_committed(arena);
+  mps_arena_memory_target_set(arena, committed * 4);
+  Insist(mps_arena_memory_target(arena) == committed * 4);
+  Insist(mps_arena_memory_pressure(arena) > 0.0);
+  Insist(mps_arena_memory_pressure(arena) < 0.5);
+  Insist(mps_arena_spare_committed(arena) == spare_committed);
+
+  /* Pressure over 1.0 purges all of it. */
+  mps_arena_memory_target_set(arena, committed / 2);
+  Insist(mps_arena_spare_committed(arena) == 0);
+  Insist(mps_arena_memory_pressure(arena) > 0.0);
+
+  mps_arena_memory_target_set(arena, 0);
+  Insist(mps_arena_memory_pressure(arena) == 0.0);
+  mps_arena_destroy(arena);
+
+  /* A target from the probe has the same effect, as soon as the
+     arena polls. */
+  pressure_file_write("4096");
+  arena = pressure_arena_create(&spare_committed);
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(mps_arena_spare_committed(arena) == 0);
+  Insist(mps_arena_memory_pressure(arena) >= 1.0);
+  mps_arena_destroy(arena);
+
+  cdie(remove(pressure_filename) == 0, "pressure file remove");
+}
+
+
+/* arena_idle_test
+ *
+ * intended to test:
+ *   MPS_KEY_IDLE_TIME
+ *   mps_arena_idle_time
+ *   mps_arena_idle_time_set
+ *
+ * Nothing fills a buffer, so the idle timer should soon step the
+ * arena, which decays the spare memory just as an explicit
+ * mps_arena_step does in arena_spare_decay_test.
+ *
+ * The test keeps one collection of a non-moving pool in progress, so
+ * each idle step has work to do and posts a GC message when it
+ * finishes, and so the wait is bounded by the number of idle steps
+ * rather than by the wall clock.  Collecting the live object frees
+ * no memory, so the spare memory can only go down.
+ */
+
+#define idleTIME 0.001          /* idle time, in seconds */
+#define idleCOLLECTIONS 10      /* collections before spare must decay */
+
+static void arena_idle_test(void)
+{
+  mps_arena_t arena;
+  mps_fmt_t format;
+  mps_pool_t pool;
+  mps_ap_t idle_ap;
+  mps_root_t root;
+  mps_word_t obj;
+  mps_res_t res;
+  size_t collections = 0;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE, 1.0);
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE_DECAY, spareDecayTICK);
+    MPS_ARGS_ADD(args, MPS_KEY_IDLE_TIME, idleTIME);
+    res = mps_arena_create_k(&arena, mps_arena_class_vm(), args);
+  } MPS_ARGS_END(args);
+  if (res == MPS_RES_UNIMPL)
+    return; /* no background threads on this platform */
+  die(res, "idle arena create");
+  Insist(mps_arena_idle_time(arena) == idleTIME);
+
+  die(dylan_fmt(&format, arena), "idle format create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    die(mps_pool_create_k(&pool, arena, mps_class_ams(), args),
+        "idle pool create");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&idle_ap, pool, mps_args_none), "idle ap create");
+  die(make_dylan_vector(&obj, idle_ap, 1), "idle object");
+  die(mps_root_create_area(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                           &obj, &obj + 1, mps_scan_area, NULL),
+      "idle root create");
+
+  spare_decay_alloc(arena, spareDecayOBJECTS);
+  Insist(mps_arena_spare_committed(arena) > 0);
+
+  mps_message_type_enable(arena, mps_message_type_gc());
+  die(mps_arena_start_collect(arena), "idle collect");
+  while (mps_arena_spare_committed(arena) > 0) {
+    mps_message_t message;
+    if (mps_message_get(&message, arena, mps_message_type_gc())) {
+      mps_message_discard(arena, message);
+      ++collections;
+      Insist(collections < idleCOLLECTIONS);
+      die(mps_arena_start_collect(arena), "idle collect");
+    }
+  }
+
+  die(mps_arena_idle_time_set(arena, 0.0), "idle time set off");
+  Insist(mps_arena_idle_time(arena) == 0.0);
+  die(mps_arena_idle_time_set(arena, 1.5), "idle time set");
+  Insist(mps_arena_idle_time(arena) == 1.5);
+
+  mps_arena_park(arena);
+  mps_root_destroy(root);
+  mps_ap_destroy(idle_ap);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(arena);
+}
+
+
 static void *test(void *arg, size_t s)
 {
   mps_arena_t arena;
@@ -490,6 +752,12 @@ static void *test(void *arg, size_t s)
         cdie(exactRoots[r] == objNULL || dylan_check(exactRoots[r]),
              "all roots check");
       }
+      /* The precise check only ever removes false positives, and */
+      /* nothing outside the arena's segments can have moved. */
+      cdie(!mps_ld_isstale_precise(&ld, arena, obj)
+           || mps_ld_isstale(&ld, arena, obj), "mps_ld_isstale_precise");
+      cdie(!mps_ld_isstale_precise(&ld, arena, &ld),
+           "mps_ld_isstale_precise(not in arena)");
       if(collections == 1) {
         mps_arena_clamp(arena);
         clamp_until = i + 10000;
@@ -591,11 +859,16 @@ int main(int argc, char *argv[])
 
   testlib_init(argc, argv);
 
+  arena_spare_decay_test();
+  arena_pressure_test();
+  arena_idle_test();
+
   MPS_ARGS_BEGIN(args) {
     /* Randomize pause time as a regression test for job004011. */
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, rnd_pause_time());
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, TEST_ARENA_SIZE);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, rnd_double());
+    MPS_ARGS_ADD(args, MPS_KEY_ADAPT_CHAINS, rnd() % 2);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
         "arena_create");
   } MPS_ARGS_END(args);
@@ -131,24 +131,98 @@ found:
 }
 
 
-/* policyCollectionTime -- estimate time to collect the world, in seconds */
+/* policyCollectionRate -- estimate rate of collection, in bytes/second */
+
+static double policyCollectionRate(Arena arena)
+{
+  AVERT(Arena, arena);
+
+  /* The condition arena->tracedTime >= 1.0 ensures that the division
+   * can't overflow. */
+  if (arena->tracedTime >= 1.0)
+    return arena->tracedWork / arena->tracedTime;
+  else
+    return ARENA_DEFAULT_COLLECTION_RATE;
+}
+
+
+/* PolicyCalibrate -- calibrate the event clock against the plinth clock
+ *
+ * The cost model measures tracing with the event clock, which is
+ * cheap to read but has no known rate.  Call this with the plinth
+ * clock time and the event clock ticks of the same interval of
+ * tracing.  See <design/strategy/#policy.model.clock>.
+ */
+
+void PolicyCalibrate(Arena arena, Clock clocks, double ticks)
+{
+  AVERT(Arena, arena);
+  AVER(ticks >= 0.0);
+
+  arena->calibClocks += (double)clocks;
+  arena->calibTicks += ticks;
+  if (arena->calibClocks > ArenaCalibrateMEMORY * (double)ClocksPerSec()) {
+    arena->calibClocks /= 2.0;
+    arena->calibTicks /= 2.0;
+  }
+}
+
+
+/* policyTicksPerClock -- event clock ticks per plinth clock tick
+ *
+ * Return zero if the event clock has not been calibrated yet, in
+ * which case the cost model can't be used.
+ */
+
+static double policyTicksPerClock(Arena arena)
+{
+  AVERT(Arena, arena);
+
+  if (arena->calibClocks < ArenaCalibrateMIN * (double)ClocksPerSec()
+      || arena->calibTicks <= 0.0)
+    return 0.0;
+  return arena->calibTicks / arena->calibClocks;
+}
+
+
+/* policyCollectionTime -- estimate time to collect the world, in seconds
+ *
+ * If the event clock is calibrated, sum the predictions of the cost
+ * model for each generation.  See <design/strategy/#policy.model>.
+ * Otherwise, divide the collectable size by the overall collection
+ * rate.
+ */
 
 static double policyCollectionTime(Arena arena)
 {
   Size collectableSize;
   double collectionRate;
   double collectionTime;
+  double ticksPerClock;
   
   AVERT(Arena, arena);
 
-  collectableSize = ArenaCollectable(arena);
-  /* The condition arena->tracedTime >= 1.0 ensures that the division
-   * can't overflow. */
-  if (arena->tracedTime >= 1.0)
-    collectionRate = arena->tracedWork / arena->tracedTime;
-  else
-    collectionRate = ARENA_DEFAULT_COLLECTION_RATE;
-  collectionTime = collectableSize / collectionRate;
+  collectionRate = policyCollectionRate(arena);
+  ticksPerClock = policyTicksPerClock(arena);
+  if (ticksPerClock > 0.0) {
+    double ticksPerSec = ticksPerClock * (double)ClocksPerSec();
+    double defaultScanRate = ticksPerSec / collectionRate;
+    double ticks;
+    Ring node, nextNode;
+
+    ticks = GenDescCollectTicks(&arena->topGen, defaultScanRate);
+    RING_FOR(node, &arena->chainRing, nextNode) {
+      Chain chain = RING_ELT(Chain, chainRing, node);
+      Index i;
+      AVERT(Chain, chain);
+      for (i = 0; i < chain->genCount; ++i)
+        ticks += GenDescCollectTicks(&chain->gens[i], defaultScanRate);
+    }
+    collectionTime = ticks / ticksPerSec;
+  } else {
+    collectableSize = ArenaCollectable(arena);
+    collectionTime = collectableSize / collectionRate;
+  }
   collectionTime += ARENA_DEFAULT_COLLECTION_OVERHEAD;
 
   return collectionTime;
@@ -198,6 +272,125 @@ Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
 }
 
 
+/* policyHeapSize -- memory in use in the arena's generations
+ *
+ * If young is FALSE, leave out the new memory in generation zero of
+ * each chain, whose growth is limited by the chain's capacity. See
+ * <design/strategy/#policy.growth.start>.
+ */
+
+static Size policyHeapSize(Arena arena, Bool young)
+{
+  Ring node, nextNode;
+  Size size;
+
+  AVERT(Arena, arena);
+  AVERT(Bool, young);
+
+  size = GenDescUsedSize(&arena->topGen);
+  RING_FOR(node, &arena->chainRing, nextNode) {
+    Chain chain = RING_ELT(Chain, chainRing, node);
+    size_t i;
+    AVERT(Chain, chain);
+    for (i = 0; i < chain->genCount; ++i)
+      size += GenDescUsedSize(&chain->gens[i]);
+    if (!young)
+      size -= GenDescNewSize(&chain->gens[0]);
+  }
+  return size;
+}
+
+
+/* policyAdaptGen -- adapt the capacity of a generation to its cost
+ *
+ * Called for each generation condemned by a trace of a chain in an
+ * arena with adaptive chains. See <design/strategy/#policy.adapt>.
+ */
+
+static void policyAdaptGen(Trace trace, GenDesc gen, Clock maxPause)
+{
+  Arena arena;
+  GenTrace genTrace;
+  Size survived, condemned;
+  double pause, capacity, minCapacity, maxCapacity;
+
+  AVERT(Trace, trace);
+  AVERT(GenDesc, gen);
+
+  arena = trace->arena;
+  genTrace = &gen->trace[trace->ti];
+  condemned = genTrace->condemned;
+  if (condemned == 0)
+    return;
+  survived = genTrace->forwarded + genTrace->preservedInPlace;
+  pause = (double)maxPause / (double)ClocksPerSec();
+
+  capacity = (double)gen->capacity;
+  if (pause > arena->pauseTime)
+    capacity *= LocusAdaptSHRINK;
+  else if ((double)survived < (double)condemned * LocusAdaptSURVIVAL)
+    capacity *= LocusAdaptGROW;
+  else
+    return;
+
+  minCapacity = (double)gen->baseCapacity / LocusAdaptRANGE;
+  maxCapacity = (double)gen->baseCapacity * LocusAdaptRANGE;
+  if (capacity < minCapacity)
+    capacity = minCapacity;
+  if (capacity > maxCapacity)
+    capacity = maxCapacity;
+  if (capacity < 1.0 || (Size)capacity == gen->capacity)
+    return;
+
+  EVENT8(GenAdapt, arena, trace, gen, survived, condemned, pause,
+         gen->capacity, (Size)capacity);
+  GenDescSetCapacity(gen, (Size)capacity);
+}
+
+
+/* PolicyTraceEnd -- note the end of a trace
+ *
+ * Called when a trace has reclaimed its condemned memory, but before
+ * the generations it collected have been released. If the trace
+ * collected the world, or if the live size is not yet known, measure
+ * the live size. See <design/strategy/#policy.growth.live>. If the
+ * trace collected a chain and the arena's chains are adaptive, adapt
+ * the capacities of the generations it collected. See
+ * <design/strategy/#policy.adapt>.
+ */
+
+void PolicyTraceEnd(Trace trace)
+{
+  Arena arena;
+
+  AVERT(Trace, trace);
+  AVER(trace->state == TraceFINISHED);
+
+  arena = trace->arena;
+  if (TraceSetIsMember(arena->topGen.activeTraces, trace)
+      || arena->liveSize == 0)
+  {
+    arena->liveSize = policyHeapSize(arena, TRUE);
+    EVENT3(LiveSize, arena, trace, arena->liveSize);
+  }
+
+  if (arena->adaptChains && trace->why == TraceStartWhyCHAIN_GEN0CAP) {
+    /* Flips are not in the pause log, because they happen inside
+       other pauses, but a flip during mps_arena_step or
+       mps_arena_collect is a pause all the same. */
+    Clock maxPause = PauseStatsMaxSince(ArenaPauseStats(arena),
+                                        trace->startTime);
+    Ring node, nextNode;
+    if (trace->flipPause > maxPause)
+      maxPause = trace->flipPause;
+    RING_FOR(node, &trace->genRing, nextNode) {
+      GenDesc gen = GenDescOfTraceRing(node, trace);
+      policyAdaptGen(trace, gen, maxPause);
+    }
+  }
+}
+
+
 /* policyCondemnChain -- condemn approriate parts of this chain
  *
  * If successful, set *mortalityReturn to an estimate of the mortality
@@ -230,10 +423,27 @@ static Res policyCondemnChain(double *mortalityReturn, Chain chain, Trace trace)
     -- topCondemnedGen;
     gen = &chain->gens[topCondemnedGen];
     AVERT(GenDesc, gen);
-    if (GenDescNewSize(gen) >= gen->capacity)
+    if (GenDescNewSize(gen) >= ChainCapacity(chain, topCondemnedGen))
       break;
   }
 
+  /* In an adaptive chain, also condemn the next generation if the
+   * survivors of this collection are predicted to fill it, so as not
+   * to have to collect it straight afterwards. See
+   * <design/strategy/#policy.adapt.condemn>. */
+  if (chain->arena->adaptChains) {
+    while (topCondemnedGen + 1 < chain->genCount) {
+      GenDesc next = &chain->gens[topCondemnedGen + 1];
+      double survivors;
+      gen = &chain->gens[topCondemnedGen];
+      survivors = (double)GenDescNewSize(gen) * (1.0 - gen->mortality);
+      if ((double)GenDescNewSize(next) + survivors
+          < (double)ChainCapacity(chain, topCondemnedGen + 1))
+        break;
+      ++ topCondemnedGen;
+    }
+  }
+
   /* At this point, we've decided to condemn topCondemnedGen and all
    * lower generations. */
   TraceCondemnStart(trace);
@@ -248,6 +458,40 @@ static Res policyCondemnChain(double *mortalityReturn, Chain chain, Trace trace)
 }
 
 
+/* policyStartWorld -- start a collection of the world
+ *
+ * Condemn everything and start the trace, paced as for a chain so
+ * that it finishes before the heap has grown much further.  Used by
+ * the heap growth target and by memory pressure, which unlike the
+ * dynamic criterion must not wait for the arena to run short of
+ * memory.  Return TRUE if a trace was started.
+ */
+
+static Bool policyStartWorld(Trace *traceReturn, Arena arena,
+                             TraceStartWhy why, double workFactor)
+{
+  Res res;
+  Trace trace;
+  double mortality;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(workFactor >= 0.0);
+
+  res = TraceCreate(&trace, arena, why);
+  AVER(res == ResOK);
+  res = TraceCondemnAll(&mortality, trace);
+  if (res != ResOK || TraceIsEmpty(trace)) {
+    TraceDestroyInit(trace);
+    return FALSE;
+  }
+  res = TraceStart(trace, mortality, trace->condemned * workFactor);
+  AVER(res == ResOK);
+  *traceReturn = trace;
+  return TRUE;
+}
+
+
 /* PolicyStartTrace -- consider starting a trace
  *
  * If collectWorldAllowed is TRUE, consider starting a collection of
@@ -301,6 +545,37 @@ Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
       *traceReturn = trace;
       return TRUE;
     }
+
+    /* Has the heap grown past its target over the live size? See
+       <design/strategy/#policy.growth.start>. */
+    if (arena->heapGrowth > 0.0 && arena->liveSize > 0) {
+      double heapGoal = (double)arena->liveSize
+        * (1.0 + arena->heapGrowth / 100.0);
+      if (heapGoal < (double)ARENA_MINIMUM_COLLECTABLE_SIZE)
+        heapGoal = (double)ARENA_MINIMUM_COLLECTABLE_SIZE;
+      if ((double)policyHeapSize(arena, FALSE) > heapGoal
+          && policyStartWorld(&trace, arena, TraceStartWhyHEAPGROWTH,
+                              TraceWorkFactor))
+      {
+        *collectWorldReturn = TRUE;
+        *traceReturn = trace;
+        return TRUE;
+      }
+    }
+
+    /* Has committed memory reached the soft target? See
+       <design/arena/#pressure.collect>. */
+    if (arena->pressure >= 1.0
+        && (arena->liveSize == 0
+            || (double)policyHeapSize(arena, FALSE)
+               > (double)arena->liveSize * ArenaPressureREGROW)
+        && policyStartWorld(&trace, arena, TraceStartWhyMEMORYPRESSURE,
+                            TraceWorkFactor))
+    {
+      *collectWorldReturn = TRUE;
+      *traceReturn = trace;
+      return TRUE;
+    }
   }
   {
     /* Find the chain most over its capacity. */
@@ -347,10 +622,56 @@ failStart:
 }
 
 
+/* policyMMUPaced -- is polling paced to meet the MMU target?
+ *
+ * Pacing is abandoned in an emergency, and when the mutator has
+ * allocated so far ahead of the collector that the collection might
+ * not finish in time.  See <design/arena/#mmu.debt>.
+ */
+
+static Bool policyMMUPaced(Arena arena)
+{
+  Globals globals = ArenaGlobals(arena);
+
+  return ArenaMMUTarget(arena) > 0.0
+    && !ArenaEmergency(arena)
+    && (globals->fillMutatorSize - globals->pollThreshold
+        + globals->pollDebt) < ArenaPollDEBTMAX;
+}
+
+
+/* policyMMUSlack -- collection time left in the MMU window
+ *
+ * Return the time, in clocks, that polling may still spend collecting
+ * in the window that ends now, if the mutator is to get its target
+ * share of that window.  busy is the time taken so far by the poll in
+ * progress, which is not yet in the pause log.  See <design/arena/#mmu>.
+ */
+
+static double policyMMUSlack(Arena arena, Clock now, Clock busy)
+{
+  double window, budget;
+  Clock since, spent;
+
+  window = ArenaMMUWindow(arena) * (double)ClocksPerSec();
+  budget = (1.0 - ArenaMMUTarget(arena)) * window;
+  since = (double)now > window ? now - (Clock)window : 0;
+  spent = PauseStatsSince(ArenaPauseStats(arena), since) + busy;
+  return budget - (double)spent;
+}
+
+
 /* PolicyPoll -- do some tracing work?
  *
  * Return TRUE if the MPS should do some tracing work; FALSE if it
  * should return to the mutator.
+ *
+ * If the MMU window has no collection time left, the poll is put off,
+ * even though the mutator has allocated enough to pay for some work.
+ * The poll threshold is advanced, so that the window is checked again
+ * only after another poll interval of allocation, and the allocation
+ * that was due for work is recorded as debt, which is paid by later
+ * polls.  See <design/arena/#mmu.defer>.
  */
 
 Bool PolicyPoll(Arena arena)
@@ -358,7 +679,57 @@ Bool PolicyPoll(Arena arena)
   Globals globals;
   AVERT(Arena, arena);
   globals = ArenaGlobals(arena);
-  return globals->pollThreshold <= globals->fillMutatorSize;
+  if (globals->pollThreshold > globals->fillMutatorSize)
+    return FALSE;
+  if (policyMMUPaced(arena) && policyMMUSlack(arena, ClockNow(), 0) <= 0.0) {
+    double next = globals->fillMutatorSize + ArenaPollALLOCTIME;
+    globals->pollDebt += next - globals->pollThreshold;
+    globals->pollThreshold = next;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+
+/* policyStepTime -- predict the time of the next step of a trace
+ *
+ * Return the predicted time, in plinth clock ticks, of the next call
+ * to TracePoll for the trace: a quantum of scanning at the rate
+ * measured so far in this trace, or reclaiming the condemned
+ * generations at their measured rates.  Return zero if there is no
+ * prediction.  See <design/strategy/#policy.model.pause>.
+ */
+
+static double policyStepTime(Arena arena, Trace trace)
+{
+  double ticksPerClock, ticks = 0.0;
+
+  AVERT(Arena, arena);
+  AVERT(Trace, trace);
+
+  ticksPerClock = policyTicksPerClock(arena);
+  if (ticksPerClock <= 0.0)
+    return 0.0;
+
+  switch (trace->state) {
+  case TraceFLIPPED:
+    if (trace->segScanSize > 0)
+      ticks = (double)trace->quantumWork * trace->segScanTicks
+        / (double)trace->segScanSize;
+    break;
+  case TraceRECLAIM: {
+    Ring node, nextNode;
+    RING_FOR(node, &trace->genRing, nextNode) {
+      GenDesc gen = GenDescOfTraceRing(node, trace);
+      ticks += GenDescReclaimRate(gen)
+        * (double)gen->trace[trace->ti].condemned;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return ticks / ticksPerClock;
 }
 
 
@@ -375,16 +746,38 @@ Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
 {
   Bool moreTime;
   Globals globals;
-  double nextPollThreshold;
+  double nextPollThreshold, stepTime;
+  Clock now;
 
   AVERT(Arena, arena);
-  UNUSED(tracedWork);
 
   if (ArenaEmergency(arena))
     return TRUE;
 
   /* Is there more work to do and more time to do it in? */
-  moreTime = (ClockNow() - start) < ArenaPauseTime(arena) * ClocksPerSec();
+  now = ClockNow();
+  moreTime = (now - start) < ArenaPauseTime(arena) * ClocksPerSec();
+
+  /* Will the next step fit in the pause?
+     <design/strategy/#policy.model.pause> */
+  stepTime = 0.0;
+  if (moreWork && moreTime && arena->busyTraces != TraceSetEMPTY) {
+    stepTime = policyStepTime(arena, ArenaTrace(arena, (TraceId)0));
+    if (stepTime > 0.0)
+      moreTime = (double)(now - start) + stepTime
+        < ArenaPauseTime(arena) * (double)ClocksPerSec();
+  }
+
+  /* If pacing to the MMU target, is there time for another quantum
+     like the last one in the MMU window?  <design/arena/#mmu.quantum> */
+  if (moreWork && moreTime && policyMMUPaced(arena)) {
+    double quantumTime = stepTime;
+    if (quantumTime <= 0.0)
+      quantumTime = tracedWork / policyCollectionRate(arena)
+        * (double)ClocksPerSec();
+    moreTime = policyMMUSlack(arena, now, now - start) > quantumTime;
+  }
+
   if (moreWork && moreTime)
     return TRUE;
 
@@ -393,11 +786,20 @@ Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
   globals = ArenaGlobals(arena);
 
   if (moreWork) {
-    /* We did one quantum of work; consume one unit of 'time'. */
-    nextPollThreshold = globals->pollThreshold + ArenaPollALLOCTIME;
+    /* We did one quantum of work; consume one unit of 'time', paying
+       off the debt from deferred polls first.
+       <design/arena/#mmu.defer> */
+    if (globals->pollDebt >= ArenaPollALLOCTIME) {
+      globals->pollDebt -= ArenaPollALLOCTIME;
+      return FALSE;
+    }
+    nextPollThreshold = globals->pollThreshold + ArenaPollALLOCTIME
+      - globals->pollDebt;
+    globals->pollDebt = 0.0;
   } else {
     /* No more work to do.  Sleep until NOW + a bit. */
     nextPollThreshold = globals->fillMutatorSize + ArenaPollALLOCTIME;
+    globals->pollDebt = 0.0;
   }
 
   /* Advance pollThreshold; check: enough precision? */
@@ -95,6 +95,7 @@ Bool PoolCheck(Pool pool)
   CHECKL(pool->alignment == PoolGrainsSize(pool, (Align)1));
   if (pool->format != NULL)
     CHECKD(Format, pool->format);
+  CHECKL(BoolCheck(pool->frozen));
   return TRUE;
 }
 
@@ -113,6 +114,7 @@ ARG_DEFINE_KEY(MAX_SIZE, Size);
 ARG_DEFINE_KEY(ALIGN, Align);
 ARG_DEFINE_KEY(SPARE, double);
 ARG_DEFINE_KEY(INTERIOR, Bool);
+ARG_DEFINE_KEY(ZEROED, Bool);
 
 
 /* PoolInit -- initialize a pool
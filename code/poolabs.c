@@ -89,6 +89,7 @@ Res PoolAbsInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   pool->alignment = MPS_PF_ALIGN;
   pool->alignShift = SizeLog2(pool->alignment);
   pool->format = NULL;
+  pool->frozen = FALSE;
 
   if (ArgPick(&arg, args, MPS_KEY_FORMAT)) {
     Format format = arg.val.format;
@@ -339,6 +340,7 @@ Res PoolAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                (WriteFP)pool->arena, (WriteFU)pool->arena->serial,
                "alignment $W\n", (WriteFW)pool->alignment,
                "alignShift $W\n", (WriteFW)pool->alignShift,
+               "frozen $S\n", WriteFYesNo(pool->frozen),
                NULL);
   if (res != ResOK)
     return res;
@@ -34,6 +34,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO);
 static Res amcSegFixEmergency(Seg seg, ScanState ss, Ref *refIO);
 static void amcSegWalk(Seg seg, Format format, FormattedObjectsVisitor f,
                        void *p, size_t s);
+static void amcSegForgetHashes(Seg seg, Addr base, Addr limit);
 
 /* local class declations */
 
@@ -99,6 +100,15 @@ enum {
  * collection via TracePoll), and by hash array allocations (where we
  * don't want the allocation to provoke a collection that makes the
  * location dependency stale immediately).
+ *
+ * .seg.promoted: The "promoted" flag is TRUE if the segment was
+ * chosen at condemn time to be promoted in place rather than
+ * evacuated. See <design/poolamc/#promote>.
+ *
+ * .seg.slice: If "scanTraces" is not empty, the segment is part way
+ * through a scan in slices for those traces, and "scanned" is the
+ * limit of the slices scanned so far. See
+ * <design/poolamc/#seg-scan.slice>.
  */
 
 typedef struct amcSegStruct *amcSeg;
@@ -113,6 +123,9 @@ typedef struct amcSegStruct {
   BOOLFIELD(accountedAsBuffered); /* .seg.accounted-as-buffered */
   BOOLFIELD(old);           /* .seg.old */
   BOOLFIELD(deferred);      /* .seg.deferred */
+  BOOLFIELD(promoted);      /* .seg.promoted */
+  TraceSet scanTraces;      /* .seg.slice */
+  Addr scanned;             /* .seg.slice */
   Sig sig;                  /* <code/misc.h#sig> */
 } amcSegStruct;
 
@@ -127,9 +140,15 @@ static Bool amcSegCheck(amcSeg amcseg)
     CHECKD(Nailboard, amcseg->board);
     CHECKL(SegNailed(MustBeA(Seg, amcseg)) != TraceSetEMPTY);
   }
+  CHECKL(!amcseg->promoted || amcseg->board != NULL);
+  CHECKL(TraceSetCheck(amcseg->scanTraces));
+  CHECKL(amcseg->scanTraces == TraceSetEMPTY
+         || (SegBase(MustBeA(Seg, amcseg)) < amcseg->scanned
+             && amcseg->scanned < SegLimit(MustBeA(Seg, amcseg))));
   /* CHECKL(BoolCheck(amcseg->accountedAsBuffered)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->old)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->deferred)); <design/type/#bool.bitfield.check> */
+  /* CHECKL(BoolCheck(amcseg->promoted)); <design/type/#bool.bitfield.check> */
   return TRUE;
 }
 
@@ -160,6 +179,9 @@ static Res AMCSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   amcseg->accountedAsBuffered = FALSE;
   amcseg->old = FALSE;
   amcseg->deferred = FALSE;
+  amcseg->promoted = FALSE;
+  amcseg->scanTraces = TraceSetEMPTY;
+  amcseg->scanned = base;
 
   SetClassOfPoly(seg, CLASS(amcSeg));
   amcseg->sig = amcSegSig;
@@ -190,6 +212,7 @@ static void amcSegFinish(Inst inst)
  *
  * A typical sketch is "bGW_", meaning the seg has a nailboard, has
  * some Grey and some White objects, and has no buffer attached.
+ * A promoted segment is sketched "p" rather than "b".
  */
 
 static void AMCSegSketch(Seg seg, char *pbSketch, size_t cbSketch)
@@ -201,6 +224,8 @@ static void AMCSegSketch(Seg seg, char *pbSketch, size_t cbSketch)
 
   if(SegNailed(seg) == TraceSetEMPTY) {
     pbSketch[0] = 'm';  /* mobile */
+  } else if (MustBeA(amcSeg, seg)->promoted) {
+    pbSketch[0] = 'p';  /* promoted */
   } else if (amcSegHasNailboard(seg)) {
     pbSketch[0] = 'b';  /* boarded */
   } else {
@@ -285,7 +310,9 @@ static Res AMCSegDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   p = AddrAdd(base, pool->format->headerSize);
   limit = SegLimit(seg);
 
-  if (amcSegHasNailboard(seg)) {
+  if (amcseg->promoted) {
+    res = WriteF(stream, depth + 2, "Promoted\n", NULL);
+  } else if (amcSegHasNailboard(seg)) {
     res = WriteF(stream, depth + 2, "Boarded\n", NULL);
   } else if (SegNailed(seg) == TraceSetEMPTY) {
     res = WriteF(stream, depth + 2, "Mobile\n", NULL);
@@ -348,6 +375,22 @@ static Res AMCSegDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* amcSegSetGrey -- change the greyness of an AMC segment
+ *
+ * A scan in slices is abandoned if the segment stops being grey for
+ * any of the traces it was for. See <design/poolamc/#seg-scan.slice>.
+ */
+
+static void amcSegSetGrey(Seg seg, TraceSet grey)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+
+  NextMethod(Seg, amcSeg, setGrey)(seg, grey);
+  if (!TraceSetSub(amcseg->scanTraces, grey))
+    amcseg->scanTraces = TraceSetEMPTY;
+}
+
+
 /* amcSegClass -- Class definition for AMC segments */
 
 DEFINE_CLASS(Seg, amcSeg, klass)
@@ -358,6 +401,7 @@ DEFINE_CLASS(Seg, amcSeg, klass)
   klass->instClassStruct.finish = amcSegFinish;
   klass->size = sizeof(amcSegStruct);
   klass->init = AMCSegInit;
+  klass->setGrey = amcSegSetGrey;
   klass->bufferEmpty = amcSegBufferEmpty;
   klass->whiten = amcSegWhiten;
   klass->scan = amcSegScan;
@@ -422,6 +466,8 @@ typedef struct AMCStruct { /* <design/poolamc/#struct> */
   amcPinnedFunction pinned; /* function determining if block is pinned */
   Size extendBy;           /* segment size to extend pool by */
   Size largeSize;          /* min size of "large" segments */
+  double promoteSurvival;  /* <design/poolamc/#promote.survival> */
+  Bool zeroed;             /* <design/poolamc/#zeroed> */
   Sig sig;                 /* <design/pool/#outer-structure.sig> */
 } AMCStruct;
 
@@ -712,6 +758,9 @@ static void AMCVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
  * See <design/poolamc/#init>.
  * Shared by AMCInit and AMCZinit.
  */
+
+ARG_DEFINE_KEY(AMC_PROMOTE_SURVIVAL, double);
+
 static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
                        RankSet rankSet, ArgList args)
 {
@@ -724,6 +773,8 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   Chain chain;
   Size extendBy = AMC_EXTEND_BY_DEFAULT;
   Size largeSize = AMC_LARGE_SIZE_DEFAULT;
+  double promoteSurvival = AMC_PROMOTE_SURVIVAL_DEFAULT;
+  Bool zeroed = AMC_ZEROED_DEFAULT;
   ArgStruct arg;
 
   AVER(pool != NULL);
@@ -742,6 +793,10 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
     extendBy = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_LARGE_SIZE))
     largeSize = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_PROMOTE_SURVIVAL))
+    promoteSurvival = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_ZEROED))
+    zeroed = arg.val.b;
 
   AVERT(Chain, chain);
   AVER(chain->arena == arena);
@@ -752,6 +807,15 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
    * unacceptable fragmentation due to the padding objects. This
    * assertion catches this bad case. */
   AVER(largeSize >= extendBy);
+  AVER(promoteSurvival >= 0.0);
+  AVERT(Bool, zeroed);
+  /* Zeroed allocation needs buffers with no rank. A flip between
+     reserve and commit makes the commit on a ranked buffer fail, and
+     the next reserve returns the same memory, already written by the
+     client, without the pool being told.
+     <design/poolamc/#zeroed.leaf> */
+  if (zeroed && rankSet != RankSetEMPTY)
+    return ResPARAM;
 
   res = NextMethod(Pool, AMCZPool, init)(pool, arena, klass, args);
   if (res != ResOK)
@@ -785,6 +849,8 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   /* .extend-by.aligned: extendBy is aligned to the arena alignment. */
   amc->extendBy = SizeArenaGrains(extendBy, arena);
   amc->largeSize = largeSize;
+  amc->promoteSurvival = promoteSurvival;
+  amc->zeroed = zeroed;
 
   SetClassOfPoly(pool, klass);
   amc->sig = AMCSig;
@@ -817,6 +883,8 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   amc->rampGen = amc->gen[genCount-1]; /* last ephemeral gen */
   amc->afterRampGen = amc->gen[genCount];
   amc->gensBooted = TRUE;
+  if (zeroed)
+    ++arena->zeroedPools;
 
   AVERT(AMC, amc);
   if(rankSet == RankSetEMPTY)
@@ -875,6 +943,8 @@ static void AMCFinish(Inst inst)
     BufferDetach(gen->forward, pool);
   }
 
+  IdHashForgetPool(PoolArena(pool), pool); /* <design/poolamc/#hash> */
+
   ring = PoolSegRing(pool);
   RING_FOR(node, ring, nextNode) {
     Seg seg = SegOfPoolRing(node);
@@ -901,6 +971,12 @@ static void AMCFinish(Inst inst)
     amcGenDestroy(gen);
   }
 
+  if (amc->zeroed) {
+    Arena arena = PoolArena(pool);
+    AVER(arena->zeroedPools > 0);
+    --arena->zeroedPools;
+  }
+
   amc->sig = SigInvalid;
 
   NextMethod(Inst, AMCZPool, finish)(inst);
@@ -969,6 +1045,12 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
 
   base = SegBase(seg);
+
+  /* Only the mutator sees uninitialized memory: forwarding buffers
+   * are filled by copying.  See <design/poolamc/#zeroed.fill>. */
+  if (amc->zeroed && BufferIsMutator(buffer))
+    ArenaZero(arena, base, SegLimit(seg));
+
   if (size < amc->largeSize) {
     /* Small or Medium segment: give the buffer the entire seg. */
     limit = AddrAdd(base, grainsSize);
@@ -1073,6 +1155,69 @@ static void AMCRampBegin(Pool pool, Buffer buf, Bool collectAll)
 }
 
 
+/* AMCFramePush -- push an allocation frame
+ *
+ * The frame pointer is the limit of initialized objects in the
+ * buffer, or NULL if the buffer has no segment. See
+ * <design/poolamc/#frame>.
+ */
+
+static Res AMCFramePush(AllocFrame *frameReturn, Pool pool, Buffer buf)
+{
+  AVER(frameReturn != NULL);
+  AVERT(Pool, pool);
+  AVERT(Buffer, buf);
+  AVER(BufferIsMutator(buf));
+
+  if (BufferIsReset(buf))
+    *frameReturn = NULL;
+  else
+    *frameReturn = (AllocFrame)BufferGetInit(buf);
+  return ResOK;
+}
+
+
+/* AMCFramePop -- pop an allocation frame
+ *
+ * If the frame pointer lies between the base of the buffer and the
+ * limit of initialized objects, and the buffer has not been flipped,
+ * then every object allocated since the frame was pushed is in the
+ * buffer and has not been seen by the collector, so we reclaim them
+ * immediately by resetting the buffer's allocation pointer.
+ * Otherwise the objects are left for the collector. See
+ * <design/poolamc/#frame.pop>.
+ */
+
+static Res AMCFramePop(Pool pool, Buffer buf, AllocFrame frame)
+{
+  AMC amc = MustBeA(AMCZPool, pool);
+  Addr addr = (Addr)frame;
+
+  AVERT(Pool, pool);
+  AVERT(Buffer, buf);
+  AVER(BufferIsMutator(buf));
+  /* frame is an Addr and can't be directly checked */
+
+  if (!BufferIsReset(buf)
+      && (buf->mode & BufferModeFLIPPED) == 0
+      && BufferBase(buf) <= addr
+      && addr <= BufferGetInit(buf))
+  {
+    /* The popped objects are dead, so forget their hashes before
+     * their memory is handed out again. See <design/poolamc/#hash>. */
+    Seg seg = BufferSeg(buf);
+    if (SegHashed(seg))
+      amcSegForgetHashes(seg, addr, BufferGetInit(buf));
+    /* The popped objects will be handed out again by reserve: see
+     * <design/poolamc/#zeroed.frame>. */
+    if (amc->zeroed)
+      (void)AddrSet(addr, 0, AddrOffset(addr, BufferGetInit(buf)));
+    BufferSetAllocAddr(buf, addr);
+  }
+  return ResOK;
+}
+
+
 /* AMCRampEnd -- note an exit from a ramp pattern */
 
 static void AMCRampEnd(Pool pool, Buffer buf)
@@ -1139,6 +1284,43 @@ static PoolGen amcSegPoolGen(Pool pool, Seg seg)
 }
 
 
+/* amcSegPromote -- decide whether to promote a segment in place
+ *
+ * Called by amcSegWhiten. Promotion in place is off if the pool's
+ * promoteSurvival threshold is above 1.0, as it is by default.
+ * Otherwise, a segment is promoted in place if it is large
+ * (evacuating it would copy an object the size of the segment), or
+ * if the measured survival rate of its generation is at least the
+ * threshold (evacuating it would probably copy most of the segment).
+ * Buffered, nailed and deferred segments are never promoted. If the
+ * nailboard can't be created, the segment is evacuated as usual.
+ *
+ * See <design/poolamc/#promote>.
+ */
+static void amcSegPromote(Seg seg, Trace trace)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  AMC amc = MustBeA(AMCZPool, SegPool(seg));
+  GenDesc gen = amcseg->gen->pgen.gen;
+  Res res;
+
+  if (amc->promoteSurvival > 1.0)
+    return;
+  if (SegHasBuffer(seg) || SegNailed(seg) != TraceSetEMPTY
+      || amcseg->deferred)
+    return;
+  if (SegSize(seg) < amc->largeSize
+      && 1.0 - gen->mortality < amc->promoteSurvival)
+    return;
+
+  res = amcSegCreateNailboard(seg);
+  if (res != ResOK)
+    return;
+  SegSetNailed(seg, TraceSetSingle(trace));
+  amcseg->promoted = TRUE;
+}
+
+
 /* amcSegWhiten -- condemn the segment for the trace
  *
  * If the segment has a mutator buffer on it, we nail the buffer,
@@ -1232,6 +1414,8 @@ static Res amcSegWhiten(Seg seg, Trace trace)
       PoolGenAccountForAge(&gen->pgen, 0, SegSize(seg), amcseg->deferred);
   }
 
+  amcSegPromote(seg, trace);
+
   amcseg->forwarded[trace->ti] = 0;
   SegSetWhite(seg, TraceSetAdd(SegWhite(seg), trace));
   GenDescCondemned(gen->pgen.gen, trace, condemned + SegSize(seg));
@@ -1363,7 +1547,9 @@ static Res amcSegScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
   if(loops > 1) {
     RefSet refset;
 
-    AVER(ArenaEmergency(PoolArena(pool)));
+    /* Only emergency fixing or promotion in place nail objects in */
+    /* a segment while it is being scanned. */
+    AVER(ArenaEmergency(PoolArena(pool)) || MustBeA(amcSeg, seg)->promoted);
 
     /* Looped: fixed refs (from 1st pass) were seen by MPS_FIX1
      * (in later passes), so the "ss.unfixedSummary" is _not_
@@ -1388,6 +1574,79 @@ static Res amcSegScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
 }
 
 
+/* amcSegScanSlice -- scan the next slice of a large segment
+ *
+ * Scans at most ss->sliceSize bytes of the object at the start of the
+ * segment, resuming where the previous slice for the same traces left
+ * off. If the object is not finished, sets ss->unfinished so that the
+ * segment stays grey. See <design/poolamc/#seg-scan.slice>.
+ */
+static Res amcSegScanSlice(Bool *totalReturn, ScanState ss, Seg seg,
+                           Format format)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  Addr object, objLimit, base, limit;
+  Bool fromStart;
+  Res res;
+
+  object = AddrAdd(SegBase(seg), format->headerSize);
+  objLimit = AddrSub((*format->skip)(object), format->headerSize);
+  AVER(objLimit <= SegLimit(seg));
+
+  if (amcseg->scanTraces == ss->traces) {
+    base = amcseg->scanned;
+    fromStart = FALSE;
+  } else {
+    base = SegBase(seg);
+    fromStart = TRUE;
+  }
+  AVER(base < objLimit);
+  amcseg->scanTraces = TraceSetEMPTY;
+
+  limit = AddrAdd(base, ss->sliceSize);
+  if (limit < objLimit) {
+    res = FormatScanSlice(format, ss, object, base, limit);
+    if (res != ResOK) {
+      *totalReturn = FALSE;
+      return res;
+    }
+    amcseg->scanTraces = ss->traces;
+    amcseg->scanned = limit;
+    ss->unfinished = TRUE;
+    *totalReturn = FALSE;
+    return ResOK;
+  }
+
+  res = FormatScanSlice(format, ss, object, base, objLimit);
+  if (res == ResOK && objLimit < SegLimit(seg)) {
+    if (amcSegHasNailboard(seg)) {
+      /* Promoted in place: only scan the nailed objects after the
+       * large one. See <design/poolamc/#promote.scan>. */
+      AMC amc = MustBeA(AMCZPool, SegPool(seg));
+      Nailboard board = amcSegNailboard(seg);
+      Bool total, more;
+      size_t loops = 0;
+      do {
+        NailboardClearNewNails(board);
+        res = amcSegScanNailedRange(&total, &more, ss, amc, board,
+                                    objLimit, SegLimit(seg));
+        ++loops;
+      } while (res == ResOK && NailboardNewNails(board));
+      /* The unfixed summary isn't accurate after a second pass: see */
+      /* amcSegScanNailed. */
+      if (loops > 1)
+        ScanStateSetSummary(ss, ScanStateSummary(ss));
+      *totalReturn = FALSE;
+      return res;
+    }
+    res = FormatScan(format, ss, AddrAdd(objLimit, format->headerSize),
+                     AddrAdd(SegLimit(seg), format->headerSize));
+  }
+  *totalReturn = res == ResOK && fromStart;
+  return res;
+}
+
+
 /* amcSegScan -- scan a single seg, turning it black
  *
  * See <design/poolamc/#seg-scan>.
@@ -1409,11 +1668,24 @@ static Res amcSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   amc = MustBeA(AMCZPool, pool);
   format = pool->format;
 
+  base = AddrAdd(SegBase(seg), format->headerSize);
+
+  /* <design/poolamc/#seg-scan.slice> */
+  if (ss->sliceSize > 0 && format->scanSlice != NULL
+      && SegSize(seg) >= amc->largeSize && SegSize(seg) > ss->sliceSize
+      && !SegHasBuffer(seg) && (*format->isMoved)(base) == NULL
+      && (!amcSegHasNailboard(seg)
+          || (MustBeA(amcSeg, seg)->promoted
+              && (*amc->pinned)(amc, amcSegNailboard(seg), base,
+                                (*format->skip)(base)))))
+    return amcSegScanSlice(totalReturn, ss, seg, format);
+
+  /* Only the nailed objects in a promoted segment are scanned: see
+   * <design/poolamc/#promote.scan>. */
   if(amcSegHasNailboard(seg)) {
     return amcSegScanNailed(totalReturn, ss, pool, seg, amc);
   }
 
-  base = AddrAdd(SegBase(seg), format->headerSize);
   /* <design/poolamc/#seg-scan.loop> */
   while (SegBuffer(&buffer, seg)) {
     limit = AddrAdd(BufferScanLimit(buffer),
@@ -1457,6 +1729,7 @@ static Res amcSegScan(Bool *totalReturn, Seg seg, ScanState ss)
  *
  * If the segment has a nailboard then we use that to record the fix.
  * Otherwise we simply grey and nail the entire segment.
+ *
  */
 static void amcSegFixInPlace(Seg seg, ScanState ss, Ref *refIO)
 {
@@ -1617,6 +1890,14 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
       /* Object is not preserved (neither moved, nor nailed) */
       /* hence, reference should be splatted. */
       goto updateReference;
+    } else if(MustBeA_CRITICAL(amcSeg, seg)->promoted) {
+      /* Object is not preserved yet, but the segment is being */
+      /* promoted in place, so preserve it by nailing. */
+      /* See <design/poolamc/#promote.fix>. */
+      ss->wasMarked = FALSE; /* <design/fix/#was-marked.not> */
+      amcSegFixInPlace(seg, ss, refIO);
+      res = ResOK;
+      goto returnRes;
     }
     /* Object is not preserved yet (neither moved, nor nailed) */
     /* so should be preserved by forwarding. */
@@ -1638,6 +1919,7 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
 
       toSeg = BufferSeg(buffer);
       ShieldExpose(arena, toSeg);
+      SegSetMoved(toSeg, ArenaEpoch(arena)); /* <design/seg/#field.moved> */
 
       /* Since we're moving an object from one segment to another, */
       /* union the greyness and the summaries together. */
@@ -1661,6 +1943,10 @@ static Res amcSegFix(Seg seg, ScanState ss, Ref *refIO)
       MustBeA(amcSeg, seg)->forwarded[ti] += length;
     TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
 
+    /* <design/poolamc/#hash> */
+    if (SegHashed(seg) && IdHashMove(arena, ref, newRef))
+      SegSetHashed(toSeg, TRUE);
+
     (*format->move)(ref, newRef);  /* .exposed.seg */
   } else {
     /* reference to broken heart (which should be snapped out -- */
@@ -1696,6 +1982,8 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
   Addr padBase;          /* base of next padding object */
   Size padLength;        /* length of next padding object */
   Buffer buffer;
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  Bool promoted = amcseg->promoted;
 
   /* All arguments AVERed by AMCReclaim */
 
@@ -1727,6 +2015,8 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
        * overstated. */
       preserve = !(*format->isMoved)(clientP);
     }
+    if(!preserve && SegHashed(seg))
+      IdHashForget(arena, clientP); /* <design/poolamc/#hash> */
     if(preserve) {
       ++preservedInPlaceCount;
       preservedInPlaceSize += length;
@@ -1759,7 +2049,8 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
   SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
   if(SegNailed(seg) == TraceSetEMPTY && amcSegHasNailboard(seg)) {
     NailboardDestroy(amcSegNailboard(seg), arena);
-    MustBeA(amcSeg, seg)->board = NULL;
+    amcseg->board = NULL;
+    amcseg->promoted = FALSE;
   }
 
   STATISTIC(AVER(bytesReclaimed <= SegSize(seg)));
@@ -1772,7 +2063,7 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     GenDescCondemned(pgen->gen, trace,
                      AddrOffset(BufferBase(buffer), BufferLimit(buffer)));
   }
-  GenDescSurvived(pgen->gen, trace, MustBeA(amcSeg, seg)->forwarded[trace->ti],
+  GenDescSurvived(pgen->gen, trace, amcseg->forwarded[trace->ti],
                   preservedInPlaceSize);
 
   /* Free the seg if we can; fixes .nailboard.limitations.middle. */
@@ -1783,8 +2074,50 @@ static void amcSegReclaimNailed(Pool pool, Trace trace, Seg seg)
     /* We may not free a buffered seg. */
     AVER(!SegHasBuffer(seg));
 
-    PoolGenFree(pgen, seg, 0, SegSize(seg), 0, MustBeA(amcSeg, seg)->deferred);
+    PoolGenFree(pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
+  } else if(promoted) {
+    /* Move the survivors to the generation they would have been */
+    /* forwarded to. See <design/poolamc/#promote.reclaim>. */
+    amcGen toGen = amcBufGen(amcseg->gen->forward);
+    if(toGen != amcseg->gen) {
+      PoolGenPromote(pgen, &toGen->pgen, seg);
+      amcseg->gen = toGen;
+    }
+  }
+}
+
+
+/* amcSegForgetHashes -- forget identity hashes of objects in a segment
+ *
+ * Forgets the hashes of the objects in [base, limit) of the segment.
+ * Called before freeing a white segment with no nailed objects: the
+ * survivors have all been forwarded, taking their hashes with them, so
+ * any hash left belongs to a dead object.  Also called by AMCFramePop
+ * on the objects it pops.  See <design/poolamc/#hash>.
+ */
+
+static void amcSegForgetHashes(Seg seg, Addr base, Addr limit)
+{
+  Pool pool = SegPool(seg);
+  Arena arena = PoolArena(pool);
+  Format format = pool->format;
+  Size headerSize = format->headerSize;
+  Addr p;
+
+  AVER(SegBase(seg) <= base);
+  AVER(base <= limit);
+  AVER(limit <= SegLimit(seg));
+  ShieldExpose(arena, seg);
+  p = base;
+  while (p < limit) {
+    Addr clientP = AddrAdd(p, headerSize);
+    Addr q = AddrSub((*format->skip)(clientP), headerSize);
+    IdHashForget(arena, clientP);
+    AVER(p < q);
+    p = q;
   }
+  AVER(p == limit);
+  ShieldCover(arena, seg);
 }
 
 
@@ -1825,6 +2158,9 @@ static void amcSegReclaim(Seg seg, Trace trace)
 
   STATISTIC(trace->reclaimSize += SegSize(seg));
 
+  if (SegHashed(seg))
+    amcSegForgetHashes(seg, SegBase(seg), SegLimit(seg));
+
   GenDescSurvived(gen->pgen.gen, trace, amcseg->forwarded[trace->ti], 0);
   PoolGenFree(&gen->pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
 }
@@ -1965,6 +2301,8 @@ static Res AMCDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   }
   res = WriteF(stream, depth + 2,
                rampmode, " ($U)\n", (WriteFU)amc->rampCount,
+               "promoteSurvival $D\n", (WriteFD)amc->promoteSurvival,
+               "zeroed $S\n", WriteFYesNo(amc->zeroed),
                NULL);
   if(res != ResOK)
     return res;
@@ -2004,6 +2342,8 @@ DEFINE_CLASS(Pool, AMCZPool, klass)
   klass->bufferFill = AMCBufferFill;
   klass->rampBegin = AMCRampBegin;
   klass->rampEnd = AMCRampEnd;
+  klass->framePush = AMCFramePush;
+  klass->framePop = AMCFramePop;
   klass->segPoolGen = amcSegPoolGen;
   klass->bufferClass = amcBufClassGet;
   klass->totalSize = AMCTotalSize;
@@ -2117,6 +2457,9 @@ static Bool AMCCheck(AMC amc)
   /* if BEGIN or RAMPING, count must not be zero. */
   CHECKL((amc->rampCount != 0) || ((amc->rampMode != RampBEGIN) &&
                                    (amc->rampMode != RampRAMPING)));
+  CHECKL(amc->promoteSurvival >= 0.0);
+  CHECKL(BoolCheck(amc->zeroed));
+  CHECKL(!amc->zeroed || amc->rankSet == RankSetEMPTY);
 
   return TRUE;
 }
@@ -1480,6 +1480,7 @@ static Res amsSegFix(Seg seg, ScanState ss, Ref *refIO)
     amsseg->ambiguousFixes = TRUE;
     /* falls through */
   case RankEXACT:
+  case RankEPHEMERON:
   case RankFINAL:
   case RankWEAK:
     if (AMS_IS_WHITE(seg, i)) {
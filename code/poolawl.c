@@ -131,6 +131,8 @@ typedef struct AWLSegStruct {
   BT mark;
   BT scanned;
   BT alloc;
+  BT pending;               /* objects with pending ephemerons, or NULL */
+  Count pendingCount;       /* number of bits set in pending */
   Count grains;
   Count freeGrains;         /* free grains */
   Count bufferedGrains;     /* grains in buffers */
@@ -151,6 +153,8 @@ static Bool AWLSegCheck(AWLSeg awlseg)
   CHECKL(awlseg->mark != NULL);
   CHECKL(awlseg->scanned != NULL);
   CHECKL(awlseg->alloc != NULL);
+  CHECKL(awlseg->pendingCount == 0 || awlseg->pending != NULL);
+  CHECKL(awlseg->pendingCount <= awlseg->grains);
   CHECKL(awlseg->grains > 0);
   CHECKL(awlseg->grains == awlseg->freeGrains + awlseg->bufferedGrains
          + awlseg->newGrains + awlseg->oldGrains);
@@ -176,6 +180,29 @@ static void awlStatTotalInit(AWL awl)
 }
 
 
+/* awlSegTables -- number of bit tables for a segment of a rank set
+ *
+ * Segments of rank ephemeron have a fourth table recording which
+ * objects have pending ephemerons. See <design/poolawl/#ephemeron>.
+ */
+
+static Count awlSegTables(RankSet rankSet)
+{
+  return RankSetIsMember(rankSet, RankEPHEMERON) ? 4 : 3;
+}
+
+
+/* awlSegPendingReset -- forget the pending ephemerons for a new trace */
+
+static void awlSegPendingReset(AWLSeg awlseg)
+{
+  if (awlseg->pending != NULL) {
+    BTResRange(awlseg->pending, 0, awlseg->grains);
+    awlseg->pendingCount = 0;
+  }
+}
+
+
 /* AWLSegInit -- Init method for AWL segments */
 
 ARG_DEFINE_KEY(awl_seg_rank_set, RankSet);
@@ -196,8 +223,9 @@ static Res AWLSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   rankSet = arg.val.u;
   AVERT(RankSet, rankSet);
   /* .assume.samerank */
-  /* AWL only accepts two ranks */
+  /* AWL only accepts three ranks */
   AVER(RankSetSingle(RankEXACT) == rankSet
+       || RankSetSingle(RankEPHEMERON) == rankSet
        || RankSetSingle(RankWEAK) == rankSet);
 
   /* Initialize the superclass fields first via next-method call */
@@ -212,16 +240,21 @@ static Res AWLSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   bits = PoolSizeGrains(pool, size);
   tableSize = BTSize(bits);
-  res = ControlAlloc(&v, arena, 3 * tableSize);
+  res = ControlAlloc(&v, arena, awlSegTables(rankSet) * tableSize);
   if (res != ResOK)
     goto failControlAlloc;
   awlseg->mark = v;
   awlseg->scanned = PointerAdd(v, tableSize);
   awlseg->alloc = PointerAdd(v, 2 * tableSize);
+  awlseg->pending = NULL;
+  if (awlSegTables(rankSet) > 3)
+    awlseg->pending = PointerAdd(v, 3 * tableSize);
+  awlseg->pendingCount = 0;
   awlseg->grains = bits;
   BTResRange(awlseg->mark, 0, bits);
   BTResRange(awlseg->scanned, 0, bits);
   BTResRange(awlseg->alloc, 0, bits);
+  awlSegPendingReset(awlseg);
   SegSetRankAndSummary(seg, rankSet, RefSetUNIV);
   awlseg->freeGrains = bits;
   awlseg->bufferedGrains = (Count)0;
@@ -260,7 +293,8 @@ static void AWLSegFinish(Inst inst)
   segGrains = PoolSizeGrains(pool, SegSize(seg));
   AVER(segGrains == awlseg->grains);
   tableSize = BTSize(segGrains);
-  ControlFree(arena, awlseg->mark, 3 * tableSize);
+  ControlFree(arena, awlseg->mark,
+              awlSegTables(SegRankSet(seg)) * tableSize);
   awlseg->sig = SigInvalid;
 
   /* finish the superclass fields last */
@@ -750,6 +784,8 @@ static Res awlSegWhiten(Seg seg, Trace trace)
   /* see <design/poolawl/#fun.condemn> */
   AVER(SegWhite(seg) == TraceSetEMPTY);
 
+  awlSegPendingReset(awlseg);
+
   if (!SegBuffer(&buffer, seg)) {
     awlSegRangeWhiten(awlseg, 0, awlseg->grains);
     uncondemnedGrains = (Count)0;
@@ -819,6 +855,7 @@ static void awlSegGreyen(Seg seg, Trace trace)
   if (!TraceSetIsMember(SegWhite(seg), trace)) {
     AWLSeg awlseg = MustBeA(AWLSeg, seg);
 
+    awlSegPendingReset(awlseg);
     SegSetGrey(seg, TraceSetAdd(SegGrey(seg), trace));
     if (SegBuffer(&buffer, seg)) {
       Addr base = SegBase(seg);
@@ -845,6 +882,7 @@ static void awlSegBlacken(Seg seg, TraceSet traceSet)
   AVERT(TraceSet, traceSet);
 
   BTSetRange(awlseg->scanned, 0, awlseg->grains);
+  awlSegPendingReset(awlseg);
 }
 
 
@@ -884,10 +922,44 @@ static Res awlScanObject(Arena arena, AWL awl, ScanState ss,
 }
 
 
-/* awlSegScanSinglePass -- a single scan pass over a segment */
+/* awlSegNotePending -- record whether an object's ephemerons wait
+ *
+ * Called after scanning object i of an ephemeron segment, where
+ * pending says whether the scan left any ephemerons waiting for their
+ * keys.  The first scan of an object in a trace is progress; a rescan
+ * only makes progress if it fixes a value, which the tracer notes
+ * itself.  See <design/poolawl/#ephemeron.scan>.
+ */
+
+static void awlSegNotePending(AWLSeg awlseg, ScanState ss, Index i,
+                              Bool pending)
+{
+  AVER(awlseg->pending != NULL);
+  if (BTGet(awlseg->pending, i)) {
+    if (!pending) {
+      BTRes(awlseg->pending, i);
+      AVER(awlseg->pendingCount > 0);
+      --awlseg->pendingCount;
+    }
+  } else {
+    ss->progress = TRUE;
+    if (pending) {
+      BTSet(awlseg->pending, i);
+      ++awlseg->pendingCount;
+    }
+  }
+}
+
+
+/* awlSegScanSinglePass -- a single scan pass over a segment
+ *
+ * If pendingOnly is TRUE, scan only the objects with pending
+ * ephemerons; see <design/poolawl/#ephemeron.scan>.
+ */
 
 static Res awlSegScanSinglePass(Bool *anyScannedReturn, ScanState ss,
-                                Seg seg, Bool scanAllObjects)
+                                Seg seg, Bool scanAllObjects,
+                                Bool pendingOnly)
 {
   AWLSeg awlseg = MustBeA(AWLSeg, seg);
   Pool pool = SegPool(seg);
@@ -903,6 +975,8 @@ static Res awlSegScanSinglePass(Bool *anyScannedReturn, ScanState ss,
 
   AVERT(ScanState, ss);
   AVERT(Bool, scanAllObjects);
+  AVERT(Bool, pendingOnly);
+  AVER(!pendingOnly || scanAllObjects);
 
   *anyScannedReturn = FALSE;
   p = base;
@@ -930,13 +1004,17 @@ static Res awlSegScanSinglePass(Bool *anyScannedReturn, ScanState ss,
     objectLimit = (format->skip)(hp);
     /* <design/poolawl/#fun.scan.pass.object> */
     if (scanAllObjects
-        || (BTGet(awlseg->mark, i) && !BTGet(awlseg->scanned, i))) {
+        ? !pendingOnly || BTGet(awlseg->pending, i)
+        : BTGet(awlseg->mark, i) && !BTGet(awlseg->scanned, i)) {
+      Count pending = ss->pending;
       Res res = awlScanObject(arena, awl, ss, pool->format,
                               hp, objectLimit);
       if (res != ResOK)
         return res;
       *anyScannedReturn = TRUE;
       BTSet(awlseg->scanned, i);
+      if (awlseg->pending != NULL)
+        awlSegNotePending(awlseg, ss, i, ss->pending > pending);
     }
     objectLimit = AddrSub(objectLimit, format->headerSize);
     AVER(p < objectLimit);
@@ -953,8 +1031,10 @@ static Res awlSegScanSinglePass(Bool *anyScannedReturn, ScanState ss,
 
 static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
 {
+  AWLSeg awlseg = MustBeA(AWLSeg, seg);
   Bool anyScanned;
   Bool scanAllObjects;
+  Bool pendingOnly;
   Res res;
 
   AVER(totalReturn != NULL);
@@ -975,8 +1055,20 @@ static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   scanAllObjects =
     (TraceSetDiff(ss->traces, SegWhite(seg)) != TraceSetEMPTY);
 
+  /* Objects with pending ephemerons have been scanned already, but */
+  /* must be scanned again in case their keys have since been */
+  /* reached.  See <design/poolawl/#ephemeron.scan>. */
+  pendingOnly = scanAllObjects && awlseg->pendingCount > 0;
+  if (!scanAllObjects && awlseg->pendingCount > 0) {
+    Index i;
+    for (i = 0; i < awlseg->grains; ++i)
+      if (BTGet(awlseg->pending, i))
+        BTRes(awlseg->scanned, i);
+  }
+
   do {
-    res = awlSegScanSinglePass(&anyScanned, ss, seg, scanAllObjects);
+    res = awlSegScanSinglePass(&anyScanned, ss, seg, scanAllObjects,
+                               pendingOnly);
     if (res != ResOK) {
       *totalReturn = FALSE;
       return res;
@@ -986,7 +1078,7 @@ static Res awlSegScan(Bool *totalReturn, Seg seg, ScanState ss)
   /* gotten fixed) */
   } while(!scanAllObjects && anyScanned);
 
-  *totalReturn = scanAllObjects;
+  *totalReturn = scanAllObjects && !pendingOnly;
   AWLNoteScan(seg, ss);
   return ResOK;
 }
@@ -25,6 +25,7 @@ typedef struct LOStruct {
   PoolStruct poolStruct;        /* generic pool structure */
   PoolGenStruct pgenStruct;     /* generation representing the pool */
   PoolGen pgen;                 /* NULL or pointer to pgenStruct */
+  Bool zeroed;                  /* <design/poollo/#zeroed> */
   Sig sig;                      /* <code/misc.h#sig> */
 } LOStruct;
 
@@ -313,6 +314,7 @@ static void loSegReclaim(Seg seg, Trace trace)
   Format format = NULL; /* supress "may be used uninitialized" warning */
   Count preservedInPlaceCount = (Count)0;
   Size preservedInPlaceSize = (Size)0;
+  Bool zeroed = MustBeA(LOPool, pool)->zeroed;
   Bool b;
 
   AVERT(Trace, trace);
@@ -359,6 +361,10 @@ static void loSegReclaim(Seg seg, Trace trace)
       Index j = PoolIndexOfAddr(base, pool, q);
       /* This object is not marked, so free it */
       BTResRange(loseg->alloc, i, j);
+      /* Zero it now rather than when it is next allocated: see
+       * <design/poollo/#zeroed.reclaim>. */
+      if (zeroed)
+        (void)AddrSet(p, 0, AddrOffset(p, q));
       reclaimedGrains += j - i;
     }
     p = q;
@@ -462,6 +468,7 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   ArgStruct arg;
   Chain chain;
   unsigned gen = LO_GEN_DEFAULT;
+  Bool zeroed = LO_ZEROED_DEFAULT;
 
   AVER(pool != NULL);
   AVERT(Arena, arena);
@@ -484,17 +491,21 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   }
   if (ArgPick(&arg, args, MPS_KEY_GEN))
     gen = arg.val.u;
+  if (ArgPick(&arg, args, MPS_KEY_ZEROED))
+    zeroed = arg.val.b;
   
   AVERT(Format, pool->format);
   AVER(FormatArena(pool->format) == arena);
   AVERT(Chain, chain);
   AVER(gen <= ChainGens(chain));
   AVER(chain->arena == arena);
+  AVERT(Bool, zeroed);
 
   pool->alignment = pool->format->alignment;
   pool->alignShift = SizeLog2(pool->alignment);
 
   lo->pgen = NULL;
+  lo->zeroed = zeroed;
 
   SetClassOfPoly(pool, CLASS(LOPool));
   lo->sig = LOSig;
@@ -504,6 +515,8 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   if (res != ResOK)
     goto failGenInit;
   lo->pgen = &lo->pgenStruct;
+  if (zeroed)
+    ++arena->zeroedPools;
 
   EVENT2(PoolInitLO, pool, pool->format);
 
@@ -539,6 +552,12 @@ static void LOFinish(Inst inst)
   }
   PoolGenFinish(lo->pgen);
 
+  if (lo->zeroed) {
+    Arena arena = PoolArena(pool);
+    AVER(arena->zeroedPools > 0);
+    --arena->zeroedPools;
+  }
+
   lo->sig = SigInvalid;
 
   NextMethod(Inst, LOPool, finish)(inst);
@@ -578,6 +597,9 @@ static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
                      argsNone);
   if (res != ResOK)
     return res;
+  /* Free grains in a zeroed pool are zero: see <design/poollo/#zeroed>. */
+  if (lo->zeroed)
+    ArenaZero(PoolArena(pool), SegBase(seg), SegLimit(seg));
   b = SegBufferFill(baseReturn, limitReturn, seg, size, rankSet);
   AVER(b);
   return ResOK;
@@ -754,6 +776,7 @@ static Bool LOCheck(LO lo)
     CHECKL(lo->pgen == &lo->pgenStruct);
     CHECKD(PoolGen, lo->pgen);
   }
+  CHECKL(BoolCheck(lo->zeroed));
   return TRUE;
 }
 
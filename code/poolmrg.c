@@ -31,6 +31,7 @@
 #include "ring.h"
 #include "mpm.h"
 #include "poolmrg.h"
+#include "table.h"
 
 SRCID(poolmrg, "$Id$");
 
@@ -97,6 +98,30 @@ static void MRGRefPartSetRef(Arena arena, RefPart refPart, Ref ref)
 }
 
 
+/* MRGRefPartPeek -- read the reference without the read barrier
+ *
+ * .ref.peek: Reading through the software barrier may fix the
+ * reference, but the reference in a prefinal guardian must only
+ * change in mrgRefSegScan, so that the index stays up to date. See
+ * <design/poolmrg/#index.move>.
+ */
+static Ref MRGRefPartPeek(Arena arena, RefPart refPart)
+{
+  Seg seg = NULL;       /* suppress "may be used uninitialized" */
+  Bool b;
+  Ref ref;
+
+  AVER(refPart != NULL);
+
+  b = SegOfAddr(&seg, arena, (Addr)refPart);
+  AVER(b);
+  ShieldExpose(arena, seg);
+  ref = refPart->ref;
+  ShieldCover(arena, seg);
+  return ref;
+}
+
+
 /* MRGStruct -- MRG pool structure */
 
 #define MRGSig          ((Sig)0x519369B0) /* SIGnature MRG POol */
@@ -107,6 +132,9 @@ typedef struct MRGStruct {
   RingStruct freeRing;      /* <design/poolmrg/#poolstruct.free> */
   RingStruct refRing;       /* <design/poolmrg/#poolstruct.refring> */
   Size extendBy;            /* <design/poolmrg/#extend> */
+  Count freeGuardians;      /* number of guardians on freeRing */
+  Table index;              /* <design/poolmrg/#index> */
+  Count unindexed;          /* <design/poolmrg/#index.dup> */
   Sig sig;                  /* <code/mps.h#sig> */
 } MRGStruct;
 
@@ -130,6 +158,8 @@ static Bool MRGCheck(MRG mrg)
   CHECKD_NOSIG(Ring, &mrg->freeRing);
   CHECKD_NOSIG(Ring, &mrg->refRing);
   CHECKL(mrg->extendBy == ArenaGrainSize(PoolArena(pool)));
+  CHECKL(RingIsSingle(&mrg->freeRing) == (mrg->freeGuardians == 0));
+  CHECKD(Table, mrg->index);
   return TRUE;
 }
 
@@ -411,11 +441,87 @@ static void MRGGuardianInit(MRG mrg, Link link, RefPart refPart)
   RingInit(&link->the.linkRing);
   link->state = MRGGuardianFREE;
   RingAppend(&mrg->freeRing, &link->the.linkRing);
+  ++mrg->freeGuardians;
   /* <design/poolmrg/#free.overwrite> */
   MRGRefPartSetRef(PoolArena(MustBeA(AbstractPool, mrg)), refPart, 0);
 }
 
 
+/* Index -- map from object to prefinal guardian
+ *
+ * See <design/poolmrg/#index>. References are never zero
+ * (<design/poolmrg/#free.overwrite>), and objects are aligned, so
+ * neither zero nor one can be the address of a registered object.
+ */
+
+#define mrgIndexUNUSED  ((TableKey)0)
+#define mrgIndexDELETED ((TableKey)1)
+
+
+/* mrgIndexAdd -- index a newly registered guardian
+ *
+ * If the object is already indexed then it has been registered more
+ * than once, and this guardian is left out of the index. See
+ * <design/poolmrg/#index.dup>.
+ */
+
+static void mrgIndexAdd(MRG mrg, Link link, Ref ref)
+{
+  Res res;
+
+  AVER(link->state == MRGGuardianPREFINAL);
+  AVER((TableKey)ref != mrgIndexDELETED);
+
+  res = TableDefine(mrg->index, (TableKey)ref, link);
+  if (res != ResOK) {
+    /* The index was grown by mrgReserve, so it's a duplicate key. */
+    AVER(res == ResFAIL);
+    ++mrg->unindexed;
+  }
+}
+
+
+/* mrgIndexRemove -- remove a guardian that is no longer prefinal */
+
+static void mrgIndexRemove(MRG mrg, Link link, Ref ref)
+{
+  TableValue value;
+  Res res;
+
+  if (TableLookup(&value, mrg->index, (TableKey)ref) && value == link) {
+    res = TableRemove(mrg->index, (TableKey)ref);
+    AVER(res == ResOK);
+  } else {
+    AVER(mrg->unindexed > 0);
+    --mrg->unindexed;
+  }
+}
+
+
+/* mrgIndexMove -- update the index when a guardian's object moves
+ *
+ * Called from the scan, so it must not allocate. Removing the old key
+ * means the table has room for the new key without growing. See
+ * <design/poolmrg/#index.move>.
+ */
+
+static void mrgIndexMove(MRG mrg, Link link, Ref old, Ref new)
+{
+  TableValue value;
+  Res res;
+
+  if (TableLookup(&value, mrg->index, (TableKey)old) && value == link) {
+    res = TableRemove(mrg->index, (TableKey)old);
+    AVER(res == ResOK);
+    res = TableDefine(mrg->index, (TableKey)new, link);
+    if (res != ResOK) {
+      AVER(res == ResFAIL);
+      ++mrg->unindexed;
+    }
+  }
+}
+
+
 /* MRGMessage* -- Implementation of MRG's MessageClass */
 
 
@@ -557,16 +663,19 @@ failLinkSegAlloc:
 
 static void MRGFinalize(Arena arena, MRGLinkSeg linkseg, Index indx)
 {
+  MRG mrg = MustBeA(MRGPool, SegPool(MustBeA(Seg, linkseg)));
   Link link;
   Message message;
 
-  AVER(indx < MRGGuardiansPerSeg(MustBeA(MRGPool, SegPool(MustBeA(Seg, linkseg)))));
+  AVER(indx < MRGGuardiansPerSeg(mrg));
 
   link = linkOfIndex(linkseg, indx);
 
   /* only finalize it if it hasn't been finalized already */
   if (link->state != MRGGuardianFINAL) {
     AVER(link->state == MRGGuardianPREFINAL);
+    /* .ref.direct: called from the scan, so the shield is exposed. */
+    mrgIndexRemove(mrg, link, refPartOfIndex(linkseg->refSeg, indx)->ref);
     RingRemove(&link->the.linkRing);
     RingFinish(&link->the.linkRing);
     link->state = MRGGuardianFINAL;
@@ -607,11 +716,14 @@ static Res mrgRefSegScan(Bool *totalReturn, Seg seg, ScanState ss)
         /* .ref.direct: We can access the reference directly */
         /* because we are in a scan and the shield is exposed. */
         if (TRACE_FIX1(ss, refPart->ref)) {
+          Ref old = refPart->ref;
           res = TRACE_FIX2(ss, &(refPart->ref));
           if (res != ResOK) {
             *totalReturn = FALSE;
             return res;
           }
+          if (refPart->ref != old) /* <design/poolmrg/#index.move> */
+            mrgIndexMove(mrg, linkOfIndex(linkseg, i), old, refPart->ref);
 
           if (ss->rank == RankFINAL && !ss->wasMarked) { /* .improve.rank */
             MRGFinalize(arena, linkseg, i);
@@ -644,10 +756,18 @@ static Res MRGInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
     goto failNextInit;
   mrg = CouldBeA(MRGPool, pool);
  
+  res = TableCreate(&mrg->index, MRG_INDEX_INITIAL,
+                    ControlTableAlloc, ControlTableFree, arena,
+                    mrgIndexUNUSED, mrgIndexDELETED);
+  if (res != ResOK)
+    goto failIndex;
+
   RingInit(&mrg->entryRing);
   RingInit(&mrg->freeRing);
   RingInit(&mrg->refRing);
   mrg->extendBy = ArenaGrainSize(PoolArena(pool));
+  mrg->freeGuardians = 0;
+  mrg->unindexed = 0;
 
   SetClassOfPoly(pool, CLASS(MRGPool));
   mrg->sig = MRGSig;
@@ -655,6 +775,8 @@ static Res MRGInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   return ResOK;
 
+failIndex:
+  NextMethod(Inst, MRGPool, finish)(MustBeA(Inst, pool));
 failNextInit:
   AVER(res != ResOK);
   return res;
@@ -699,6 +821,7 @@ static void MRGFinish(Inst inst)
     MRGSegPairDestroy(refseg);
   }
 
+  TableDestroy(mrg->index);
   mrg->sig = SigInvalid;
   RingFinish(&mrg->refRing);
   /* <design/poolmrg/#trans.no-finish> */
@@ -707,26 +830,43 @@ static void MRGFinish(Inst inst)
 }
 
 
-/* MRGRegister -- register an object for finalization */
+/* mrgReserve -- ensure there are enough free guardians and index space
+ *
+ * Reserves room to register count objects, so that registering them
+ * can't fail. See <design/poolmrg/#alloc.grow>.
+ */
 
-Res MRGRegister(Pool pool, Ref ref)
+static Res mrgReserve(MRG mrg, Count count)
 {
-  MRG mrg = MustBeA(MRGPool, pool);
-  Arena arena = PoolArena(pool);
+  Res res;
+
+  while (mrg->freeGuardians < count) {
+    MRGRefSeg junk; /* unused */
+    res = MRGSegPairCreate(&junk, mrg);
+    if (res != ResOK)
+      return res;
+  }
+
+  return TableGrow(mrg->index, count);
+}
+
+
+/* mrgRegister -- register an object in a free guardian
+ *
+ * There must be a free guardian and room in the index: see
+ * mrgReserve.
+ */
+
+static void mrgRegister(MRG mrg, Ref ref)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
   Ring freeNode;
   Link link;
   RefPart refPart;
-  Res res;
-  MRGRefSeg junk; /* unused */
 
   AVER(ref != 0);
+  AVER(mrg->freeGuardians > 0);
 
-  /* <design/poolmrg/#alloc.grow> */
-  if (RingIsSingle(&mrg->freeRing)) {
-    res = MRGSegPairCreate(&junk, mrg);  
-    if (res != ResOK)
-      return res;
-  }
   AVER(!RingIsSingle(&mrg->freeRing));
   freeNode = RingNext(&mrg->freeRing);
 
@@ -734,32 +874,92 @@ Res MRGRegister(Pool pool, Ref ref)
   AVER(link->state == MRGGuardianFREE);
   /* <design/poolmrg/#alloc.pop> */
   RingRemove(freeNode);
+  --mrg->freeGuardians;
   link->state = MRGGuardianPREFINAL;
   RingAppend(&mrg->entryRing, freeNode);
 
   /* <design/poolmrg/#guardian.ref.alloc> */
   refPart = MRGRefPartOfLink(link, arena);
   MRGRefPartSetRef(arena, refPart, ref);
+  mrgIndexAdd(mrg, link, ref);
+}
+
+
+/* MRGRegister -- register an object for finalization */
+
+Res MRGRegister(Pool pool, Ref ref)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Res res;
+
+  AVER(ref != 0);
+
+  res = mrgReserve(mrg, 1);
+  if (res != ResOK)
+    return res;
+  mrgRegister(mrg, ref);
 
   return ResOK;
 }
 
 
-/* MRGDeregister -- deregister (once) an object for finalization
+/* MRGRegisterMany -- register several objects for finalization
  *
- * TODO: Definalization loops over all finalizable objects in the heap,
- * and so using it could accidentally be disastrous for performance.
- * See job003953 and back out changelist 187123 if this is fixed.
+ * The references are read from refs through the barrier, as
+ * ArenaFinalize's caller does for one. Either all the objects are
+ * registered, or none are.
  */
 
-Res MRGDeregister(Pool pool, Ref obj)
+Res MRGRegisterMany(Pool pool, Ref *refs, Count count)
 {
   MRG mrg = MustBeA(MRGPool, pool);
   Arena arena = PoolArena(pool);
+  Index i;
+  Res res;
+
+  AVER(refs != NULL);
+
+  res = mrgReserve(mrg, count);
+  if (res != ResOK)
+    return res;
+  for (i = 0; i < count; ++i)
+    mrgRegister(mrg, ArenaPeek(arena, &refs[i]));
+
+  return ResOK;
+}
+
+
+/* mrgScanGrey -- scan the pool's grey reference segments
+ *
+ * While a trace is flipped, the index may still hold the old address
+ * of a moved object whose guardian has not yet been scanned. Scanning
+ * them brings the index up to date. See <design/poolmrg/#index.flip>.
+ */
+
+static void mrgScanGrey(MRG mrg)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
   Ring node, nextNode;
-  Count nGuardians;       /* guardians per seg */
 
-  /* Can't check obj */
+  RING_FOR(node, &mrg->refRing, nextNode) {
+    Seg seg = MustBeA(Seg, RING_ELT(MRGRefSeg, mrgRing, node));
+    if (TraceSetInter(SegGrey(seg), arena->flippedTraces) != TraceSetEMPTY)
+      TraceSegScanFlipped(arena, seg);
+  }
+}
+
+
+/* mrgFindUnindexed -- find an unindexed guardian for an object
+ *
+ * Loops over all the guardians, so it's only used when the object has
+ * been registered more than once. See <design/poolmrg/#index.dup>.
+ */
+
+static Bool mrgFindUnindexed(Link *linkReturn, MRG mrg, Ref obj)
+{
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
+  Ring node, nextNode;
+  Count nGuardians;       /* guardians per seg */
 
   nGuardians = MRGGuardiansPerSeg(mrg);
 
@@ -780,15 +980,47 @@ Res MRGDeregister(Pool pool, Ref obj)
         ++i, ++link, ++refPart) {
       /* check if it's allocated and points to obj */
       if (link->state == MRGGuardianPREFINAL
-          && MRGRefPartRef(arena, refPart) == obj) {
-        RingRemove(&link->the.linkRing);
-        RingFinish(&link->the.linkRing);
-        MRGGuardianInit(mrg, link, refPart);
-        return ResOK;
+          && MRGRefPartPeek(arena, refPart) == obj) { /* .ref.peek */
+        *linkReturn = link;
+        return TRUE;
       }
     }
   }
-  return ResFAIL;
+  return FALSE;
+}
+
+
+/* MRGDeregister -- deregister (once) an object for finalization
+ *
+ * The guardian is found in the index. See <design/poolmrg/#index>.
+ */
+
+Res MRGDeregister(Pool pool, Ref obj)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Arena arena = PoolArena(pool);
+  TableValue value;
+  Link link;
+  Bool found;
+
+  /* Can't check obj */
+
+  found = TableLookup(&value, mrg->index, (TableKey)obj);
+  if (!found && arena->flippedTraces != TraceSetEMPTY) {
+    mrgScanGrey(mrg);
+    found = TableLookup(&value, mrg->index, (TableKey)obj);
+  }
+  if (found)
+    link = value;
+  else if (mrg->unindexed == 0 || !mrgFindUnindexed(&link, mrg, obj))
+    return ResFAIL;
+
+  AVER(link->state == MRGGuardianPREFINAL);
+  mrgIndexRemove(mrg, link, obj);
+  RingRemove(&link->the.linkRing);
+  RingFinish(&link->the.linkRing);
+  MRGGuardianInit(mrg, link, MRGRefPartOfLink(link, arena));
+  return ResOK;
 }
 
 
@@ -816,7 +1048,12 @@ static Res MRGDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   if (res != ResOK)
     return res;
 
-  res = WriteF(stream, depth + 2, "extendBy $W\n", (WriteFW)mrg->extendBy, NULL);
+  res = WriteF(stream, depth + 2,
+               "extendBy $W\n", (WriteFW)mrg->extendBy,
+               "freeGuardians $U\n", (WriteFU)mrg->freeGuardians,
+               "indexed $U\n", (WriteFU)TableCount(mrg->index),
+               "unindexed $U\n", (WriteFU)mrg->unindexed,
+               NULL);
   if (res != ResOK)
     return res;
 
@@ -831,7 +1068,7 @@ static Res MRGDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
       ShieldEnter(arena);
     }
     res = WriteF(stream, depth + 2, "at $A Ref $A\n",
-                 (WriteFA)refPart, (WriteFA)MRGRefPartRef(arena, refPart),
+                 (WriteFA)refPart, (WriteFA)MRGRefPartPeek(arena, refPart),
                  NULL);
     if (outsideShield) {
       ShieldLeave(arena);
@@ -13,7 +13,16 @@
 SRCID(root, "$Id$");
 
 
-/* RootStruct -- tracing root structure */
+/* RootStruct -- tracing root structure
+ *
+ * .region: A large protectable area root created with
+ * RootModeINCREMENTAL is divided into regions of regionSize bytes,
+ * which may be scanned one at a time after the flip. While a deferred
+ * scan is in progress, greyRegions counts the regions that are still
+ * grey (their bits in scannedRegions are reset), and regionSummary
+ * accumulates the summary of the regions scanned so far. See
+ * <design/root/#region>.
+ */
 
 #define RootSig         ((Sig)0x51960029) /* SIGnature ROOT */
 
@@ -35,6 +44,11 @@ typedef struct RootStruct {
   Addr protBase;                /* base of protectable area */
   Addr protLimit;               /* limit of protectable area */
   AccessSet pm;                 /* Protection Mode */
+  Size regionSize;              /* size of regions, or 0: see .region */
+  Count regions;                /* number of regions */
+  BT scannedRegions;            /* regions scanned since flip */
+  Count greyRegions;            /* number of regions still grey */
+  RefSet regionSummary;         /* summary of regions scanned so far */
   RootVar var;                  /* union discriminator */
   union RootUnion {
     struct {
@@ -82,11 +96,14 @@ Bool RootVarCheck(RootVar rootVar)
 Bool RootModeCheck(RootMode mode)
 {
   CHECKL((mode & (RootModeCONSTANT | RootModePROTECTABLE
-                  | RootModePROTECTABLE_INNER))
+                  | RootModePROTECTABLE_INNER | RootModeINCREMENTAL))
          == mode);
   /* RootModePROTECTABLE_INNER implies RootModePROTECTABLE */
   CHECKL((mode & RootModePROTECTABLE_INNER) == 0
          || (mode & RootModePROTECTABLE));
+  /* RootModeINCREMENTAL implies RootModePROTECTABLE */
+  CHECKL((mode & RootModeINCREMENTAL) == 0
+         || (mode & RootModePROTECTABLE));
   UNUSED(mode);
 
   return TRUE;
@@ -166,6 +183,20 @@ Bool RootCheck(Root root)
     CHECKL(root->protLimit == (Addr)0);
     CHECKL(root->pm == (AccessSet)0);
   }
+  if (root->regionSize > 0) {
+    CHECKL(root->protectable);
+    CHECKL(root->rank == RankEXACT);
+    CHECKL(root->var == RootAREA || root->var == RootAREA_TAGGED);
+    CHECKL(SizeIsArenaGrains(root->regionSize, root->arena));
+    CHECKL(root->regions > 1);
+    CHECKL(root->scannedRegions != NULL);
+    CHECKL(root->greyRegions <= root->regions);
+  } else {
+    CHECKL(root->regions == 0);
+    CHECKL(root->scannedRegions == NULL);
+    CHECKL(root->greyRegions == 0);
+  }
+  CHECKL(root->greyRegions == 0 || root->grey != TraceSetEMPTY);
   return TRUE;
 }
 
@@ -189,6 +220,7 @@ static Res rootCreate(Root *rootReturn, Arena arena,
   AVER(rootReturn != NULL);
   AVERT(Arena, arena);
   AVERT(Rank, rank);
+  AVER(rank != RankEPHEMERON); /* <design/root/#rank.ephemeron> */
   AVERT(RootMode, mode);
   AVERT(RootVar, type);
   globals = ArenaGlobals(arena);
@@ -209,6 +241,11 @@ static Res rootCreate(Root *rootReturn, Arena arena,
   root->protectable = FALSE;
   root->protBase = (Addr)0;
   root->protLimit = (Addr)0;
+  root->regionSize = 0;
+  root->regions = 0;
+  root->scannedRegions = NULL;
+  root->greyRegions = 0;
+  root->regionSummary = RefSetEMPTY;
 
   /* See <design/arena/#root-ring> */
   RingInit(&root->arenaRing);
@@ -245,7 +282,8 @@ static Res rootCreateProtectable(Root *rootReturn, Arena arena,
       if (!(root->protBase < root->protLimit)) {
         /* root had no inner pages */
         root->protectable = FALSE;
-        root->mode &=~ (RootModePROTECTABLE|RootModePROTECTABLE_INNER);
+        root->mode &=~ (RootModePROTECTABLE|RootModePROTECTABLE_INNER
+                        |RootModeINCREMENTAL);
       }
     } else {
       root->protBase = AddrArenaGrainDown(base, arena);
@@ -269,6 +307,25 @@ static Res rootCreateProtectable(Root *rootReturn, Arena arena,
     }
   }
 
+  /* Divide a large exact area root into regions for incremental
+     scanning: see .region. */
+  if ((root->mode & RootModeINCREMENTAL) && rank == RankEXACT
+      && (var == RootAREA || var == RootAREA_TAGGED))
+  {
+    Size regionSize = SizeArenaGrains(TraceSliceSIZE, arena);
+    Size size = AddrOffset(root->protBase, root->protLimit);
+    if (size > regionSize) {
+      Count regions = (size + regionSize - 1) / regionSize;
+      res = BTCreate(&root->scannedRegions, arena, regions);
+      if (res != ResOK) {
+        RootDestroy(root);
+        return res;
+      }
+      root->regionSize = regionSize;
+      root->regions = regions;
+    }
+  }
+
   AVERT(Root, root);
 
   *rootReturn = root;
@@ -444,6 +501,12 @@ void RootDestroy(Root root)
   RingRemove(&root->arenaRing);
   RingFinish(&root->arenaRing);
 
+  if (root->regionSize > 0) {
+    if (root->greyRegions > 0 || root->pm != AccessSetEMPTY)
+      ProtSet(root->protBase, root->protLimit, AccessSetEMPTY);
+    BTDestroy(root->scannedRegions, arena, root->regions);
+  }
+
   root->sig = SigInvalid;
 
   ControlFree(arena, root, sizeof(RootStruct));
@@ -470,15 +533,95 @@ Rank RootRank(Root root)
 }
 
 
-/* RootPM -- return the protection mode of a root */
+/* rootRegionIndex -- index of the region of a root containing addr */
+
+static Index rootRegionIndex(Root root, Addr addr)
+{
+  AVER(root->regionSize > 0);
+  AVER(root->protBase <= addr);
+  AVER(addr < root->protLimit);
+  return AddrOffset(root->protBase, addr) / root->regionSize;
+}
+
+
+/* rootRegionAddr -- base of a region of a root
+ *
+ * Returns the limit of the protectable area when i is the number of
+ * regions. */
+
+static Addr rootRegionAddr(Root root, Index i)
+{
+  Size offset;
+
+  AVER(i <= root->regions);
+  offset = i * root->regionSize;
+  if (offset >= AddrOffset(root->protBase, root->protLimit))
+    return root->protLimit;
+  return AddrAdd(root->protBase, offset);
+}
+
+
+/* rootRegionMode -- protection mode of a region of a root
+ *
+ * Grey regions are protected from all access. While a deferred scan
+ * is in progress, the regions already scanned are protected from
+ * writes, unless one has been written already, so that the summary of
+ * the root can be set when the scan is finished. See
+ * <design/root/#region.barrier>. */
+
+static AccessSet rootRegionMode(Root root, Index i)
+{
+  if (root->greyRegions == 0)
+    return root->pm;
+  if (!BTGet(root->scannedRegions, i))
+    return AccessREAD | AccessWRITE;
+  if (root->regionSummary != RefSetUNIV)
+    return AccessWRITE;
+  return root->pm;
+}
+
+
+/* rootProtect -- apply the protection modes of all regions of a root */
 
-AccessSet RootPM(Root root)
+static void rootProtect(Root root)
+{
+  Index i, j;
+
+  if (root->greyRegions == 0) {
+    ProtSet(root->protBase, root->protLimit, root->pm);
+    return;
+  }
+
+  for (i = 0; i < root->regions; i = j) {
+    AccessSet mode = rootRegionMode(root, i);
+    for (j = i + 1; j < root->regions && rootRegionMode(root, j) == mode; ++j)
+      NOOP;
+    ProtSet(rootRegionAddr(root, i), rootRegionAddr(root, j), mode);
+  }
+}
+
+
+/* RootPM -- return the protection mode of a root at an address */
+
+AccessSet RootPM(Root root, Addr addr)
 {
   AVERT(Root, root);
+  if (root->greyRegions > 0)
+    return rootRegionMode(root, rootRegionIndex(root, addr));
   return root->pm;
 }
 
 
+/* RootRegionIsGrey -- is the region of a root containing addr grey? */
+
+Bool RootRegionIsGrey(Root root, Addr addr)
+{
+  AVERT(Root, root);
+  return root->greyRegions > 0
+    && !BTGet(root->scannedRegions, rootRegionIndex(root, addr));
+}
+
+
 /* RootSummary -- return the summary of a root */
 
 RefSet RootSummary(Root root)
@@ -494,7 +637,11 @@ void RootGrey(Root root, Trace trace)
 {
   AVERT(Root, root);
   AVERT(Trace, trace);
- 
+  /* Regions are grey for all the traces the root is grey for, so a
+     deferred scan must finish before another trace greys the root.
+     See <design/root/#region.traces>. */
+  AVER(root->greyRegions == 0);
+
   root->grey = TraceSetAdd(root->grey, trace);
 }
 
@@ -516,7 +663,130 @@ static void rootSetSummary(Root root, RefSet summary)
 }
 
 
-/* RootScan -- scan root */
+/* rootScanArea -- scan the part of an area root in [base, limit) */
+
+static Res rootScanArea(ScanState ss, Root root, Addr base, Addr limit)
+{
+  Word *areaBase = root->the.area.base, *areaLimit = root->the.area.limit;
+
+  if (base < (Addr)areaBase)
+    base = (Addr)areaBase;
+  if ((Addr)areaLimit < limit)
+    limit = (Addr)areaLimit;
+  if (base >= limit)
+    return ResOK;
+
+  switch (root->var) {
+  case RootAREA:
+    return TraceScanArea(ss, (Word *)base, (Word *)limit,
+                         root->the.area.scan_area,
+                         root->the.area.the.closure);
+  case RootAREA_TAGGED:
+    return TraceScanArea(ss, (Word *)base, (Word *)limit,
+                         root->the.area.scan_area,
+                         &root->the.area.the.tag);
+  default:
+    NOTREACHED;
+    return ResUNIMPL;
+  }
+}
+
+
+/* rootScanRegion -- scan one grey region of a root
+ *
+ * The mutator may be running, so it's held while the region is
+ * exposed. When the last grey region is scanned, the root becomes
+ * black and gets the summary of all its regions. */
+
+static Res rootScanRegion(ScanState ss, Root root, Index i)
+{
+  Addr base, limit;
+  Res res;
+
+  AVER(root->greyRegions > 0);
+  AVER(!BTGet(root->scannedRegions, i));
+
+  base = rootRegionAddr(root, i);
+  limit = rootRegionAddr(root, i + 1);
+  ShieldHold(ss->arena);
+  ProtSet(base, limit, AccessSetEMPTY);
+  res = rootScanArea(ss, root, base, limit);
+  if (res == ResOK) {
+    BTSet(root->scannedRegions, i);
+    --root->greyRegions;
+    root->regionSummary = RefSetUnion(root->regionSummary,
+                                      ScanStateSummary(ss));
+  }
+  if (root->greyRegions == 0) {
+    root->grey = TraceSetDiff(root->grey, ss->traces);
+    rootSetSummary(root, root->regionSummary);
+    ProtSet(root->protBase, root->protLimit, root->pm);
+    EVENT3(RootScan, root, ss->traces, root->regionSummary);
+  } else {
+    ProtSet(base, limit, rootRegionMode(root, i));
+  }
+  ShieldRelease(ss->arena);
+  return res;
+}
+
+
+/* rootScanRegions -- continue a deferred scan of a root
+ *
+ * Scans the next grey region, or all of them if the scan state has
+ * no slice size. */
+
+static Res rootScanRegions(ScanState ss, Root root)
+{
+  AVER(TraceSetSub(root->grey, ss->traces));
+
+  do {
+    Index base, limit;
+    Res res;
+    Bool found = BTFindShortResRange(&base, &limit, root->scannedRegions,
+                                     0, root->regions, 1);
+    AVER(found);
+    res = rootScanRegion(ss, root, base);
+    if (res != ResOK)
+      return res;
+  } while (ss->sliceSize == 0 && root->greyRegions > 0);
+
+  return ResOK;
+}
+
+
+/* rootDefer -- grey the regions of a root instead of scanning it
+ *
+ * Called at flip. Parts of the root that can't be protected are
+ * scanned now; the regions are protected from all access, and
+ * scanned later. See <design/root/#region.flip>. */
+
+static Res rootDefer(ScanState ss, Root root)
+{
+  Res res;
+
+  AVER(root->greyRegions == 0);
+
+  res = rootScanArea(ss, root, (Addr)root->the.area.base, root->protBase);
+  if (res != ResOK)
+    return res;
+  res = rootScanArea(ss, root, root->protLimit, (Addr)root->the.area.limit);
+  if (res != ResOK)
+    return res;
+
+  BTResRange(root->scannedRegions, 0, root->regions);
+  root->greyRegions = root->regions;
+  root->regionSummary = ScanStateSummary(ss);
+  rootSetSummary(root, RefSetUNIV);
+  rootProtect(root);
+  return ResOK;
+}
+
+
+/* RootScan -- scan root
+ *
+ * If the scan state has a slice size, a root with regions is not
+ * scanned at flip but greyed region by region, and each later call
+ * scans one region. See <design/root/#region>. */
 
 Res RootScan(ScanState ss, Root root)
 {
@@ -531,6 +801,11 @@ Res RootScan(ScanState ss, Root root)
 
   AVER(ScanStateSummary(ss) == RefSetEMPTY);
 
+  if (root->greyRegions > 0)
+    return rootScanRegions(ss, root);
+  if (root->regionSize > 0 && ss->sliceSize > 0 && root->grey == ss->traces)
+    return rootDefer(ss, root);
+
   if (root->pm != AccessSetEMPTY) {
     ProtSet(root->protBase, root->protLimit, AccessSetEMPTY);
   }
@@ -609,6 +884,26 @@ failScan:
 }
 
 
+/* RootScanRegion -- scan the region of a root containing addr
+ *
+ * Used when the mutator hits the barrier on a grey region. */
+
+Res RootScanRegion(ScanState ss, Root root, Addr addr)
+{
+  Index i;
+
+  AVERT(Root, root);
+  AVERT(ScanState, ss);
+  AVER(root->rank == ss->rank);
+  AVER(RootRegionIsGrey(root, addr));
+  AVER(TraceSetSub(root->grey, ss->traces));
+  AVER(ScanStateSummary(ss) == RefSetEMPTY);
+
+  i = rootRegionIndex(root, addr);
+  return rootScanRegion(ss, root, i);
+}
+
+
 /* RootOfAddr -- return the root at addr
  *
  * Returns TRUE if the addr is in a root (and returns the root in
@@ -635,20 +930,51 @@ Bool RootOfAddr(Root *rootReturn, Arena arena, Addr addr)
 }
 
 
+/* RootOfGreyRegions -- find a root with regions left to scan
+ *
+ * Returns TRUE if some root has grey regions after its scan was
+ * deferred at flip (and returns the root in *rootReturn), otherwise
+ * returns FALSE.  See <design/root/#region.advance>.  */
+
+Bool RootOfGreyRegions(Root *rootReturn, Arena arena)
+{
+  Ring node, next;
+
+  AVER(rootReturn != NULL);
+  AVERT(Arena, arena);
+
+  RING_FOR(node, &ArenaGlobals(arena)->rootRing, next) {
+    Root root = RING_ELT(Root, arenaRing, node);
+
+    if (root->greyRegions > 0) {
+      *rootReturn = root;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
 /* RootAccess -- handle barrier hit on root */
 
-void RootAccess(Root root, AccessSet mode)
+void RootAccess(Root root, Addr addr, AccessSet mode)
 {
   AVERT(Root, root);
   AVERT(AccessSet, mode);
-  AVER((root->pm & mode) != AccessSetEMPTY);
-  AVER(mode == AccessWRITE); /* only write protection supported */
+  AVER((RootPM(root, addr) & mode) != AccessSetEMPTY);
+  AVER(mode == AccessWRITE); /* read hits are handled by TraceRootAccess */
 
-  rootSetSummary(root, RefSetUNIV);
+  /* A write during a deferred scan spoils the summary being collected
+     from the regions: see <design/root/#region.barrier>. */
+  if (root->greyRegions > 0)
+    root->regionSummary = RefSetUNIV;
+  else
+    rootSetSummary(root, RefSetUNIV);
 
   /* Access must now be allowed. */
-  AVER((root->pm & mode) == AccessSetEMPTY);
-  ProtSet(root->protBase, root->protLimit, root->pm);
+  AVER((RootPM(root, addr) & mode) == AccessSetEMPTY);
+  rootProtect(root);
 }
 
 
@@ -693,6 +1019,7 @@ Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
                root->mode & RootModeCONSTANT ? " CONSTANT" : "",
                root->mode & RootModePROTECTABLE ? " PROTECTABLE" : "",
                root->mode & RootModePROTECTABLE_INNER ? " INNER" : "",
+               root->mode & RootModeINCREMENTAL ? " INCREMENTAL" : "",
                "\n",
                "  protectable $S", WriteFYesNo(root->protectable),
                "  protBase $A", (WriteFA)root->protBase,
@@ -705,6 +1032,17 @@ Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
   if (res != ResOK)
     return res;
 
+  if (root->regionSize > 0) {
+    res = WriteF(stream, depth + 2,
+                 "regionSize $W regions $U greyRegions $U\n",
+                 (WriteFW)root->regionSize, (WriteFU)root->regions,
+                 (WriteFU)root->greyRegions,
+                 "regionSummary $B\n", (WriteFB)root->regionSummary,
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+
   switch(root->var) {
   case RootAREA:
     res = WriteF(stream, depth + 2,
@@ -0,0 +1,345 @@
+/* sample.c: ALLOCATION SAMPLING
+ *
+ * $Id$
+ * Copyright (c) 2001-2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .sample: When the client has set a sampler, roughly one allocation
+ * in every sampleInterval bytes allocated by the mutator in a moving
+ * pool is sampled: it is passed to the client's sampler, which records
+ * whatever it likes (typically a backtrace) and returns a cookie.  The
+ * sampled allocation is the one that covers a chosen byte, so an
+ * object is sampled in proportion to its size.  See
+ * <design/arena/#sample>.
+ *
+ * .sample.point: The arena counts down the bytes to the next sample.
+ * When a buffer is filled, the countdown is charged the rest of the
+ * buffer if the chosen byte lies beyond it.  Otherwise the buffer is
+ * given a sample point, and its AP's limit is held there, so the
+ * allocation that reaches the point goes out of line to BufferFill
+ * and is sampled by SampleCross.  MPS_RESERVE_BLOCK is unchanged, and
+ * allocations that don't reach a sample point stay on it.  If the
+ * buffer is emptied before its sample point is reached, that sample
+ * is lost.
+ *
+ * .sample.track: A sampled object is given an identity hash, so that
+ * the moving pool tracks it through collections and forgets it when
+ * it dies (<code/ld.c#hash>).  The sample is kept in a table keyed
+ * by the hash, and SamplesWalk finds the live ones by looking up each hash in the
+ * identity hash table.
+ *
+ * .sample.gap: The gap between samples is drawn uniformly from one to
+ * twice the interval, so that allocation patterns can't alias with
+ * the sampling.
+ */
+
+#include "mpm.h"
+#include "table.h"
+
+SRCID(sample, "$Id$");
+
+
+#define sampleUNUSED    ((TableKey)0)
+#define sampleDELETED   ((TableKey)1)
+#define sampleINITIAL   ((Count)64)
+
+typedef struct SampleStruct *Sample;
+
+typedef struct SampleStruct {
+  void *cookie;                 /* returned by client's sampler */
+  Bool seen;                    /* found live by current walk? */
+} SampleStruct;
+
+
+/* sampleGap -- choose the number of bytes to fill before next sample */
+
+static Size sampleGap(Size interval)
+{
+  Size range = interval * 2;
+  AVER(interval > 0);
+  if (range < interval) /* overflow? */
+    range = interval;
+  return 1 + (Size)(RandomWord() % range); /* .sample.gap */
+}
+
+
+/* SamplerSet -- set or clear the client's allocation sampler */
+
+void SamplerSet(Arena arena, Size interval, mps_alloc_sampler_t sampler,
+                void *closure)
+{
+  AVERT(Arena, arena);
+  AVER(interval == 0 || FUNCHECK(sampler));
+
+  arena->sampleInterval = interval;
+  arena->sampler = interval == 0 ? NULL : sampler;
+  arena->samplerClosure = closure;
+  arena->sampleCountdown = interval == 0 ? 0 : sampleGap(interval);
+}
+
+
+/* sampleRecord -- sample an allocation
+ *
+ * Sampling is best effort: if the MPS can't allocate the memory to
+ * record the sample, the allocation isn't sampled.  If the allocation
+ * isn't sampled, the identity hash it was given for the sample is
+ * forgotten, so that it doesn't keep an entry in the hash table for
+ * the rest of its life.
+ */
+
+static void sampleRecord(Arena arena, Buffer buffer, Addr p, Size size)
+{
+  TableValue value;
+  Sample sample;
+  void *base;
+  Word hash;
+  Bool hashed;
+  Res res;
+
+  if (arena->sampleTable == NULL) {
+    res = TableCreate(&arena->sampleTable, sampleINITIAL,
+                      ControlTableAlloc, ControlTableFree, arena,
+                      sampleUNUSED, sampleDELETED);
+    if (res != ResOK)
+      return;
+  }
+  res = TableGrow(arena->sampleTable, 1);
+  if (res != ResOK)
+    return;
+  hashed = arena->hashTable != NULL
+           && TableLookup(&value, arena->hashTable, (TableKey)p);
+  res = IdHash(&hash, arena, p); /* .sample.track */
+  if (res != ResOK)
+    return;
+  if (TableLookup(&value, arena->sampleTable, (TableKey)hash))
+    return; /* already sampled */
+  res = ControlAlloc(&base, arena, sizeof(SampleStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  sample = base;
+
+  sample->cookie = (*arena->sampler)((mps_addr_t)p, (size_t)size,
+                                     BufferAP(buffer),
+                                     arena->samplerClosure);
+  if (sample->cookie == NULL)
+    goto failSampler;
+  sample->seen = FALSE;
+  res = TableDefine(arena->sampleTable, (TableKey)hash, sample);
+  AVER(res == ResOK); /* table has room, and key is new */
+  return;
+
+failSampler:
+  ControlFree(arena, sample, sizeof(SampleStruct));
+failAlloc:
+  if (!hashed)
+    IdHashForget(arena, p);
+}
+
+
+/* sampleArm -- charge the rest of a buffer, or give it a sample point
+ *
+ * Called after an allocation that ends at from.  See .sample.point.
+ */
+
+static void sampleArm(Arena arena, Buffer buffer, Addr from)
+{
+  Size rest = AddrOffset(from, BufferLimit(buffer));
+  Addr point;
+
+  if (arena->sampleCountdown > rest) {
+    arena->sampleCountdown -= rest;
+    BufferSetSampleLimit(buffer, (Addr)0);
+    return;
+  }
+
+  /* The chosen byte is at from + sampleCountdown - 1, and the first */
+  /* allocation to end beyond the aligned point covers it. */
+  point = AddrAlignDown(AddrAdd(from, arena->sampleCountdown - 1),
+                        PoolAlignment(BufferPool(buffer)));
+  arena->sampleCountdown = sampleGap(arena->sampleInterval);
+  BufferSetSampleLimit(buffer, point);
+}
+
+
+/* SampleFill -- consider sampling the allocation that filled a buffer
+ *
+ * Called by BufferFill after the pool has filled the buffer, and the
+ * client's allocation of size bytes has been made at base.  crossed is
+ * TRUE if the buffer had a sample point before it was filled: the
+ * allocation didn't fit, so it reached the point.
+ */
+
+void SampleFill(Buffer buffer, Addr base, Size size, Bool crossed)
+{
+  Arena arena;
+
+  AVERT(Buffer, buffer);
+  AVER(size > 0);
+  AVERT(Bool, crossed);
+  arena = BufferArena(buffer);
+
+  /* Forwarding buffers are filled during fix, which mustn't call */
+  /* the client. */
+  if (arena->sampleInterval == 0 || !buffer->isMutator
+      || !PoolHasAttr(BufferPool(buffer), AttrMOVINGGC))
+    return;
+
+  if (crossed) {
+    sampleRecord(arena, buffer, base, size);
+  } else if (size >= arena->sampleCountdown) {
+    arena->sampleCountdown = sampleGap(arena->sampleInterval);
+    sampleRecord(arena, buffer, base, size);
+  } else {
+    arena->sampleCountdown -= size;
+  }
+  sampleArm(arena, buffer, AddrAdd(base, size));
+}
+
+
+/* SampleCross -- sample the allocation that reached a sample point
+ *
+ * Called by BufferFill when the allocation of size bytes at p goes
+ * beyond the buffer's sample point.  See .sample.point.
+ */
+
+void SampleCross(Buffer buffer, Addr p, Size size)
+{
+  Arena arena;
+
+  AVERT(Buffer, buffer);
+  AVER(size > 0);
+  arena = BufferArena(buffer);
+
+  if (arena->sampleInterval == 0) { /* sampler was cleared */
+    BufferSetSampleLimit(buffer, (Addr)0);
+    return;
+  }
+  sampleRecord(arena, buffer, p, size);
+  sampleArm(arena, buffer, AddrAdd(p, size));
+}
+
+
+/* SamplesWalk -- visit the live samples, and forget the dead ones
+ *
+ * A sample is live if its object still has an identity hash.  The
+ * client is told about each dead sample once, with a null address, so
+ * that it can free whatever the cookie refers to.
+ */
+
+typedef struct SamplesWalkStruct {
+  Arena arena;
+  mps_sample_stepper_t f;
+  void *p;
+  size_t s;
+} SamplesWalkStruct, *SamplesWalkClosure;
+
+static void sampleVisitLive(void *closure, TableKey key, TableValue value)
+{
+  SamplesWalkClosure walk = closure;
+  TableValue sampleValue;
+
+  if (TableLookup(&sampleValue, walk->arena->sampleTable,
+                  (TableKey)value)) {
+    Sample sample = sampleValue;
+    sample->seen = TRUE;
+    (*walk->f)((mps_addr_t)key, sample->cookie, TRUE, walk->p, walk->s);
+  }
+}
+
+static void sampleVisitDead(void *closure, TableKey key, TableValue value)
+{
+  SamplesWalkClosure walk = closure;
+  Sample sample = value;
+
+  if (sample->seen) {
+    sample->seen = FALSE;
+  } else {
+    Res res;
+    (*walk->f)(NULL, sample->cookie, FALSE, walk->p, walk->s);
+    /* Removing the entry only marks it deleted, so TableMap can */
+    /* carry on. */
+    res = TableRemove(walk->arena->sampleTable, key);
+    AVER(res == ResOK);
+    ControlFree(walk->arena, sample, sizeof(SampleStruct));
+  }
+}
+
+void SamplesWalk(Arena arena, mps_sample_stepper_t f, void *p, size_t s)
+{
+  SamplesWalkStruct walkStruct;
+
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(f));
+
+  if (arena->sampleTable == NULL)
+    return;
+
+  walkStruct.arena = arena;
+  walkStruct.f = f;
+  walkStruct.p = p;
+  walkStruct.s = s;
+  if (arena->hashTable != NULL)
+    TableMap(arena->hashTable, sampleVisitLive, &walkStruct);
+  TableMap(arena->sampleTable, sampleVisitDead, &walkStruct);
+}
+
+
+/* SampleFinish -- throw away all samples */
+
+static void sampleFree(void *closure, TableKey key, TableValue value)
+{
+  UNUSED(key);
+  ControlFree((Arena)closure, value, sizeof(SampleStruct));
+}
+
+void SampleFinish(Arena arena)
+{
+  AVERT(Arena, arena);
+
+  if (arena->sampleTable != NULL) {
+    TableMap(arena->sampleTable, sampleFree, arena);
+    TableDestroy(arena->sampleTable);
+    arena->sampleTable = NULL;
+  }
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -123,15 +123,18 @@ static Res segAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   limit = AddrAdd(base, size);
   seg->limit = limit;
+  seg->moved = 0;
   seg->rankSet = RankSetEMPTY;
   seg->white = TraceSetEMPTY;
   seg->nailed = TraceSetEMPTY;
+  seg->pending = TraceSetEMPTY;
   seg->grey = TraceSetEMPTY;
   seg->pm = AccessSetEMPTY;
   seg->sm = AccessSetEMPTY;
   seg->defer = WB_DEFER_INIT;
   seg->depth = 0;
   seg->queued = FALSE;
+  seg->hashed = FALSE;
   seg->firstTract = NULL;
   RingInit(SegPoolRing(seg));
 
@@ -245,6 +248,10 @@ void SegSetGrey(Seg seg, TraceSet grey)
   AVERT(TraceSet, grey);
   AVER(grey == TraceSetEMPTY || SegRankSet(seg) != RankSetEMPTY);
 
+  /* A segment awaits ephemeron keys only while it is grey. See
+     <design/trace/#ephemeron.pending>. */
+  seg->pending = TraceSetInter(seg->pending, grey);
+
   /* Don't dispatch to the class method if there's no actual change in
      greyness, or if the segment doesn't contain any references. */
   if (grey != SegGrey(seg) && SegRankSet(seg) != RankSetEMPTY)
@@ -441,10 +448,14 @@ static Res segAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "grey $B\n", (WriteFB)seg->grey,
                "white $B\n", (WriteFB)seg->white,
                "nailed $B\n", (WriteFB)seg->nailed,
+               "pending $B\n", (WriteFB)seg->pending,
+               "moved $U\n", (WriteFU)seg->moved,
+               "hashed $S\n", WriteFYesNo(seg->hashed),
                "rankSet",
                seg->rankSet == RankSetEMPTY ? " EMPTY" : "",
                BS_IS_MEMBER(seg->rankSet, RankAMBIG) ? " AMBIG" : "",
                BS_IS_MEMBER(seg->rankSet, RankEXACT) ? " EXACT" : "",
+               BS_IS_MEMBER(seg->rankSet, RankEPHEMERON) ? " EPHEMERON" : "",
                BS_IS_MEMBER(seg->rankSet, RankFINAL) ? " FINAL" : "",
                BS_IS_MEMBER(seg->rankSet, RankWEAK)  ? " WEAK"  : "",
                "\n",
@@ -868,6 +879,7 @@ Bool SegCheck(Seg seg)
   /* can't assume nailed is subset of white - mightn't be during whiten */
   /* CHECKL(TraceSetSub(seg->nailed, seg->white)); */
   CHECKL(TraceSetCheck(seg->grey));
+  CHECKL(TraceSetSub(seg->pending, seg->grey));
   CHECKD_NOSIG(Tract, seg->firstTract);
   pool = SegPool(seg);
   CHECKU(Pool, pool);
@@ -876,6 +888,7 @@ Bool SegCheck(Seg seg)
   CHECKL(AddrIsArenaGrain(TractBase(seg->firstTract), arena));
   CHECKL(AddrIsArenaGrain(seg->limit, arena));
   CHECKL(seg->limit > TractBase(seg->firstTract));
+  CHECKL(seg->moved <= ArenaEpoch(arena));
   /* CHECKL(BoolCheck(seq->queued)); <design/type/#bool.bitfield.check> */
 
   /* Each tract of the segment must agree about the segment and its
@@ -1104,6 +1117,7 @@ static Res segTrivMerge(Seg seg, Seg segHi,
   AVER(seg->rankSet == segHi->rankSet);
   AVER(seg->white == segHi->white);
   AVER(seg->nailed == segHi->nailed);
+  AVER(seg->pending == segHi->pending);
   AVER(seg->grey == segHi->grey);
   AVER(seg->pm == segHi->pm);
   AVER(seg->sm == segHi->sm);
@@ -1117,6 +1131,9 @@ static Res segTrivMerge(Seg seg, Seg segHi,
   /* no need to update fields which match. See .similar */
 
   seg->limit = limit;
+  if (segHi->moved > seg->moved)
+    seg->moved = segHi->moved;      /* <design/seg/#field.moved> */
+  seg->hashed = BOOLOF(seg->hashed || segHi->hashed);
   TRACT_FOR(tract, addr, arena, mid, limit) {
     AVERT(Tract, tract);
     AVER(segHi == TractSeg(tract));
@@ -1182,9 +1199,12 @@ static Res segTrivSplit(Seg seg, Seg segHi,
 
   InstInit(CouldBeA(Inst, segHi));
   segHi->limit = limit;
+  segHi->moved = seg->moved;
+  segHi->hashed = seg->hashed;
   segHi->rankSet = seg->rankSet;
   segHi->white = seg->white;
   segHi->nailed = seg->nailed;
+  segHi->pending = seg->pending;
   segHi->grey = seg->grey;
   segHi->pm = seg->pm;
   segHi->sm = seg->sm;
@@ -231,6 +231,11 @@ static void shieldSync(Shield shield, Seg seg)
  * Called from inside impl.c.shield when any segment is not synced, in
  * order to provide exclusive access to the segment by the MPS.  See
  * .inv.unsynced.suspended.
+ *
+ * .suspend.event: The event lock is held while the threads are
+ * suspended, so that no thread is suspended while recording an event,
+ * which would leave the collector waiting for the event lock.  See
+ * <design/telemetry/#buffer.lock.suspend>.
  */
 
 static void shieldSuspend(Arena arena)
@@ -242,7 +247,9 @@ static void shieldSuspend(Arena arena)
   AVER(shield->inside);
 
   if (!shield->suspended) {
+    LockClaimEvent(); /* .suspend.event */
     ThreadRingSuspend(ArenaThreadRing(arena), ArenaDeadRing(arena));
+    LockReleaseEvent();
     shield->suspended = TRUE;
   }
 }
@@ -69,7 +69,7 @@ static Hash tableHash(TableKey key)
 Bool TableCheck(Table table)
 {
   CHECKS(Table, table);
-  CHECKL(table->count <= table->length);
+  CHECKL(table->count + table->deleted <= table->length);
   CHECKL(table->length == 0 || table->array != NULL);
   CHECKL(FUNCHECK(table->alloc));
   CHECKL(FUNCHECK(table->free));
@@ -110,7 +110,7 @@ static TableEntry tableFind(Table table, TableKey key, Bool skip_deleted)
     Word k = table->array[i].key;
     if (k == key ||
         k == table->unusedKey ||
-        (!skip_deleted && key == table->deletedKey))
+        (!skip_deleted && k == table->deletedKey))
       return &table->array[i];
     i = (i + (hash | 1)) & mask; /* .find.visit */
   } while(i != hash);
@@ -133,6 +133,13 @@ static TableEntry tableFind(Table table, TableKey key, Bool skip_deleted)
  *
  * .hash.initial: Any reasonable number.
  *
+ * .hash.deleted: Deleted slots are reused by TableDefine, but a
+ * lookup has to probe past them, so if they make the table cramped it
+ * is rehashed to clear them, even if it doesn't need to grow. It is
+ * then sized for twice the required capacity, so that the rehash is
+ * paid for by the deletions and definitions it takes to cramp it
+ * again.
+ *
  * .hash.growth: A compromise between space inefficiency (growing bigger 
  * than required) and time inefficiency (growing too slowly, with all 
  * the rehash costs at every step).  A factor of 2 means that at the 
@@ -153,11 +160,21 @@ Res TableGrow(Table table, Count extraCapacity)
   Count oldLength, newLength;
   Count required, minimum;
   Count i, found;
+  Bool cramped;
 
   required = table->count + extraCapacity;
   if (required < table->count)  /* overflow? */
     return ResLIMIT;
 
+  /* .hash.deleted */
+  cramped = table->deleted > 0
+    && table->count + table->deleted >= table->length * SPACEFRACTION;
+  if (cramped) {
+    if (required * 2 < required) /* overflow? */
+      return ResLIMIT;
+    required *= 2;
+  }
+
   /* Calculate the minimum table length that would allow for the required
      capacity without growing again. */
   minimum = (Count)(required / SPACEFRACTION);
@@ -174,7 +191,7 @@ Res TableGrow(Table table, Count extraCapacity)
     newLength = doubled;
   }
 
-  if (newLength == oldLength)   /* already enough space? */
+  if (newLength == oldLength && !cramped) /* already enough space? */
     return ResOK;
 
   /* TODO: An event would be good here */
@@ -192,6 +209,7 @@ Res TableGrow(Table table, Count extraCapacity)
  
   table->length = newLength;
   table->array = newArray;
+  table->deleted = 0;
 
   found = 0;
   for(i = 0; i < oldLength; ++i) {
@@ -238,6 +256,7 @@ Res TableCreate(Table *tableReturn, Count length,
 
   table->length = 0;
   table->count = 0;
+  table->deleted = 0;
   table->array = NULL;
   table->alloc = tableAlloc;
   table->free = tableFree;
@@ -310,6 +329,8 @@ Res TableDefine(Table table, TableKey key, TableValue value)
     /* Search again to find the best slot, deletions included. */
     entry = tableFind(table, key, FALSE /* don't skip deleted */);
     AVER(entry != NULL);
+    if (entry->key == table->deletedKey) /* .hash.deleted */
+      --table->deleted;
   }
 
   entry->key = key;
@@ -352,6 +373,7 @@ Res TableRemove(Table table, TableKey key)
     return ResFAIL;
   entry->key = table->deletedKey;
   --table->count;
+  ++table->deleted;
   return ResOK;
 }
 
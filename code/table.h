@@ -32,6 +32,7 @@ typedef struct TableStruct {
   Sig sig;                      /* <design/sig/> */
   Count length;                 /* Number of slots in the array */
   Count count;                  /* Active entries in the table */
+  Count deleted;                /* Deleted entries in the table */
   TableEntry array;             /* Array of table slots */
   TableAllocFunction alloc;
   TableFreeFunction free;
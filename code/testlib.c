@@ -13,7 +13,7 @@
 #include "misc.h" /* for NOOP */
 
 #include <math.h> /* fmod, log, HUGE_VAL */
-#include <stdio.h> /* fflush, printf, stderr, sscanf, vfprintf */
+#include <stdio.h> /* fclose, fflush, fopen, fscanf, printf, stderr, sscanf, vfprintf */
 #include <stdlib.h> /* abort, exit, getenv */
 #include <time.h> /* time */
 
@@ -255,6 +255,23 @@ double rnd_pause_time(void)
     return 1 / t - 1;
 }
 
+size_t file_pressure_probe(void *closure)
+{
+  const char *filename = closure;
+  FILE *stream;
+  unsigned long target;
+  int n;
+
+  stream = fopen(filename, "r");
+  if (stream == NULL)
+    return 0;
+  n = fscanf(stream, "%lu", &target);
+  (void)fclose(stream);
+  if (n != 1)
+    return 0;  /* "max", or garbage */
+  return (size_t)target;
+}
+
 rnd_state_t rnd_seed(void)
 {
   /* Initialize seed based on seconds since epoch and on processor
@@ -266,6 +266,17 @@ extern size_t rnd_align(size_t min, size_t max);
 extern double rnd_pause_time(void);
 
 
+/* file_pressure_probe -- memory pressure probe reading a file
+ *
+ * A stand-in for a probe reading cgroup memory.high, suitable for
+ * MPS_KEY_PRESSURE_PROBE.  The closure is the name of a file holding
+ * a target in bytes, as a decimal number.  Returns zero (no target)
+ * if the file is missing or holds "max".
+ */
+
+extern size_t file_pressure_probe(void *closure);
+
+
 /* randomize -- randomize the generator, or initialize to replay
  *
  * randomize(argc, argv) randomizes the rnd generator (using time(3))
@@ -16,6 +16,7 @@
 
 
 #define ThreadSig       ((Sig)0x519286ED) /* SIGnature THREaD */
+#define ThreadTimerSig  ((Sig)0x519286E7) /* SIGnature THREad Timer */
 
 extern Bool ThreadCheck(Thread thread);
 
@@ -75,6 +76,25 @@ extern Res ThreadScan(ScanState ss, Thread thread, void *stackCold,
 extern void ThreadSetup(void);
 
 
+/*  ThreadTimerCreate/Destroy
+ *
+ *  Create a background thread that calls fun(closure) every interval
+ *  seconds until the timer is destroyed.  See
+ *  <design/thread-manager/#if.timer>.  Returns ResUNIMPL on platforms
+ *  without threads.
+ *
+ *  The function is called with no locks held.  ThreadTimerDestroy
+ *  waits for the background thread to exit, so if it is called with
+ *  the arena lock held, the function must not wait for that lock.
+ */
+
+extern Res ThreadTimerCreate(ThreadTimer *timerReturn, Arena arena,
+                             double interval, ThreadTimerFunction fun,
+                             void *closure);
+extern void ThreadTimerDestroy(ThreadTimer timer);
+extern Bool ThreadTimerCheck(ThreadTimer timer);
+
+
 #endif /* th_h */
 
 
@@ -142,6 +142,34 @@ Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* ThreadTimerCreate -- no background threads on the ANSI platform */
+
+Res ThreadTimerCreate(ThreadTimer *timerReturn, Arena arena,
+                      double interval, ThreadTimerFunction fun,
+                      void *closure)
+{
+  AVER(timerReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(interval > 0.0);
+  AVER(FUNCHECK(fun));
+  UNUSED(closure);
+  return ResUNIMPL;
+}
+
+void ThreadTimerDestroy(ThreadTimer timer)
+{
+  UNUSED(timer);
+  NOTREACHED;
+}
+
+Bool ThreadTimerCheck(ThreadTimer timer)
+{
+  UNUSED(timer);
+  NOTREACHED;
+  return FALSE;
+}
+
+
 void ThreadSetup(void)
 {
   /* Nothing to do as ANSI platform does not have fork(). */
@@ -312,6 +312,122 @@ Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
 }
 
 
+/* ThreadTimerStruct -- background timer thread
+ *
+ * See <design/thread-manager/#impl.w3.timer>.
+ */
+
+typedef struct ThreadTimerStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  double interval;              /* seconds between calls to fun */
+  ThreadTimerFunction fun;      /* function to call */
+  void *closure;                /* closure argument to fun */
+  HANDLE stop;                  /* event set by ThreadTimerDestroy */
+  HANDLE handle;                /* the background thread */
+} ThreadTimerStruct;
+
+
+Bool ThreadTimerCheck(ThreadTimer timer)
+{
+  CHECKS(ThreadTimer, timer);
+  CHECKU(Arena, timer->arena);
+  CHECKL(timer->interval > 0.0);
+  CHECKL(FUNCHECK(timer->fun));
+  /* can't check closure */
+  return TRUE;
+}
+
+
+/* threadTimerMain -- body of the background thread
+ *
+ * Wait for the interval to elapse, or for ThreadTimerDestroy to set
+ * the stop event, whichever comes first.
+ */
+
+static DWORD WINAPI threadTimerMain(LPVOID p)
+{
+  ThreadTimer timer = p;
+  DWORD ms = (DWORD)(timer->interval * 1000.0);
+
+  if (ms == 0)
+    ms = 1;
+  while (WaitForSingleObject(timer->stop, ms) == WAIT_TIMEOUT)
+    (*timer->fun)(timer->closure);
+  return 0;
+}
+
+
+Res ThreadTimerCreate(ThreadTimer *timerReturn, Arena arena,
+                      double interval, ThreadTimerFunction fun,
+                      void *closure)
+{
+  ThreadTimer timer;
+  void *p;
+  Res res;
+
+  AVER(timerReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(interval > 0.0);
+  AVER(FUNCHECK(fun));
+
+  res = ControlAlloc(&p, arena, sizeof(ThreadTimerStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  timer = p;
+
+  timer->arena = arena;
+  timer->interval = interval;
+  timer->fun = fun;
+  timer->closure = closure;
+  timer->stop = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (timer->stop == NULL) {
+    res = ResRESOURCE;
+    goto failEvent;
+  }
+  timer->handle = CreateThread(NULL, 0, threadTimerMain, timer, 0, NULL);
+  if (timer->handle == NULL) {
+    res = ResRESOURCE;
+    goto failThread;
+  }
+
+  timer->sig = ThreadTimerSig;
+  AVERT(ThreadTimer, timer);
+  *timerReturn = timer;
+  return ResOK;
+
+failThread:
+  (void)CloseHandle(timer->stop);
+failEvent:
+  ControlFree(arena, timer, sizeof(ThreadTimerStruct));
+failAlloc:
+  return res;
+}
+
+
+void ThreadTimerDestroy(ThreadTimer timer)
+{
+  Arena arena;
+  BOOL b;
+  DWORD r;
+
+  AVERT(ThreadTimer, timer);
+  arena = timer->arena;
+
+  b = SetEvent(timer->stop);
+  AVER(b);
+  r = WaitForSingleObject(timer->handle, INFINITE);
+  AVER(r == WAIT_OBJECT_0);
+  b = CloseHandle(timer->handle);
+  AVER(b);
+  b = CloseHandle(timer->stop);
+  AVER(b);
+
+  timer->sig = SigInvalid;
+  ControlFree(arena, timer, sizeof(ThreadTimerStruct));
+}
+
+
 void ThreadSetup(void)
 {
   /* Nothing to do as MPS does not support fork() on Windows. */
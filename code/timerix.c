@@ -0,0 +1,268 @@
+/* timerix.c: BACKGROUND TIMER THREADS FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2001-2018 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is a pthreads implementation of the background timer
+ * part of the threads manager.  This implements ThreadTimerCreate,
+ * ThreadTimerDestroy and ThreadTimerCheck from <code/th.h>.
+ *
+ * .posix: The implementation uses only a POSIX interface, and so is
+ * shared by the threads managers for FreeBSD and Linux (thix.c) and
+ * for macOS (thxc.c).
+ *
+ * .design: See <design/thread-manager/#impl.ix.timer>.
+ */
+
+#include "mpm.h"
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI) && !defined(MPS_OS_XC)
+#error "timerix.c is specific to MPS_OS_FR, MPS_OS_LI or MPS_OS_XC"
+#endif
+
+#include <errno.h> /* ETIMEDOUT */
+#include <pthread.h>
+#include <signal.h> /* pthread_sigmask, sigfillset */
+#include <sys/time.h> /* gettimeofday */
+#include <unistd.h> /* getpid */
+
+SRCID(timerix, "$Id$");
+
+
+/* ThreadTimerStruct -- background timer thread
+ *
+ * See <design/thread-manager/#impl.ix.timer>.
+ */
+
+typedef struct ThreadTimerStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  double interval;              /* seconds between calls to fun */
+  ThreadTimerFunction fun;      /* function to call */
+  void *closure;                /* closure argument to fun */
+  pid_t pid;                    /* process that created the thread */
+  Bool stopping;                /* thread has been asked to exit */
+  pthread_mutex_t mutex;        /* protects stopping */
+  pthread_cond_t cond;          /* signalled when stopping is set */
+  pthread_t id;                 /* the background thread */
+} ThreadTimerStruct;
+
+
+Bool ThreadTimerCheck(ThreadTimer timer)
+{
+  CHECKS(ThreadTimer, timer);
+  CHECKU(Arena, timer->arena);
+  CHECKL(timer->interval > 0.0);
+  CHECKL(FUNCHECK(timer->fun));
+  /* can't check closure */
+  /* can't check stopping without claiming the mutex */
+  return TRUE;
+}
+
+
+/* threadTimerDeadline -- absolute time interval seconds from now */
+
+static void threadTimerDeadline(struct timespec *deadline, double interval)
+{
+  struct timeval now;
+  double when;
+  int res;
+
+  res = gettimeofday(&now, NULL);
+  AVER(res == 0);
+  when = (double)now.tv_sec + (double)now.tv_usec / 1e6 + interval;
+  deadline->tv_sec = (time_t)when;
+  deadline->tv_nsec = (long)((when - (double)deadline->tv_sec) * 1e9);
+  AVER(0 <= deadline->tv_nsec && deadline->tv_nsec < 1000000000L);
+}
+
+
+/* threadTimerMain -- body of the background thread
+ *
+ * Wait for the interval to elapse, or for ThreadTimerDestroy to set
+ * the stopping flag, whichever comes first.  The function is called
+ * without the mutex held, so that ThreadTimerDestroy never waits
+ * for it to return except in pthread_join.
+ */
+
+static void *threadTimerMain(void *p)
+{
+  ThreadTimer timer = p;
+  int res;
+
+  res = pthread_mutex_lock(&timer->mutex);
+  AVER(res == 0);
+  while (!timer->stopping) {
+    struct timespec deadline;
+    threadTimerDeadline(&deadline, timer->interval);
+    do {
+      res = pthread_cond_timedwait(&timer->cond, &timer->mutex, &deadline);
+    } while (res == 0 && !timer->stopping); /* spurious wakeup */
+    AVER(res == 0 || res == ETIMEDOUT);
+    if (!timer->stopping) {
+      res = pthread_mutex_unlock(&timer->mutex);
+      AVER(res == 0);
+      (*timer->fun)(timer->closure);
+      res = pthread_mutex_lock(&timer->mutex);
+      AVER(res == 0);
+    }
+  }
+  res = pthread_mutex_unlock(&timer->mutex);
+  AVER(res == 0);
+  return NULL;
+}
+
+
+/* ThreadTimerCreate -- start a background timer thread
+ *
+ * All signals are blocked in the new thread, so that signals meant
+ * for the client program are not handled on a thread it doesn't
+ * know about.  The new thread inherits the signal mask of the
+ * creating thread, so block them here and restore them afterwards.
+ */
+
+Res ThreadTimerCreate(ThreadTimer *timerReturn, Arena arena,
+                      double interval, ThreadTimerFunction fun,
+                      void *closure)
+{
+  ThreadTimer timer;
+  sigset_t all, old;
+  void *p;
+  Res res;
+  int err;
+
+  AVER(timerReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(interval > 0.0);
+  AVER(FUNCHECK(fun));
+
+  res = ControlAlloc(&p, arena, sizeof(ThreadTimerStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  timer = p;
+
+  timer->arena = arena;
+  timer->interval = interval;
+  timer->fun = fun;
+  timer->closure = closure;
+  timer->pid = getpid();
+  timer->stopping = FALSE;
+  err = pthread_mutex_init(&timer->mutex, NULL);
+  if (err != 0) {
+    res = ResRESOURCE;
+    goto failMutex;
+  }
+  err = pthread_cond_init(&timer->cond, NULL);
+  if (err != 0) {
+    res = ResRESOURCE;
+    goto failCond;
+  }
+
+  err = sigfillset(&all);
+  AVER(err == 0);
+  err = pthread_sigmask(SIG_SETMASK, &all, &old);
+  AVER(err == 0);
+  err = pthread_create(&timer->id, NULL, threadTimerMain, timer);
+  {
+    int maskErr = pthread_sigmask(SIG_SETMASK, &old, NULL);
+    AVER(maskErr == 0);
+  }
+  if (err != 0) {
+    res = ResRESOURCE;
+    goto failCreate;
+  }
+
+  timer->sig = ThreadTimerSig;
+  AVERT(ThreadTimer, timer);
+  *timerReturn = timer;
+  return ResOK;
+
+failCreate:
+  err = pthread_cond_destroy(&timer->cond);
+  AVER(err == 0);
+failCond:
+  err = pthread_mutex_destroy(&timer->mutex);
+  AVER(err == 0);
+failMutex:
+  ControlFree(arena, timer, sizeof(ThreadTimerStruct));
+failAlloc:
+  return res;
+}
+
+
+/* ThreadTimerDestroy -- stop a background timer thread and free it
+ *
+ * In the child of a fork, the background thread does not exist, and
+ * its mutex might have been held at the time of the fork, so don't
+ * touch either <design/thread-manager/#impl.ix.timer.fork>.
+ */
+
+void ThreadTimerDestroy(ThreadTimer timer)
+{
+  Arena arena;
+  int res;
+
+  AVERT(ThreadTimer, timer);
+  arena = timer->arena;
+
+  if (timer->pid == getpid()) {
+    res = pthread_mutex_lock(&timer->mutex);
+    AVER(res == 0);
+    timer->stopping = TRUE;
+    res = pthread_cond_signal(&timer->cond);
+    AVER(res == 0);
+    res = pthread_mutex_unlock(&timer->mutex);
+    AVER(res == 0);
+    res = pthread_join(timer->id, NULL);
+    AVER(res == 0);
+    res = pthread_cond_destroy(&timer->cond);
+    AVER(res == 0);
+    res = pthread_mutex_destroy(&timer->mutex);
+    AVER(res == 0);
+  }
+
+  timer->sig = SigInvalid;
+  ControlFree(arena, timer, sizeof(ThreadTimerStruct));
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2001-2018 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -51,6 +51,13 @@ Bool ScanStateCheck(ScanState ss)
   CHECKL(TraceSetSuper(ss->arena->busyTraces, ss->traces));
   CHECKL(RankCheck(ss->rank));
   CHECKL(BoolCheck(ss->wasMarked));
+  CHECKL(BoolCheck(ss->unfinished));
+  CHECKL(!ss->unfinished || ss->sliceSize > 0);
+  CHECKL(BoolCheck(ss->progress));
+  CHECKL(BoolCheck(ss->splat));
+  /* traceFixUnreached probes keys at rank weak */
+  CHECKL(ss->pending == 0 || ss->rank == RankEPHEMERON
+         || ss->rank == RankWEAK);
   /* @@@@ checks for counts missing */
   return TRUE;
 }
@@ -75,7 +82,10 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
      TraceFix. */
   ss->fix = NULL;
   ss->fixClosure = NULL;
+  ss->splat = FALSE;
   TRACE_SET_ITER(ti, trace, ts, arena) {
+    if (trace->ephemeronSplat)
+      ss->splat = TRUE;
     if (ss->fix == NULL) {
       ss->fix = trace->fix;
       ss->fixClosure = trace->fixClosure;
@@ -108,6 +118,10 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   STATISTIC(ss->preservedInPlaceCount = (Count)0);
   STATISTIC(ss->copiedSize = (Size)0);
   ss->scannedSize = (Size)0; /* see .work */
+  ss->sliceSize = (Size)0;
+  ss->unfinished = FALSE;
+  ss->pending = 0;
+  ss->progress = FALSE;
   ss->sig = ScanStateSig;
 
   AVERT(ScanState, ss);
@@ -153,6 +167,7 @@ Bool TraceCheck(Trace trace)
   CHECKL(trace == &trace->arena->trace[trace->ti]);
   CHECKL(TraceSetIsMember(trace->arena->busyTraces, trace));
   CHECKL(ZoneSetSub(trace->mayMove, trace->white));
+  CHECKL(BoolCheck(trace->frozenWhite));
   CHECKD_NOSIG(Ring, &trace->genRing);
   /* Use trace->state to check more invariants. */
   switch(trace->state) {
@@ -171,6 +186,7 @@ Bool TraceCheck(Trace trace)
       CHECKL(!RingIsSingle(&trace->genRing));
       CHECKL(TraceSetIsMember(trace->arena->flippedTraces, trace));
       CHECKL(RankCheck(trace->band));
+      CHECKL(!trace->ephemeronSplat || trace->band >= RankFINAL);
       /* @@@@ Assert that mutator is black for trace. */
       break;
 
@@ -189,6 +205,8 @@ Bool TraceCheck(Trace trace)
       NOTREACHED;
       break;
   }
+  CHECKL(BoolCheck(trace->ephemeronProgress));
+  CHECKL(BoolCheck(trace->ephemeronSplat));
   CHECKL(FUNCHECK(trace->fix));
   /* Can't check trace->fixClosure. */
 
@@ -286,6 +304,9 @@ static void traceUpdateCounts(Trace trace, ScanState ss,
     default:
       NOTREACHED;
   }
+  /* See <design/trace/#ephemeron.progress>. */
+  if (ss->rank != RankEPHEMERON || ss->progress)
+    trace->ephemeronProgress = TRUE;
   STATISTIC(trace->fixRefCount += ss->fixRefCount);
   STATISTIC(trace->segRefCount += ss->segRefCount);
   STATISTIC(trace->whiteSegRefCount += ss->whiteSegRefCount);
@@ -311,6 +332,40 @@ static void traceSetUpdateCounts(TraceSet ts, Arena arena, ScanState ss,
 }
 
 
+/* traceTicks -- event clock ticks between two readings
+ *
+ * The event clock may be a per-processor counter, so allow for it
+ * going backwards if the thread migrates.
+ */
+
+static double traceTicks(EventClock start, EventClock end)
+{
+  return end > start ? (double)(end - start) : 0.0;
+}
+
+
+/* traceSetScanCost -- record the cost of scanning a segment
+ *
+ * See <design/strategy/#policy.model>.
+ */
+
+static void traceSetScanCost(TraceSet ts, Arena arena, Seg seg,
+                             Size scannedSize, double ticks)
+{
+  TraceId ti; Trace trace;
+  Pool pool = SegPool(seg);
+
+  TRACE_SET_ITER(ti, trace, ts, arena)
+    trace->segScanTicks += ticks;
+  TRACE_SET_ITER_END(ti, trace, ts, arena);
+
+  /* Only automatically managed pools have generations. */
+  if (PoolHasAttr(pool, AttrGC))
+    PoolGenAccountForScanCost(PoolSegPoolGen(pool, seg), scannedSize,
+                              ticks);
+}
+
+
 /* traceSetWhiteUnion
  *
  * Returns a ZoneSet describing the union of the white sets of all the
@@ -381,6 +436,11 @@ Res TraceAddWhite(Trace trace, Seg seg)
       trace->mayMove = ZoneSetUnion(trace->mayMove,
                                     ZoneSetOfSeg(trace->arena, seg));
     }
+
+    /* Frozen pools must be scanned if they might refer to the
+       condemned objects.  See .start.frozen. */
+    if (PoolFrozen(pool))
+      trace->frozenWhite = TRUE;
   }
 
   return ResOK;
@@ -483,9 +543,14 @@ static void traceFlipBuffers(Globals arena)
 }
 
 
-/* traceScanRootRes -- scan a root, with result code */
+/* traceScanRootRes -- scan a root, with result code
+ *
+ * If sliceSize is non-zero, a large root may be scanned one region at
+ * a time. If addr is not NULL, only the grey region of the root
+ * containing addr is scanned. See <design/root/#region>. */
 
-static Res traceScanRootRes(TraceSet ts, Rank rank, Arena arena, Root root)
+static Res traceScanRootRes(TraceSet ts, Rank rank, Arena arena, Root root,
+                            Size sliceSize, Addr addr)
 {
   ZoneSet white;
   Res res;
@@ -494,8 +559,12 @@ static Res traceScanRootRes(TraceSet ts, Rank rank, Arena arena, Root root)
   white = traceSetWhiteUnion(ts, arena);
 
   ScanStateInit(&ss, ts, arena, rank, white);
+  ss.sliceSize = sliceSize;
 
-  res = RootScan(&ss, root);
+  if (addr == NULL)
+    res = RootScan(&ss, root);
+  else
+    res = RootScanRegion(&ss, root, addr);
 
   traceSetUpdateCounts(ts, arena, &ss, traceAccountingPhaseRootScan);
   ScanStateFinish(&ss);
@@ -508,15 +577,16 @@ static Res traceScanRootRes(TraceSet ts, Rank rank, Arena arena, Root root)
  * Scan a root, entering emergency mode on allocation failure.
  */
 
-static Res traceScanRoot(TraceSet ts, Rank rank, Arena arena, Root root)
+static Res traceScanRoot(TraceSet ts, Rank rank, Arena arena, Root root,
+                         Size sliceSize, Addr addr)
 {
   Res res;
 
-  res = traceScanRootRes(ts, rank, arena, root);
+  res = traceScanRootRes(ts, rank, arena, root, sliceSize, addr);
 
   if (ResIsAllocFailure(res)) {
     ArenaSetEmergency(arena, TRUE);
-    res = traceScanRootRes(ts, rank, arena, root);
+    res = traceScanRootRes(ts, rank, arena, root, 0, addr);
     /* Should be OK in emergency mode */
     AVER(!ResIsAllocFailure(res));
   }
@@ -531,6 +601,7 @@ struct rootFlipClosureStruct {
   TraceSet ts;
   Arena arena;
   Rank rank;
+  Size sliceSize;
 };
 
 static Res rootFlip(Root root, void *p)
@@ -547,7 +618,8 @@ static Res rootFlip(Root root, void *p)
   AVER(RootRank(root) <= RankEXACT); /* see .root.rank */
 
   if(RootRank(root) == rf->rank) {
-    res = traceScanRoot(rf->ts, rf->rank, rf->arena, root);
+    res = traceScanRoot(rf->ts, rf->rank, rf->arena, root, rf->sliceSize,
+                        NULL);
     if (res != ResOK)
       return res;
   }
@@ -589,12 +661,17 @@ static Res traceFlip(Trace trace)
   Rank rank;
   struct rootFlipClosureStruct rfc;
   Res res;
+  Clock start, end;
 
   AVERT(Trace, trace);
   rfc.ts = TraceSetSingle(trace);
+  start = ClockNow();
 
   arena = trace->arena;
   rfc.arena = arena;
+  /* Large roots may be scanned after the flip: see
+     <design/root/#region.flip>. */
+  rfc.sliceSize = ArenaEmergency(arena) ? 0 : TraceSliceSIZE;
   ShieldHold(arena);
 
   AVER(trace->state == TraceUNFLIPPED);
@@ -653,6 +730,9 @@ static Res traceFlip(Trace trace)
   EVENT2(TraceFlipEnd, trace, arena);
 
   ShieldRelease(arena);
+  end = ClockNow();
+  trace->flipPause = end - start;
+  PauseStatsRecord(ArenaPauseStats(arena), PauseKindFLIP, start, end);
   return ResOK;
 
 failRootFlip:
@@ -708,11 +788,16 @@ found:
 
   trace->arena = arena;
   trace->why = why;
+  trace->startTime = ClockNow();
+  trace->flipPause = 0;
   trace->white = ZoneSetEMPTY;
   trace->mayMove = ZoneSetEMPTY;
+  trace->frozenWhite = FALSE;
   trace->ti = ti;
   trace->state = TraceINIT;
   trace->band = RankMIN;
+  trace->ephemeronProgress = TRUE;
+  trace->ephemeronSplat = FALSE;
   trace->fix = SegFix;
   trace->fixClosure = NULL;
   RingInit(&trace->genRing);
@@ -728,6 +813,7 @@ found:
   STATISTIC(trace->rootCopiedSize = (Size)0);
   STATISTIC(trace->segScanCount = (Count)0);
   trace->segScanSize = (Size)0; /* see .work */
+  trace->segScanTicks = 0.0;
   STATISTIC(trace->segCopiedSize = (Size)0);
   STATISTIC(trace->singleScanCount = (Count)0);
   STATISTIC(trace->singleScanSize = (Size)0);
@@ -879,9 +965,17 @@ static void traceReclaim(Trace trace)
       AVER_CRITICAL(!TraceSetIsMember(SegGrey(seg), trace));
       if (TraceSetIsMember(SegWhite(seg), trace)) {
         Addr base = SegBase(seg);
+        Size size = SegSize(seg);
+        PoolGen pgen;
+        EventClock reclaimStart, reclaimEnd;
         AVER_CRITICAL(PoolHasAttr(SegPool(seg), AttrGC));
+        pgen = PoolSegPoolGen(SegPool(seg), seg);
         STATISTIC(++trace->reclaimCount);
+        EVENT_CLOCK(reclaimStart);
         SegReclaim(seg, trace);
+        EVENT_CLOCK(reclaimEnd);
+        PoolGenAccountForReclaimCost(pgen, size,
+                                     traceTicks(reclaimStart, reclaimEnd));
 
         /* If the segment still exists, it should no longer be white. */
         /* Note that the seg returned by this SegOfAddr may not be */
@@ -901,6 +995,7 @@ static void traceReclaim(Trace trace)
   }
 
   trace->state = TraceFINISHED;
+  PolicyTraceEnd(trace);
 
   ArenaCompact(arena, trace);  /* let arenavm drop chunks */
 
@@ -917,6 +1012,12 @@ static void traceReclaim(Trace trace)
  * .scan.conservative: It's safe to scan at EXACT unless the band is
  * WEAK and in that case the segment should be weak.
  *
+ * If the trace band is still AMBIG, no segment has been scanned since
+ * the flip, but all ambiguous references were fixed at flip, so we
+ * scan EXACT. This happens if the MPS reads a grey segment on the
+ * mutator's behalf (for example, in MRGDeregister) before the trace
+ * has advanced.
+ *
  * If the trace band is EXACT then we scan EXACT. This might prevent
  * finalisation messages and may preserve objects pointed to only by weak
  * references but tough luck -- the mutator wants to look.
@@ -956,9 +1057,12 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
   rankSet = SegRankSet(seg);
   switch(band) {
   case RankAMBIG:
-    NOTREACHED;
-    break;
+    AVER(RingIsSingle(ArenaGreyRing(arena, RankAMBIG)));
+    return RankEXACT;
   case RankEXACT:
+  case RankEPHEMERON:
+    /* Scanning ephemerons at exact rank keeps their values alive, */
+    /* which is safe. */
     return RankEXACT;
   case RankFINAL:
     if(rankSet == RankSetSingle(RankFINAL)) {
@@ -978,6 +1082,45 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
   return RankEXACT;
 }
 
+/* traceEphemeronRound -- make pending ephemeron segments eligible
+ *
+ * Called when the only grey segments left in the band are pending
+ * (.check.ephemeron.pending).  If anything has been preserved since
+ * the last round, one of their keys may now be reachable, so they
+ * are scanned again.  Otherwise, in the final band, they are scanned
+ * once more to splat the ephemerons whose keys were not reached.
+ * Returns TRUE if any segment was made eligible.  See
+ * <design/trace/#ephemeron.round>.
+ */
+
+static Bool traceEphemeronRound(Trace trace)
+{
+  Arena arena = trace->arena;
+  Ring node, nextNode;
+  Bool found = FALSE;
+
+  if(trace->band != RankEPHEMERON && trace->band != RankFINAL)
+    return FALSE;
+
+  if(!trace->ephemeronProgress) {
+    /* Finalization may yet reach a key, so wait for the final band. */
+    if(trace->band == RankEPHEMERON)
+      return FALSE;
+    trace->ephemeronSplat = TRUE;
+  }
+
+  RING_FOR(node, ArenaGreyRing(arena, RankEPHEMERON), nextNode) {
+    Seg seg = SegOfGreyRing(node);
+    if(TraceSetIsMember(seg->pending, trace)) {
+      seg->pending = TraceSetDel(seg->pending, trace);
+      found = TRUE;
+    }
+  }
+  trace->ephemeronProgress = FALSE;
+  return found;
+}
+
+
 /* traceFindGrey -- find a grey segment
  *
  * This function finds the next segment to scan.  It does this according
@@ -1021,6 +1164,13 @@ Rank TraceRankForAccess(Arena arena, Seg seg)
  * expect to have to change the check if we introduce more ranks, or
  * start changing the semantics of them.  A flag is used to implement
  * this check.  See <http://info.ravenbrook.com/project/mps/issue/job001658/>.
+ * RankEPHEMERON is the exception: ephemeron segments are scanned
+ * again in rounds, interleaved with exact segments, until no more keys
+ * are reached.  See <design/trace/#ephemeron>.
+ *
+ * .check.ephemeron.pending: A segment that is pending for the trace
+ * (see <design/trace/#ephemeron.pending>) stays grey but is skipped
+ * until traceEphemeronRound makes it eligible again.
  *
  * For further discussion on the semantics of rank based tracing see
  * <http://info.ravenbrook.com/mail/2007/06/25/11-35-57/0.txt>
@@ -1053,14 +1203,15 @@ static Bool traceFindGrey(Seg *segReturn, Rank *rankReturn,
         AVER(SegGrey(seg) != TraceSetEMPTY);
         AVER(RankSetIsMember(SegRankSet(seg), rank));
 
-        if(TraceSetIsMember(SegGrey(seg), trace)) {
+        if(TraceSetIsMember(SegGrey(seg), trace)
+           && !TraceSetIsMember(seg->pending, trace)) {
           /* .check.band.weak */
           AVER(band != RankWEAK || rank == band);
           if(rank != band) {
             traceBandFirstStretchDone(trace);
           } else {
             /* .check.final.one-pass */
-            AVER(traceBandFirstStretch(trace));
+            AVER(rank == RankEPHEMERON || traceBandFirstStretch(trace));
           }
           *segReturn = seg;
           *rankReturn = rank;
@@ -1071,6 +1222,8 @@ static Bool traceFindGrey(Seg *segReturn, Rank *rankReturn,
     }
     /* .check.ambig.not */
     AVER(RingIsSingle(ArenaGreyRing(arena, RankAMBIG)));
+    if(traceEphemeronRound(trace))
+      continue;
     if(!traceBandAdvance(trace)) {
       /* No grey segments for this trace. */
       return FALSE;
@@ -1119,11 +1272,18 @@ RefSet ScanStateSummary(ScanState ss)
  * @@@@ During scanning, the segment should be write-shielded to prevent
  * any other threads from updating it while fix is being applied to it
  * (because fix is not atomic).  At the moment, we don't bother, because
- * we know that all threads are suspended.  */
+ * we know that all threads are suspended.
+ *
+ * If sliceSize is non-zero, the pool may scan a large segment in
+ * slices of that size, and the segment stays grey until its last
+ * slice is scanned.  See <design/trace/#scan.slice>.  */
 
-static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
+static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg,
+                           Size sliceSize)
 {
   Bool wasTotal;
+  Bool unfinished = FALSE;
+  Count pending = 0;
   ZoneSet white;
   Res res;
   RefSet summary;
@@ -1141,15 +1301,25 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
   } else {      /* scan it */
     ScanStateStruct ssStruct;
     ScanState ss = &ssStruct;
+    EventClock scanStart, scanEnd;
     ScanStateInit(ss, ts, arena, rank, white);
+    ss->sliceSize = sliceSize;
 
     /* Expose the segment to make sure we can scan it. */
     ShieldExpose(arena, seg);
+    EVENT_CLOCK(scanStart);
     res = SegScan(&wasTotal, seg, ss);
+    EVENT_CLOCK(scanEnd);
     /* Cover, regardless of result */
     ShieldCover(arena, seg);
+    unfinished = ss->unfinished;
+    AVER(!unfinished || !wasTotal);
+    pending = ss->pending;
+    AVER(pending == 0 || !ss->splat);
 
     traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
+    traceSetScanCost(ts, arena, seg, ss->scannedSize,
+                     traceTicks(scanStart, scanEnd));
     /* Count segments scanned pointlessly */
     STATISTIC({
       TraceId ti; Trace trace;
@@ -1183,8 +1353,9 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
         seg->defer = WB_DEFER_DELAY;
     }
 
-    /* Only apply the write barrier if it is not deferred. */
-    if (seg->defer == 0) {
+    /* Only apply the write barrier if it is not deferred, and never
+       to frozen segments, which aren't written (see PoolFreeze). */
+    if (seg->defer == 0 && !PoolFrozen(SegPool(seg))) {
       /* If we scanned every reference in the segment then we have a
          complete summary we can set. Otherwise, we just have
          information about more zones that the segment refers to. */
@@ -1200,10 +1371,16 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     ScanStateFinish(ss);
   }
 
-  if(res == ResOK) {
-    /* The segment is now black only if scan was successful. */
-    /* Remove the greyness from it. */
-    SegSetGrey(seg, TraceSetDiff(SegGrey(seg), ts));
+  if(res == ResOK && !unfinished) {
+    if(pending > 0) {
+      /* Some ephemerons are waiting for their keys, so the segment */
+      /* stays grey.  See <design/trace/#ephemeron.pending>. */
+      seg->pending = TraceSetUnion(seg->pending, ts);
+    } else {
+      /* The segment is now black only if scan was successful and */
+      /* complete.  Remove the greyness from it. */
+      SegSetGrey(seg, TraceSetDiff(SegGrey(seg), ts));
+    }
   }
 
   return res;
@@ -1216,14 +1393,15 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
  * failure.
  */
 
-static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg)
+static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg,
+                        Size sliceSize)
 {
   Res res;
 
-  res = traceScanSegRes(ts, rank, arena, seg);
+  res = traceScanSegRes(ts, rank, arena, seg, sliceSize);
   if(ResIsAllocFailure(res)) {
     ArenaSetEmergency(arena, TRUE);
-    res = traceScanSegRes(ts, rank, arena, seg);
+    res = traceScanSegRes(ts, rank, arena, seg, 0);
     /* Should be OK in emergency mode. */
     AVER(!ResIsAllocFailure(res));
   }
@@ -1232,11 +1410,74 @@ static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg)
 }
 
 
+/* TraceRootAccess -- handle barrier hit on a root
+ *
+ * An access to a grey region of a root scans that region. Any write
+ * hit that remains is handled by the root. See
+ * <design/root/#region.barrier>.
+ */
+
+void TraceRootAccess(Arena arena, Root root, Addr addr, AccessSet mode)
+{
+  AVERT(Arena, arena);
+  AVERT(Root, root);
+  AVERT(AccessSet, mode);
+
+  if (RootRegionIsGrey(root, addr)) {
+    Res res = traceScanRoot(arena->flippedTraces, RootRank(root), arena,
+                            root, 0, addr);
+    /* Allocation failures are handled by emergency mode. */
+    AVER(res == ResOK);
+    AVER(!RootRegionIsGrey(root, addr));
+  }
+
+  mode &= RootPM(root, addr);
+  if (mode != AccessSetEMPTY)
+    RootAccess(root, addr, mode);
+}
+
+
+/* TraceSegScanFlipped -- scan a grey segment for the flipped traces
+ *
+ * Scans all of a segment that is grey for a flipped trace, so that it
+ * is no longer grey for any, as if the mutator had hit its read
+ * barrier. Also used by pools whose segments are only read through
+ * the software barrier (see <design/poolmrg/#index.flip>).
+ */
+
+void TraceSegScanFlipped(Arena arena, Seg seg)
+{
+  Rank rank;
+  TraceSet traces;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVERT(Seg, seg);
+  AVER(TraceSetInter(SegGrey(seg), arena->flippedTraces) != TraceSetEMPTY);
+  AVER(SegRankSet(seg) != RankSetEMPTY);
+
+  /* Pick set of traces to scan for: */
+  traces = arena->flippedTraces;
+  rank = TraceRankForAccess(arena, seg);
+  /* The mutator is waiting for the segment, so scan all of it. */
+  res = traceScanSeg(traces, rank, arena, seg, 0);
+
+  /* Allocation failures should be handled my emergency mode, and we don't
+     expect any other kind of failure in a normal GC that causes access
+     faults. */
+  AVER(res == ResOK);
+
+  /* The pool should've done the job of removing the greyness that */
+  /* was causing the segment to be protected, so that the mutator */
+  /* can go ahead and access it. */
+  AVER(TraceSetInter(SegGrey(seg), traces) == TraceSetEMPTY);
+}
+
+
 /* TraceSegAccess -- handle barrier hit on a segment */
 
 void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 {
-  Res res;
   AccessSet shieldHit;
   Bool readHit, writeHit;
 
@@ -1265,32 +1506,14 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
     seg->defer = WB_DEFER_HIT;
 
   if (readHit) {
-    Rank rank;
-    TraceSet traces;
-
-    AVER(SegRankSet(seg) != RankSetEMPTY);
-
-    /* Pick set of traces to scan for: */
-    traces = arena->flippedTraces;
-    rank = TraceRankForAccess(arena, seg);
-    res = traceScanSeg(traces, rank, arena, seg);
-
-    /* Allocation failures should be handled my emergency mode, and we don't
-       expect any other kind of failure in a normal GC that causes access
-       faults. */
-    AVER(res == ResOK);
-
-    /* The pool should've done the job of removing the greyness that */
-    /* was causing the segment to be protected, so that the mutator */
-    /* can go ahead and access it. */
-    AVER(TraceSetInter(SegGrey(seg), traces) == TraceSetEMPTY);
+    TraceSegScanFlipped(arena, seg);
 
     STATISTIC({
       Trace trace;
       TraceId ti;
-      TRACE_SET_ITER(ti, trace, traces, arena)
+      TRACE_SET_ITER(ti, trace, arena->flippedTraces, arena)
         ++trace->readBarrierHitCount;
-      TRACE_SET_ITER_END(ti, trace, traces, arena);
+      TRACE_SET_ITER_END(ti, trace, arena->flippedTraces, arena);
     });
   }
 
@@ -1410,6 +1633,101 @@ done:
 }
 
 
+/* traceFixUnreached -- fix a reference unless its referent is unreached
+ *
+ * Fixes *refIO as a weak reference, to find out whether its referent
+ * has been reached, but leaves *refIO unchanged if it has not, instead
+ * of splatting it.  Sets *reachedReturn accordingly.
+ */
+
+static Res traceFixUnreached(Bool *reachedReturn, ScanState ss,
+                             mps_addr_t *refIO)
+{
+  mps_addr_t ref = *refIO;
+  Rank rank = ss->rank;
+  Res res;
+
+  if(ref == NULL
+     || !RefSetIsMember(ss->arena, ScanStateWhite(ss), ref)) {
+    *reachedReturn = TRUE;
+    return ResOK;
+  }
+  ss->rank = RankWEAK;
+  res = _mps_fix2(&ss->ss_s, &ref);
+  ss->rank = rank;
+  if(res != ResOK)
+    return res;
+  *reachedReturn = (ref != NULL);
+  if(ref != NULL)
+    *refIO = ref;
+  return ResOK;
+}
+
+
+/* _mps_fix_ephemeron -- fix an ephemeron
+ *
+ * An ephemeron is a pair of references, a key and a value, in which
+ * the value is only reachable if the key is reachable by some other
+ * path.  MPS_FIX_EPHEMERON has already applied MPS_FIX1 to both, so
+ * the unfixed summary is up to date.  See <design/trace/#ephemeron>.
+ */
+
+mps_res_t _mps_fix_ephemeron(mps_ss_t mps_ss, mps_addr_t *keyIO,
+                             mps_addr_t *valueIO)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  Bool reached;
+  Res res;
+
+  AVERT(ScanState, ss);
+  AVER(keyIO != NULL);
+  AVER(valueIO != NULL);
+
+  if(ss->rank != RankEPHEMERON) {
+    /* Not tracing ephemerons (for example, scanning the segment in */
+    /* response to a barrier hit), so both references are strong. */
+    if(*keyIO != NULL
+       && RefSetIsMember(ss->arena, ScanStateWhite(ss), *keyIO)) {
+      res = _mps_fix2(mps_ss, keyIO);
+      if(res != ResOK)
+        return res;
+    }
+    if(*valueIO != NULL
+       && RefSetIsMember(ss->arena, ScanStateWhite(ss), *valueIO))
+      return _mps_fix2(mps_ss, valueIO);
+    return ResOK;
+  }
+
+  res = traceFixUnreached(&reached, ss, keyIO);
+  if(res != ResOK)
+    return res;
+  if(!reached) {
+    if(ss->splat) {
+      /* <design/trace/#ephemeron.splat> */
+      *keyIO = NULL;
+      *valueIO = NULL;
+    } else {
+      /* <design/trace/#ephemeron.pending> */
+      ++ss->pending;
+      ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, *keyIO);
+      ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, *valueIO);
+    }
+    return ResOK;
+  }
+
+  /* The key is reachable, so the value is too. */
+  res = traceFixUnreached(&reached, ss, valueIO);
+  if(res != ResOK)
+    return res;
+  if(!reached) {
+    /* <design/trace/#ephemeron.progress> */
+    ss->progress = TRUE;
+    res = _mps_fix2(mps_ss, valueIO);
+  }
+  return res;
+}
+
+
 /* traceScanSingleRefRes -- scan a single reference, with result code */
 
 static Res traceScanSingleRefRes(TraceSet ts, Rank rank, Arena arena,
@@ -1577,7 +1895,12 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
         /* to the white set.  This is done by seeing if the summary */
         /* of references in the segment intersects with the */
         /* approximation to the white set. */
-        if(ZoneSetInter(SegSummary(seg), trace->white) != ZoneSetEMPTY) {
+        /* .start.frozen: Objects in a frozen pool only refer to */
+        /* objects in frozen pools or pools that are not garbage */
+        /* collected (see PoolFreeze), so unless the trace condemned */
+        /* some frozen objects, their segments needn't be scanned. */
+        if((trace->frozenWhite || !PoolFrozen(SegPool(seg)))
+           && ZoneSetInter(SegSummary(seg), trace->white) != ZoneSetEMPTY) {
           /* Note: can a white seg get greyed as well?  At this point */
           /* we still assume it may.  (This assumption runs out in */
           /* PoolTrivGrey). */
@@ -1658,10 +1981,27 @@ void TraceAdvance(Trace trace)
   case TraceFLIPPED: {
     Seg seg;
     Rank rank;
+    Root root;
+    /* Bound the work in this step: see <design/trace/#scan.slice>. */
+    Size sliceSize = ArenaEmergency(arena) ? 0 : TraceSliceSIZE;
 
-    if (traceFindGrey(&seg, &rank, arena, trace->ti)) {
+    /* Deferred root regions precede segments: see
+       <design/root/#region.advance>. */
+    if (RootOfGreyRegions(&root, arena)) {
+      Res res;
+      /* Ambiguous references were all fixed at flip, and the regions
+         are exact, so the exact band has begun. */
+      if (traceBand(trace) == RankAMBIG) {
+        AVER(RingIsSingle(ArenaGreyRing(arena, RankAMBIG)));
+        (void)traceBandAdvance(trace);
+      }
+      res = traceScanRoot(TraceSetSingle(trace), RootRank(root), arena,
+                          root, sliceSize, NULL);
+      AVER(res == ResOK);
+    } else if (traceFindGrey(&seg, &rank, arena, trace->ti)) {
       Res res;
-      res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
+      res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg,
+                         sliceSize);
       /* Allocation failures should be handled by emergency mode, and we
        * don't expect any other error in a normal GC trace. */
       AVER(res == ResOK);
@@ -1684,25 +2024,21 @@ void TraceAdvance(Trace trace)
 }
 
 
-/* TraceStartCollectAll: start a trace which condemns everything in
- * the arena.
+/* TraceCondemnAll -- condemn everything in the arena
  *
- * "why" is a TraceStartWhy* enum member that specifies why the
- * collection is starting. */
+ * If successful, set *mortalityReturn to an estimate of the mortality
+ * of the condemned memory and return ResOK.
+ */
 
-Res TraceStartCollectAll(Trace *traceReturn, Arena arena, TraceStartWhy why)
+Res TraceCondemnAll(double *mortalityReturn, Trace trace)
 {
-  Trace trace = NULL;
-  Res res;
-  double mortality, finishingTime;
+  Arena arena;
   Ring chainNode, chainNext;
 
-  AVERT(Arena, arena);
-  AVER(arena->busyTraces == TraceSetEMPTY);
-
-  res = TraceCreate(&trace, arena, why);
-  AVER(res == ResOK); /* succeeds because no other trace is busy */
+  AVER(mortalityReturn != NULL);
+  AVERT(Trace, trace);
 
+  arena = trace->arena;
   TraceCondemnStart(trace);
 
   /* Condemn all generations in all chains, plus the top generation. */
@@ -1718,7 +2054,29 @@ Res TraceStartCollectAll(Trace *traceReturn, Arena arena, TraceStartWhy why)
   }
   GenDescStartTrace(&arena->topGen, trace);
 
-  res = TraceCondemnEnd(&mortality, trace);
+  return TraceCondemnEnd(mortalityReturn, trace);
+}
+
+
+/* TraceStartCollectAll: start a trace which condemns everything in
+ * the arena.
+ *
+ * "why" is a TraceStartWhy* enum member that specifies why the
+ * collection is starting. */
+
+Res TraceStartCollectAll(Trace *traceReturn, Arena arena, TraceStartWhy why)
+{
+  Trace trace = NULL;
+  Res res;
+  double mortality, finishingTime;
+
+  AVERT(Arena, arena);
+  AVER(arena->busyTraces == TraceSetEMPTY);
+
+  res = TraceCreate(&trace, arena, why);
+  AVER(res == ResOK); /* succeeds because no other trace is busy */
+
+  res = TraceCondemnAll(&mortality, trace);
   if(res != ResOK) /* should try some other trace, really @@@@ */
     goto failCondemn;
   finishingTime = ArenaAvail(arena) - trace->condemned * (1.0 - mortality);
@@ -1780,9 +2138,12 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
   AVER(arena->busyTraces == TraceSetSingle(trace));
   oldWork = traceWork(trace);
   endWork = oldWork + trace->quantumWork;
+  /* Return to the policy before reclaiming, so that it can decide
+     whether the reclaim fits in the pause.  See
+     <design/strategy/#policy.model.pause>. */
   do {
     TraceAdvance(trace);
-  } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
+  } while (trace->state == TraceFLIPPED && traceWork(trace) < endWork);
   newWork = traceWork(trace);
   AVER(newWork >= oldWork);
   work = newWork - oldWork;
@@ -1822,8 +2183,10 @@ Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth)
                "  why \"$S\"\n", (WriteFS)TraceStartWhyToString(trace->why),
                "  state $S\n", (WriteFS)state,
                "  band $U\n", (WriteFU)trace->band,
+               "  flipPause $U\n", (WriteFU)trace->flipPause,
                "  white   $B\n", (WriteFB)trace->white,
                "  mayMove $B\n", (WriteFB)trace->mayMove,
+               "  frozenWhite $S\n", WriteFYesNo(trace->frozenWhite),
                "  condemned $U\n", (WriteFU)trace->condemned,
                "  notCondemned $U\n", (WriteFU)trace->notCondemned,
                "  foundation $U\n", (WriteFU)trace->foundation,
@@ -1832,6 +2195,7 @@ Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth)
                STATISTIC_WRITE("  rootCopiedSize $U\n",
                                (WriteFU)trace->rootCopiedSize)
                "  segScanSize $U\n", (WriteFU)trace->segScanSize,
+               "  segScanTicks $D\n", (WriteFD)trace->segScanTicks,
                STATISTIC_WRITE("  segCopiedSize $U\n",
                                (WriteFU)trace->segCopiedSize)
                "  forwardedSize $U\n", (WriteFU)trace->forwardedSize,
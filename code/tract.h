@@ -25,6 +25,7 @@
 #define PageStateALLOC 0    /* allocated to a pool as a tract */
 #define PageStateSPARE 1    /* free but mapped to backing store */
 #define PageStateFREE  2    /* free and unmapped (address space only) */
+#define PageStateLAZY  3    /* spare, but the OS may discard the contents */
 #define PageStateWIDTH 2    /* bitfield width */
 
 typedef union PagePoolUnion {
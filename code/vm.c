@@ -23,6 +23,9 @@ Bool VMCheck(VM vm)
   CHECKL(ArenaGrainSizeCheck(vm->pageSize));
   CHECKL(AddrIsAligned(vm->base, vm->pageSize));
   CHECKL(AddrIsAligned(vm->limit, vm->pageSize));
+  CHECKL(SizeIsAligned(vm->hugePageSize, vm->pageSize));
+  CHECKL(AddrIsAligned(vm->base, vm->hugePageSize));
+  CHECKL(AddrIsAligned(vm->limit, vm->hugePageSize));
   CHECKL(vm->block != NULL);
   CHECKL((Addr)vm->block <= vm->base);
   CHECKL(vm->mapped <= vm->reserved);
@@ -22,6 +22,7 @@
 typedef struct VMStruct {
   Sig sig;                      /* <design/sig/> */
   Size pageSize;                /* operating system page size */
+  Size hugePageSize;            /* huge page size, or pageSize if none */
   void *block;                  /* unaligned base of mmap'd memory */
   Addr base, limit;             /* aligned boundaries of reserved space */
   Size reserved;                /* total reserved address space */
@@ -30,6 +31,7 @@ typedef struct VMStruct {
 
 
 #define VMPageSize(vm) RVALUE((vm)->pageSize)
+#define VMHugePageSize(vm) RVALUE((vm)->hugePageSize)
 #define VMBase(vm) RVALUE((vm)->base)
 #define VMLimit(vm) RVALUE((vm)->limit)
 #define VMReserved(vm) RVALUE((vm)->reserved)
@@ -45,6 +47,7 @@ extern Addr (VMBase)(VM vm);
 extern Addr (VMLimit)(VM vm);
 extern Res VMMap(VM vm, Addr base, Addr limit);
 extern void VMUnmap(VM vm, Addr base, Addr limit);
+extern void VMLazyFree(VM vm, Addr base, Addr limit);
 extern Size (VMReserved)(VM vm);
 extern Size (VMMapped)(VM vm);
 extern void VMCopy(VM dest, VM src);
@@ -64,6 +64,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   (void)mps_lib_memset(vbase, VMJunkBYTE, reserved);
 
   vm->pageSize = pageSize;
+  vm->hugePageSize = pageSize;
   vm->block = vbase;
   vm->base  = AddrAlignUp(vbase, grainSize);
   vm->limit = AddrAdd(vm->base, size);
@@ -147,6 +148,22 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMLazyFree -- allow the OS to discard mapped memory
+ *
+ * There is no OS, so the memory is simply kept.
+ */
+
+void VMLazyFree(VM vm, Addr base, Addr limit)
+{
+  AVERT(VM, vm);
+  AVER(VMBase(vm) <= base);
+  AVER(base < limit);
+  AVER(limit <= VMLimit(vm));
+  AVER(AddrIsAligned(base, vm->pageSize));
+  AVER(AddrIsAligned(limit, vm->pageSize));
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.
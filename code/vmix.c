@@ -36,6 +36,22 @@
  * .remap: Possibly this should use mremap to reduce the number of
  * distinct mappings.  According to our current testing, it doesn't
  * seem to be a problem.
+ *
+ * .huge: If the client passes MPS_KEY_ARENA_HUGE_PAGES, and the
+ * platform supports transparent huge pages (that is, MADV_HUGEPAGE is
+ * defined: currently only Linux), then the reserved address space is
+ * aligned to VMIX_HUGE_PAGE_SIZE and every range that is mapped is
+ * advised to be backed by huge pages.  Reservations smaller than a
+ * huge page are left alone.  See <design/vm/#sol.huge>.
+ * MAP_HUGETLB is not used because it draws on a pool of huge pages
+ * that the system administrator must reserve in advance, and cannot
+ * be mapped and unmapped at page granularity.
+ *
+ * .lazy: VMLazyFree uses madvise(MADV_FREE) where it is defined
+ * (FreeBSD, Linux, and macOS).  The kernel may then reclaim the
+ * memory whenever it likes, in which case the pages read as zero;
+ * writing to a page cancels the advice.  This meets the contract
+ * <design/vm/#if.lazy-free>.  Elsewhere, VMLazyFree does nothing.
  */
 
 #include "mpm.h"
@@ -70,11 +86,26 @@ Size PageSize(void)
 }
 
 
+typedef struct VMParamsStruct {
+  Bool hugePages;
+} VMParamsStruct, *VMParams;
+
+static const VMParamsStruct vmParamsDefaults = {
+  /* .hugePages = */ FALSE,
+};
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
+  VMParams vmParams;
+  ArgStruct arg;
   AVER(params != NULL);
   AVERT(ArgList, args);
+  AVER(paramSize >= sizeof(VMParamsStruct));
   UNUSED(paramSize);
+  vmParams = (VMParams)params;
+  (void)mps_lib_memcpy(vmParams, &vmParamsDefaults, sizeof(VMParamsStruct));
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_HUGE_PAGES))
+    vmParams->hugePages = arg.val.b;
   return ResOK;
 }
 
@@ -83,7 +114,8 @@ Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 
 Res VMInit(VM vm, Size size, Size grainSize, void *params)
 {
-  Size pageSize, reserved;
+  Size pageSize, hugePageSize, align, reserved;
+  VMParams vmParams = params;
   void *vbase;
 
   AVER(vm != NULL);
@@ -96,12 +128,26 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   /* Grains must consist of whole pages. */
   AVER(grainSize % pageSize == 0);
 
+  /* See .huge. A reservation smaller than a huge page (such as the
+   * one for the arena structure) could never be backed by one. */
+  hugePageSize = pageSize;
+#if defined(MADV_HUGEPAGE)
+  if (vmParams->hugePages && VMIX_HUGE_PAGE_SIZE > pageSize
+      && size >= VMIX_HUGE_PAGE_SIZE)
+    hugePageSize = VMIX_HUGE_PAGE_SIZE;
+#else
+  UNUSED(vmParams);
+#endif
+  align = grainSize > hugePageSize ? grainSize : hugePageSize;
+  AVER(align % grainSize == 0);
+  AVER(align % hugePageSize == 0);
+
   /* Check that the rounded-up sizes will fit in a Size. */
-  size = SizeRoundUp(size, grainSize);
-  if (size < grainSize || size > (Size)(size_t)-1)
+  size = SizeRoundUp(size, align);
+  if (size < align || size > (Size)(size_t)-1)
     return ResRESOURCE;
-  reserved = size + grainSize - pageSize;
-  if (reserved < grainSize || reserved > (Size)(size_t)-1)
+  reserved = size + align - pageSize;
+  if (reserved < align || reserved > (Size)(size_t)-1)
     return ResRESOURCE;
 
   /* See .assume.not-last. */
@@ -118,8 +164,9 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   }
 
   vm->pageSize = pageSize;
+  vm->hugePageSize = hugePageSize;
   vm->block = vbase;
-  vm->base = AddrAlignUp(vbase, grainSize);
+  vm->base = AddrAlignUp(vbase, align);
   vm->limit = AddrAdd(vm->base, size);
   AVER(vm->base < vm->limit);  /* .assume.not-last */
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
@@ -181,6 +228,14 @@ Res VMMap(VM vm, Addr base, Addr limit)
     return ResMEMORY;
   }
 
+#if defined(MADV_HUGEPAGE)
+  /* The mapping replaced the advice for this range, so give it again.
+   * Failure is harmless (for example, the kernel may have transparent
+   * huge pages disabled): the memory is backed by small pages. */
+  if (vm->hugePageSize > vm->pageSize)
+    (void)madvise((void *)base, (size_t)size, MADV_HUGEPAGE);
+#endif
+
   vm->mapped += size;
   AVER(VMMapped(vm) <= VMReserved(vm));
 
@@ -218,6 +273,28 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMLazyFree -- allow the OS to discard mapped memory
+ *
+ * See .lazy.
+ */
+
+void VMLazyFree(VM vm, Addr base, Addr limit)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVER(base >= VMBase(vm));
+  AVER(limit <= VMLimit(vm));
+  AVER(AddrIsAligned(base, vm->pageSize));
+  AVER(AddrIsAligned(limit, vm->pageSize));
+
+#if defined(MADV_FREE)
+  /* Failure is harmless (for example, kernels before Linux 4.5 don't
+   * support MADV_FREE): the memory just stays resident. */
+  (void)madvise((void *)base, (size_t)AddrOffset(base, limit), MADV_FREE);
+#endif
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2018 Ravenbrook Limited <http://www.ravenbrook.com/>.
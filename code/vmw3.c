@@ -132,6 +132,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(AddrIsAligned(vbase, pageSize));
 
   vm->pageSize = pageSize;
+  vm->hugePageSize = pageSize;
   vm->block = vbase;
   vm->base = AddrAlignUp(vbase, grainSize);
   vm->limit = AddrAdd(vm->base, size);
@@ -227,6 +228,25 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMLazyFree -- allow the OS to discard mapped memory
+ *
+ * .lazy.no-reset: This does nothing.  VirtualAlloc with MEM_RESET
+ * would allow the OS to discard the pages, but leaves their contents
+ * undefined rather than zero, which doesn't meet the contract
+ * <design/vm/#if.lazy-free>.
+ */
+
+void VMLazyFree(VM vm, Addr base, Addr limit)
+{
+  AVERT(VM, vm);
+  AVER(AddrIsAligned(base, vm->pageSize));
+  AVER(AddrIsAligned(limit, vm->pageSize));
+  AVER(VMBase(vm) <= base);
+  AVER(base < limit);
+  AVER(limit <= VMLimit(vm));
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2018 Ravenbrook Limited <http://www.ravenbrook.com/>.
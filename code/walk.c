@@ -6,6 +6,7 @@
 
 #include "mpm.h"
 #include "mps.h"
+#include "table.h"
 
 SRCID(walk, "$Id$");
 
@@ -109,6 +110,610 @@ void mps_arena_formatted_objects_walk(mps_arena_t mps_arena,
 
 
 
+/* Parallel heap walking
+ *
+ * .parallel: mps_arena_formatted_objects_walk_parallel divides the
+ * formatted segments among several workers, which the client runs on
+ * threads of its own choosing: the walk doesn't create threads.  The
+ * calling thread holds the arena lock for the whole walk, and exposes
+ * all the segments before any worker starts and covers them after
+ * they have all finished, so the workers only read segments (the
+ * pools' walk methods don't change MPS state) and never touch the
+ * shield.
+ *
+ * .parallel.balance: Each worker gets a run of segments that are
+ * adjacent in address order and whose sizes add up to roughly an
+ * equal share of the total.
+ */
+
+#define ParallelWalkSig ((Sig)0x519BA3A1) /* SIGnature PARallel wALk */
+
+typedef struct ParallelWalkStruct *ParallelWalk;
+
+typedef struct ParallelWalkStruct {
+  Sig sig;
+  Arena arena;
+  mps_formatted_objects_stepper_t f;
+  void **ps;                    /* one client closure per worker */
+  size_t s;
+  Count workers;                /* number of workers */
+  Index *starts;                /* first segment of each worker, then count */
+  Seg *segs;                    /* formatted segments in address order */
+  Count count;                  /* number of formatted segments */
+} ParallelWalkStruct;
+
+
+ATTRIBUTE_UNUSED
+static Bool ParallelWalkCheck(ParallelWalk pw)
+{
+  CHECKS(ParallelWalk, pw);
+  CHECKU(Arena, pw->arena);
+  CHECKL(FUNCHECK(pw->f));
+  CHECKL(pw->ps != NULL);
+  CHECKL(pw->workers > 0);
+  CHECKL(pw->starts != NULL);
+  CHECKL(pw->starts[0] == 0);
+  CHECKL(pw->starts[pw->workers] == pw->count);
+  CHECKL(pw->count == 0 || pw->segs != NULL);
+  return TRUE;
+}
+
+
+/* parallelWalkWork -- walk the segments belonging to one worker
+ *
+ * Called by the client's runner, possibly on a thread that doesn't
+ * hold the arena lock.  See .parallel.
+ */
+
+static void parallelWalkWork(void *p, size_t worker)
+{
+  ParallelWalk pw = p;
+  FormattedObjectsStepClosureStruct c;
+  Index i;
+
+  AVERT(ParallelWalk, pw);
+  AVER(worker < pw->workers);
+
+  c.sig = FormattedObjectsStepClosureSig;
+  c.f = pw->f;
+  c.p = pw->ps[worker];
+  c.s = pw->s;
+
+  for (i = pw->starts[worker]; i < pw->starts[worker + 1]; ++i) {
+    Seg seg = pw->segs[i];
+    Format format;
+    Bool b = PoolFormat(&format, SegPool(seg));
+    AVER(b);
+    SegWalk(seg, format, ArenaFormattedObjectsStep, &c, UNUSED_SIZE);
+  }
+}
+
+
+/* ArenaFormattedObjectsWalkParallel -- iterate over all objects using
+ * several workers */
+
+static Res ArenaFormattedObjectsWalkParallel(Arena arena,
+                                             mps_formatted_objects_stepper_t f,
+                                             void **ps, size_t s,
+                                             Count workers,
+                                             mps_walk_runner_t runner,
+                                             void *runnerP)
+{
+  ParallelWalkStruct pwStruct;
+  Seg seg;
+  Format format;
+  Count count, worker;
+  Size total, sofar, share;
+  Index i;
+  void *block;
+  size_t blockSize;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(f));
+  AVER(ps != NULL);
+  AVER(workers > 0);
+  AVER(FUNCHECK(runner));
+
+  /* Count the formatted segments and their total size. */
+  count = 0;
+  total = 0;
+  if (SegFirst(&seg, arena)) {
+    do {
+      if (PoolFormat(&format, SegPool(seg))) {
+        ++count;
+        total += SegSize(seg);
+      }
+    } while (SegNext(&seg, arena, seg));
+  }
+
+  blockSize = (workers + 1) * sizeof(Index) + count * sizeof(Seg);
+  res = ControlAlloc(&block, arena, blockSize);
+  if (res != ResOK)
+    return res;
+  pwStruct.starts = block;
+  pwStruct.segs = (Seg *)&pwStruct.starts[workers + 1];
+
+  /* Divide the segments among the workers. .parallel.balance */
+  share = total / workers;
+  i = 0;
+  worker = 0;
+  sofar = 0;
+  pwStruct.starts[0] = 0;
+  if (SegFirst(&seg, arena)) {
+    do {
+      if (PoolFormat(&format, SegPool(seg))) {
+        while (worker + 1 < workers && sofar >= share * (worker + 1))
+          pwStruct.starts[++worker] = i;
+        pwStruct.segs[i] = seg;
+        sofar += SegSize(seg);
+        ++i;
+      }
+    } while (SegNext(&seg, arena, seg));
+  }
+  AVER(i == count);
+  while (worker < workers)
+    pwStruct.starts[++worker] = count;
+
+  pwStruct.arena = arena;
+  pwStruct.f = f;
+  pwStruct.ps = ps;
+  pwStruct.s = s;
+  pwStruct.workers = workers;
+  pwStruct.count = count;
+  pwStruct.sig = ParallelWalkSig;
+  AVERT(ParallelWalk, &pwStruct);
+
+  for (i = 0; i < count; ++i)
+    ShieldExpose(arena, pwStruct.segs[i]);
+  (*runner)(parallelWalkWork, &pwStruct, workers, runnerP);
+  for (i = 0; i < count; ++i)
+    ShieldCover(arena, pwStruct.segs[i]);
+
+  pwStruct.sig = SigInvalid;
+  ControlFree(arena, block, blockSize);
+  return ResOK;
+}
+
+
+/* mps_arena_formatted_objects_walk_parallel -- iterate over all
+ * objects using several workers
+ *
+ * Client interface to ArenaFormattedObjectsWalkParallel.  */
+
+mps_res_t mps_arena_formatted_objects_walk_parallel(mps_arena_t mps_arena,
+                                                    mps_formatted_objects_stepper_t f,
+                                                    void **ps, size_t s,
+                                                    size_t workers,
+                                                    mps_walk_runner_t runner,
+                                                    void *runner_p)
+{
+  Arena arena = (Arena)mps_arena;
+  Res res;
+
+  ArenaEnter(arena);
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(f));
+  AVER(ps != NULL);
+  AVER(workers > 0);
+  AVER(FUNCHECK(runner));
+  /* ps[i], s and runner_p are arbitrary closures, hence can't be */
+  /* checked */
+  res = ArenaFormattedObjectsWalkParallel(arena, f, ps, s, workers,
+                                          runner, runner_p);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+
+/* Heap census
+ *
+ * .census: mps_arena_census walks the formatted objects as
+ * mps_arena_formatted_objects_walk does, and counts the objects and
+ * their total size for each pool, generation and class, where the
+ * class of an object is given by its format's class method.  The
+ * counts are kept in a table keyed by class, whose value is a list of
+ * buckets, one for each pool and generation in which objects of that
+ * class were found.  There are few of these, so the list is short.
+ *
+ * .census.key: A table needs two keys that are never used, but the
+ * class comes from the client's format and may be any word (the
+ * default class method returns the first word of the object).  So the
+ * census picks two unlikely words, unaligned addresses at the top of
+ * memory, and keeps the buckets for those classes in the census
+ * itself rather than in the table.
+ */
+
+#define censusUNUSED    ((TableKey)-1)
+#define censusDELETED   ((TableKey)-2)
+#define censusINITIAL   ((Count)64)
+
+typedef struct CensusBucketStruct *CensusBucket;
+
+typedef struct CensusBucketStruct {
+  CensusBucket next;            /* next bucket for the same class */
+  Pool pool;                    /* pool of the objects */
+  GenDesc gen;                  /* generation, or NULL if pool has none */
+  Count count;                  /* number of objects */
+  Size size;                    /* total size of objects */
+} CensusBucketStruct;
+
+#define CensusSig ((Sig)0x519CE115) /* SIGnature CENSUs */
+
+typedef struct CensusStruct *Census;
+
+typedef struct CensusStruct {
+  Sig sig;
+  Arena arena;
+  Table table;                  /* class -> list of buckets */
+  CensusBucket unused;          /* buckets for class censusUNUSED */
+  CensusBucket deleted;         /* buckets for class censusDELETED */
+  GenDesc gen;                  /* generation of segment being walked */
+  Res res;                      /* first failure, or ResOK */
+  mps_census_stepper_t f;       /* client function */
+  void *p;                      /* client closure */
+  size_t s;                     /* client closure */
+} CensusStruct;
+
+
+ATTRIBUTE_UNUSED
+static Bool CensusCheck(Census census)
+{
+  CHECKS(Census, census);
+  CHECKU(Arena, census->arena);
+  CHECKD(Table, census->table);
+  if (census->gen != NULL)
+    CHECKD(GenDesc, census->gen);
+  CHECKL(FUNCHECK(census->f));
+  /* p and s fields are arbitrary closures which cannot be checked */
+  return TRUE;
+}
+
+
+/* censusStep -- count one object */
+
+static void censusStep(Addr object, Format format, Pool pool,
+                       void *p, size_t s)
+{
+  Census census = p;
+  TableKey key;
+  TableValue value;
+  CensusBucket bucket, *head;
+  Size size;
+  Res res;
+
+  AVERT(Format, format);
+  AVERT(Pool, pool);
+  AVERT(Census, census);
+  AVER(s == UNUSED_SIZE);
+
+  if (census->res != ResOK)
+    return;
+
+  key = (TableKey)(*format->klass)((mps_addr_t)object);
+  size = AddrOffset(object, (*format->skip)(object));
+
+  /* See .census.key. */
+  if (key == censusUNUSED)
+    head = &census->unused;
+  else if (key == censusDELETED)
+    head = &census->deleted;
+  else
+    head = NULL;
+
+  if (head != NULL)
+    value = *head;
+  else if (!TableLookup(&value, census->table, key))
+    value = NULL;
+  for (bucket = value; bucket != NULL; bucket = bucket->next)
+    if (bucket->pool == pool && bucket->gen == census->gen)
+      break;
+
+  if (bucket == NULL) {
+    void *base;
+    res = ControlAlloc(&base, census->arena, sizeof(CensusBucketStruct));
+    if (res != ResOK) {
+      census->res = res;
+      return;
+    }
+    bucket = base;
+    bucket->next = value;
+    bucket->pool = pool;
+    bucket->gen = census->gen;
+    bucket->count = 0;
+    bucket->size = 0;
+    if (head != NULL) {
+      *head = bucket;
+      res = ResOK;
+    } else if (value == NULL) {
+      res = TableDefine(census->table, key, bucket);
+    } else {
+      res = TableRedefine(census->table, key, bucket);
+    }
+    if (res != ResOK) {
+      ControlFree(census->arena, bucket, sizeof(CensusBucketStruct));
+      census->res = res;
+      return;
+    }
+  }
+
+  ++bucket->count;
+  bucket->size += size;
+}
+
+
+/* censusReport -- pass the buckets for one class to the client */
+
+static void censusReport(void *closure, TableKey key, TableValue value)
+{
+  Census census = closure;
+  CensusBucket bucket;
+
+  AVERT(Census, census);
+
+  for (bucket = value; bucket != NULL; bucket = bucket->next) {
+    Index gen = 0;
+    if (bucket->gen != NULL
+        && !GenDescIndex(&gen, census->arena, bucket->gen))
+      gen = MPS_CENSUS_GEN_TOP;
+    (*census->f)((mps_pool_t)bucket->pool, (size_t)gen, (mps_addr_t)key,
+                 (size_t)bucket->count, (size_t)bucket->size,
+                 census->p, census->s);
+  }
+}
+
+
+/* censusFreeBuckets -- free the buckets for one class */
+
+static void censusFreeBuckets(void *closure, TableKey key, TableValue value)
+{
+  Census census = closure;
+  CensusBucket bucket, next;
+
+  AVERT(Census, census);
+  UNUSED(key);
+
+  for (bucket = value; bucket != NULL; bucket = next) {
+    next = bucket->next;
+    ControlFree(census->arena, bucket, sizeof(CensusBucketStruct));
+  }
+}
+
+
+/* ArenaCensus -- count the formatted objects in the arena */
+
+static Res ArenaCensus(Arena arena, mps_census_stepper_t f,
+                       void *p, size_t s)
+{
+  CensusStruct censusStruct;
+  Census census = &censusStruct;
+  Seg seg;
+  Format format;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(f));
+
+  res = TableCreate(&census->table, censusINITIAL, ControlTableAlloc,
+                    ControlTableFree, arena, censusUNUSED, censusDELETED);
+  if (res != ResOK)
+    return res;
+  census->arena = arena;
+  census->unused = NULL;
+  census->deleted = NULL;
+  census->gen = NULL;
+  census->res = ResOK;
+  census->f = f;
+  census->p = p;
+  census->s = s;
+  census->sig = CensusSig;
+  AVERT(Census, census);
+
+  if (SegFirst(&seg, arena)) {
+    do {
+      Pool pool = SegPool(seg);
+      if (PoolFormat(&format, pool)) {
+        if (PoolHasAttr(pool, AttrGC))
+          census->gen = PoolSegPoolGen(pool, seg)->gen;
+        else
+          census->gen = NULL;
+        ShieldExpose(arena, seg);
+        SegWalk(seg, format, censusStep, census, UNUSED_SIZE);
+        ShieldCover(arena, seg);
+      }
+    } while (census->res == ResOK && SegNext(&seg, arena, seg));
+  }
+
+  res = census->res;
+  if (res == ResOK) {
+    TableMap(census->table, censusReport, census);
+    censusReport(census, censusUNUSED, census->unused);
+    censusReport(census, censusDELETED, census->deleted);
+  }
+  TableMap(census->table, censusFreeBuckets, census);
+  censusFreeBuckets(census, censusUNUSED, census->unused);
+  censusFreeBuckets(census, censusDELETED, census->deleted);
+  TableDestroy(census->table);
+  census->sig = SigInvalid;
+  return res;
+}
+
+
+/* mps_arena_census -- count the formatted objects in the arena
+ *
+ * Client interface to ArenaCensus.  */
+
+mps_res_t mps_arena_census(mps_arena_t mps_arena, mps_census_stepper_t f,
+                           void *p, size_t s)
+{
+  Arena arena = (Arena)mps_arena;
+  Res res;
+
+  ArenaEnter(arena);
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(f));
+  /* p and s are arbitrary closures, hence can't be checked */
+  res = ArenaCensus(arena, f, p, s);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* Freezing pools
+ *
+ * .freeze: A frozen pool promises that its objects won't be written
+ * again, and that they only refer to objects in frozen pools, or in
+ * pools that aren't garbage collected (.freeze.closed).  Its
+ * segments are then left without a write barrier, and a trace only
+ * scans them if it condemned some frozen objects.  See
+ * <code/trace.c#start.frozen>.
+ *
+ * .freeze.closed: The closure is checked by scanning every object in
+ * the pool with a trace for which every segment except the pool's
+ * own is white, so that freezeFix sees every reference out of the
+ * pool.
+ *
+ * .freeze.parked: The arena must be parked, so that the pool's
+ * segments are neither grey nor white for any other trace, and so
+ * that a trace is available (compare .assume.parked).
+ */
+
+typedef struct FreezeScanStateStruct {
+  ScanStateStruct ssStruct;     /* generic scan state object */
+  Pool pool;                    /* pool being frozen */
+  Res res;                      /* result of scanning so far */
+} FreezeScanStateStruct, *FreezeScanState;
+
+#define ScanState2FreezeScanState(ss) \
+  PARENT(FreezeScanStateStruct, ssStruct, ss)
+
+
+/* freezeFix -- check a reference out of a pool being frozen */
+
+static Res freezeFix(Seg seg, ScanState ss, Ref *refIO)
+{
+  Pool pool;
+
+  AVERT(Seg, seg);
+  AVERT(ScanState, ss);
+  AVER(refIO != NULL);
+
+  pool = SegPool(seg);
+  if (pool == ScanState2FreezeScanState(ss)->pool || PoolFrozen(pool)
+      || !PoolHasAttr(pool, AttrGC))
+    return ResOK;
+  return ResFAIL; /* .freeze.closed */
+}
+
+
+/* freezeStep -- scan one object in a pool being frozen */
+
+static void freezeStep(Addr object, Format format, Pool pool,
+                       void *p, size_t s)
+{
+  FreezeScanState fss = p;
+
+  AVER(fss->pool == pool);
+  UNUSED(s);
+
+  if (fss->res == ResOK)
+    fss->res = FormatScan(format, &fss->ssStruct, object,
+                          (*format->skip)(object));
+}
+
+
+/* PoolFreeze -- make the objects in a pool immutable */
+
+static Res PoolFreeze(Pool pool)
+{
+  Arena arena = PoolArena(pool);
+  FreezeScanStateStruct fssStruct;
+  ScanState ss = &fssStruct.ssStruct;
+  Format format;
+  Trace trace;
+  Ring node, next;
+  Res res;
+
+  if (!PoolFormat(&format, pool) || !PoolHasAttr(pool, AttrGC))
+    return ResPARAM;
+  if (PoolFrozen(pool))
+    return ResOK;
+
+  /* Objects can't be allocated in a frozen pool, so it mustn't have */
+  /* allocation points. See also BufferCreate. */
+  RING_FOR(node, &pool->bufferRing, next) {
+    Buffer buffer = RING_ELT(Buffer, poolRing, node);
+    if (BufferIsMutator(buffer))
+      return ResPARAM;
+  }
+
+  res = WalkTraceCreate(&trace, arena);
+  if (res != ResOK)
+    return res;
+
+  /* Only references out of the pool are fixed. */
+  RING_FOR(node, PoolSegRing(pool), next) {
+    Seg seg = SegOfPoolRing(node);
+    SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
+  }
+
+  ScanStateInit(ss, TraceSetSingle(trace), arena, RankEXACT,
+                trace->white);
+  ss->fix = freezeFix;
+  fssStruct.pool = pool;
+  fssStruct.res = ResOK;
+
+  RING_FOR(node, PoolSegRing(pool), next) {
+    Seg seg = SegOfPoolRing(node);
+    if (SegRankSet(seg) != RankSetEMPTY) {
+      ShieldExpose(arena, seg);
+      SegWalk(seg, format, freezeStep, &fssStruct, UNUSED_SIZE);
+      ShieldCover(arena, seg);
+      if (fssStruct.res != ResOK)
+        break;
+    }
+  }
+  res = fssStruct.res;
+
+  ScanStateFinish(ss);
+  WalkTraceDestroy(trace);
+  if (res != ResOK)
+    return res;
+
+  /* The objects won't change, so the write barrier is useless. */
+  RING_FOR(node, PoolSegRing(pool), next) {
+    Seg seg = SegOfPoolRing(node);
+    if (SegRankSet(seg) != RankSetEMPTY)
+      SegSetSummary(seg, RefSetUNIV);
+  }
+  pool->frozen = TRUE;
+  return ResOK;
+}
+
+
+/* mps_pool_freeze -- make the objects in a pool immutable
+ *
+ * Client interface to PoolFreeze.  */
+
+mps_res_t mps_pool_freeze(mps_pool_t pool)
+{
+  Arena arena;
+  Res res;
+
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+  AVERT(Pool, pool);
+  AVER(ArenaGlobals(arena)->clamped);          /* .freeze.parked */
+  AVER(arena->busyTraces == TraceSetEMPTY);    /* .freeze.parked */
+  res = PoolFreeze(pool);
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
 /* Root Walking
  *
  * This involves more code than it should. The roots are walked by
@@ -279,6 +884,72 @@ static Res rootWalkGrey(Root root, void *p)
 }
 
 
+/* WalkTraceCreate -- create a trace for which everything is white
+ *
+ * The trace is flipped, so that every reference into the arena can be
+ * fixed by a scan state for it, as in ArenaRootsWalk.  The arena must
+ * be parked (.assume.parked).
+ */
+
+Res WalkTraceCreate(Trace *traceReturn, Arena arena)
+{
+  Trace trace;
+  Seg seg;
+  Res res;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+
+  res = TraceCreate(&trace, arena, TraceStartWhyWALK);
+  /* Have to fail if no trace available.  Unlikely due to .assume.parked. */
+  if (res != ResOK)
+    return res;
+
+  /* See .roots-walk.first-stage. */
+  trace->white = ZoneSetUNIV;
+
+  /* See .roots-walk.second-stage. */
+  if (SegFirst(&seg, arena)) {
+    do {
+      SegSetWhite(seg, TraceSetAdd(SegWhite(seg), trace));
+    } while (SegNext(&seg, arena, seg));
+  }
+
+  /* Make this trace look like any other trace. */
+  arena->flippedTraces = TraceSetAdd(arena->flippedTraces, trace);
+
+  *traceReturn = trace;
+  return ResOK;
+}
+
+
+/* WalkTraceDestroy -- destroy a trace made by WalkTraceCreate */
+
+void WalkTraceDestroy(Trace trace)
+{
+  Arena arena;
+  Seg seg;
+
+  /* Can't check trace: it's flipped but still in TraceINIT. */
+  AVER(trace != NULL);
+  arena = trace->arena;
+  AVER(trace->state == TraceINIT);
+  AVER(TraceSetIsMember(arena->flippedTraces, trace));
+
+  /* Turn segments black again. */
+  if (SegFirst(&seg, arena)) {
+    do {
+      SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
+    } while (SegNext(&seg, arena, seg));
+  }
+
+  /* Make this trace look like any other finished trace. */
+  trace->state = TraceFINISHED;
+  TraceDestroyFinished(trace);
+  AVER(!ArenaEmergency(arena)); /* There was no allocation. */
+}
+
+
 /* ArenaRootsWalk -- walks all the root in the arena */
 
 static Res ArenaRootsWalk(Globals arenaGlobals, mps_roots_stepper_t f,
@@ -20,6 +20,8 @@
 #include "mpm.h"
 
 #include <stdio.h> /* printf */
+#include <stdlib.h> /* realloc */
+#include <string.h> /* memcpy */
 
 #define testArenaSIZE     ((size_t)((size_t)64 << 20))
 #define avLEN             3
@@ -138,6 +140,27 @@ static void object_stepper(mps_addr_t object, mps_fmt_t format,
 }
 
 
+/* walk_runner -- run the workers of a parallel walk
+ *
+ * The workers may run on any threads in any order.  Running them one
+ * at a time on this thread, last first, checks that they don't depend
+ * on each other, and lets object_stepper call back into the MPS.
+ */
+
+#define walkWORKERS 4
+
+static void walk_runner(mps_walk_work_t work, void *work_p, size_t workers,
+                        void *p)
+{
+    size_t i;
+
+    Insist(workers == walkWORKERS);
+    testlib_unused(p);
+    for (i = workers; i > 0; --i)
+        (*work)(work_p, i - 1);
+}
+
+
 /* A roots stepper function. Passed to mps_arena_roots_walk. */
 
 typedef struct roots_stepper_data {
@@ -156,19 +179,155 @@ static void roots_stepper(mps_addr_t *ref, mps_root_t root, void *p, size_t s)
 }
 
 
+/* A census stepper function. Passed to mps_arena_census.
+ *
+ * Accumulates the counts and sizes that MPS passes to it, separating
+ * padding objects (which have no class) from the others.
+ */
+typedef struct census_stepper_data {
+  mps_pool_t expect_pool;
+  size_t classes;               /* number of distinct classes */
+  size_t count;                 /* number of non-padding objects */
+  size_t objSize;               /* total size of non-padding objects */
+  size_t padSize;               /* total size of padding objects */
+} census_stepper_data_s, *census_stepper_data_t;
+
+static void census_stepper(mps_pool_t pool, size_t gen, mps_addr_t klass,
+                           size_t count, size_t size, void *p, size_t s)
+{
+  census_stepper_data_t data = p;
+  Insist(s == sizeof *data);
+  Insist(pool == data->expect_pool);
+  Insist(gen < genCOUNT || gen == MPS_CENSUS_GEN_TOP);
+  Insist(count > 0);
+  if (klass == NULL) {
+    data->padSize += size;
+  } else {
+    ++ data->classes;
+    data->count += count;
+    data->objSize += size;
+  }
+}
+
+
+/* Image writer and reader, keeping the image in memory. */
+
+static char *imageBuf;
+static size_t imageLen, imageMax, imagePos;
+
+static mps_res_t image_write(const void *buf, size_t size, void *p)
+{
+  testlib_unused(p);
+  if (imageLen + size > imageMax) {
+    size_t newMax = imageMax == 0 ? 4096 : imageMax;
+    char *newBuf;
+    while (newMax < imageLen + size)
+      newMax *= 2;
+    newBuf = realloc(imageBuf, newMax);
+    if (newBuf == NULL)
+      return MPS_RES_MEMORY;
+    imageBuf = newBuf;
+    imageMax = newMax;
+  }
+  memcpy(imageBuf + imageLen, buf, size);
+  imageLen += size;
+  return MPS_RES_OK;
+}
+
+static mps_res_t image_read(void *buf, size_t size, void *p)
+{
+  testlib_unused(p);
+  if (size > imageLen - imagePos)
+    return MPS_RES_IO;
+  memcpy(buf, imageBuf + imagePos, size);
+  imagePos += size;
+  return MPS_RES_OK;
+}
+
+
+/* test_image_fail -- check that reading a corrupt image fails cleanly
+ *
+ * Spoils the image in imageBuf.  First the header claims impossibly
+ * many runs, then impossibly many padding objects, and the read must
+ * fail without reading the runs.  Then the bit table claims that every
+ * word is a reference, so relocation fails after all the runs have
+ * been read: they must have been replaced with padding, so that the
+ * pool can be walked and collected <code/image.c#fail>.
+ */
+
+#define imageHeaderALIGN 3  /* indexes of header words */
+#define imageHeaderRUNS 5   /* <code/image.c#layout> */
+#define imageHeaderPADS 6
+#define imageHeaderSIZE 7
+
+static void test_image_fail(mps_arena_t arena, mps_fmt_t format,
+                            mps_chain_t chain, mps_pool_class_t pool_class)
+{
+    mps_word_t *header = (mps_word_t *)imageBuf;
+    mps_word_t saved;
+    mps_pool_t pool;
+    object_stepper_data_s sd;
+    size_t btSize;
+
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+        MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+        die(mps_pool_create_k(&pool, arena, pool_class, args), "pool_create");
+    } MPS_ARGS_END(args);
+    die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+
+    saved = header[imageHeaderRUNS];
+    header[imageHeaderRUNS] = (mps_word_t)-1;
+    imagePos = 0;
+    Insist(mps_ap_image_read(ap, image_read, NULL, NULL, 0) == MPS_RES_FAIL);
+    header[imageHeaderRUNS] = saved;
+
+    saved = header[imageHeaderPADS];
+    header[imageHeaderPADS] =
+        header[imageHeaderSIZE] / header[imageHeaderALIGN] + 1;
+    imagePos = 0;
+    Insist(mps_ap_image_read(ap, image_read, NULL, NULL, 0) == MPS_RES_FAIL);
+    header[imageHeaderPADS] = saved;
+
+    btSize = BTSize(header[imageHeaderSIZE] / sizeof(mps_word_t));
+    memset(imageBuf + imageLen - btSize, 0xFF, btSize);
+    imagePos = 0;
+    Insist(mps_ap_image_read(ap, image_read, NULL, NULL, 0) == MPS_RES_FAIL);
+    Insist(imagePos == imageLen);
+
+    sd.arena = arena;
+    sd.expect_pool = pool;
+    sd.expect_fmt = format;
+    sd.count = 0;
+    sd.objSize = 0;
+    sd.padSize = 0;
+    mps_arena_formatted_objects_walk(arena, object_stepper, &sd, sizeof sd);
+    Insist(sd.count == 0);
+    Insist(sd.padSize > 0);
+    mps_arena_collect(arena);
+
+    mps_ap_destroy(ap);
+    mps_pool_destroy(pool);
+}
+
+
 /* test -- the body of the test */
 
 static void test(mps_arena_t arena, mps_pool_class_t pool_class)
 {
     mps_chain_t chain;
     mps_fmt_t format;
-    mps_pool_t pool;
+    mps_pool_t pool, imagePool;
+    mps_ap_t imageAp;
     mps_root_t exactRoot;
     size_t i;
     size_t totalSize, freeSize, allocSize, bufferSize;
     unsigned long objs;
     object_stepper_data_s objectStepperData, *sd;
+    object_stepper_data_s workerData[walkWORKERS];
+    void *workerPs[walkWORKERS];
     roots_stepper_data_s rootsStepperData, *rsd;
+    census_stepper_data_s censusStepperData, *csd;
 
     die(dylan_fmt(&format, arena), "fmt_create");
     die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
@@ -241,9 +400,285 @@ static void test(mps_arena_t arena, mps_pool_class_t pool_class)
            (unsigned long)bufferSize);
     Insist(sd->objSize + sd->padSize + bufferSize == allocSize);
 
+    /* A parallel walk finds the same objects. */
+    for (i = 0; i < walkWORKERS; ++i) {
+        workerData[i] = *sd;
+        workerData[i].count = 0;
+        workerData[i].objSize = 0;
+        workerData[i].padSize = 0;
+        workerPs[i] = &workerData[i];
+    }
+    die(mps_arena_formatted_objects_walk_parallel(arena, object_stepper,
+                                                  workerPs, sizeof *sd,
+                                                  walkWORKERS, walk_runner,
+                                                  NULL),
+        "mps_arena_formatted_objects_walk_parallel");
+    for (i = 1; i < walkWORKERS; ++i) {
+        workerData[0].count += workerData[i].count;
+        workerData[0].objSize += workerData[i].objSize;
+        workerData[0].padSize += workerData[i].padSize;
+    }
+    Insist(workerData[0].count == sd->count);
+    Insist(workerData[0].objSize == sd->objSize);
+    Insist(workerData[0].padSize == sd->padSize);
+
+    csd = &censusStepperData;
+    csd->expect_pool = pool;
+    csd->classes = 0;
+    csd->count = 0;
+    csd->objSize = 0;
+    csd->padSize = 0;
+    die(mps_arena_census(arena, census_stepper, csd, sizeof *csd),
+        "mps_arena_census");
+    Insist(csd->classes > 0);
+    Insist(csd->count == sd->count);
+    Insist(csd->objSize == sd->objSize);
+    Insist(csd->padSize == sd->padSize);
+
+    /* Write an image of the pool, read it into a new pool, relocating
+     * the roots, and replace the old pool with the new one. */
+    imageLen = 0;
+    die(mps_pool_image_write(pool, image_write, NULL), "image_write");
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+        MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+        die(mps_pool_create_k(&imagePool, arena, pool_class, args),
+            "pool_create");
+    } MPS_ARGS_END(args);
+    die(mps_ap_create(&imageAp, imagePool, mps_rank_exact()), "ap_create");
+    imagePos = 0;
+    die(mps_ap_image_read(imageAp, image_read, NULL,
+                          exactRoots, exactRootsCOUNT),
+        "image_read");
+    Insist(imagePos == imageLen);
+    mps_ap_destroy(ap);
+    mps_pool_destroy(pool);
+    ap = imageAp;
+    pool = imagePool;
+
+    for (i = 0; i < exactRootsCOUNT; ++i)
+        if (exactRoots[i] != objNULL) {
+            mps_pool_t root_pool;
+            Insist(mps_addr_pool(&root_pool, arena, exactRoots[i]));
+            Insist(root_pool == pool);
+            cdie(dylan_check(exactRoots[i]), "restored root check");
+        }
+
+    /* The restored pool has the same objects and padding. */
+    sd->expect_pool = pool;
+    sd->count = 0;
+    sd->objSize = 0;
+    sd->padSize = 0;
+    mps_arena_formatted_objects_walk(arena, object_stepper, sd, sizeof *sd);
+    Insist(sd->count == objs);
+    Insist(sd->objSize == csd->objSize);
+    Insist(sd->padSize == csd->padSize);
+
+    /* Collecting scans the relocated references. */
+    mps_arena_collect(arena);
+    for (i = 0; i < exactRootsCOUNT; ++i)
+        if (exactRoots[i] != objNULL)
+            cdie(dylan_check(exactRoots[i]), "collected root check");
+
+    /* Freezing is only possible without an allocation point, and the
+     * pool only refers to itself.  A frozen pool is still collected. */
     mps_ap_destroy(ap);
+    mps_arena_park(arena);
+    if (pool_class == mps_class_snc()) {
+        Insist(mps_pool_freeze(pool) == MPS_RES_PARAM);
+    } else {
+        die(mps_pool_freeze(pool), "pool_freeze");
+        mps_arena_collect(arena);
+        for (i = 0; i < exactRootsCOUNT; ++i)
+            if (exactRoots[i] != objNULL)
+                cdie(dylan_check(exactRoots[i]), "frozen root check");
+    }
+
     mps_root_destroy(exactRoot);
     mps_pool_destroy(pool);
+    test_image_fail(arena, format, chain, pool_class);
+    mps_chain_destroy(chain);
+    mps_fmt_destroy(format);
+    mps_arena_release(arena);
+}
+
+/* test_census_keys -- count classes that the census can't use as keys
+ *
+ * The default class method returns the first word of an object, so
+ * a class may be any word, including the two that the census table
+ * reserves <code/walk.c#census.key>.  This format gives all the
+ * one-slot vectors one of those classes and all the two-slot vectors
+ * the other.
+ */
+
+#define censusKeysCOUNT 100
+#define censusKeyONE ((mps_addr_t)(mps_word_t)-1)
+#define censusKeyTWO ((mps_addr_t)(mps_word_t)-2)
+
+static mps_addr_t census_keys_class(mps_addr_t addr)
+{
+    if (dylan_ispad(addr))
+        return NULL;
+    if (AddrOffset(addr, dylan_skip(addr)) == 3 * sizeof(mps_word_t))
+        return censusKeyONE;
+    return censusKeyTWO;
+}
+
+typedef struct census_keys_data {
+  size_t one, two;              /* number of objects of each class */
+} census_keys_data_s, *census_keys_data_t;
+
+static void census_keys_stepper(mps_pool_t pool, size_t gen,
+                                mps_addr_t klass, size_t count, size_t size,
+                                void *p, size_t s)
+{
+    census_keys_data_t data = p;
+    Insist(s == sizeof *data);
+    testlib_unused(pool);
+    testlib_unused(gen);
+    testlib_unused(size);
+    if (klass == censusKeyONE)
+        data->one += count;
+    else if (klass == censusKeyTWO)
+        data->two += count;
+    else
+        Insist(klass == NULL);
+}
+
+static void test_census_keys(mps_arena_t arena)
+{
+    mps_fmt_A_s *fmt_A = dylan_fmt_A();
+    mps_fmt_t format;
+    mps_pool_t pool;
+    mps_ap_t census_ap;
+    mps_word_t obj;
+    census_keys_data_s data;
+    size_t i;
+
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FMT_ALIGN, fmt_A->align);
+        MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN, fmt_A->scan);
+        MPS_ARGS_ADD(args, MPS_KEY_FMT_SKIP, fmt_A->skip);
+        MPS_ARGS_ADD(args, MPS_KEY_FMT_PAD, fmt_A->pad);
+        MPS_ARGS_ADD(args, MPS_KEY_FMT_CLASS, census_keys_class);
+        die(mps_fmt_create_k(&format, arena, args), "fmt_create");
+    } MPS_ARGS_END(args);
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+        die(mps_pool_create_k(&pool, arena, mps_class_ams(), args),
+            "pool_create");
+    } MPS_ARGS_END(args);
+    die(mps_ap_create_k(&census_ap, pool, mps_args_none), "ap_create");
+
+    /* Nothing refers to the objects, so keep the arena parked. */
+    mps_arena_park(arena);
+    for (i = 0; i < censusKeysCOUNT; ++i)
+        die(make_dylan_vector(&obj, census_ap, 1 + i % 2),
+            "make_dylan_vector");
+
+    data.one = 0;
+    data.two = 0;
+    die(mps_arena_census(arena, census_keys_stepper, &data, sizeof data),
+        "mps_arena_census");
+    Insist(data.one == (censusKeysCOUNT + 1) / 2);
+    Insist(data.two == censusKeysCOUNT / 2);
+
+    mps_ap_destroy(census_ap);
+    mps_pool_destroy(pool);
+    mps_fmt_destroy(format);
+    mps_arena_release(arena);
+}
+
+/* test_freeze -- freeze a pool referred to by a mutable pool */
+
+#define freezeRootsCOUNT 2
+
+static void test_freeze(mps_arena_t arena)
+{
+    mps_chain_t chain, frozenChain;
+    mps_fmt_t format;
+    mps_pool_t pool, frozenPool;
+    mps_ap_t frozenAp;
+    mps_root_t root;
+    mps_addr_t roots[freezeRootsCOUNT];
+    mps_word_t mutable, frozen;
+    Seg seg;
+    size_t i;
+
+    die(dylan_fmt(&format, arena), "fmt_create");
+    die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+    die(mps_chain_create(&frozenChain, arena, genCOUNT, testChain),
+        "chain_create");
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+        MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+        die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+            "pool_create");
+    } MPS_ARGS_END(args);
+    MPS_ARGS_BEGIN(args) {
+        MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+        MPS_ARGS_ADD(args, MPS_KEY_CHAIN, frozenChain);
+        die(mps_pool_create_k(&frozenPool, arena, mps_class_amc(), args),
+            "pool_create");
+    } MPS_ARGS_END(args);
+    die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+    die(mps_ap_create(&frozenAp, frozenPool, mps_rank_exact()), "ap_create");
+    die(mps_root_create_table(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                              roots, freezeRootsCOUNT),
+        "root_create_table");
+
+    die(make_dylan_vector(&mutable, ap, 1), "make_dylan_vector");
+    die(make_dylan_vector(&frozen, frozenAp, 1), "make_dylan_vector");
+    roots[0] = (mps_addr_t)mutable;
+    roots[1] = (mps_addr_t)frozen;
+    DYLAN_VECTOR_SLOT(roots[1], 0) = (mps_word_t)roots[0];
+
+    /* The pool can't be frozen while it has an allocation point. */
+    mps_arena_park(arena);
+    Insist(mps_pool_freeze(frozenPool) == MPS_RES_PARAM);
+    mps_ap_destroy(frozenAp);
+
+    /* Nor while it refers to a mutable pool. */
+    Insist(mps_pool_freeze(frozenPool) == MPS_RES_FAIL);
+    DYLAN_VECTOR_SLOT(roots[1], 0) = DYLAN_INT(0);
+    die(mps_pool_freeze(frozenPool), "pool_freeze");
+    die(mps_pool_freeze(frozenPool), "pool_freeze again");
+
+    /* No allocation point can be created in a frozen pool. */
+    Insist(mps_ap_create(&frozenAp, frozenPool, mps_rank_exact())
+           == MPS_RES_PARAM);
+    DYLAN_VECTOR_SLOT(roots[0], 0) = (mps_word_t)roots[1];
+    mps_arena_release(arena);
+
+    /* Collect the mutable pool without condemning the frozen one. */
+    for (i = 0; i < objCOUNT; ++i) {
+        mps_addr_t p;
+        mps_res_t res;
+        size_t size = 8 * sizeof(mps_word_t);
+        do {
+            MPS_RESERVE_BLOCK(res, p, ap, size);
+            if (res)
+                die(res, "MPS_RESERVE_BLOCK");
+            die(dylan_init(p, size, roots, freezeRootsCOUNT),
+                "dylan_init");
+        } while (!mps_commit(ap, p, size));
+    }
+
+    mps_arena_collect(arena);
+    mutable = (mps_word_t)roots[0];
+    frozen = (mps_word_t)roots[1];
+    cdie(dylan_check((mps_addr_t)mutable), "mutable check");
+    cdie(dylan_check((mps_addr_t)frozen), "frozen check");
+    Insist(DYLAN_VECTOR_SLOT(mutable, 0) == frozen);
+    Insist(SegOfAddr(&seg, (Arena)arena, (Addr)frozen));
+    Insist(PoolFrozen(SegPool(seg)));
+    Insist(SegSummary(seg) == RefSetUNIV);
+
+    mps_ap_destroy(ap);
+    mps_root_destroy(root);
+    mps_pool_destroy(frozenPool);
+    mps_pool_destroy(pool);
+    mps_chain_destroy(frozenChain);
     mps_chain_destroy(chain);
     mps_fmt_destroy(format);
     mps_arena_release(arena);
@@ -267,9 +702,12 @@ int main(int argc, char *argv[])
     test(arena, mps_class_awl());
     test(arena, mps_class_lo());
     test(arena, mps_class_snc());
+    test_census_keys(arena);
+    test_freeze(arena);
 
     mps_thread_dereg(thread);
     mps_arena_destroy(arena);
+    free(imageBuf);
 
     printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
     return 0;